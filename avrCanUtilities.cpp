@@ -102,32 +102,234 @@ bool CAN_init_tx(uint8_t canBaud, bool bigEndian, uint8_t txMobCount)
 
 
 /**
- * @brief Sends all bytes through the can bus
+ * @brief Sends a NUL terminated string through the can bus, packed 7 bytes to a frame with CAN_send_buffer. 
+ * Put it back together with CAN_segment_receive. It has the same limit on its length as CAN_send_buffer
  * @param bytes The bytes to send
  * @param id The ID to send
  * @param priority The priority of the send
- * @return true If frame was able to be loaded
- * @return false If frame was NOT able to be loaded
+ * @return true If all the frames were able to be loaded
+ * @return false If a frame was NOT able to be loaded
  */
 bool CAN_send(uint8_t bytes[], uint32_t id, uint8_t priority) {
 	
+	return CAN_send_buffer(bytes, (uint16_t)strlen((const char*)bytes), id, priority);
+}
+
+
+
+/**
+ * @brief Sends up to 8 bytes in a single frame, zeros included
+ * @param bytes The bytes to send
+ * @param length The amount of bytes, 0 to 8
+ * @param id The ID to send
+ * @param priority The priority of the send
+ * @return true If frame was able to be loaded
+ * @return false If frame was NOT able to be loaded or the length is over 8
+ */
+bool CAN_send_bytes(const uint8_t bytes[], uint8_t length, uint32_t id, uint8_t priority) {
+	
 	//Variables
-	bool hasWorked = true;
+	CAN_FRAME outgoing; //The frame that's being sent
 	uint8_t index = 0; //Index for loops
-	volatile uint8_t subIndex = 0; //Index for loops
 	
+	if(length > 8) {
+		return false;
+	}
+	
+	outgoing.id = id; //Set the id for the frame
+	outgoing.extended = false; //Set extended to false
+	outgoing.priority = priority; //0-15 lower is higher priority
+	outgoing.length = length; //Set the length of the data
+	outgoing.data.value = 0; //Unused bytes go out as 0
 	
-	//Loop through while the value at index is not null
-	while(bytes[index] != '\0' && hasWorked == true) {
-		hasWorked = CAN_send_int((uint32_t)bytes[index],id,priority);
-		if(hasWorked == false) {
-			subIndex++;
+	for(index = 0; index < length; index++) {
+		outgoing.data.bytes[index] = bytes[index];
+	}
+
+	//Return the status of loading the frame.
+	return(Can0.sendFrame(outgoing));
+}
+
+
+
+/**
+ * @brief Sends a buffer of any length, zeros included, as segments of a header byte and up to 7 payload bytes. 
+ * The header has CAN_SEGMENT_FIRST on the first frame, CAN_SEGMENT_LAST on the last, and a sequence number. A buffer of 7 or less is one frame with both. 
+ * Doesn't wait, it loads every segment or none, only as many as Can0.txOrderedRoom() says will go out in order, so it's busy until the bus takes the frames before. 
+ * That makes a hard limit on the length: 56 bytes with one TX MOb, as the MOb and the 7 frames of the transmit buffer are drained in order, 
+ * and 7 bytes with more, as only one frame at a time is sure to go out in order. Anything longer always fails, and has to be sent 
+ * a few segments at a time with CAN_segment_send. For big transfers with flow control, use canIsoTp
+ * @param bytes The bytes to send
+ * @param length The amount of bytes
+ * @param id The ID to send
+ * @param priority The priority of the send
+ * @return true If all the frames were loaded
+ * @return false If there wasn't room for them all, or an interrupt took the room part way through
+ */
+bool CAN_send_buffer(const uint8_t bytes[], uint16_t length, uint32_t id, uint8_t priority) {
+	
+	//Variables
+	CanSegmentTx_t tx; //The send state
+	uint16_t frames = (length + CAN_SEGMENT_PAYLOAD - 1) / CAN_SEGMENT_PAYLOAD; //The segments needed
+	
+	if(frames == 0) {
+		frames = 1;
+	}
+	
+	if(frames > Can0.txOrderedRoom()) {
+		return false;
+	}
+	
+	CAN_segment_send_init(&tx, bytes, length, id, priority);
+	
+	return (CAN_segment_send(&tx) == 1);
+}
+
+
+
+/**
+ * @brief Sets up to send a buffer with CAN_segment_send. The buffer has to stay as it is until it's sent
+ * @param tx The state to set up
+ * @param bytes The bytes to send
+ * @param length The amount of bytes
+ * @param id The ID to send
+ * @param priority The priority of the send
+ */
+void CAN_segment_send_init(CanSegmentTx_t* tx, const uint8_t bytes[], uint16_t length, uint32_t id, uint8_t priority) {
+	
+	tx->bytes = bytes;
+	tx->length = length;
+	tx->offset = 0;
+	tx->id = id;
+	tx->priority = priority;
+	tx->sequence = 0;
+}
+
+
+
+/**
+ * @brief Loads as many segments of the buffer as Can0.txOrderedRoom() says will go out in order, without waiting. 
+ * Call again, such as from the main loop, until it returns 1
+ * @param tx The state set up by CAN_segment_send_init
+ * @return int8_t 1 if every segment has been loaded, 0 if some are left
+ */
+int8_t CAN_segment_send(CanSegmentTx_t* tx) {
+	
+	//Variables
+	uint8_t segment[8]; //The segment being sent
+	uint8_t chunk = 0; //The payload bytes in the segment
+	uint8_t index = 0; //Index for loops
+	uint8_t room = Can0.txOrderedRoom(); //The segments that can be loaded and still go out in order
+	
+	//An empty buffer still goes out as one segment with no payload
+	while(tx->offset < tx->length || (tx->offset == 0 && tx->sequence == 0)) {
+		
+		//Leave the rest for the next call once they could overtake the ones already loaded
+		if(room == 0) {
+			return 0;
 		}
 		
-		index++;
+		chunk = (tx->length - tx->offset > CAN_SEGMENT_PAYLOAD) ? CAN_SEGMENT_PAYLOAD : (uint8_t)(tx->length - tx->offset);
+		
+		segment[0] = tx->sequence & CAN_SEGMENT_SEQUENCE_MASK;
+		
+		if(tx->offset == 0) {
+			segment[0] |= CAN_SEGMENT_FIRST;
+		}
+		
+		if(tx->offset + chunk >= tx->length) {
+			segment[0] |= CAN_SEGMENT_LAST;
+		}
+		
+		for(index = 0; index < chunk; index++) {
+			segment[index + 1] = tx->bytes[tx->offset + index];
+		}
+		
+		//Leave it for the next call if the transmit buffer is full
+		if(CAN_send_bytes(segment, chunk + 1, tx->id, tx->priority) == false) {
+			return 0;
+		}
+		
+		tx->offset += chunk;
+		tx->sequence++;
+		room--;
 	}
+	
+	return 1;
+}
+
+
 
-	return hasWorked;
+/**
+ * @brief Sets up to put a buffer sent with CAN_send_buffer back together
+ * @param rx The state to set up
+ * @param buffer Where the payload goes
+ * @param size The size of the buffer
+ */
+void CAN_segment_init(CanSegmentRx_t* rx, uint8_t* buffer, uint16_t size) {
+	
+	rx->buffer = buffer;
+	rx->size = size;
+	rx->length = 0;
+	rx->sequence = 0;
+	rx->active = false;
+}
+
+
+
+/**
+ * @brief Adds a received segment. A first segment always starts over
+ * @param rx The state set up by CAN_segment_init
+ * @param frame The received frame
+ * @return int8_t 1 if the buffer is complete with rx->length bytes, 0 if more are needed, 
+ * -1 if a segment was missed or out of order, -2 if the buffer is too small. After an error, it waits for the next first segment
+ */
+int8_t CAN_segment_receive(CanSegmentRx_t* rx, const CAN_FRAME& frame) {
+	
+	//Variables
+	uint8_t header = frame.data.bytes[0]; //The segment header
+	uint8_t chunk = 0; //The payload bytes in the segment
+	uint8_t index = 0; //Index for loops
+	
+	if(frame.length == 0) {
+		return 0;
+	}
+	
+	if(header & CAN_SEGMENT_FIRST) {
+		rx->active = true;
+		rx->length = 0;
+		rx->sequence = 0;
+	}
+	
+	if(rx->active == false) {
+		return 0;
+	}
+	
+	if((header & CAN_SEGMENT_SEQUENCE_MASK) != rx->sequence) {
+		rx->active = false;
+		return -1;
+	}
+	
+	chunk = frame.length - 1;
+	
+	if(rx->length + chunk > rx->size) {
+		rx->active = false;
+		return -2;
+	}
+	
+	for(index = 0; index < chunk; index++) {
+		rx->buffer[rx->length + index] = frame.data.bytes[index + 1];
+	}
+	
+	rx->length += chunk;
+	rx->sequence = (rx->sequence + 1) & CAN_SEGMENT_SEQUENCE_MASK;
+	
+	if(header & CAN_SEGMENT_LAST) {
+		rx->active = false;
+		return 1;
+	}
+	
+	return 0;
 }
 
 
@@ -276,6 +478,46 @@ int8_t CAN_process_frame(int8_t(*can_frame_callback)(CAN_FRAME&)) {
 
 
 
+#if MCU_USE_TRACE == 1
+
+/**
+ * @brief Sends the oldest trace record as an 8 byte frame. Call it from the main loop or a timer to stream the trace in the background.
+ * The record is only removed once the frame is loaded, so it is tried again if the transmit buffer was full
+ * 
+ * @param id The id for the trace frames
+ * @param priority The priority of the frame
+ * @return true If a record was sent
+ * @return false If there was nothing to send or the frame could not be loaded
+ */
+bool CAN_send_trace(uint32_t id, uint8_t priority) {
+	
+	//Variables
+	TraceRecord_t record; //The record being sent
+	CAN_FRAME outgoing; //The frame that's being sent
+	
+	if(TracePeek(&record) == false) {
+		return false;
+	}
+	
+	outgoing.id = id;
+	outgoing.extended = (id > 0x7FF);
+	outgoing.priority = priority;
+	outgoing.length = 8;
+	TracePack(&record, outgoing.data.bytes);
+	
+	if(Can0.sendFrame(outgoing) == false) {
+		return false;
+	}
+	
+	TraceRelease();
+	
+	return true;
+}
+
+#endif
+
+
+
 #endif
 #endif /* __AVR_CAN_UTILITIES_CPP__ */
 #endif
\ No newline at end of file
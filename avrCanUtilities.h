@@ -13,6 +13,7 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include "avr_can.h"
+#include "mcuTrace.h"
 #include "string.h"
 
 ///Reads data into the passed frame buffer and returns 1 if frame was returned, else 0
@@ -27,12 +28,60 @@
 ///Helper for forming the id to send onto the can network
 #define CAN_create_msg_id(mainId, offsetId1, offsetId2)		(mainId | offsetId1 | offsetId2)
 
+///Segment header bit for the first frame of a buffer
+#define CAN_SEGMENT_FIRST			0x80
+
+///Segment header bit for the last frame of a buffer
+#define CAN_SEGMENT_LAST			0x40
+
+///Segment header bits for the sequence number, counting up from 0 at the first frame
+#define CAN_SEGMENT_SEQUENCE_MASK	0x3F
+
+///The payload bytes in each segment, after the header byte
+#define CAN_SEGMENT_PAYLOAD			7
+
+typedef struct _CAN_SEGMENT_RX_
+{
+	uint8_t* buffer;			///Where the payload is put
+	uint16_t size;				///The size of the buffer
+	uint16_t length;			///The payload bytes received so far, the whole length once complete
+	uint8_t sequence;			///The sequence number of the next segment
+	bool active;				///If a buffer is part way through
+
+}
+/**
+* \brief Struct for putting a buffer sent with CAN_send_buffer back together
+*/
+CanSegmentRx_t;
+
+typedef struct _CAN_SEGMENT_TX_
+{
+	const uint8_t* bytes;		///The buffer being sent
+	uint16_t length;			///The size of the buffer
+	uint16_t offset;			///Where the next segment starts in the buffer
+	uint32_t id;				///The id to send
+	uint8_t priority;			///The priority of the send
+	uint8_t sequence;			///The sequence number of the next segment
+
+}
+/**
+* \brief Struct for sending a buffer too big for the transmit buffer a few segments at a time with CAN_segment_send
+*/
+CanSegmentTx_t;
+
 bool CAN_init(uint8_t canBaud, void(*set_tx_box_count)(void), bool bigEndian);
 bool CAN_init_rx_all(uint8_t canBaud, bool bigEndian);
 
 bool CAN_init_tx(uint8_t canBaud, bool bigEndian, uint8_t txMobCount);
 
 bool CAN_send(uint8_t bytes[], uint32_t id, uint8_t priority);
+bool CAN_send_bytes(const uint8_t bytes[], uint8_t length, uint32_t id, uint8_t priority);
+bool CAN_send_buffer(const uint8_t bytes[], uint16_t length, uint32_t id, uint8_t priority);
+
+void CAN_segment_send_init(CanSegmentTx_t* tx, const uint8_t bytes[], uint16_t length, uint32_t id, uint8_t priority);
+int8_t CAN_segment_send(CanSegmentTx_t* tx);
+void CAN_segment_init(CanSegmentRx_t* rx, uint8_t* buffer, uint16_t size);
+int8_t CAN_segment_receive(CanSegmentRx_t* rx, const CAN_FRAME& frame);
 
 bool CAN_send_char(uint8_t value, uint32_t id, uint8_t priority);
 bool CAN_send_short(uint16_t value, uint32_t id, uint8_t priority);
@@ -41,6 +90,10 @@ bool CAN_send_long(uint64_t value, uint32_t id, uint8_t priority);
 
 int8_t CAN_process_frame(int8_t(*can_frame_callback)(CAN_FRAME&));
 
+#if MCU_USE_TRACE == 1
+bool CAN_send_trace(uint32_t id, uint8_t priority);
+#endif
+
 #endif /* __AVR_CAN_UTILITIES_H_ */
 #endif
 #endif
\ No newline at end of file
@@ -0,0 +1,457 @@
+/**
+ * \file avrLin.c
+ * \author Tim Robbins
+ * \brief Source file for the interrupt driven LIN driver
+ */
+#include "avrLin.h"
+
+#if !defined(AVR_LIN_C_) && defined(__AVR) && defined(LINCR)
+#define AVR_LIN_C_ 1
+
+#include <avr/interrupt.h>
+#include "mcuUtils.h"
+
+
+///LINCR commands
+#define LIN_CMD_IDLE					0x00
+#define LIN_CMD_TX_HEADER				0x01
+#define LIN_CMD_RX_RESPONSE				0x02
+#define LIN_CMD_TX_RESPONSE				0x03
+
+
+///The frames this node takes part in
+static LinFrame_t* m_linFrames = 0;
+
+///The amount of frames
+static uint8_t m_uchrLinFrameCount = 0;
+
+///If this node is the master
+static bool m_bLinMaster = false;
+
+///The schedule table
+static const LinSlot_t* m_linSchedule = 0;
+
+///The amount of slots in the schedule
+static uint8_t m_uchrLinSlotCount = 0;
+
+///The table to change to at the end of the current slot, 0 for none
+static const LinSlot_t* volatile m_linNextSchedule = 0;
+
+///The amount of slots in the table to change to
+static volatile uint8_t m_uchrLinNextSlotCount = 0;
+
+///The next slot to send
+static uint8_t m_uchrLinSlot = 0;
+
+///The milliseconds left in the current slot
+static uint8_t m_uchrLinSlotMs = 0;
+
+///If the schedule is running
+static volatile bool m_bLinRunning = false;
+
+///The frame whose response is being sent or received, 0 for none
+static LinFrame_t* volatile m_linActive = 0;
+
+
+
+/**
+ * \brief Finds a frame in the table
+ * \param id The frame id
+ * \return The frame or 0 if this node doesn't take part in it
+ */
+static LinFrame_t* LinFind(uint8_t id)
+{
+	for(uint8_t i = 0; i < m_uchrLinFrameCount; i++)
+	{
+		if(m_linFrames[i].id == id)
+		{
+			return &m_linFrames[i];
+		}
+	}
+
+	return 0;
+}
+
+
+
+/**
+ * \brief Writes a command to the controller, with the checksum model of the frame
+ * \param command The command
+ * \param frame The frame, or 0 for the enhanced checksum
+ */
+static inline void LinCommand(uint8_t command, const LinFrame_t* frame)
+{
+	LINCR = (1 << LENA) | ((frame != 0 && (frame->flags & LIN_FRAME_CLASSIC)) ? (1 << LIN13) : 0) | command;
+}
+
+
+
+/**
+ * \brief Saturating count
+ * \param counter The counter
+ */
+static inline void LinCount(volatile uint8_t* counter)
+{
+	if(*counter != 0xFF)
+	{
+		(*counter)++;
+	}
+}
+
+
+
+/**
+ * \brief Sets up the LIN/UART in LIN mode
+ * \param baud The baud rate, usually 19200, 10417 or 9600
+ * \param master True if this node is the master
+ * \param frames The frames this node takes part in. They're kept, not copied
+ * \param count The amount of frames
+ * \return False if the baud rate can't be made within LIN_MASTER_TOLERANCE, or LIN_SLAVE_TOLERANCE for a slave
+ */
+bool LinInit(uint32_t baud, bool master, LinFrame_t frames[], uint8_t count)
+{
+	//Variables
+	uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+	uint32_t divider = 0; //Divider being tried
+	uint32_t error = 0; //Its error
+	uint8_t bestSamples = 0; //Samples per bit with the least error
+	uint32_t bestDivider = 0; //Divider with the least error
+	uint32_t bestError = 0xFFFFFFFF; //The least error
+
+	if(baud == 0)
+	{
+		return false;
+	}
+
+	//The bit time is samples * divider cycles, so look for the pair closest to the baud rate
+	for(uint8_t samples = 8; samples < 64; samples++)
+	{
+		divider = (F_CPU + (samples * baud) / 2) / (samples * baud);
+
+		if(divider == 0 || divider > 4096)
+		{
+			continue;
+		}
+
+		error = F_CPU / (samples * divider);
+		error = (error > baud) ? error - baud : baud - error;
+
+		if(error < bestError)
+		{
+			bestError = error;
+			bestSamples = samples;
+			bestDivider = divider;
+		}
+	}
+
+	if(bestSamples == 0 || bestError * 1000 > baud * (master ? LIN_MASTER_TOLERANCE : LIN_SLAVE_TOLERANCE))
+	{
+		return false;
+	}
+
+	interruptsOff();
+
+	//Bit timing can only be changed with the controller off, and with resynchronising disabled
+	LINCR = (1 << LSWRES);
+	LINBTR = (1 << LDISR) | bestSamples;
+	
+	//A slave resynchronises its bit timing to the master's on each sync field
+	if(master == false)
+	{
+		LINBTR = bestSamples;
+	}
+	
+	LINBRR = (uint16_t)(bestDivider - 1);
+	LinCommand(LIN_CMD_IDLE, 0);
+	LINENIR = (1 << LENERR) | (1 << LENIDOK) | (1 << LENTXOK) | (1 << LENRXOK);
+
+	m_linFrames = frames;
+	m_uchrLinFrameCount = count;
+	m_bLinMaster = master;
+	m_bLinRunning = false;
+	m_linActive = 0;
+	m_linSchedule = 0;
+	m_uchrLinSlotCount = 0;
+	m_linNextSchedule = 0;
+
+	for(uint8_t i = 0; i < count; i++)
+	{
+		frames[i].updated = false;
+		frames[i].errors = 0;
+		frames[i].misses = 0;
+	}
+
+	SREG = sreg;
+
+	return true;
+}
+
+
+
+/**
+ * \brief Sets the master's schedule table. If it's running, the change happens at the end of the current slot
+ * \param table The slots. It's kept, not copied
+ * \param count The amount of slots
+ * \return False if this node isn't the master or the table is empty
+ */
+bool LinScheduleSet(const LinSlot_t table[], uint8_t count)
+{
+	//Variables
+	uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+
+	if(m_bLinMaster == false || count == 0)
+	{
+		return false;
+	}
+
+	interruptsOff();
+
+	if(m_bLinRunning)
+	{
+		m_linNextSchedule = table;
+		m_uchrLinNextSlotCount = count;
+	}
+	else
+	{
+		m_linSchedule = table;
+		m_uchrLinSlotCount = count;
+		m_uchrLinSlot = 0;
+	}
+
+	SREG = sreg;
+
+	return true;
+}
+
+
+
+/**
+ * \brief Starts the schedule, from its first slot on the next tick
+ */
+void LinScheduleStart(void)
+{
+	if(m_linSchedule != 0)
+	{
+		m_uchrLinSlot = 0;
+		m_uchrLinSlotMs = 0;
+		m_bLinRunning = true;
+	}
+}
+
+
+
+/**
+ * \brief Stops the schedule after the current frame
+ */
+void LinScheduleStop(void)
+{
+	m_bLinRunning = false;
+}
+
+
+
+/**
+ * \brief Runs the master's schedule. Call from a periodic interrupt every LIN_TICK_MS
+ */
+void LinTick(void)
+{
+	//Variables
+	LinFrame_t* frame = 0; //The frame of the slot starting
+
+	if(m_bLinRunning == false)
+	{
+		return;
+	}
+
+	if(m_uchrLinSlotMs > LIN_TICK_MS)
+	{
+		m_uchrLinSlotMs -= LIN_TICK_MS;
+		return;
+	}
+
+	//The slot is over, so a frame still going never got its response
+	if(m_linActive != 0)
+	{
+		LinCount(&m_linActive->misses);
+		LinCommand(LIN_CMD_IDLE, 0);
+		m_linActive = 0;
+	}
+
+	if(m_linNextSchedule != 0)
+	{
+		m_linSchedule = m_linNextSchedule;
+		m_uchrLinSlotCount = m_uchrLinNextSlotCount;
+		m_linNextSchedule = 0;
+		m_uchrLinSlot = 0;
+	}
+
+	frame = m_linSchedule[m_uchrLinSlot].frame;
+	m_uchrLinSlotMs = m_linSchedule[m_uchrLinSlot].delayMs;
+
+	if(++m_uchrLinSlot >= m_uchrLinSlotCount)
+	{
+		m_uchrLinSlot = 0;
+	}
+
+	m_linActive = frame;
+	LINIDR = frame->id & 0x3F;
+	LinCommand(LIN_CMD_TX_HEADER, frame);
+}
+
+
+
+/**
+ * \brief Changes the signal buffer of a frame, sent the next time its header comes
+ * \param frame The frame
+ * \param data Its length in bytes
+ */
+void LinFrameWrite(LinFrame_t* frame, const uint8_t data[])
+{
+	//Variables
+	uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+
+	interruptsOff();
+
+	for(uint8_t i = 0; i < frame->length; i++)
+	{
+		frame->data[i] = data[i];
+	}
+
+	SREG = sreg;
+}
+
+
+
+/**
+ * \brief Copies out the signal buffer of a frame
+ * \param frame The frame
+ * \param data Where to put its length in bytes
+ * \return True if a response was received since the last read
+ */
+bool LinFrameRead(LinFrame_t* frame, uint8_t data[])
+{
+	//Variables
+	uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+	bool updated = false; //If there was a new response
+
+	interruptsOff();
+
+	for(uint8_t i = 0; i < frame->length; i++)
+	{
+		data[i] = frame->data[i];
+	}
+
+	updated = frame->updated;
+	frame->updated = false;
+
+	SREG = sreg;
+
+	return updated;
+}
+
+
+
+/**
+ * \brief Handles the LIN transfer interrupt, a header sent or received, or a response done. \n
+ * Called from LIN_TC_vect, the driver's own or the application's with LIN_USE_ISR as 0
+ */
+void LinTransferInterrupt(void)
+{
+	//Variables
+	uint8_t status = LINSIR; //The flags
+	LinFrame_t* frame = 0; //The frame of the header
+
+	if(status & (1 << LIDOK))
+	{
+		LINSIR = (1 << LIDOK);
+
+		//The master already knows the frame, a slave looks it up
+		frame = m_bLinMaster ? m_linActive : LinFind(LINIDR & 0x3F);
+		m_linActive = frame;
+
+		if(frame == 0)
+		{
+			LinCommand(LIN_CMD_IDLE, 0);
+		}
+		else if(frame->flags & LIN_FRAME_PUBLISH)
+		{
+			LINSEL = 0;
+
+			for(uint8_t i = 0; i < frame->length; i++)
+			{
+				LINDAT = frame->data[i];
+			}
+
+			LINDLR = frame->length << 4;
+			LinCommand(LIN_CMD_TX_RESPONSE, frame);
+		}
+		else
+		{
+			LINDLR = frame->length;
+			LinCommand(LIN_CMD_RX_RESPONSE, frame);
+		}
+	}
+
+	if(status & (1 << LRXOK))
+	{
+		LINSIR = (1 << LRXOK);
+		frame = m_linActive;
+
+		if(frame != 0)
+		{
+			LINSEL = 0;
+
+			for(uint8_t i = 0; i < frame->length; i++)
+			{
+				frame->data[i] = LINDAT;
+			}
+
+			frame->updated = true;
+			m_linActive = 0;
+		}
+	}
+
+	if(status & (1 << LTXOK))
+	{
+		LINSIR = (1 << LTXOK);
+		m_linActive = 0;
+	}
+}
+
+
+
+/**
+ * \brief Handles the LIN error interrupt, counted against the frame going on. \n
+ * Called from LIN_ERR_vect, the driver's own or the application's with LIN_USE_ISR as 0
+ */
+void LinErrorInterrupt(void)
+{
+	if(m_linActive != 0)
+	{
+		LinCount(&m_linActive->errors);
+		m_linActive = 0;
+	}
+
+	//Clears LINERR too
+	LINSIR = (1 << LERR);
+}
+
+
+
+#if LIN_USE_ISR == 1
+
+ISR(LIN_TC_vect)
+{
+	LinTransferInterrupt();
+}
+
+
+ISR(LIN_ERR_vect)
+{
+	LinErrorInterrupt();
+}
+
+#endif
+
+
+#endif
@@ -0,0 +1,126 @@
+/**
+ * \file avrLin.h
+ * \author Tim Robbins
+ * \brief Header file for an interrupt driven LIN driver on the LIN/UART of the ATmegaxxM1 and xxC1. \n
+ * Each node has a table of the frames it takes part in, each with a signal buffer. A publish frame is one this node sends \n
+ * the response of, the application changes its buffer with LinFrameWrite whenever it likes and the newest data goes out \n
+ * the next time the header comes. A subscribe frame's buffer is filled when its response is received, read with LinFrameRead. \n
+ * The master also runs a schedule table, sending each slot's header and waiting the slot's delay before the next one. \n
+ * LinTick has to be called from a periodic interrupt every LIN_TICK_MS to keep the schedule going, such as with SYSTEM_TICK_HOOK. \n
+ * Headers, responses and errors are all handled in the LIN interrupts, so nothing waits on the bus. \n
+ * The controller works out and checks the checksum, classic for LIN 1.3 frames and the diagnostic frames 0x3C and 0x3D, \n
+ * enhanced otherwise, set per frame with LIN_FRAME_CLASSIC. Checksum and other errors are counted per frame, \n
+ * as are headers the master sent that nobody answered before the slot ended. \n
+ * The driver owns the LIN interrupts, so it can't be used with the LIN functions of avrSerial.c or with canGateway. \n
+ * With LIN_USE_ISR as 0 the vectors are left to the application, whose LIN_TC_vect and LIN_ERR_vect call \n
+ * LinTransferInterrupt and LinErrorInterrupt, so the LIN/UART can be shared with another user of it. \n
+ *
+ * Example use, on the master: \n
+ *
+ * #define SYSTEM_TICK_HOOK() { extern void LinTick(void); LinTick(); } \n
+ * ... \n
+ * static LinFrame_t frames[] = { { 0x10, 2, LIN_FRAME_PUBLISH }, { 0x20, 4, 0 } }; \n
+ * static const LinSlot_t schedule[] = { { &frames[0], 10 }, { &frames[1], 10 } }; \n
+ * ... \n
+ * LinInit(19200, true, frames, 2); \n
+ * LinScheduleSet(schedule, 2); \n
+ * LinScheduleStart(); \n
+ * ... \n
+ * LinFrameWrite(&frames[0], lampCommands); \n
+ * if(LinFrameRead(&frames[1], switches)) { ... new switch states ... } \n
+ */
+#ifndef AVR_LIN_H_
+#define AVR_LIN_H_ 1
+
+#include "config.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+
+#ifdef __AVR
+
+#include <avr/io.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef LINCR
+
+
+#ifndef LIN_TICK_MS
+///The milliseconds between calls of LinTick
+#define LIN_TICK_MS						1
+#endif
+
+
+#ifndef LIN_USE_ISR
+///Set as 0 to leave LIN_TC_vect and LIN_ERR_vect to the application, which calls LinTransferInterrupt and LinErrorInterrupt from them
+#define LIN_USE_ISR						1
+#endif
+
+#ifndef LIN_MASTER_TOLERANCE
+///The baud rate error allowed for the master, in tenths of a percent. LIN asks 0.5% of it
+#define LIN_MASTER_TOLERANCE			5
+#endif
+
+#ifndef LIN_SLAVE_TOLERANCE
+///The baud rate error allowed for a slave, in tenths of a percent. 1.5% is LIN's tolerance for a slave without resynchronising
+#define LIN_SLAVE_TOLERANCE				15
+#endif
+
+
+///Frame flags
+#define LIN_FRAME_PUBLISH				0x01	//This node sends the response, otherwise it receives it
+#define LIN_FRAME_CLASSIC				0x02	//Classic checksum over the data only, for LIN 1.3 and diagnostic frames
+
+
+typedef struct _LIN_FRAME_
+{
+	uint8_t id;						///The 6 bit frame id
+	uint8_t length;					///The data bytes, 1 to 8
+	uint8_t flags;					///LIN_FRAME_PUBLISH and LIN_FRAME_CLASSIC
+	volatile uint8_t data[8];		///The signal buffer
+	volatile bool updated;			///Set when a response is received, cleared by LinFrameRead
+	volatile uint8_t errors;		///Responses with an error, saturating at 255
+	volatile uint8_t misses;		///Headers sent by the master with no response, saturating at 255
+
+}
+/**
+* \brief Struct for a frame and its signal buffer
+*/
+LinFrame_t;
+
+
+typedef struct _LIN_SLOT_
+{
+	LinFrame_t* frame;				///The frame whose header is sent
+	uint8_t delayMs;				///The milliseconds until the next slot, a multiple of LIN_TICK_MS
+
+}
+/**
+* \brief Struct for a slot of the master's schedule table
+*/
+LinSlot_t;
+
+
+extern bool LinInit(uint32_t baud, bool master, LinFrame_t frames[], uint8_t count);
+extern bool LinScheduleSet(const LinSlot_t table[], uint8_t count);
+extern void LinScheduleStart(void);
+extern void LinScheduleStop(void);
+extern void LinTick(void);
+extern void LinFrameWrite(LinFrame_t* frame, const uint8_t data[]);
+extern bool LinFrameRead(LinFrame_t* frame, uint8_t data[]);
+extern void LinTransferInterrupt(void);
+extern void LinErrorInterrupt(void);
+
+#endif
+
+#endif
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif /* AVR_LIN_H_ */
@@ -11,6 +11,7 @@
 #include "mcuUtils.h"
 #include "mcuDelays.h"
 #include "mcuPinUtils.h"
+#include "mcuIsrStats.h"
 #include <util/atomic.h>
 
 #ifdef UDR0
@@ -28,11 +29,13 @@
 		*
 		*/
 		ISR(USART0_RX_vect) {
+			ISR_STATS_ENTER(ISR_STATS_ID_USART0_RX);
 			uchrSerial0ReadBuffer[uchrBuffer0ReadIndex] = UDR0;
 			uchrBuffer0ReadIndex++;
 			if(uchrBuffer0ReadIndex >= MAX_SERIAL_SIZE) {
 				uchrBuffer0ReadIndex = 0;
 			}
+			ISR_STATS_EXIT(ISR_STATS_ID_USART0_RX);
 		}
 
 		/**
@@ -202,11 +205,13 @@
 		*
 		*/
 		ISR(USART1_RX_vect) {
+			ISR_STATS_ENTER(ISR_STATS_ID_USART1_RX);
 			uchrSerial1ReadBuffer[uchrBuffer1ReadIndex] = UDR1;
 			uchrBuffer1ReadIndex++;
 			if(uchrBuffer1ReadIndex >= MAX_SERIAL_SIZE) {
 				uchrBuffer1ReadIndex = 1;
 			}
+			ISR_STATS_EXIT(ISR_STATS_ID_USART1_RX);
 		}
 
 		/**
@@ -249,7 +254,7 @@
 	*/
 	void USART1_write_string(uint8_t* strStringtoWrite)
 	{
-		if(strlen(strStringtoWrite) == 0 && strStringtoWrite != NULL) {
+		if(strlen((const char*)strStringtoWrite) == 0 && strStringtoWrite != NULL) {
 			while (!(UCSR1A & (1 << UDRE1)));
 			UDR1 = *strStringtoWrite;
 		}
@@ -305,7 +310,7 @@
 	*/
 	void LIN_write_string(uint8_t* strStringtoWrite)
 	{
-		if(strlen(strStringtoWrite) == 0 && strStringtoWrite != NULL) {
+		if(strlen((const char*)strStringtoWrite) == 0 && strStringtoWrite != NULL) {
 			LIN_write_byte(*strStringtoWrite);
 		}
 		else {
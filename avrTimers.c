@@ -466,6 +466,321 @@ void Timer3Disable() {
 
 
 
+#if AVR_TIMERS_USE_SYSTEM_TICK == 1 && defined(TCNT0) && defined(OCR0A)
+
+#include <avr/interrupt.h>
+#include "mcuIsrStats.h"
+
+
+///The milliseconds since the tick was started
+static volatile uint32_t m_ulSystemMillis = 0;
+
+///The CPU cycles counted toward the next millisecond
+static volatile uint16_t m_uintSystemCycleRemainder = 0;
+
+///The wheel slots, each a list of the timers that expire on a millisecond matching the slot
+static SoftTimer_t* m_softTimerWheel[SOFT_TIMER_WHEEL_SIZE];
+
+///The last millisecond the wheel was serviced for
+static uint32_t m_ulSoftTimerServiced = 0;
+
+///The next timer to look at while a slot is being walked, kept here so a callback stopping it doesn't break the walk
+static SoftTimer_t* m_softTimerWalkNext = 0;
+
+
+
+/**
+ * \brief System tick interrupt. Counts the CPU cycles of the tick into whole milliseconds
+ */
+ISR(TIMER0_COMPA_vect)
+{
+	ISR_STATS_ENTER(ISR_STATS_ID_SYSTEM_TICK);
+	
+	//Variables
+	uint16_t cycles = m_uintSystemCycleRemainder + SYSTEM_TICK_CYCLES; //The cycles not yet counted into a millisecond
+	uint32_t millis = m_ulSystemMillis; //Local copy so the volatile isn't reloaded in the loop
+	
+	while(cycles >= SYSTEM_CYCLES_PER_MS)
+	{
+		cycles -= SYSTEM_CYCLES_PER_MS;
+		millis++;
+	}
+	
+	m_uintSystemCycleRemainder = cycles;
+	m_ulSystemMillis = millis;
+	
+	SYSTEM_TICK_HOOK();
+	
+	ISR_STATS_EXIT(ISR_STATS_ID_SYSTEM_TICK);
+}
+
+
+
+/**
+ * \brief Starts Timer 0 in CTC mode as the system tick. Interrupts must be turned on by the caller
+ */
+void SystemTickInit(void)
+{
+	Timer0Enable();
+	
+	//Stop the timer while setting it up
+	TCCR0B = 0;
+	TCNT0 = 0;
+	
+	//CTC mode, compare A at the tick rate
+	TCCR0A = (1 << WGM01);
+	OCR0A = SYSTEM_TICK_COMPARE;
+	TIFR0 = (1 << OCF0A);
+	TIMSK0 = (1 << OCIE0A);
+	
+	for(uint8_t i = 0; i < SOFT_TIMER_WHEEL_SIZE; i++)
+	{
+		m_softTimerWheel[i] = 0;
+	}
+	
+	m_ulSoftTimerServiced = m_ulSystemMillis;
+	
+	TCCR0B = SYSTEM_TICK_CS_BITS;
+}
+
+
+
+/**
+ * \brief Gets the milliseconds since the system tick was started. Wraps after around 49 days
+ * \return The milliseconds
+ */
+uint32_t SystemMillis(void)
+{
+	//Variables
+	uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+	uint32_t millis = 0; //The milliseconds
+	
+	cli();
+	millis = m_ulSystemMillis;
+	SREG = sreg;
+	
+	return millis;
+}
+
+
+
+/**
+ * \brief Gets the microseconds since the system tick was started, to the resolution of the timer prescaler. Wraps after around 71 minutes
+ * \return The microseconds
+ */
+uint32_t SystemMicros(void)
+{
+	//Variables
+	uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+	uint32_t millis = 0; //The milliseconds
+	uint16_t cycles = 0; //The cycles since the last whole millisecond
+	uint8_t count = 0; //The timer count
+	
+	cli();
+	millis = m_ulSystemMillis;
+	cycles = m_uintSystemCycleRemainder;
+	count = TCNT0;
+	
+	//If the timer has reset but the interrupt hasn't run yet, account for the tick it missed
+	if((TIFR0 & (1 << OCF0A)) && count < SYSTEM_TICK_COMPARE)
+	{
+		cycles += SYSTEM_TICK_CYCLES;
+	}
+	
+	SREG = sreg;
+	
+	cycles += (uint16_t)count * SYSTEM_TICK_PRESCALE;
+	
+	#if (F_CPU % 1000000UL) == 0
+	return (millis * 1000UL) + (cycles / SYSTEM_CYCLES_PER_US);
+	#else
+	//Under 1MHz there are no whole cycles per microsecond, and between whole MHz the remainder would be lost
+	return (millis * 1000UL) + (uint16_t)(((uint32_t)cycles * 1000UL) / SYSTEM_CYCLES_PER_MS);
+	#endif
+}
+
+
+
+/**
+ * \brief Gets if a deadline in milliseconds has been reached. Safe across the millisecond counter wrapping
+ * \param deadlineMs The deadline, from SystemMillis() plus some amount
+ * \return True if reached
+ */
+bool SystemTimeReached(uint32_t deadlineMs)
+{
+	return ((int32_t)(SystemMillis() - deadlineMs) >= 0);
+}
+
+
+
+/**
+ * \brief Puts a timer into the wheel slot for its expire time
+ * \param timer The timer
+ */
+static void SoftTimerInsert(SoftTimer_t* timer)
+{
+	//Variables
+	SoftTimer_t** slot = &m_softTimerWheel[timer->expires & (SOFT_TIMER_WHEEL_SIZE - 1)]; //The slot for the timer
+	
+	timer->prev = 0;
+	timer->next = *slot;
+	
+	if(*slot != 0)
+	{
+		(*slot)->prev = timer;
+	}
+	
+	*slot = timer;
+	timer->active = true;
+}
+
+
+
+/**
+ * \brief Takes a timer out of its wheel slot
+ * \param timer The timer
+ */
+static void SoftTimerRemove(SoftTimer_t* timer)
+{
+	if(timer->prev != 0)
+	{
+		timer->prev->next = timer->next;
+	}
+	else
+	{
+		m_softTimerWheel[timer->expires & (SOFT_TIMER_WHEEL_SIZE - 1)] = timer->next;
+	}
+	
+	if(timer->next != 0)
+	{
+		timer->next->prev = timer->prev;
+	}
+	
+	//Keep a slot walk going if this was the next timer to look at
+	if(m_softTimerWalkNext == timer)
+	{
+		m_softTimerWalkNext = timer->next;
+	}
+	
+	timer->next = 0;
+	timer->prev = 0;
+	timer->active = false;
+}
+
+
+
+/**
+ * \brief Starts a software timer, restarting it if it's already running. Call from the main loop, not from interrupts.
+ * \param timer The timer, set up with SOFT_TIMER_INIT or SoftTimerInit before its first start
+ * \param delayMs The milliseconds until the timer first expires
+ * \param periodMs The milliseconds between expires after the first, or 0 for a one shot timer
+ * \param callback The function to call when the timer expires. Called from SoftTimerService
+ * \param arg The argument to pass to the callback
+ */
+void SoftTimerStart(SoftTimer_t* timer, uint32_t delayMs, uint32_t periodMs, SoftTimerCallback_t callback, void* arg)
+{
+	if(timer->active)
+	{
+		SoftTimerRemove(timer);
+	}
+	
+	//At least a millisecond out so it doesn't land in a slot that was already serviced
+	if(delayMs == 0)
+	{
+		delayMs = 1;
+	}
+	
+	timer->expires = SystemMillis() + delayMs;
+	timer->period = periodMs;
+	timer->callback = callback;
+	timer->arg = arg;
+	
+	SoftTimerInsert(timer);
+}
+
+
+
+/**
+ * \brief Stops a software timer
+ * \param timer The timer
+ */
+void SoftTimerStop(SoftTimer_t* timer)
+{
+	if(timer->active)
+	{
+		SoftTimerRemove(timer);
+	}
+}
+
+
+
+/**
+ * \brief Runs the callbacks of the expired software timers. Call from the main loop. \n
+ * Only the slots for the milliseconds passed since the last call are looked at, so the cost doesn't grow with the amount of timers. \n
+ * If the loop falls more than SOFT_TIMER_WHEEL_SIZE milliseconds behind, every slot is looked at once.
+ */
+void SoftTimerService(void)
+{
+	//Variables
+	uint32_t now = SystemMillis(); //The current millisecond
+	uint32_t elapsed = now - m_ulSoftTimerServiced; //The milliseconds since the last service
+	uint32_t slotTime = m_ulSoftTimerServiced; //The millisecond of the slot being looked at
+	SoftTimer_t* timer = 0; //The timer being looked at
+	
+	if(elapsed > SOFT_TIMER_WHEEL_SIZE)
+	{
+		elapsed = SOFT_TIMER_WHEEL_SIZE;
+	}
+	
+	while(elapsed > 0)
+	{
+		slotTime++;
+		elapsed--;
+		
+		timer = m_softTimerWheel[slotTime & (SOFT_TIMER_WHEEL_SIZE - 1)];
+		
+		//Walk the slot. Timers for later laps around the wheel stay where they are
+		while(timer != 0)
+		{
+			m_softTimerWalkNext = timer->next;
+			
+			if((int32_t)(now - timer->expires) >= 0)
+			{
+				SoftTimerRemove(timer);
+				
+				//Reschedule periodic timers off the expire time, not now, so they don't drift
+				if(timer->period != 0)
+				{
+					timer->expires += timer->period;
+					
+					//If the loop fell behind by more than a period, skip the missed expires
+					if((int32_t)(now - timer->expires) >= 0)
+					{
+						timer->expires = now + timer->period;
+					}
+					
+					SoftTimerInsert(timer);
+				}
+				
+				if(timer->callback != 0)
+				{
+					timer->callback(timer->arg);
+				}
+			}
+			
+			timer = m_softTimerWalkNext;
+		}
+	}
+	
+	m_softTimerWalkNext = 0;
+	m_ulSoftTimerServiced = now;
+}
+
+
+#endif
+
+
+
 
 
 
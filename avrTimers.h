@@ -9,6 +9,8 @@
 #ifndef __AVR_TIMERS_H__
 #define __AVR_TIMERS_H__
 
+#include "config.h"
+
 #if defined(__AVR)
 
 #ifdef __cplusplus
@@ -225,6 +227,125 @@ Timer_t;
 
 
 
+#ifndef AVR_TIMERS_USE_SYSTEM_TICK
+///Set as 1 to use Timer 0 as the system tick for the millisecond clock and the software timers. Timer 0 can't be used for PWM then
+#define AVR_TIMERS_USE_SYSTEM_TICK							0
+#endif
+
+
+#if AVR_TIMERS_USE_SYSTEM_TICK == 1 && defined(TCNT0) && defined(OCR0A)
+
+	#ifndef SYSTEM_TICK_HZ
+	///The rate of the system tick interrupt
+	#define SYSTEM_TICK_HZ									1000UL
+	#endif
+
+	#ifndef SOFT_TIMER_WHEEL_SIZE
+	///The amount of slots in the software timer wheel, one per millisecond. Must be a power of 2
+	#define SOFT_TIMER_WHEEL_SIZE							16
+	#endif
+
+	#if (SOFT_TIMER_WHEEL_SIZE & (SOFT_TIMER_WHEEL_SIZE - 1)) != 0
+	#error avrTimers.h: SOFT_TIMER_WHEEL_SIZE must be a power of 2
+	#endif
+
+	#ifndef SYSTEM_TICK_HOOK
+	///Optional function like macro called from the system tick interrupt, for driver ticks such as kp_Tick
+	#define SYSTEM_TICK_HOOK()
+	#endif
+
+	//Pick the smallest prescaler that lets the tick fit in the 8 bit compare register
+	#if (F_CPU / 8 / SYSTEM_TICK_HZ) <= 256
+		#define SYSTEM_TICK_PRESCALE						8UL
+		#define SYSTEM_TICK_CS_BITS							(1 << CS01)
+	#elif (F_CPU / 64 / SYSTEM_TICK_HZ) <= 256
+		#define SYSTEM_TICK_PRESCALE						64UL
+		#define SYSTEM_TICK_CS_BITS							(1 << CS01 | 1 << CS00)
+	#elif (F_CPU / 256 / SYSTEM_TICK_HZ) <= 256
+		#define SYSTEM_TICK_PRESCALE						256UL
+		#define SYSTEM_TICK_CS_BITS							(1 << CS02)
+	#else
+		#define SYSTEM_TICK_PRESCALE						1024UL
+		#define SYSTEM_TICK_CS_BITS							(1 << CS02 | 1 << CS00)
+	#endif
+
+	///The compare value for the tick
+	#define SYSTEM_TICK_COMPARE								((F_CPU / SYSTEM_TICK_PRESCALE / SYSTEM_TICK_HZ) - 1)
+
+	///The CPU cycles per tick. This is what the clock counts with, so a tick that isn't an exact millisecond doesn't drift
+	#define SYSTEM_TICK_CYCLES								((SYSTEM_TICK_COMPARE + 1) * SYSTEM_TICK_PRESCALE)
+
+	///The CPU cycles per millisecond
+	#define SYSTEM_CYCLES_PER_MS							(F_CPU / 1000UL)
+
+	///The CPU cycles per microsecond. Only exact when F_CPU is in whole MHz, otherwise SystemMicros works from SYSTEM_CYCLES_PER_MS
+	#define SYSTEM_CYCLES_PER_US							(F_CPU / 1000000UL)
+
+	#if (SYSTEM_TICK_CYCLES * 2) + SYSTEM_CYCLES_PER_MS > 0xFFFF
+	#error avrTimers.h: SYSTEM_TICK_HZ is too slow for this F_CPU
+	#endif
+
+
+	///Function pointer type for software timer callbacks
+	typedef void (*SoftTimerCallback_t)(void* arg);
+
+
+	typedef struct _SOFT_TIMER_
+	{
+		struct _SOFT_TIMER_* next;						///The next timer in the wheel slot
+		struct _SOFT_TIMER_* prev;						///The previous timer in the wheel slot
+		uint32_t expires;								///The millisecond the timer expires on
+		uint32_t period;								///The period in milliseconds for periodic timers, 0 for one shot
+		SoftTimerCallback_t callback;					///The function to call when the timer expires
+		void* arg;										///The argument passed to the callback
+		bool active;									///If the timer is in the wheel
+
+	}
+	/**
+	* \brief Struct for a software timer. The memory belongs to the caller and must stay valid while the timer is active. \n
+	* A timer has to start out stopped, so set one up with SOFT_TIMER_INIT or SoftTimerInit before the first SoftTimerStart. \n
+	* Globals and statics are already zeroed, which is the same
+	*/
+	SoftTimer_t;
+
+	///Initialiser for a stopped software timer, such as SoftTimer_t timer = SOFT_TIMER_INIT;
+	#define SOFT_TIMER_INIT									{ 0, 0, 0, 0, 0, 0, false }
+
+
+	extern void SystemTickInit(void);
+	extern uint32_t SystemMillis(void);
+	extern uint32_t SystemMicros(void);
+	extern bool SystemTimeReached(uint32_t deadlineMs);
+
+	extern void SoftTimerStart(SoftTimer_t* timer, uint32_t delayMs, uint32_t periodMs, SoftTimerCallback_t callback, void* arg);
+	extern void SoftTimerStop(SoftTimer_t* timer);
+	extern void SoftTimerService(void);
+
+	/**
+	* \brief Sets up a software timer as stopped. Needed before the first SoftTimerStart on one that isn't zeroed, such as on the stack
+	* \param timer The timer
+	*/
+	static inline void SoftTimerInit(SoftTimer_t* timer)
+	{
+		timer->next = 0;
+		timer->prev = 0;
+		timer->active = false;
+	}
+
+	/**
+	* \brief Gets if a software timer is running
+	* \param timer The timer
+	* \return True if active
+	*/
+	static inline bool SoftTimerIsActive(SoftTimer_t* timer)
+	{
+		return timer->active;
+	}
+
+#endif
+
+
+
 
 
 #ifdef __cplusplus
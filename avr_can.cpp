@@ -28,6 +28,7 @@
 
 #include "avr_can.h"
 #include <avr/interrupt.h>
+#include "mcuIsrStats.h"
 #include <string.h>
   
     
@@ -39,6 +40,11 @@
 CANRaw::CANRaw() {
 	bigEndian = false;
 	busSpeed = 0;
+	wasErrorPassive = false;
+	memset((void *)&stats, 0, sizeof(CAN_STATS));
+	cacheHook = 0;
+	txHook = 0;
+	reservedMob = -1;
 	
 	for (int i = 0; i < SIZE_LISTENERS; i++) listener[i] = NULL;
 }
@@ -140,6 +146,7 @@ uint8_t CANRaw::setNumTXBoxes(uint8_t txboxes) {
 	if (txboxes < 0)              c = 0;
     
     numTXBoxes = c;
+    reservedMob = -1;                                                   // The boxes are being laid out again, so nothing stays reserved
     
     
 	//Initialize remaining Mob as RX boxes
@@ -153,6 +160,9 @@ uint8_t CANRaw::setNumTXBoxes(uint8_t txboxes) {
 	//Initialize TX boxes
 	for (c = CANMB_QUANTITY - numTXBoxes; c < CANMB_QUANTITY; c++) {
 		mailbox_set_accept_mask(c, 0x7FF, false);
+		mailbox_set_MOb_index(c);
+		CANCDMOB &= ~((1<<CONMOB1)|(1<<CONMOB0));                       // Stop it receiving, if an earlier layout had it as an RX box
+		disable_interrupt(c);
 	}
     
     return (numTXBoxes);
@@ -183,6 +193,28 @@ void CANRaw::setGeneralCallback(void (*cb)(CAN_FRAME *))
 	cbCANFrame[CANMB_QUANTITY] = cb;
 }
 
+/**
+ * \brief Set up a cache for frames that only the newest of matters, such as periodic telemetry.
+ * Frames without a mailbox callback are offered to it first, and the ones it keeps skip the catch all, listeners and rx_frame_buff.
+ *
+ * \param hook Function called from the interrupt with each frame, returning true if it kept it. 0 to remove
+ */
+void CANRaw::setCacheHook(bool (*hook)(CAN_FRAME *))
+{
+	cacheHook = hook;
+}
+
+/**
+ * \brief Set up a function to be told of each frame once it has been sent, such as to get the timestamp of a sync message.
+ * The frame's time is the CAN timer when it went out, captured at the start or end of frame as set by set_timestamp_capture_point.
+ *
+ * \param hook Function called from the interrupt with each sent frame. 0 to remove
+ */
+void CANRaw::setTxHook(void (*hook)(CAN_FRAME *))
+{
+	txHook = hook;
+}
+
 void CANRaw::attachCANInterrupt(void (*cb)(CAN_FRAME *)) 
 {
 	setGeneralCallback(cb);
@@ -333,15 +365,30 @@ void CANRaw::disable_interrupt(uint8_t mb)
 
 /**
  * \brief Get the 16-bit free-running internal timer count.
- *
+ * Reading the low byte doesn't latch the high byte, so a carry between the two byte reads would leave the value 256 off.
+ * It's read twice, and a third time if the two disagree, with interrupts off so an ISR between the reads can't look like a carry.
+ * Safe to call from interrupts.
  *
  * \retval The internal CAN free-running timer counter.
  */
 uint16_t CANRaw::get_internal_timer_value()
 {
-	   int t = CANTIML;                         //was --> return (m_pCan->CAN_TIM);
-	   t += (CANTIMH<<8);                       // Always read LOW then HIGH values of 16bit registers from AVR CPUs.
-       return(t);
+	uint8_t sreg = SREG;
+	uint16_t first;
+	uint16_t second;
+
+	cli();
+	first = CANTIML;                                                        // Always read LOW then HIGH values of 16bit registers from AVR CPUs.
+	first |= (uint16_t)CANTIMH << 8;
+	second = CANTIML;
+	second |= (uint16_t)CANTIMH << 8;
+	if ((uint16_t)(second - first) > 0x80)                                  // One of them caught a carry and is 256 off. Another can't come
+	{                                                                       //    this soon, so a third read is right
+		second = CANTIML;
+		second |= (uint16_t)CANTIMH << 8;
+	}
+	SREG = sreg;
+	return second;
 }
 
 /**
@@ -379,6 +426,47 @@ uint8_t CANRaw::get_rx_error_cnt()
 	return (uint8_t) (CANREC);                              //was --> (m_pCan->CAN_ECR >> CAN_ECR_REC_Pos);
 }
 
+/**
+ * \brief Get the CAN error state from the general status register.
+ *
+ * \retval CAN_STATE_ERROR_ACTIVE, CAN_STATE_ERROR_PASSIVE or CAN_STATE_BUS_OFF
+ */
+uint8_t CANRaw::get_error_state()
+{
+	uint8_t status = CANGSTA;
+
+	if (status & (1<<BOFF)) return CAN_STATE_BUS_OFF;
+	if (status & (1<<ERRP)) return CAN_STATE_ERROR_PASSIVE;
+	return CAN_STATE_ERROR_ACTIVE;
+}
+
+/**
+ * \brief Copy the error and frame counters, with interrupts off so the handler can't change them part way through.
+ *
+ * \param copy Where to put them
+ */
+void CANRaw::get_stats(CAN_STATS &copy)
+{
+	uint8_t sreg = SREG;
+
+	cli();
+	memcpy(&copy, (const void *)&stats, sizeof(CAN_STATS));
+	SREG = sreg;
+}
+
+/**
+ * \brief Zero the error and frame counters.
+ */
+void CANRaw::clear_stats()
+{
+	uint8_t sreg = SREG;
+
+	cli();
+	memset((void *)&stats, 0, sizeof(CAN_STATS));
+	wasErrorPassive = false;
+	SREG = sreg;
+}
+
 
 /**
  * \brief Send single mailbox abort request.
@@ -496,6 +584,7 @@ template <typename t> void CANRaw::write(t inputValue)
 bool CANRaw::sendFrame(CAN_FRAME& txFrame) 
 {
 	for (int i = (CANMB_QUANTITY - numTXBoxes); i < CANMB_QUANTITY; i++) {          // Search the Tx MObs, looking for one that is not currently busy.
+           if (i == reservedMob) continue;                                          //    Skipping the one kept for scheduled frames
        	   mailbox_set_MOb_index(i);                                                //    Select a Mob
               if ( (i < 8)   && !(CANEN2 & (1<<i))        ||                        //    1st 8 read-bits in CANEN2.  bit=1 = in use.
                   ((i >= 8)  && !(CANEN1 & (1<<(i-8)))))                            //    Next 8 in CANEN1
@@ -529,6 +618,116 @@ bool CANRaw::sendFrame(CAN_FRAME& txFrame)
 	return true;
 }
 
+/**
+ * \brief Keep a TX MOb for frames that have to go out at a set time, such as from a schedule.
+ * It's the first of the TX boxes, and sendFrame and the queue leave it alone, so at least 2 TX boxes are needed.
+ * Laying the boxes out again with setNumTXBoxes releases it.
+ *
+ * \retval The MOb, or -1 if there aren't enough TX boxes
+ */
+int8_t CANRaw::reserveTxMob()
+{
+	if (reservedMob < 0 && numTXBoxes >= 2) reservedMob = CANMB_QUANTITY - numTXBoxes;
+	return reservedMob;
+}
+
+/**
+ * \brief Give the reserved TX MOb back to sendFrame and the queue
+ */
+void CANRaw::releaseTxMob()
+{
+	reservedMob = -1;
+}
+
+/**
+ * \brief Check if the reserved TX MOb still holds a frame that hasn't gone out
+ *
+ * \retval True if busy. False if not, or if there is no reserved MOb
+ */
+bool CANRaw::reservedBusy()
+{
+	if (reservedMob < 0) return false;
+	if (reservedMob < 8) return ((CANEN2 & (1<<reservedMob)) != 0);
+	return ((CANEN1 & (1<<(reservedMob-8))) != 0);
+}
+
+/**
+ * \brief Count the frames sendFrame can take right now without failing, free TX MObs plus room in the queue.
+ * Only grows until something else sends, as the interrupt empties the MObs and the queue.
+ *
+ * \retval The frames that can be sent
+ */
+uint8_t CANRaw::txRoom()
+{
+	uint8_t room = 0;
+	
+	for (int i = (CANMB_QUANTITY - numTXBoxes); i < CANMB_QUANTITY; i++) {
+		if (i == reservedMob) continue;
+		if (((i < 8)  && !(CANEN2 & (1<<i))) ||
+			((i >= 8) && !(CANEN1 & (1<<(i-8))))) room++;
+	}
+	
+	room += (tx_buffer_head + SIZE_TX_BUFFER - tx_buffer_tail - 1) % SIZE_TX_BUFFER;  // The queue keeps one slot empty to tell full from empty
+	return room;
+}
+
+/**
+ * \brief Count the frames sendFrame can take right now and still put on the bus in the order they were given.
+ * The controller sends the waiting MObs by its own priority rather than the order they were loaded, and the interrupt
+ * refills whichever MOb is free from the queue. With one TX MOb the queue drains through it in order, so it's txRoom().
+ * With more, a frame is only sure to go out after the ones before it once every TX MOb and the queue are empty, so it's 1 then, 0 otherwise.
+ *
+ * \retval The frames that can be sent in order
+ */
+uint8_t CANRaw::txOrderedRoom()
+{
+	uint8_t boxes = (reservedMob < 0) ? numTXBoxes : (numTXBoxes - 1);  // The TX MObs sendFrame uses
+	uint8_t room = txRoom();
+	
+	if (boxes <= 1) return room;
+	return (room == boxes + SIZE_TX_BUFFER - 1) ? 1 : 0;
+}
+
+/**
+ * \brief Send a frame from the reserved TX MOb, dropping a frame still waiting in it so the new one isn't held up.
+ * Safe to call from other interrupts, as the MOb page is put back after.
+ *
+ * \param txFrame The filled out frame structure to use for sending
+ *
+ * \retval True if it was loaded. False if there is no reserved MOb, or the old frame was already on the bus
+ */
+bool CANRaw::sendReserved(CAN_FRAME& txFrame)
+{
+	uint8_t sreg = SREG;
+	uint8_t savedPage = CANPAGE;
+	bool loaded = false;
+
+	if (reservedMob < 0) return false;
+
+	cli();
+	mailbox_set_MOb_index(reservedMob);
+	CANCDMOB &= ~((1<<CONMOB1)|(1<<CONMOB0));                               // Drop a frame that's still waiting, if any
+
+	if (!reservedBusy())                                                    // Only busy now if it's mid frame on the bus
+	{
+		CANSTMOB = 0;
+		mailbox_set_id(reservedMob, txFrame.id, txFrame.extended);
+		CANCDMOB = (txFrame.length & 0x0F);
+		if (txFrame.extended)
+			CANCDMOB |= 1<<IDE;
+		for (uint8_t cnt = 0; cnt < 8; cnt++)
+		{
+			CANMSG = txFrame.data.bytes[cnt];
+		}
+		enable_interrupt(reservedMob);
+		loaded = (mailbox_tx_frame(reservedMob) == CAN_MAILBOX_TRANSFER_OK);
+	}
+
+	CANPAGE = savedPage;
+	SREG = sreg;
+	return loaded;
+}
+
   
 
 /**
@@ -555,6 +754,7 @@ uint8_t CANRaw::mailbox_read(uint8_t uc_index, volatile CAN_FRAME *rxframe)
         rxframe->extended = false;
 	}
     rxframe->id = ul_id;
+    rxframe->rtr = (CANIDT4 & (1<<RTRTAG)) ? 1 : 0;                      // A remote frame asks for the id's data, it has none of its own
     rxframe->length = CANCDMOB & 0x0F;
     rxframe->time   = CANSTML;
     rxframe->time   += (CANSTMH<<8);                                     // Always read LOW then HIGH values of 16bit registers from AVR CPUs.
@@ -699,7 +899,9 @@ uint8_t CANRaw::get_rx_buff(CAN_FRAME& buffer) {
 	if (rx_buffer_head == rx_buffer_tail) return 0;
 	buffer.id = rx_frame_buff[rx_buffer_tail].id;
 	buffer.extended = rx_frame_buff[rx_buffer_tail].extended;
+	buffer.rtr = rx_frame_buff[rx_buffer_tail].rtr;
 	buffer.length = rx_frame_buff[rx_buffer_tail].length;
+	buffer.time = rx_frame_buff[rx_buffer_tail].time;
 	buffer.data.value = rx_frame_buff[rx_buffer_tail].data.value;
 	rx_buffer_tail = (rx_buffer_tail + 1) % SIZE_RX_BUFFER;
 	return 1;
@@ -711,6 +913,8 @@ uint8_t CANRaw::get_rx_buff(CAN_FRAME& buffer) {
 void CANRaw::interruptHandler() {
 
 	uint16_t ul_status;
+	uint8_t generalStatus;
+	bool isErrorPassive;
     int i;
  
 	ul_status = CANSIT2;                                //get status of MOb interrupts
@@ -721,6 +925,17 @@ void CANRaw::interruptHandler() {
              mailbox_int_handler(i);                        //  . . . call the handler
     }
 
+    generalStatus = CANGIT;                                 // Count the errors not tied to a MOb, and bus off
+    if (generalStatus & (1<<BOFFIT)) stats.busOff++;
+    if (generalStatus & (1<<SERG))   stats.stuffErrors++;
+    if (generalStatus & (1<<CERG))   stats.crcErrors++;
+    if (generalStatus & (1<<FERG))   stats.formErrors++;
+    if (generalStatus & (1<<AERG))   stats.ackErrors++;
+
+    isErrorPassive = ((CANGSTA & (1<<ERRP)) != 0);          // There is no interrupt for going error passive, so catch the change here
+    if (isErrorPassive && !wasErrorPassive) stats.errorPassive++;
+    wasErrorPassive = isErrorPassive;
+
    
     /**********   Origional Due code follows - looks like they ignore any other error type outside of mail-boxes..
     if (ul_status & CAN_SR_ERRA) { //error active
@@ -902,6 +1117,8 @@ void CANRaw::mailbox_int_handler(uint8_t mb) {
                                 
     if (CANSTMOB & (1<<RXOK)) {                                              // Here bacuase of an Receive interupt?
            	mailbox_read(mb, &tempFrame);                                     // Yes, so go get it!
+            stats.rxFrames++;
+            stats.busBits += (tempFrame.extended ? CAN_FRAME_BITS_EXT : CAN_FRAME_BITS_STD) + 8 * tempFrame.length;
 
               // Reset this MOb to receive another message.
             mailbox_set_id(mb, RXIDFilterSave[mb],(CANCDMOB & (1<<IDE)));     // Restore the ID filter, with extended/standard flag.
@@ -917,6 +1134,10 @@ void CANRaw::mailbox_int_handler(uint8_t mb) {
 				caughtFrame = true;
                 (*cbCANFrame[mb])(&tempFrame);
  			}
+			else if (cacheHook && (*cacheHook)(&tempFrame))                 // Latest value only, kept out of the queue?
+			{
+				caughtFrame = true;
+			}
 			else if (cbCANFrame[CANMB_QUANTITY])                            // How about a 'catch-all' call back?
 			{
 				caughtFrame = true;
@@ -951,13 +1172,23 @@ void CANRaw::mailbox_int_handler(uint8_t mb) {
                     memcpy((void *)&rx_frame_buff[rx_buffer_head], &tempFrame, sizeof(CAN_FRAME));
 					rx_buffer_head = temp;
 				}
+				else
+				{
+					stats.rxOverruns++;
+				}
                    
 			}
                          
     } else if (CANSTMOB & (1<<TXOK)) {                                                      // Something just transmitted.
+               stats.txFrames++;
+               stats.busBits += ((CANCDMOB & (1<<IDE)) ? CAN_FRAME_BITS_EXT : CAN_FRAME_BITS_STD) + 8 * (CANCDMOB & 0x0F);
+               if (txHook) {                                                                 // Someone wants to know what went out and when?
+                    mailbox_read(mb, &tempFrame);                                            //    Read it back before the MOb is cleared
+                    (*txHook)(&tempFrame);
+               }
                CANSTMOB &= ~(1<<TXOK);                                                       // Clear the Tx interupt flag
                CANCDMOB = 0;  								    //   ... and the controller reg.
-         	if (tx_buffer_head != tx_buffer_tail) 
+         	if (mb != reservedMob && tx_buffer_head != tx_buffer_tail) 
 			{ //if there is a frame in the queue to send - refill this now empty MOb and start sending.
 				mailbox_set_id(mb, tx_frame_buff[tx_buffer_head].id, tx_frame_buff[tx_buffer_head].extended);
                 CANCDMOB = (tx_frame_buff[tx_buffer_head].length & 0x0F);
@@ -979,6 +1210,12 @@ void CANRaw::mailbox_int_handler(uint8_t mb) {
      //!       disable_interrupt(mb);                                                          // Due API does not report out errors, so just clear it here and free the MOb
        //!     CANSTMOB &= ~((1<<AERR)|(1<<FERR)|(1<<CERR)|(1<<SERR)|(1<<BERR)|(1<<DLCW));     // Clear all the 'other' interupt bits that we are ignoring.
       //!      CANCDMOB &= ~((1<<CONMOB1)|(1<<CONMOB0));                                       // And reset the command register to unused (idle) 
+            uint8_t errors = CANSTMOB;                                                      // Count them before they're cleared
+            if (errors & (1<<BERR)) stats.bitErrors++;
+            if (errors & (1<<SERR)) stats.stuffErrors++;
+            if (errors & (1<<CERR)) stats.crcErrors++;
+            if (errors & (1<<FERR)) stats.formErrors++;
+            if (errors & (1<<AERR)) stats.ackErrors++;
             uint8_t bCANCDMOB = CANCDMOB;                                                   //! Reset the Mob to continue on as it had before.
             CANCDMOB = 0;                                                                   //! Need to reset MOb to idle 1st
             CANSTMOB &= ~((1<<AERR)|(1<<FERR)|(1<<CERR)|(1<<SERR)|(1<<BERR)|(1<<DLCW));     //! Clear all the 'other' interupt bits that we are ignoring.
@@ -1044,12 +1281,14 @@ void CANListener::detachGeneralHandler()
 	ISR(CAN_INT_vect)
 #endif   
 {
+    ISR_STATS_ENTER(ISR_STATS_ID_CAN);
     uint8_t savedMOB;                                           // Save and restore the index value, in case interrupt occurred during an ongoing operation..
 
     savedMOB = CANPAGE;
     Can0.interruptHandler();
     CANPAGE = savedMOB;
 
+    ISR_STATS_EXIT(ISR_STATS_ID_CAN);
 } 
 
 
@@ -1061,7 +1300,9 @@ void CANListener::detachGeneralHandler()
 	ISR(CAN_TOVF_vect)
 #endif
 {                                                               // Should never get here, as Overflow interrupts are not enabled - -
+        ISR_STATS_ENTER(ISR_STATS_ID_CAN_TIMER);
         CANGIT  |= (1<<OVRTIM);                                 // But if we do, simply ignore this error and reset things.
+        ISR_STATS_EXIT(ISR_STATS_ID_CAN_TIMER);
 }
 
 
@@ -248,6 +248,31 @@ typedef struct
 	BytesUnion data;	// 64 bits - lots of ways to access it.
 } CAN_FRAME;
 
+/** Error states returned by get_error_state */
+#define CAN_STATE_ERROR_ACTIVE        0     //! Normal operation, both error counters under 128
+#define CAN_STATE_ERROR_PASSIVE       1     //! An error counter is 128 or more, the node only sends passive error flags
+#define CAN_STATE_BUS_OFF             2     //! The transmit error counter went past 255, the node is off the bus
+
+/** Bits on the bus for a frame without its data and stuff bits, including the 3 bit intermission */
+#define CAN_FRAME_BITS_STD            47
+#define CAN_FRAME_BITS_EXT            67
+
+//Counters kept by the interrupt handler. They wrap, so use the difference between two reads
+typedef struct
+{
+	uint16_t bitErrors;         // Bit errors on our own transmits
+	uint16_t stuffErrors;       // Stuff errors, in a MOb or on the bus
+	uint16_t crcErrors;         // CRC errors, in a MOb or on the bus
+	uint16_t formErrors;        // Form errors, in a MOb or on the bus
+	uint16_t ackErrors;         // Transmits nobody acknowledged, in a MOb or on the bus
+	uint16_t errorPassive;      // Times the controller went error passive
+	uint16_t busOff;            // Times the controller went bus off
+	uint16_t rxFrames;          // Frames received into a MOb
+	uint16_t txFrames;          // Frames sent from a MOb
+	uint16_t rxOverruns;        // Received frames dropped for a full rx_frame_buff
+	uint32_t busBits;           // Estimated bits on the bus for the frames sent and received, for the bus load
+} CAN_STATS;
+
 class CANListener
 {
 public:
@@ -291,7 +316,13 @@ class CANRaw
     
     uint32_t RXIDFilterSave[CANMB_QUANTITY];                            // CAN ID Mask registers are overwritten with incomming message IDs, need to save values to reinitialize
 
+    volatile CAN_STATS stats;                                           // Error and frame counters, kept by the interrupt handler
+    bool wasErrorPassive;                                               // Error passive state at the last interrupt, for counting the changes
+
 	void (*cbCANFrame[CANMB_QUANTITY+1])(CAN_FRAME *);                  //Call-Back function pointer array - max mailboxes plus an optional catch all
+	bool (*cacheHook)(CAN_FRAME *);                                     //Optional latest value cache, tried before the catch all. Returns true if it kept the frame
+	void (*txHook)(CAN_FRAME *);                                        //Optional hook told of each sent frame, with its timestamp
+	int8_t reservedMob;                                                 //TX MOb kept out of sendFrame and the queue for scheduled frames, -1 if none
 	CANListener *listener[SIZE_LISTENERS];	
 
     void mailbox_set_MOb_index(uint8_t uc_index);                       // Sets internal Mob pointer to uc_index
@@ -341,11 +372,20 @@ class CANRaw
 	uint8_t get_rx_buff(CAN_FRAME &);
 	uint8_t read(CAN_FRAME &);
 	bool sendFrame(CAN_FRAME& txFrame);
+	int8_t reserveTxMob();
+	void releaseTxMob();
+	bool reservedBusy();
+	uint8_t txRoom();
+	uint8_t txOrderedRoom();
+	bool sendReserved(CAN_FRAME& txFrame);
     
  	uint8_t  get_tx_error_cnt();
 	uint8_t  get_rx_error_cnt(); 
     uint16_t get_internal_timer_value();
     uint16_t get_timestamp_value();
+    uint8_t  get_error_state();
+    void get_stats(CAN_STATS &);
+    void clear_stats();
     
     void disable_overload_frame();
 	void enable_overload_frame();
@@ -361,6 +401,8 @@ class CANRaw
     
 	void setCallback(int mailbox, void (*cb)(CAN_FRAME *));         // Not sure why two names for the same capability, but it was in the origional due lib so leaving it...
 	void setGeneralCallback(void (*cb)(CAN_FRAME *));
+	void setCacheHook(bool (*hook)(CAN_FRAME *));
+	void setTxHook(void (*hook)(CAN_FRAME *));
 	//note that these below versions still use mailbox number. There isn't a good way around this. 
 	void attachCANInterrupt(void (*cb)(CAN_FRAME *));                //alternative callname for setGeneralCallback
 	void attachCANInterrupt(uint8_t mailBox, void (*cb)(CAN_FRAME *));
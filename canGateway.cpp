@@ -0,0 +1,685 @@
+/**
+ * \file canGateway.cpp
+ * \author Timothy Robbins
+ * \brief CAN to serial gateway
+ */
+#if defined(__cplusplus) && defined(__AVR)
+#if defined(__AVR_ATmega32C1__) || defined(__AVR_ATmega64C1__) || defined(__AVR_ATmega16M1__) || defined(__AVR_ATmega32M1__) || defined(__AVR_ATmega64M1__)
+
+#ifndef __CAN_GATEWAY_CPP__
+#define __CAN_GATEWAY_CPP__
+
+
+#include "canGateway.h"
+#include <avr/interrupt.h>
+
+
+#if (CAN_GATEWAY_TX_SIZE > 256) || (CAN_GATEWAY_TX_SIZE & (CAN_GATEWAY_TX_SIZE - 1))
+#error CAN_GATEWAY_TX_SIZE must be a power of 2, 256 or less
+#endif
+
+#if CAN_GATEWAY_PACKET_MAX > 255
+#error CAN_GATEWAY_PACKET_MAX must fit the length byte
+#endif
+
+///Mask for wrapping a ring index
+#define CAN_GATEWAY_TX_MASK             (CAN_GATEWAY_TX_SIZE - 1)
+
+///Bytes a packet adds around its payload, the sync, type, length and check
+#define CAN_GATEWAY_PACKET_OVERHEAD     4
+
+///Command parser states
+#define CAN_GATEWAY_RX_SYNC             0
+#define CAN_GATEWAY_RX_TYPE             1
+#define CAN_GATEWAY_RX_LENGTH           2
+#define CAN_GATEWAY_RX_PAYLOAD          3
+#define CAN_GATEWAY_RX_CHECK            4
+
+
+typedef struct _CAN_GATEWAY_FILTER_
+{
+    uint32_t id;                    ///The id to match
+    uint32_t mask;                  ///The bits of the id that have to match
+    uint8_t flags;                  ///CAN_GATEWAY_FILTER_ENABLE and CAN_GATEWAY_FILTER_EXTENDED
+
+}
+/**
+* \brief Struct for a filter set by the host
+*/
+CanGatewayFilter_t;
+
+
+///The packets to the host
+static volatile uint8_t m_uchrGatewayRing[CAN_GATEWAY_TX_SIZE];
+
+///Where the next byte is put in the ring
+static volatile uint8_t m_uchrGatewayHead = 0;
+
+///The next byte to send from the ring
+static volatile uint8_t m_uchrGatewayTail = 0;
+
+///The end of the closed packets, the UART sends up to here
+static volatile uint8_t m_uchrGatewayCommitted = 0;
+
+///If a packet is being filled
+static volatile bool m_bGatewayOpen = false;
+
+///Where the open packet's length byte is
+static volatile uint8_t m_uchrGatewayOpenAt = 0;
+
+///The payload bytes in the open packet
+static volatile uint8_t m_uchrGatewayOpenLength = 0;
+
+///The sum of the open packet so far
+static volatile uint8_t m_uchrGatewayOpenSum = 0;
+
+///If the UART is sending a byte
+static volatile bool m_bGatewaySending = false;
+
+///The filters set by the host
+static CanGatewayFilter_t m_canGatewayFilters[CAN_GATEWAY_FILTERS];
+
+///The amount of times the CAN timer has wrapped, its upper 16 bits
+static volatile uint16_t m_uintGatewayWraps = 0;
+
+///The newest CAN timer value seen
+static volatile uint16_t m_uintGatewayLastTimer = 0;
+
+///The command parser state
+static volatile uint8_t m_uchrGatewayRxState = CAN_GATEWAY_RX_SYNC;
+
+///The bytes of the command's payload received
+static volatile uint8_t m_uchrGatewayRxCount = 0;
+
+///The sum of the command so far
+static volatile uint8_t m_uchrGatewayRxSum = 0;
+
+///The type of the command
+static volatile uint8_t m_uchrGatewayCommandType = 0;
+
+///The payload length of the command
+static volatile uint8_t m_uchrGatewayCommandLength = 0;
+
+///The payload of the command
+static volatile uint8_t m_uchrGatewayCommand[CAN_GATEWAY_COMMAND_MAX];
+
+///If a command is waiting for CanGatewayPoll
+static volatile bool m_bGatewayCommandReady = false;
+
+///The counters
+static volatile CanGatewayStats_t m_canGatewayStats;
+
+
+
+/**
+ * \brief Extends a CAN timer value to 32 bits. Call with interrupts off
+ * \param timer The timer value, from the timer or a frame. Can be a little older than the newest seen
+ * \return The ticks
+ */
+static uint32_t CanGatewayExtend(uint16_t timer)
+{
+    //Variables
+    uint16_t ahead = timer - m_uintGatewayLastTimer; //The ticks past the newest value seen
+
+    if(ahead < 0x8000)
+    {
+        if(timer < m_uintGatewayLastTimer)
+        {
+            m_uintGatewayWraps++;
+        }
+
+        m_uintGatewayLastTimer = timer;
+        return ((uint32_t)m_uintGatewayWraps << 16) | timer;
+    }
+
+    //A frame stamped before the newest value, such as one received while the poll had interrupts off
+    return (((uint32_t)m_uintGatewayWraps << 16) | m_uintGatewayLastTimer) - (uint16_t)(m_uintGatewayLastTimer - timer);
+}
+
+
+
+/**
+ * \brief The bytes free in the ring
+ * \return The bytes
+ */
+static inline uint8_t CanGatewayFree(void)
+{
+    return (uint8_t)(CAN_GATEWAY_TX_MASK - ((m_uchrGatewayHead - m_uchrGatewayTail) & CAN_GATEWAY_TX_MASK));
+}
+
+
+
+/**
+ * \brief Puts a byte of the open packet's payload in the ring
+ * \param value The byte
+ */
+static inline void CanGatewayPut(uint8_t value)
+{
+    m_uchrGatewayRing[m_uchrGatewayHead] = value;
+    m_uchrGatewayHead = (m_uchrGatewayHead + 1) & CAN_GATEWAY_TX_MASK;
+    m_uchrGatewayOpenSum += value;
+    m_uchrGatewayOpenLength++;
+}
+
+
+
+/**
+ * \brief Puts a little endian value of the open packet's payload in the ring
+ * \param value The value
+ * \param length The bytes of it to put
+ */
+static void CanGatewayPutValue(uint32_t value, uint8_t length)
+{
+    while(length-- != 0)
+    {
+        CanGatewayPut((uint8_t)value);
+        value >>= 8;
+    }
+}
+
+
+
+/**
+ * \brief Starts a packet. Check there's room for it first
+ * \param type The packet type
+ */
+static void CanGatewayOpen(uint8_t type)
+{
+    m_uchrGatewayRing[m_uchrGatewayHead] = CAN_GATEWAY_SYNC;
+    m_uchrGatewayHead = (m_uchrGatewayHead + 1) & CAN_GATEWAY_TX_MASK;
+    m_uchrGatewayRing[m_uchrGatewayHead] = type;
+    m_uchrGatewayHead = (m_uchrGatewayHead + 1) & CAN_GATEWAY_TX_MASK;
+    m_uchrGatewayOpenAt = m_uchrGatewayHead;
+    m_uchrGatewayHead = (m_uchrGatewayHead + 1) & CAN_GATEWAY_TX_MASK;
+
+    m_uchrGatewayOpenSum = type;
+    m_uchrGatewayOpenLength = 0;
+    m_bGatewayOpen = true;
+}
+
+
+
+/**
+ * \brief Finishes the open packet, so the UART can send it
+ */
+static void CanGatewayClose(void)
+{
+    m_uchrGatewayRing[m_uchrGatewayOpenAt] = m_uchrGatewayOpenLength;
+    m_uchrGatewayOpenSum += m_uchrGatewayOpenLength;
+
+    m_uchrGatewayRing[m_uchrGatewayHead] = (uint8_t)(0 - m_uchrGatewayOpenSum);
+    m_uchrGatewayHead = (m_uchrGatewayHead + 1) & CAN_GATEWAY_TX_MASK;
+
+    m_uchrGatewayCommitted = m_uchrGatewayHead;
+    m_bGatewayOpen = false;
+}
+
+
+
+/**
+ * \brief Sends the next byte to the host, closing the open packet if the closed ones are all sent. Call with interrupts off
+ */
+static void CanGatewaySendNext(void)
+{
+    if(m_uchrGatewayTail == m_uchrGatewayCommitted)
+    {
+        if(m_bGatewayOpen == false || m_uchrGatewayOpenLength == 0)
+        {
+            m_bGatewaySending = false;
+            return;
+        }
+
+        CanGatewayClose();
+    }
+
+    m_bGatewaySending = true;
+    LINDAT = m_uchrGatewayRing[m_uchrGatewayTail];
+    m_uchrGatewayTail = (m_uchrGatewayTail + 1) & CAN_GATEWAY_TX_MASK;
+}
+
+
+
+/**
+ * \brief Takes each received frame from the CAN interrupt, as the catch all callback
+ * \param frame The frame
+ */
+static void CanGatewayFrame(CAN_FRAME* frame)
+{
+    //Variables
+    uint8_t i = 0; //Loop index
+    bool pass = true; //If the filters pass the frame
+    uint8_t length = (frame->length > 8) ? 8 : frame->length; //The data length
+    uint8_t record = 0; //The bytes in the frame's record
+    uint32_t ticks = 0; //The frame's time
+    const CanGatewayFilter_t* filter = 0; //The filter being checked
+
+    for(i = 0; i < CAN_GATEWAY_FILTERS; i++)
+    {
+        filter = &m_canGatewayFilters[i];
+
+        if(filter->flags & CAN_GATEWAY_FILTER_ENABLE)
+        {
+            pass = false;
+
+            if(((filter->flags & CAN_GATEWAY_FILTER_EXTENDED) != 0) == (frame->extended != 0) && ((frame->id ^ filter->id) & filter->mask) == 0)
+            {
+                pass = true;
+                break;
+            }
+        }
+    }
+
+    if(pass == false)
+    {
+        m_canGatewayStats.filtered++;
+        return;
+    }
+
+    record = 3 + (frame->extended ? 4 : 2) + length;
+    ticks = CanGatewayExtend(frame->time);
+
+    if(m_bGatewayOpen && m_uchrGatewayOpenLength + record > CAN_GATEWAY_PACKET_MAX)
+    {
+        CanGatewayClose();
+    }
+
+    if(CanGatewayFree() < record + (m_bGatewayOpen ? 1 : CAN_GATEWAY_PACKET_OVERHEAD + 4))
+    {
+        m_canGatewayStats.dropped++;
+        return;
+    }
+
+    if(m_bGatewayOpen == false)
+    {
+        CanGatewayOpen(CAN_GATEWAY_FRAMES);
+        CanGatewayPutValue(ticks, 4);
+    }
+
+    CanGatewayPut(length | (frame->extended ? CAN_GATEWAY_EXTENDED : 0));
+    CanGatewayPutValue(ticks, 2);
+    CanGatewayPutValue(frame->id, frame->extended ? 4 : 2);
+
+    for(i = 0; i < length; i++)
+    {
+        CanGatewayPut(frame->data.bytes[i]);
+    }
+
+    m_canGatewayStats.forwarded++;
+
+    if(m_bGatewaySending == false)
+    {
+        CanGatewaySendNext();
+    }
+}
+
+
+
+/**
+ * \brief Takes a byte of a packet from the host
+ * \param value The byte
+ */
+static void CanGatewayReceive(uint8_t value)
+{
+    switch(m_uchrGatewayRxState)
+    {
+        case CAN_GATEWAY_RX_SYNC:
+            if(value == CAN_GATEWAY_SYNC)
+            {
+                //The last command is still waiting, so there's nowhere to put this one
+                if(m_bGatewayCommandReady)
+                {
+                    m_canGatewayStats.badPackets++;
+                }
+                else
+                {
+                    m_uchrGatewayRxState = CAN_GATEWAY_RX_TYPE;
+                }
+            }
+        break;
+
+        case CAN_GATEWAY_RX_TYPE:
+            m_uchrGatewayCommandType = value;
+            m_uchrGatewayRxSum = value;
+            m_uchrGatewayRxState = CAN_GATEWAY_RX_LENGTH;
+        break;
+
+        case CAN_GATEWAY_RX_LENGTH:
+            if(value > CAN_GATEWAY_COMMAND_MAX)
+            {
+                m_canGatewayStats.badPackets++;
+                m_uchrGatewayRxState = CAN_GATEWAY_RX_SYNC;
+                break;
+            }
+
+            m_uchrGatewayCommandLength = value;
+            m_uchrGatewayRxSum += value;
+            m_uchrGatewayRxCount = 0;
+            m_uchrGatewayRxState = (value == 0) ? CAN_GATEWAY_RX_CHECK : CAN_GATEWAY_RX_PAYLOAD;
+        break;
+
+        case CAN_GATEWAY_RX_PAYLOAD:
+            m_uchrGatewayCommand[m_uchrGatewayRxCount++] = value;
+            m_uchrGatewayRxSum += value;
+
+            if(m_uchrGatewayRxCount >= m_uchrGatewayCommandLength)
+            {
+                m_uchrGatewayRxState = CAN_GATEWAY_RX_CHECK;
+            }
+        break;
+
+        default:
+            if((uint8_t)(m_uchrGatewayRxSum + value) == 0)
+            {
+                m_bGatewayCommandReady = true;
+            }
+            else
+            {
+                m_canGatewayStats.badPackets++;
+            }
+
+            m_uchrGatewayRxState = CAN_GATEWAY_RX_SYNC;
+        break;
+    }
+}
+
+
+
+/**
+ * \brief Puts a status packet in the ring, after the open packet
+ */
+static void CanGatewaySendStatus(void)
+{
+    //Variables
+    uint8_t sreg = SREG; //The interrupt state to go back to
+    CAN_STATS canStats; //The CAN counters, for the rx overruns
+
+    Can0.get_stats(canStats);
+
+    cli();
+
+    if(m_bGatewayOpen)
+    {
+        CanGatewayClose();
+    }
+
+    if(CanGatewayFree() >= 18 + CAN_GATEWAY_PACKET_OVERHEAD)
+    {
+        CanGatewayOpen(CAN_GATEWAY_STATUS);
+        CanGatewayPutValue((8000000UL * ((uint32_t)CANTCON + 1)) / (F_CPU / 1000UL), 2);
+        CanGatewayPutValue(m_canGatewayStats.forwarded, 4);
+        CanGatewayPutValue(m_canGatewayStats.filtered, 4);
+        CanGatewayPutValue(m_canGatewayStats.dropped, 2);
+        CanGatewayPutValue(canStats.rxOverruns, 2);
+        CanGatewayPutValue(m_canGatewayStats.badPackets, 2);
+        CanGatewayPutValue(m_canGatewayStats.txFailed, 2);
+        CanGatewayClose();
+
+        if(m_bGatewaySending == false)
+        {
+            CanGatewaySendNext();
+        }
+    }
+
+    SREG = sreg;
+}
+
+
+
+/**
+ * \brief Carries out the command from the host
+ * \return False if the command is malformed or unknown
+ */
+static bool CanGatewayCommand(void)
+{
+    //Variables
+    const volatile uint8_t* payload = m_uchrGatewayCommand; //The command's payload
+    uint8_t length = m_uchrGatewayCommandLength; //The payload length
+    uint8_t idLength = 0; //The bytes in the id
+    uint8_t i = 0; //Loop index
+    uint8_t sreg = 0; //The interrupt state to go back to
+    CAN_FRAME frame; //A frame to send
+    CanGatewayFilter_t filter; //A filter to set
+
+    switch(m_uchrGatewayCommandType)
+    {
+        case CAN_GATEWAY_SEND:
+            idLength = (payload[0] & CAN_GATEWAY_EXTENDED) ? 4 : 2;
+
+            if(length < 1 + idLength || (payload[0] & CAN_GATEWAY_LENGTH_MASK) > 8 || length != 1 + idLength + (payload[0] & CAN_GATEWAY_LENGTH_MASK))
+            {
+                return false;
+            }
+
+            frame.extended = (payload[0] & CAN_GATEWAY_EXTENDED) ? 1 : 0;
+            frame.rtr = 0;
+            frame.priority = 0;
+            frame.length = payload[0] & CAN_GATEWAY_LENGTH_MASK;
+            frame.data.value = 0;
+            frame.id = 0;
+
+            for(i = idLength; i != 0; i--)
+            {
+                frame.id = (frame.id << 8) | payload[i];
+            }
+
+            for(i = 0; i < frame.length; i++)
+            {
+                frame.data.bytes[i] = payload[1 + idLength + i];
+            }
+
+            if(Can0.sendFrame(frame) == false)
+            {
+                m_canGatewayStats.txFailed++;
+            }
+        break;
+
+        case CAN_GATEWAY_FILTER:
+            if(length != 10 || payload[0] >= CAN_GATEWAY_FILTERS)
+            {
+                return false;
+            }
+
+            filter.flags = payload[1];
+            filter.id = 0;
+            filter.mask = 0;
+
+            for(i = 4; i != 0; i--)
+            {
+                filter.id = (filter.id << 8) | payload[1 + i];
+                filter.mask = (filter.mask << 8) | payload[5 + i];
+            }
+
+            sreg = SREG;
+            cli();
+            m_canGatewayFilters[payload[0]] = filter;
+            SREG = sreg;
+        break;
+
+        case CAN_GATEWAY_GET_STATUS:
+            CanGatewaySendStatus();
+        break;
+
+        default:
+            return false;
+    }
+
+    return true;
+}
+
+
+
+/**
+ * \brief Sets up the LIN/UART and takes over the CAN catch all callback. Call after the CAN is set up with a TX MOb for the frames from the host, such as with CAN_init_tx
+ * \param baud The baud rate, up to F_CPU / 8
+ * \return False if the baud rate can't be made within 2%
+ */
+bool CanGatewayInit(uint32_t baud)
+{
+    //Variables
+    uint8_t samples = 0; //Samples per bit being tried
+    uint32_t divider = 0; //Divider being tried
+    uint32_t error = 0; //Its error
+    uint8_t bestSamples = 0; //Samples per bit with the least error
+    uint32_t bestDivider = 0; //Divider with the least error
+    uint32_t bestError = 0xFFFFFFFF; //The least error
+    uint8_t i = 0; //Loop index
+    uint8_t sreg = SREG; //The interrupt state to go back to
+
+    if(baud == 0)
+    {
+        return false;
+    }
+
+    //The bit time is samples * divider cycles, so look for the pair closest to the baud rate
+    for(samples = 8; samples < 64; samples++)
+    {
+        divider = (F_CPU + (samples * baud) / 2) / (samples * baud);
+
+        if(divider == 0 || divider > 4096)
+        {
+            continue;
+        }
+
+        error = F_CPU / (samples * divider);
+        error = (error > baud) ? error - baud : baud - error;
+
+        if(error < bestError)
+        {
+            bestError = error;
+            bestSamples = samples;
+            bestDivider = divider;
+        }
+    }
+
+    if(bestSamples == 0 || bestError * 50 > baud)
+    {
+        return false;
+    }
+
+    cli();
+
+    //Bit timing can only be changed with the controller off
+    LINCR = (1 << LSWRES);
+    LINBTR = (1 << LDISR) | bestSamples;
+    LINBRR = (uint16_t)(bestDivider - 1);
+    LINCR = (1 << LENA) | (1 << LCMD2) | (1 << LCMD1) | (1 << LCMD0);
+    LINENIR = (1 << LENRXOK) | (1 << LENTXOK);
+
+    m_uchrGatewayHead = 0;
+    m_uchrGatewayTail = 0;
+    m_uchrGatewayCommitted = 0;
+    m_bGatewayOpen = false;
+    m_bGatewaySending = false;
+    m_uchrGatewayRxState = CAN_GATEWAY_RX_SYNC;
+    m_bGatewayCommandReady = false;
+
+    m_canGatewayStats.forwarded = 0;
+    m_canGatewayStats.filtered = 0;
+    m_canGatewayStats.dropped = 0;
+    m_canGatewayStats.badPackets = 0;
+    m_canGatewayStats.txFailed = 0;
+
+    for(i = 0; i < CAN_GATEWAY_FILTERS; i++)
+    {
+        m_canGatewayFilters[i].flags = 0;
+    }
+
+    m_uintGatewayWraps = 0;
+    m_uintGatewayLastTimer = Can0.get_internal_timer_value();
+
+    Can0.setGeneralCallback(CanGatewayFrame);
+
+    SREG = sreg;
+
+    return true;
+}
+
+
+
+/**
+ * \brief Keeps the time going and carries out the commands from the host
+ */
+void CanGatewayPoll(void)
+{
+    //Variables
+    uint8_t sreg = SREG; //The interrupt state to go back to
+
+    cli();
+    CanGatewayExtend(Can0.get_internal_timer_value());
+    SREG = sreg;
+
+    if(m_bGatewayCommandReady)
+    {
+        if(CanGatewayCommand() == false)
+        {
+            cli();
+            m_canGatewayStats.badPackets++;
+            SREG = sreg;
+        }
+
+        m_bGatewayCommandReady = false;
+    }
+}
+
+
+
+/**
+ * \brief Gets the gateway's counters
+ * \param stats Where to put them
+ */
+void CanGatewayGetStats(CanGatewayStats_t* stats)
+{
+    //Variables
+    uint8_t sreg = SREG; //The interrupt state to go back to
+
+    cli();
+    stats->forwarded = m_canGatewayStats.forwarded;
+    stats->filtered = m_canGatewayStats.filtered;
+    stats->dropped = m_canGatewayStats.dropped;
+    stats->badPackets = m_canGatewayStats.badPackets;
+    stats->txFailed = m_canGatewayStats.txFailed;
+    SREG = sreg;
+}
+
+
+
+/**
+ * \brief Handles the LIN/UART interrupt, a byte from the host or the last byte to it sent. Call from LIN_TC_vect
+ */
+void CanGatewayUartInterrupt(void)
+{
+    //Variables
+    uint8_t status = LINSIR; //The flags
+
+    if(status & (1 << LRXOK))
+    {
+        CanGatewayReceive(LINDAT);
+        LINSIR = (1 << LRXOK);
+    }
+
+    if(status & (1 << LERR))
+    {
+        LINSIR = (1 << LERR);
+    }
+
+    if(status & (1 << LTXOK))
+    {
+        LINSIR = (1 << LTXOK);
+        CanGatewaySendNext();
+    }
+}
+
+
+
+#if CAN_GATEWAY_USE_LIN == 1
+
+ISR(LIN_TC_vect)
+{
+    CanGatewayUartInterrupt();
+}
+
+#endif
+
+#endif /* __CAN_GATEWAY_CPP__ */
+#endif
+#endif
@@ -0,0 +1,118 @@
+/**
+ * \file canGateway.h
+ * \author Timothy Robbins
+ * \brief CAN to serial gateway, such as for the USB node. Frames are moved between the CANRaw queues and the LIN/UART \n
+ * in UART mode with interrupts on both sides, so the main loop only has to look after the commands from the host. \n
+ * Received frames are taken by the catch all callback in the CAN interrupt and packed as binary records into a ring, \n
+ * several to a serial packet. The packet being filled is closed and sent when the UART runs out of closed packets, \n
+ * so a quiet bus gets a packet per frame and a busy one gets bigger packets, with no timer holding frames back. \n
+ * A standard frame with 8 bytes takes 13 bytes on the serial side, so a fully loaded 500kbit/s bus fits in 1Mbaud. \n
+ * The host can set up to CAN_GATEWAY_FILTERS id/mask filters, send frames onto the bus, and ask for the counters. \n
+ * The M1 and C1 have no USART, the LIN/UART is their only UART, and the gateway owns it. Its LIN_TC_vect calls CanGatewayUartInterrupt, \n
+ * or the gateway defines the vector itself with CAN_GATEWAY_USE_LIN as 1. It's 0 by default so it can't collide with avrLin's. \n
+ * CanGatewayPoll must be called more often than the CAN timer wraps, which with CANTCON at 0 is every 524288 cycles, or 32ms at 16MHz. \n
+ *
+ * Serial packets, both ways: \n
+ * [CAN_GATEWAY_SYNC][type][length][payload, length bytes][check], the check making type, length, payload and check sum to 0. \n
+ * Frame records: [flags][time, 2 bytes][id, 2 bytes, or 4 if extended][data, length bytes], \n
+ * flags having the length in bits 0 to 3 and bit 7 set for an extended id. CANRaw doesn't handle remote frames, so neither does this. \n
+ * Multi byte values are little endian. Times are CAN timer ticks, CAN_GATEWAY_STATUS gives the nanoseconds in a tick. \n
+ *
+ * CAN_GATEWAY_FRAMES, to the host: [first record's time, 4 bytes][records]. The records carry the low 16 bits of their time, \n
+ * so a record's full time is the packet's plus the record's less the packet's, in 16 bit math. \n
+ * CAN_GATEWAY_STATUS, to the host: [tick ns, 2 bytes][forwarded, 4][filtered, 4][dropped, 2][rx overruns, 2][bad packets, 2][tx failed, 2] \n
+ * CAN_GATEWAY_SEND, from the host: [a frame record, without the time] \n
+ * CAN_GATEWAY_FILTER, from the host: [index][flags, bit 0 to enable, bit 7 for extended][id, 4 bytes][mask, 4 bytes]. \n
+ * A frame is passed if it matches any enabled filter, or if none are enabled. \n
+ * CAN_GATEWAY_GET_STATUS, from the host: no payload. \n
+ *
+ * Example use: \n
+ *
+ * ISR(LIN_TC_vect) { CanGatewayUartInterrupt(); } \n
+ * ... \n
+ * CAN_init_tx(CAN_BPS_500K, false, 1); \n
+ * CanGatewayInit(1000000); \n
+ * sei(); \n
+ * ... \n
+ * while(1) { CanGatewayPoll(); ... } \n
+ */
+
+#if defined(__cplusplus) && defined(__AVR)
+#if defined(__AVR_ATmega32C1__) || defined(__AVR_ATmega64C1__) || defined(__AVR_ATmega16M1__) || defined(__AVR_ATmega32M1__) || defined(__AVR_ATmega64M1__)
+
+#ifndef __CAN_GATEWAY_H__
+#define __CAN_GATEWAY_H__
+
+#include <avr/io.h>
+#include "config.h"
+#include "avr_can.h"
+
+
+#ifndef CAN_GATEWAY_TX_SIZE
+///The bytes in the ring of packets waiting to go to the host. 256 or less, a power of 2
+#define CAN_GATEWAY_TX_SIZE             256
+#endif
+
+#ifndef CAN_GATEWAY_PACKET_MAX
+///The most payload bytes in a packet of frames, less than half of CAN_GATEWAY_TX_SIZE so the next can fill while one is sent
+#define CAN_GATEWAY_PACKET_MAX          120
+#endif
+
+#ifndef CAN_GATEWAY_FILTERS
+///The amount of id/mask filters the host can set
+#define CAN_GATEWAY_FILTERS             4
+#endif
+
+#ifndef CAN_GATEWAY_USE_LIN
+///Set as 1 for the gateway to define LIN_TC_vect, otherwise the application's calls CanGatewayUartInterrupt
+#define CAN_GATEWAY_USE_LIN             0
+#endif
+
+#ifndef CAN_GATEWAY_COMMAND_MAX
+///The most payload bytes in a packet from the host
+#define CAN_GATEWAY_COMMAND_MAX         16
+#endif
+
+
+///Byte starting every packet
+#define CAN_GATEWAY_SYNC                0xA5
+
+///Packet types
+#define CAN_GATEWAY_FRAMES              0x01    //Received frames, to the host
+#define CAN_GATEWAY_STATUS              0x02    //The counters, to the host
+#define CAN_GATEWAY_SEND                0x10    //A frame to send, from the host
+#define CAN_GATEWAY_FILTER              0x11    //Sets a filter, from the host
+#define CAN_GATEWAY_GET_STATUS          0x12    //Asks for CAN_GATEWAY_STATUS, from the host
+
+///Frame record flags
+#define CAN_GATEWAY_LENGTH_MASK         0x0F
+#define CAN_GATEWAY_EXTENDED            0x80
+
+///Filter flags
+#define CAN_GATEWAY_FILTER_ENABLE       0x01
+#define CAN_GATEWAY_FILTER_EXTENDED     0x80
+
+
+typedef struct _CAN_GATEWAY_STATS_
+{
+    uint32_t forwarded;             ///Frames put in a packet to the host
+    uint32_t filtered;              ///Frames not passed by the filters
+    uint16_t dropped;               ///Frames dropped for a full ring, the serial side not keeping up
+    uint16_t badPackets;            ///Packets from the host with a bad check or type, or sent while the last was still waiting
+    uint16_t txFailed;              ///Frames from the host that didn't fit in the CAN tx queue
+
+}
+/**
+* \brief Struct for the gateway's counters
+*/
+CanGatewayStats_t;
+
+
+bool CanGatewayInit(uint32_t baud);
+void CanGatewayPoll(void);
+void CanGatewayGetStats(CanGatewayStats_t* stats);
+void CanGatewayUartInterrupt(void);
+
+#endif /* __CAN_GATEWAY_H__ */
+#endif
+#endif
@@ -0,0 +1,537 @@
+/**
+ * \file canIsoTp.cpp
+ * \author Timothy Robbins
+ * \brief ISO 15765-2 style segmented transport over CANRaw
+ */ 
+#if defined(__cplusplus) && defined(__AVR)
+#if defined(__AVR_ATmega32C1__) || defined(__AVR_ATmega64C1__) || defined(__AVR_ATmega16M1__) || defined(__AVR_ATmega32M1__) || defined(__AVR_ATmega64M1__)
+
+#ifndef __CAN_ISO_TP_CPP__
+#define __CAN_ISO_TP_CPP__
+
+
+#include "canIsoTp.h"
+#include <string.h>
+#include "mcuUtils.h"
+
+
+///Protocol control information types, in the high nibble of the first byte
+#define ISOTP_PCI_SINGLE            0x00
+#define ISOTP_PCI_FIRST             0x10
+#define ISOTP_PCI_CONSECUTIVE       0x20
+#define ISOTP_PCI_FLOW              0x30
+
+///Flow control statuses, in the low nibble of the first byte
+#define ISOTP_FLOW_CONTINUE         0
+#define ISOTP_FLOW_WAIT             1
+#define ISOTP_FLOW_OVERFLOW         2
+
+///The longest payload that fits the classic first frame
+#define ISOTP_FIRST_FRAME_MAX       0x0FFF
+
+///Link states
+#define ISOTP_STATE_IDLE            0
+#define ISOTP_STATE_WAIT_FLOW       1
+#define ISOTP_STATE_SENDING         2
+#define ISOTP_STATE_RECEIVING       1
+
+
+
+/**
+ * \brief Ends a transfer and tells the done callback
+ * \param link The link
+ * \param transmit True for the send, false for the receive
+ * \param result The ISOTP_RESULT value
+ */
+static void IsoTpFinish(IsoTpLink_t* link, bool transmit, uint8_t result)
+{
+    if(transmit)
+    {
+        link->txState = ISOTP_STATE_IDLE;
+        link->txFramePending = false;
+    }
+    else
+    {
+        link->rxState = ISOTP_STATE_IDLE;
+        link->rxFlowPending = false;
+    }
+    
+    if(link->done != 0)
+    {
+        link->done(link->context, transmit, result);
+    }
+}
+
+
+
+/**
+ * \brief Sets up a frame with the link's transmit id, padded out to 8 bytes
+ * \param link The link
+ * \param frame The frame to set up
+ */
+static void IsoTpFrameSetup(IsoTpLink_t* link, CAN_FRAME* frame)
+{
+    //Variables
+    uint8_t i = 0; //Loop index
+    
+    frame->id = link->txId;
+    frame->extended = link->extended;
+    frame->rtr = 0;
+    frame->priority = 0;
+    frame->length = 8;
+    
+    for(i = 0; i < 8; i++)
+    {
+        frame->data.bytes[i] = ISOTP_PADDING;
+    }
+}
+
+
+
+/**
+ * \brief Sends a flow control frame
+ * \param link The link
+ * \param status The ISOTP_FLOW status
+ * \return True if it was loaded
+ */
+static bool IsoTpSendFlow(IsoTpLink_t* link, uint8_t status)
+{
+    //Variables
+    CAN_FRAME frame; //The flow control frame
+    
+    IsoTpFrameSetup(link, &frame);
+    frame.data.bytes[0] = ISOTP_PCI_FLOW | status;
+    frame.data.bytes[1] = link->blockSize;
+    frame.data.bytes[2] = link->stMin;
+    
+    return Can0.sendFrame(frame);
+}
+
+
+
+/**
+ * \brief Tries to load the pending transmit frame. After the last frame of a transfer is loaded, the send is done
+ * \param link The link
+ * \return True if there is nothing left pending
+ */
+static bool IsoTpFlush(IsoTpLink_t* link)
+{
+    if(link->txFramePending == false)
+    {
+        return true;
+    }
+    
+    if(Can0.sendFrame(link->txFrame) == false)
+    {
+        return false;
+    }
+    
+    link->txFramePending = false;
+    
+    if(link->txLastFrame)
+    {
+        IsoTpFinish(link, true, ISOTP_RESULT_OK);
+    }
+    
+    return true;
+}
+
+
+
+/**
+ * \brief Converts a received STmin to whole milliseconds. The 100-900us values round up to 1, and reserved values are taken as the max
+ * \param stMin The received STmin
+ * \return The milliseconds
+ */
+static uint8_t IsoTpStMinToMs(uint8_t stMin)
+{
+    if(stMin <= 0x7F)
+    {
+        return stMin;
+    }
+    else if(stMin >= 0xF1 && stMin <= 0xF9)
+    {
+        return 1;
+    }
+    
+    return 0x7F;
+}
+
+
+
+/**
+ * \brief Sets up a link. The callbacks and the block size and STmin asked of senders can be changed after
+ * \param link The link
+ * \param txId The id to send with
+ * \param rxId The id to receive with
+ * \param extended If the ids are extended
+ */
+void IsoTpInit(IsoTpLink_t* link, uint32_t txId, uint32_t rxId, bool extended)
+{
+    memset(link, 0, sizeof(IsoTpLink_t));
+    
+    link->txId = txId;
+    link->rxId = rxId;
+    link->extended = extended;
+    link->blockSize = ISOTP_BLOCK_SIZE;
+    link->stMin = ISOTP_ST_MIN;
+}
+
+
+
+/**
+ * \brief Starts sending a payload. The source callback is asked for the bytes as each frame goes out
+ * \param link The link
+ * \param length The payload length, 1 or more
+ * \return True if started, false if a send is in progress or the length is 0
+ */
+bool IsoTpSend(IsoTpLink_t* link, uint32_t length)
+{
+    //Variables
+    uint8_t* data = link->txFrame.data.bytes; //The frame bytes
+    uint8_t headerSize = 0; //The bytes of protocol control information
+    uint8_t chunk = 0; //The payload bytes in the frame
+    
+    if(link->txState != ISOTP_STATE_IDLE || length == 0 || link->source == 0)
+    {
+        return false;
+    }
+    
+    IsoTpFrameSetup(link, &link->txFrame);
+    
+    //If it fits a single frame...
+    if(length <= 7)
+    {
+        data[0] = ISOTP_PCI_SINGLE | (uint8_t)length;
+        headerSize = 1;
+        chunk = (uint8_t)length;
+        link->txLastFrame = true;
+        link->txState = ISOTP_STATE_SENDING;
+    }
+    //Else start with a first frame and wait for the flow control
+    else
+    {
+        if(length <= ISOTP_FIRST_FRAME_MAX)
+        {
+            data[0] = ISOTP_PCI_FIRST | (uint8_t)(length >> 8);
+            data[1] = (uint8_t)length;
+            headerSize = 2;
+        }
+        else
+        {
+            data[0] = ISOTP_PCI_FIRST;
+            data[1] = 0;
+            data[2] = (uint8_t)(length >> 24);
+            data[3] = (uint8_t)(length >> 16);
+            data[4] = (uint8_t)(length >> 8);
+            data[5] = (uint8_t)length;
+            headerSize = 6;
+        }
+        
+        chunk = 8 - headerSize;
+        link->txLastFrame = false;
+        link->txState = ISOTP_STATE_WAIT_FLOW;
+        link->txDeadline = link->now + ISOTP_TIMEOUT_MS;
+        link->txSequence = 1;
+        link->txWaits = 0;
+    }
+    
+    if(link->source(link->context, &data[headerSize], chunk) != chunk)
+    {
+        link->txState = ISOTP_STATE_IDLE;
+        return false;
+    }
+    
+    link->txRemaining = length - chunk;
+    link->txFramePending = true;
+    IsoTpFlush(link);
+    
+    return true;
+}
+
+
+
+/**
+ * \brief Handles a received frame if it is for the link
+ * \param link The link
+ * \param frame The frame
+ * \return True if it was for the link
+ */
+bool IsoTpReceive(IsoTpLink_t* link, CAN_FRAME& frame)
+{
+    //Variables
+    uint8_t* data = frame.data.bytes; //The frame bytes
+    uint8_t headerSize = 0; //The bytes of protocol control information
+    uint8_t chunk = 0; //The payload bytes in the frame
+    uint32_t total = 0; //The payload length
+    
+    if(frame.id != link->rxId || (bool)frame.extended != link->extended || frame.length == 0)
+    {
+        return false;
+    }
+    
+    switch(data[0] & 0xF0)
+    {
+        case ISOTP_PCI_SINGLE:
+        case ISOTP_PCI_FIRST:
+        
+            //A new transfer from the sender replaces one in progress
+            if(link->rxState != ISOTP_STATE_IDLE)
+            {
+                IsoTpFinish(link, false, ISOTP_RESULT_ABORTED);
+            }
+            
+            if(link->sink == 0)
+            {
+                break;
+            }
+            
+            //If a single frame...
+            if((data[0] & 0xF0) == ISOTP_PCI_SINGLE)
+            {
+                chunk = data[0] & 0x0F;
+                
+                if(chunk != 0 && chunk < frame.length)
+                {
+                    if(link->sink(link->context, 0, &data[1], chunk, chunk))
+                    {
+                        IsoTpFinish(link, false, ISOTP_RESULT_OK);
+                    }
+                }
+                
+                break;
+            }
+            
+            if(frame.length < 8)
+            {
+                break;
+            }
+            
+            total = ((uint16_t)(data[0] & 0x0F) << 8) | data[1];
+            headerSize = 2;
+            
+            //If the 32 bit escape...
+            if(total == 0)
+            {
+                total = ((uint32_t)data[2] << 24) | ((uint32_t)data[3] << 16) | ((uint16_t)data[4] << 8) | data[5];
+                headerSize = 6;
+            }
+            
+            chunk = 8 - headerSize;
+            
+            //Too short to need segmenting, so not valid
+            if(total <= 7)
+            {
+                break;
+            }
+            
+            if(link->sink(link->context, 0, &data[headerSize], chunk, total) == false)
+            {
+                IsoTpSendFlow(link, ISOTP_FLOW_OVERFLOW);
+                break;
+            }
+            
+            link->rxTotal = total;
+            link->rxOffset = chunk;
+            link->rxSequence = 1;
+            link->rxBlockLeft = link->blockSize;
+            link->rxDeadline = link->now + ISOTP_TIMEOUT_MS;
+            link->rxState = ISOTP_STATE_RECEIVING;
+            link->rxFlowPending = (IsoTpSendFlow(link, ISOTP_FLOW_CONTINUE) == false);
+            
+        break;
+        
+        case ISOTP_PCI_CONSECUTIVE:
+        
+            if(link->rxState != ISOTP_STATE_RECEIVING)
+            {
+                break;
+            }
+            
+            if((data[0] & 0x0F) != link->rxSequence)
+            {
+                IsoTpFinish(link, false, ISOTP_RESULT_SEQUENCE);
+                break;
+            }
+            
+            chunk = frame.length - 1;
+            
+            if(chunk > link->rxTotal - link->rxOffset)
+            {
+                chunk = (uint8_t)(link->rxTotal - link->rxOffset);
+            }
+            
+            if(link->sink(link->context, link->rxOffset, &data[1], chunk, link->rxTotal) == false)
+            {
+                IsoTpFinish(link, false, ISOTP_RESULT_ABORTED);
+                break;
+            }
+            
+            link->rxOffset += chunk;
+            link->rxSequence = (link->rxSequence + 1) & 0x0F;
+            link->rxDeadline = link->now + ISOTP_TIMEOUT_MS;
+            
+            if(link->rxOffset >= link->rxTotal)
+            {
+                IsoTpFinish(link, false, ISOTP_RESULT_OK);
+            }
+            //Else if the end of a block, let the sender carry on
+            else if(link->blockSize != 0 && --link->rxBlockLeft == 0)
+            {
+                link->rxBlockLeft = link->blockSize;
+                link->rxFlowPending = (IsoTpSendFlow(link, ISOTP_FLOW_CONTINUE) == false);
+            }
+            
+        break;
+        
+        case ISOTP_PCI_FLOW:
+        
+            if(link->txState != ISOTP_STATE_WAIT_FLOW || frame.length < 3)
+            {
+                break;
+            }
+            
+            switch(data[0] & 0x0F)
+            {
+                case ISOTP_FLOW_CONTINUE:
+                    link->txBlockLeft = data[1];
+                    link->txStMin = IsoTpStMinToMs(data[2]);
+                    link->txWaits = 0;
+                    link->txDeadline = link->now;
+                    link->txState = ISOTP_STATE_SENDING;
+                break;
+                
+                case ISOTP_FLOW_WAIT:
+                    link->txWaits++;
+                    link->txDeadline = link->now + ISOTP_TIMEOUT_MS;
+                    
+                    if(link->txWaits > ISOTP_MAX_WAITS)
+                    {
+                        IsoTpFinish(link, true, ISOTP_RESULT_WAIT_LIMIT);
+                    }
+                break;
+                
+                default:
+                    IsoTpFinish(link, true, ISOTP_RESULT_OVERFLOW);
+                break;
+            }
+            
+        break;
+        
+        default:
+        break;
+    }
+    
+    return true;
+}
+
+
+
+/**
+ * \brief Sends the consecutive frames that are due and checks the timeouts. Call it from the main loop as often as possible
+ * \param link The link
+ * \param nowMs The milliseconds now, such as the low 16 bits of SystemMillis
+ */
+void IsoTpPoll(IsoTpLink_t* link, uint16_t nowMs)
+{
+    //Variables
+    uint8_t chunk = 0; //The payload bytes in the frame
+    
+    link->now = nowMs;
+    
+    //Receive side
+    if(link->rxState == ISOTP_STATE_RECEIVING)
+    {
+        if(link->rxFlowPending)
+        {
+            link->rxFlowPending = (IsoTpSendFlow(link, ISOTP_FLOW_CONTINUE) == false);
+        }
+        
+        if(TimeReached16(nowMs, link->rxDeadline))
+        {
+            IsoTpFinish(link, false, ISOTP_RESULT_TIMEOUT);
+        }
+    }
+    
+    //Transmit side. Load what's allowed until the transmit buffer is full
+    if(IsoTpFlush(link) == false)
+    {
+        return;
+    }
+    
+    if(link->txState == ISOTP_STATE_WAIT_FLOW)
+    {
+        if(TimeReached16(nowMs, link->txDeadline))
+        {
+            IsoTpFinish(link, true, ISOTP_RESULT_TIMEOUT);
+        }
+        
+        return;
+    }
+    
+    while(link->txState == ISOTP_STATE_SENDING && link->txFramePending == false && TimeReached16(nowMs, link->txDeadline))
+    {
+        chunk = (link->txRemaining > 7) ? 7 : (uint8_t)link->txRemaining;
+        
+        IsoTpFrameSetup(link, &link->txFrame);
+        link->txFrame.data.bytes[0] = ISOTP_PCI_CONSECUTIVE | link->txSequence;
+        
+        if(link->source(link->context, &link->txFrame.data.bytes[1], chunk) != chunk)
+        {
+            IsoTpFinish(link, true, ISOTP_RESULT_ABORTED);
+            return;
+        }
+        
+        link->txRemaining -= chunk;
+        link->txSequence = (link->txSequence + 1) & 0x0F;
+        link->txLastFrame = (link->txRemaining == 0);
+        link->txFramePending = true;
+        
+        //Space the frames by STmin. Without one, keep going this poll
+        if(link->txStMin != 0)
+        {
+            link->txDeadline = nowMs + link->txStMin;
+        }
+        
+        //If the end of a block, wait for the next flow control once it's out
+        if(link->txLastFrame == false && link->txBlockLeft != 0 && --link->txBlockLeft == 0)
+        {
+            link->txState = ISOTP_STATE_WAIT_FLOW;
+            link->txDeadline = nowMs + ISOTP_TIMEOUT_MS;
+        }
+        
+        IsoTpFlush(link);
+    }
+}
+
+
+
+/**
+ * \brief Stops both directions without calling the done callback
+ * \param link The link
+ */
+void IsoTpAbort(IsoTpLink_t* link)
+{
+    link->txState = ISOTP_STATE_IDLE;
+    link->txFramePending = false;
+    link->rxState = ISOTP_STATE_IDLE;
+    link->rxFlowPending = false;
+}
+
+
+
+/**
+ * \brief Checks if a transfer is in progress in either direction
+ * \param link The link
+ * \return True if busy
+ */
+bool IsoTpBusy(IsoTpLink_t* link)
+{
+    return (link->txState != ISOTP_STATE_IDLE || link->rxState != ISOTP_STATE_IDLE);
+}
+
+
+
+#endif
+#endif /* __CAN_ISO_TP_CPP__ */
+#endif
@@ -0,0 +1,162 @@
+/**
+ * \file canIsoTp.h
+ * \author Timothy Robbins
+ * \brief ISO 15765-2 style segmented transport over CANRaw, for payloads bigger than a frame. \n
+ * Single, first, consecutive and flow control frames, with block size and STmin in both directions. \n
+ * Payloads are streamed through callbacks, so a transfer never has to fit in RAM. The sender's source callback \n
+ * fills each frame as it goes out, and the receiver's sink callback gets each frame's data as it comes in. \n
+ * Lengths up to 4095 bytes use the classic first frame, longer ones the 32 bit escape. \n
+ * Frames with the same id must leave in order, so use a single transmit MOb (txMobCount of 1 in CAN_init_tx). \n
+ * Received frames are passed in with IsoTpReceive, such as from the CAN_process_frame callback, \n
+ * and IsoTpPoll sends the consecutive frames and checks the timeouts. \n
+ *
+ * Example use: \n
+ *
+ * IsoTpLink_t logLink; \n
+ *
+ * IsoTpInit(&logLink, 0x7E8, 0x7E0, false); \n
+ * logLink.source = LogReadChunk; \n
+ * logLink.sink = ConfigWriteChunk; \n
+ * logLink.done = TransferDone; \n
+ * IsoTpSend(&logLink, logLength); \n
+ * ... \n
+ * int8_t OnFrame(CAN_FRAME& frame) { IsoTpReceive(&logLink, frame); return 0; } \n
+ * ... \n
+ * while(1) { CAN_process_frame(OnFrame); IsoTpPoll(&logLink, (uint16_t)SystemMillis()); } \n
+ */ 
+
+#if defined(__cplusplus) && defined(__AVR)
+#if defined(__AVR_ATmega32C1__) || defined(__AVR_ATmega64C1__) || defined(__AVR_ATmega16M1__) || defined(__AVR_ATmega32M1__) || defined(__AVR_ATmega64M1__)
+
+#ifndef __CAN_ISO_TP_H__
+#define __CAN_ISO_TP_H__
+
+#include <avr/io.h>
+#include "config.h"
+#include "avr_can.h"
+
+
+#ifndef ISOTP_BLOCK_SIZE
+///The amount of consecutive frames the sender may send before waiting for another flow control, 0 for all of them
+#define ISOTP_BLOCK_SIZE            0
+#endif
+
+#ifndef ISOTP_ST_MIN
+///The minimum milliseconds asked of the sender between consecutive frames
+#define ISOTP_ST_MIN                0
+#endif
+
+#ifndef ISOTP_TIMEOUT_MS
+///The milliseconds to wait for a flow control or the next consecutive frame before giving up
+#define ISOTP_TIMEOUT_MS            1000
+#endif
+
+#ifndef ISOTP_MAX_WAITS
+///The amount of flow control waits accepted in a row before giving up
+#define ISOTP_MAX_WAITS             8
+#endif
+
+#ifndef ISOTP_PADDING
+///The byte unused frame bytes are padded with. Frames are always sent 8 bytes long
+#define ISOTP_PADDING               0xCC
+#endif
+
+
+///Result of a transfer passed to the done callback. Finished without errors
+#define ISOTP_RESULT_OK             0
+
+///Result of a transfer passed to the done callback. No flow control or consecutive frame in time
+#define ISOTP_RESULT_TIMEOUT        1
+
+///Result of a transfer passed to the done callback. A consecutive frame was out of order
+#define ISOTP_RESULT_SEQUENCE       2
+
+///Result of a transfer passed to the done callback. The receiver refused the length
+#define ISOTP_RESULT_OVERFLOW       3
+
+///Result of a transfer passed to the done callback. Stopped by a callback, IsoTpAbort, or a new transfer from the sender
+#define ISOTP_RESULT_ABORTED        4
+
+///Result of a transfer passed to the done callback. The receiver asked to wait too many times
+#define ISOTP_RESULT_WAIT_LIMIT     5
+
+
+/**
+ * \brief Fills the next bytes of the payload being sent
+ * \param context The link's context
+ * \param buffer Where to put them
+ * \param length The amount wanted. Returning less aborts the transfer
+ * \return The amount filled
+ */
+typedef uint8_t (*IsoTpSource_t)(void* context, uint8_t* buffer, uint8_t length);
+
+/**
+ * \brief Takes the next bytes of the payload being received
+ * \param context The link's context
+ * \param offset Where the bytes go in the payload. 0 is the start of a new transfer
+ * \param data The bytes
+ * \param length The amount of bytes
+ * \param total The length of the whole payload
+ * \return True to keep going, false to abort. At offset 0 of a segmented transfer, false refuses it with an overflow
+ */
+typedef bool (*IsoTpSink_t)(void* context, uint32_t offset, const uint8_t* data, uint8_t length, uint32_t total);
+
+/**
+ * \brief Called when a transfer ends
+ * \param context The link's context
+ * \param transmit True for a send, false for a receive
+ * \param result One of the ISOTP_RESULT values
+ */
+typedef void (*IsoTpDone_t)(void* context, bool transmit, uint8_t result);
+
+
+typedef struct _ISOTP_LINK_
+{
+    uint32_t txId;                  ///The id frames are sent with
+    uint32_t rxId;                  ///The id frames are received with
+    bool extended;                  ///If the ids are extended
+    uint8_t blockSize;              ///The block size asked of the sender
+    uint8_t stMin;                  ///The STmin asked of the sender
+    IsoTpSource_t source;           ///Fills the payload being sent
+    IsoTpSink_t sink;               ///Takes the payload being received
+    IsoTpDone_t done;               ///Called when a transfer ends, can be 0
+    void* context;                  ///Passed to the callbacks
+    
+    uint16_t now;                   ///The milliseconds of the last poll
+    
+    uint8_t txState;                ///Where the send is
+    uint32_t txRemaining;           ///The payload bytes left to send
+    uint8_t txSequence;             ///The sequence number of the next consecutive frame
+    uint8_t txBlockLeft;            ///The consecutive frames left in the block, 0 for no limit
+    uint8_t txStMin;                ///The milliseconds to leave between consecutive frames
+    uint8_t txWaits;                ///The flow control waits in a row
+    uint16_t txDeadline;            ///When the flow control or next consecutive frame is due
+    bool txFramePending;            ///If txFrame couldn't be loaded yet
+    bool txLastFrame;               ///If txFrame is the last of the transfer
+    CAN_FRAME txFrame;              ///The frame being sent
+    
+    uint8_t rxState;                ///Where the receive is
+    uint32_t rxTotal;               ///The payload length
+    uint32_t rxOffset;              ///The payload bytes received
+    uint8_t rxSequence;             ///The sequence number of the next consecutive frame
+    uint8_t rxBlockLeft;            ///The consecutive frames left before sending another flow control
+    uint16_t rxDeadline;            ///When the next consecutive frame is due
+    bool rxFlowPending;             ///If a flow control couldn't be loaded yet
+
+}
+/**
+* \brief Struct for one end of a segmented transport connection, being a pair of ids
+*/
+IsoTpLink_t;
+
+
+void IsoTpInit(IsoTpLink_t* link, uint32_t txId, uint32_t rxId, bool extended);
+bool IsoTpSend(IsoTpLink_t* link, uint32_t length);
+bool IsoTpReceive(IsoTpLink_t* link, CAN_FRAME& frame);
+void IsoTpPoll(IsoTpLink_t* link, uint16_t nowMs);
+void IsoTpAbort(IsoTpLink_t* link);
+bool IsoTpBusy(IsoTpLink_t* link);
+
+#endif /* __CAN_ISO_TP_H__ */
+#endif
+#endif
@@ -0,0 +1,295 @@
+/**
+ * \file canMonitor.cpp
+ * \author Timothy Robbins
+ * \brief CAN bus health monitoring and bus off recovery
+ */ 
+#if defined(__cplusplus) && defined(__AVR)
+#if defined(__AVR_ATmega32C1__) || defined(__AVR_ATmega64C1__) || defined(__AVR_ATmega16M1__) || defined(__AVR_ATmega32M1__) || defined(__AVR_ATmega64M1__)
+
+#ifndef __CAN_MONITOR_CPP__
+#define __CAN_MONITOR_CPP__
+
+
+#include "canMonitor.h"
+#include <avr/interrupt.h>
+#include <string.h>
+
+
+///Where the monitor is, one of the CAN_MONITOR states
+static uint8_t m_uchrCanMonitorState = CAN_MONITOR_RUNNING;
+
+///Called when the state changes, can be 0
+static void (*m_canMonitorCallback)(uint8_t state) = 0;
+
+///The counters at the start of the window
+static CAN_STATS m_canMonitorStart;
+
+///The CAN timer at the last poll
+static uint16_t m_uintCanMonitorTimer = 0;
+
+///The CAN timer ticks so far in the window
+static uint32_t m_ulCanMonitorTicks = 0;
+
+///The milliseconds the window started at
+static uint16_t m_uintCanMonitorWindowStart = 0;
+
+///The last complete window
+static CanMonitorWindow_t m_canMonitorWindow;
+
+///The bus off count at the last poll, to see new ones
+static uint16_t m_uintCanMonitorBusOffs = 0;
+
+///The milliseconds to wait before the next recovery
+static uint16_t m_uintCanMonitorBackoff = CAN_MONITOR_BACKOFF_MIN_MS;
+
+///When the current wait ends, or when recovering, when the bus was enabled again
+static uint16_t m_uintCanMonitorMark = 0;
+
+///The amount of recoveries from bus off
+static uint16_t m_uintCanMonitorRecoveries = 0;
+
+
+
+/**
+ * \brief Gets the core cycles of one bit from the bit timing registers
+ * \return The cycles
+ */
+static uint16_t CanMonitorBitCycles(void)
+{
+    //Variables
+    uint8_t prescaler = ((CANBT1 >> 1) & 0x3F) + 1; //The baud rate prescaler
+    uint8_t quanta = 1 + (((CANBT2 >> 1) & 0x07) + 1) + (((CANBT3 >> 1) & 0x07) + 1) + (((CANBT3 >> 4) & 0x07) + 1); //Sync, propagation and both phase segments
+    
+    return (uint16_t)prescaler * quanta;
+}
+
+
+
+/**
+ * \brief Changes the state and tells the callback
+ * \param state The new state
+ */
+static void CanMonitorSetState(uint8_t state)
+{
+    m_uchrCanMonitorState = state;
+    
+    if(m_canMonitorCallback != 0)
+    {
+        m_canMonitorCallback(state);
+    }
+}
+
+
+
+/**
+ * \brief Closes the measuring window, working out the bus load and the changes in the counters
+ * \param stats The counters now
+ */
+static void CanMonitorCloseWindow(const CAN_STATS* stats)
+{
+    //Variables
+    uint32_t busBits = stats->busBits - m_canMonitorStart.busBits; //The bits on the bus in the window
+    uint32_t elapsedCycles = m_ulCanMonitorTicks * 8 * ((uint32_t)CANTCON + 1); //The core cycles in the window
+    uint32_t busCycles = 0; //The core cycles the frames took
+    
+    m_canMonitorWindow.rxFrames = stats->rxFrames - m_canMonitorStart.rxFrames;
+    m_canMonitorWindow.txFrames = stats->txFrames - m_canMonitorStart.txFrames;
+    m_canMonitorWindow.rxOverruns = stats->rxOverruns - m_canMonitorStart.rxOverruns;
+    m_canMonitorWindow.errors = (stats->bitErrors - m_canMonitorStart.bitErrors) + (stats->stuffErrors - m_canMonitorStart.stuffErrors) +
+                                (stats->crcErrors - m_canMonitorStart.crcErrors) + (stats->formErrors - m_canMonitorStart.formErrors) +
+                                (stats->ackErrors - m_canMonitorStart.ackErrors);
+    
+    //Scale down so the permille multiply can't overflow
+    busCycles = busBits * CanMonitorBitCycles();
+    
+    while(busCycles > 0x3FFFFF)
+    {
+        busCycles >>= 1;
+        elapsedCycles >>= 1;
+    }
+    
+    if(elapsedCycles == 0)
+    {
+        m_canMonitorWindow.busLoad = 0;
+    }
+    else
+    {
+        m_canMonitorWindow.busLoad = (busCycles * 1000) / elapsedCycles;
+        
+        if(m_canMonitorWindow.busLoad > 1000)
+        {
+            m_canMonitorWindow.busLoad = 1000;
+        }
+    }
+    
+    m_canMonitorStart = *stats;
+    m_ulCanMonitorTicks = 0;
+}
+
+
+
+/**
+ * \brief Starts monitoring the bus. Call after the CAN is initialized
+ * \param stateCallback Function called when the state changes, such as to log bus off. Can be 0
+ */
+void CanMonitorInit(void (*stateCallback)(uint8_t state))
+{
+    m_canMonitorCallback = stateCallback;
+    m_uchrCanMonitorState = CAN_MONITOR_RUNNING;
+    m_uintCanMonitorBackoff = CAN_MONITOR_BACKOFF_MIN_MS;
+    m_uintCanMonitorRecoveries = 0;
+    m_ulCanMonitorTicks = 0;
+    memset(&m_canMonitorWindow, 0, sizeof(m_canMonitorWindow));
+    
+    Can0.get_stats(m_canMonitorStart);
+    m_uintCanMonitorBusOffs = m_canMonitorStart.busOff;
+    m_uintCanMonitorTimer = Can0.get_internal_timer_value();
+}
+
+
+
+/**
+ * \brief Measures the bus and runs the bus off recovery. Call it from the main loop, more often than the CAN timer wraps
+ * \param nowMs The milliseconds now, such as the low 16 bits of SystemMillis
+ */
+void CanMonitorPoll(uint16_t nowMs)
+{
+    //Variables
+    CAN_STATS stats; //The counters now
+    uint16_t timer = 0; //The CAN timer now
+    bool isBusOff = false; //If the controller went bus off since the last poll
+    
+    Can0.get_stats(stats);
+    
+    //The timer stops in standby, so only count it while running
+    if(m_uchrCanMonitorState != CAN_MONITOR_BUS_OFF)
+    {
+        timer = Can0.get_internal_timer_value();
+        m_ulCanMonitorTicks += (uint16_t)(timer - m_uintCanMonitorTimer);
+        m_uintCanMonitorTimer = timer;
+        isBusOff = (stats.busOff != m_uintCanMonitorBusOffs);
+    }
+    
+    //The status stays bus off until the controller's own recovery finishes, so only go by it when running
+    if(m_uchrCanMonitorState == CAN_MONITOR_RUNNING && Can0.get_error_state() == CAN_STATE_BUS_OFF)
+    {
+        isBusOff = true;
+    }
+    
+    m_uintCanMonitorBusOffs = stats.busOff;
+    
+    if((uint16_t)(nowMs - m_uintCanMonitorWindowStart) >= CAN_MONITOR_WINDOW_MS)
+    {
+        CanMonitorCloseWindow(&stats);
+        m_uintCanMonitorWindowStart = nowMs;
+    }
+    
+    switch(m_uchrCanMonitorState)
+    {
+        case CAN_MONITOR_RUNNING:
+        case CAN_MONITOR_RECOVERING:
+        
+            if(isBusOff)
+            {
+                //Stand by for the backoff, then double it for next time
+                Can0.disable();
+                m_uintCanMonitorMark = nowMs + m_uintCanMonitorBackoff;
+                
+                if(m_uintCanMonitorBackoff < CAN_MONITOR_BACKOFF_MAX_MS / 2)
+                {
+                    m_uintCanMonitorBackoff <<= 1;
+                }
+                else
+                {
+                    m_uintCanMonitorBackoff = CAN_MONITOR_BACKOFF_MAX_MS;
+                }
+                
+                CanMonitorSetState(CAN_MONITOR_BUS_OFF);
+            }
+            else if(m_uchrCanMonitorState == CAN_MONITOR_RECOVERING && (uint16_t)(nowMs - m_uintCanMonitorMark) >= CAN_MONITOR_STABLE_MS)
+            {
+                m_uintCanMonitorBackoff = CAN_MONITOR_BACKOFF_MIN_MS;
+                CanMonitorSetState(CAN_MONITOR_RUNNING);
+            }
+            
+        break;
+        
+        case CAN_MONITOR_BUS_OFF:
+        
+            if((int16_t)(nowMs - m_uintCanMonitorMark) >= 0)
+            {
+                //Enabling again starts the controller's own recovery of 128 runs of 11 recessive bits
+                Can0.enable();
+                m_uintCanMonitorTimer = Can0.get_internal_timer_value();
+                m_uintCanMonitorMark = nowMs;
+                m_uintCanMonitorRecoveries++;
+                CanMonitorSetState(CAN_MONITOR_RECOVERING);
+            }
+            
+        break;
+        
+        default:
+        break;
+    }
+}
+
+
+
+/**
+ * \brief Gets the monitor state
+ * \return One of the CAN_MONITOR states
+ */
+uint8_t CanMonitorState(void)
+{
+    return m_uchrCanMonitorState;
+}
+
+
+
+/**
+ * \brief Gets the bus load over the last complete window
+ * \return The load in tenths of a percent
+ */
+uint16_t CanMonitorBusLoad(void)
+{
+    return m_canMonitorWindow.busLoad;
+}
+
+
+
+/**
+ * \brief Copies what happened over the last complete window
+ * \param window Where to copy it
+ */
+void CanMonitorGetWindow(CanMonitorWindow_t* window)
+{
+    *window = m_canMonitorWindow;
+}
+
+
+
+/**
+ * \brief Gets the amount of recoveries from bus off
+ * \return The amount
+ */
+uint16_t CanMonitorRecoveries(void)
+{
+    return m_uintCanMonitorRecoveries;
+}
+
+
+
+/**
+ * \brief Gets the milliseconds the next bus off will wait before recovering
+ * \return The milliseconds
+ */
+uint16_t CanMonitorBackoff(void)
+{
+    return m_uintCanMonitorBackoff;
+}
+
+
+
+#endif
+#endif /* __CAN_MONITOR_CPP__ */
+#endif
@@ -0,0 +1,83 @@
+/**
+ * \file canMonitor.h
+ * \author Timothy Robbins
+ * \brief CAN bus health monitoring. Bus load from the frames counted by the CANRaw interrupt handler over the CAN timer, \n
+ * the change in the error counters over each load window, and bus off recovery with a backoff. \n
+ * When the controller goes bus off, it is put in standby and enabled again after the backoff, which doubles with each bus off \n
+ * in a row up to CAN_MONITOR_BACKOFF_MAX_MS, and goes back to the minimum once the bus has stayed up for CAN_MONITOR_STABLE_MS. \n
+ * CanMonitorPoll must be called more often than the CAN timer wraps, which with CANTCON at 0 is every 524288 cycles, or 32ms at 16MHz. \n
+ *
+ * Example use: \n
+ *
+ * CAN_init_tx(CAN_BPS_500K, false, 1); \n
+ * CanMonitorInit(OnCanState); \n
+ * ... \n
+ * while(1) { CanMonitorPoll((uint16_t)SystemMillis()); ... } \n
+ * ... \n
+ * if(CanMonitorBusLoad() > 700) { ... over 70% ... } \n
+ */ 
+
+#if defined(__cplusplus) && defined(__AVR)
+#if defined(__AVR_ATmega32C1__) || defined(__AVR_ATmega64C1__) || defined(__AVR_ATmega16M1__) || defined(__AVR_ATmega32M1__) || defined(__AVR_ATmega64M1__)
+
+#ifndef __CAN_MONITOR_H__
+#define __CAN_MONITOR_H__
+
+#include <avr/io.h>
+#include "config.h"
+#include "avr_can.h"
+
+
+#ifndef CAN_MONITOR_WINDOW_MS
+///The milliseconds the bus load and error rates are measured over
+#define CAN_MONITOR_WINDOW_MS           100
+#endif
+
+#ifndef CAN_MONITOR_BACKOFF_MIN_MS
+///The milliseconds to wait before the first recovery from bus off
+#define CAN_MONITOR_BACKOFF_MIN_MS      10
+#endif
+
+#ifndef CAN_MONITOR_BACKOFF_MAX_MS
+///The longest wait before a recovery, for a node that keeps going bus off
+#define CAN_MONITOR_BACKOFF_MAX_MS      2000
+#endif
+
+#ifndef CAN_MONITOR_STABLE_MS
+///The milliseconds the bus must stay up after a recovery for the backoff to go back to the minimum
+#define CAN_MONITOR_STABLE_MS           5000
+#endif
+
+
+///Monitor states, passed to the state callback
+#define CAN_MONITOR_RUNNING             0   //Running, error active or passive
+#define CAN_MONITOR_BUS_OFF             1   //Bus off, waiting out the backoff
+#define CAN_MONITOR_RECOVERING          2   //Enabled again, waiting for the bus to stay up
+
+
+typedef struct _CAN_MONITOR_WINDOW_
+{
+    uint16_t busLoad;               ///Bus load in tenths of a percent
+    uint16_t rxFrames;              ///Frames received
+    uint16_t txFrames;              ///Frames sent
+    uint16_t errors;                ///Bit, stuff, CRC, form and ack errors
+    uint16_t rxOverruns;            ///Frames dropped for a full receive buffer
+
+}
+/**
+* \brief Struct for what happened over the last complete measuring window
+*/
+CanMonitorWindow_t;
+
+
+void CanMonitorInit(void (*stateCallback)(uint8_t state));
+void CanMonitorPoll(uint16_t nowMs);
+uint8_t CanMonitorState(void);
+uint16_t CanMonitorBusLoad(void);
+void CanMonitorGetWindow(CanMonitorWindow_t* window);
+uint16_t CanMonitorRecoveries(void);
+uint16_t CanMonitorBackoff(void);
+
+#endif /* __CAN_MONITOR_H__ */
+#endif
+#endif
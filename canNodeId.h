@@ -81,6 +81,18 @@
 ///For requesting they perform a known operation of the type passed
 #define NODE_DATA_REQUEST_KNOWN_OP      0xA0
 
+///For requesting they perform a batch of get and pin operations in one frame, see canNodeProtocol.h
+#define NODE_DATA_REQUEST_BATCH         0x90
+
+///For requesting they push an input's value when it changes, see canNodeProtocol.h
+#define NODE_DATA_REQUEST_SUBSCRIBE     0x80
+
+///For the response to a batch or subscribe request, tagged with the request's sequence
+#define NODE_DATA_RESPONSE              0x70
+
+///For the values pushed by a subscription
+#define NODE_DATA_PUBLISH               0x60
+
 
 
 ///Offset for digital i/o commands
@@ -0,0 +1,592 @@
+/**
+ * \file canNodeProtocol.cpp
+ * \author Timothy Robbins
+ * \brief Batched remote I/O between nodes
+ */
+#if defined(__cplusplus) && defined(__AVR)
+#if defined(__AVR_ATmega32C1__) || defined(__AVR_ATmega64C1__) || defined(__AVR_ATmega16M1__) || defined(__AVR_ATmega32M1__) || defined(__AVR_ATmega64M1__)
+
+#ifndef __CAN_NODE_PROTOCOL_CPP__
+#define __CAN_NODE_PROTOCOL_CPP__
+
+
+#include "canNodeProtocol.h"
+#include "mcuUtils.h"
+
+
+///The bytes of a subscribe request
+#define NODE_SUBSCRIBE_LENGTH           7
+
+///The bytes of each value in a publish frame
+#define NODE_PUBLISH_ENTRY_LENGTH       4
+
+
+///The sequence of the next request
+static uint8_t m_uchrNodeSequence = 0;
+
+
+
+/**
+ * \brief Sets up a standard id frame with no data
+ * \param frame The frame
+ * \param id The id
+ */
+static void NodeFrameSetup(CAN_FRAME* frame, uint16_t id)
+{
+    frame->id = id;
+    frame->extended = 0;
+    frame->rtr = 0;
+    frame->priority = 0;
+    frame->length = 0;
+    frame->data.value = 0;
+}
+
+
+
+/**
+ * \brief Puts a value in a frame, little endian
+ * \param frame The frame
+ * \param index Where the value goes
+ * \param value The value
+ * \param width The bytes to use
+ */
+static void NodePutValue(CAN_FRAME* frame, uint8_t index, uint16_t value, uint8_t width)
+{
+    frame->data.bytes[index] = (uint8_t)value;
+
+    if(width > 1)
+    {
+        frame->data.bytes[index + 1] = (uint8_t)(value >> 8);
+    }
+}
+
+
+
+/**
+ * \brief Takes a value from a frame, little endian
+ * \param frame The frame
+ * \param index Where the value is
+ * \param width The bytes it uses
+ * \return The value
+ */
+static uint16_t NodeGetValue(const CAN_FRAME* frame, uint8_t index, uint8_t width)
+{
+    //Variables
+    uint16_t value = frame->data.bytes[index]; //The value
+
+    if(width > 1)
+    {
+        value |= (uint16_t)frame->data.bytes[index + 1] << 8;
+    }
+
+    return value;
+}
+
+
+
+/**
+ * \brief The bytes a value of a type takes in requests and responses
+ * \param type The NODE_DATA type
+ * \return The bytes, or 0 if the type can't be used in a batch or subscription
+ */
+uint8_t NodeValueWidth(uint8_t type)
+{
+    switch(type)
+    {
+        case NODE_DATA_DIGITAL:
+        case NODE_DATA_PWM:
+            return 1;
+
+        case NODE_DATA_ADC:
+        case NODE_DATA_DAC:
+            return 2;
+
+        default:
+            return 0;
+    }
+}
+
+
+
+/**
+ * \brief Serves a batch request, answering every operation in one response
+ * \param server The server
+ * \param frame The request
+ */
+static void NodeServeBatch(NodeServer_t* server, CAN_FRAME& frame)
+{
+    //Variables
+    CAN_FRAME response; //The response
+    uint8_t index = 1; //Where the next operation is in the request
+    uint8_t operation = 0; //The number of the operation
+    uint8_t kind = 0; //The operation's request kind
+    uint8_t type = 0; //The operation's data type
+    uint8_t channel = 0; //The operation's pin or channel
+    uint8_t width = 0; //The bytes of the operation's value
+    uint16_t value = 0; //The operation's value
+    uint8_t failed = 0; //The operations that failed
+    bool full = false; //If a get's value didn't fit in the response
+
+    NodeFrameSetup(&response, server->nodeId | NODE_DATA_RESPONSE);
+    response.data.bytes[0] = frame.data.bytes[0];
+    response.length = 2;
+
+    for(operation = 0; index + 1 < frame.length && operation < 8; operation++)
+    {
+        kind = frame.data.bytes[index] & NODE_OPERATION_ID;
+        type = frame.data.bytes[index] & NODE_OPERATION_TYPE;
+        channel = frame.data.bytes[index + 1];
+        width = NodeValueWidth(type);
+        index += 2;
+
+        if(kind == NODE_DATA_REQUEST_GET)
+        {
+            value = 0;
+
+            //The values are read back by their order, so once one doesn't fit none after it can go in either
+            if(response.length + width > 8)
+            {
+                full = true;
+            }
+
+            if(width == 0 || full || server->read(server->context, type, channel, &value) == false)
+            {
+                failed |= (1 << operation);
+                value = 0;
+            }
+
+            if(full == false)
+            {
+                NodePutValue(&response, response.length, value, width);
+                response.length += width;
+            }
+        }
+        else if(kind == NODE_DATA_REQUEST_PIN_OP && width != 0 && index + width <= frame.length)
+        {
+            value = NodeGetValue(&frame, index, width);
+            index += width;
+
+            if(server->write == 0 || server->write(server->context, type, channel, value) == false)
+            {
+                failed |= (1 << operation);
+            }
+        }
+        else
+        {
+            //Where the next operation starts isn't known, so this and the rest fail
+            failed |= (uint8_t)(0xFF << operation);
+            break;
+        }
+    }
+
+    response.data.bytes[1] = failed;
+    Can0.sendFrame(response);
+}
+
+
+
+/**
+ * \brief Serves a subscribe request, starting, changing or ending a subscription
+ * \param server The server
+ * \param frame The request
+ */
+static void NodeServeSubscribe(NodeServer_t* server, CAN_FRAME& frame)
+{
+    //Variables
+    CAN_FRAME response; //The response
+    NodeSubscription_t* subscription = 0; //The subscription being changed
+    uint8_t type = frame.data.bytes[1]; //The data type
+    uint8_t channel = frame.data.bytes[2]; //The pin or channel
+    uint16_t period = NodeGetValue(&frame, 3, 2); //The milliseconds between checks
+    uint16_t value = 0; //The value now
+    bool ok = false; //If the request was served
+    uint8_t i = 0; //Loop index
+
+    for(i = 0; i < NODE_SUBSCRIPTIONS_MAX; i++)
+    {
+        if(server->subscriptions[i].type == type && server->subscriptions[i].channel == channel)
+        {
+            subscription = &server->subscriptions[i];
+            break;
+        }
+        else if(subscription == 0 && server->subscriptions[i].type == 0)
+        {
+            subscription = &server->subscriptions[i];
+        }
+    }
+
+    if(period == 0)
+    {
+        if(subscription != 0 && subscription->type == type && subscription->channel == channel)
+        {
+            subscription->type = 0;
+        }
+
+        ok = true;
+    }
+    else if(subscription != 0 && NodeValueWidth(type) != 0 && server->read(server->context, type, channel, &value))
+    {
+        subscription->type = type;
+        subscription->channel = channel;
+        subscription->period = period;
+        subscription->deadband = NodeGetValue(&frame, 5, 2);
+        subscription->last = value;
+        subscription->due = server->now + period;
+        subscription->quiet = 0;
+        subscription->send = true;
+        ok = true;
+    }
+
+    NodeFrameSetup(&response, server->nodeId | NODE_DATA_RESPONSE);
+    response.data.bytes[0] = frame.data.bytes[0];
+    response.data.bytes[1] = (ok ? 0 : 1);
+    response.length = 2;
+    Can0.sendFrame(response);
+}
+
+
+
+/**
+ * \brief Sets up a server
+ * \param server The server
+ * \param nodeId The node id from canNodeId.h, such as INPUT_NODE_ID
+ * \param read Reads inputs
+ * \param write Sets outputs, can be 0 for an input only node
+ * \param context Passed to the callbacks
+ */
+void NodeServerInit(NodeServer_t* server, uint16_t nodeId, NodeRead_t read, NodeWrite_t write, void* context)
+{
+    //Variables
+    uint8_t i = 0; //Loop index
+
+    server->nodeId = nodeId & CLEAR_NODE_ID_OFFSET;
+    server->read = read;
+    server->write = write;
+    server->context = context;
+    server->now = 0;
+
+    for(i = 0; i < NODE_SUBSCRIPTIONS_MAX; i++)
+    {
+        server->subscriptions[i].type = 0;
+        server->subscriptions[i].send = false;
+    }
+}
+
+
+
+/**
+ * \brief Serves a received frame if it's a batch or subscribe request for the node
+ * \param server The server
+ * \param frame The frame
+ * \return True if it was a request for the node
+ */
+bool NodeServerReceive(NodeServer_t* server, CAN_FRAME& frame)
+{
+    if(frame.extended || frame.rtr || frame.length < 1 || (frame.id & CLEAR_NODE_ID_OFFSET) != server->nodeId)
+    {
+        return false;
+    }
+
+    if((frame.id & CLEAR_NODE_ID) == NODE_DATA_REQUEST_BATCH)
+    {
+        NodeServeBatch(server, frame);
+        return true;
+    }
+    else if((frame.id & CLEAR_NODE_ID) == NODE_DATA_REQUEST_SUBSCRIBE && frame.length >= NODE_SUBSCRIBE_LENGTH)
+    {
+        NodeServeSubscribe(server, frame);
+        return true;
+    }
+
+    return false;
+}
+
+
+
+/**
+ * \brief Checks the subscriptions that are due and pushes the values that changed, packing them into as few frames as possible
+ * \param server The server
+ * \param nowMs The milliseconds now
+ */
+void NodeServerPoll(NodeServer_t* server, uint16_t nowMs)
+{
+    //Variables
+    NodeSubscription_t* subscription = 0; //The subscription being checked
+    NodeSubscription_t* packed[NODE_PUBLISH_PER_FRAME]; //The subscriptions in the publish frame
+    CAN_FRAME frame; //The publish frame
+    uint8_t count = 0; //The values in the publish frame
+    uint16_t value = 0; //The value now
+    uint16_t change = 0; //How far the value moved
+    uint8_t i = 0; //Loop index
+
+    server->now = nowMs;
+
+    for(i = 0; i < NODE_SUBSCRIPTIONS_MAX; i++)
+    {
+        subscription = &server->subscriptions[i];
+
+        if(subscription->type == 0 || TimeReached16(nowMs, subscription->due) == false)
+        {
+            continue;
+        }
+
+        subscription->due += subscription->period;
+
+        //Fell more than a period behind, so start again from now
+        if(TimeReached16(nowMs, subscription->due))
+        {
+            subscription->due = nowMs + subscription->period;
+        }
+
+        if(server->read(server->context, subscription->type, subscription->channel, &value) == false)
+        {
+            continue;
+        }
+
+        change = (value > subscription->last ? value - subscription->last : subscription->last - value);
+
+        if(subscription->quiet < 0xFF)
+        {
+            subscription->quiet++;
+        }
+
+        if((change != 0 && change >= subscription->deadband) || (NODE_SUBSCRIPTION_REFRESH != 0 && subscription->quiet >= NODE_SUBSCRIPTION_REFRESH))
+        {
+            subscription->last = value;
+            subscription->send = true;
+        }
+    }
+
+    NodeFrameSetup(&frame, server->nodeId | NODE_DATA_PUBLISH);
+
+    for(i = 0; i <= NODE_SUBSCRIPTIONS_MAX; i++)
+    {
+        subscription = (i < NODE_SUBSCRIPTIONS_MAX ? &server->subscriptions[i] : 0);
+
+        if(subscription != 0 && subscription->type != 0 && subscription->send)
+        {
+            frame.data.bytes[frame.length] = subscription->type;
+            frame.data.bytes[frame.length + 1] = subscription->channel;
+            NodePutValue(&frame, frame.length + 2, subscription->last, 2);
+            frame.length += NODE_PUBLISH_ENTRY_LENGTH;
+            packed[count++] = subscription;
+        }
+
+        if(count == NODE_PUBLISH_PER_FRAME || (subscription == 0 && count != 0))
+        {
+            //Left waiting to try again next poll if the transmit buffer is full
+            if(Can0.sendFrame(frame) == false)
+            {
+                return;
+            }
+
+            while(count != 0)
+            {
+                count--;
+                packed[count]->send = false;
+                packed[count]->quiet = 0;
+            }
+
+            NodeFrameSetup(&frame, server->nodeId | NODE_DATA_PUBLISH);
+        }
+    }
+}
+
+
+
+/**
+ * \brief Starts a new batch request, with the next sequence
+ * \param batch The batch
+ * \param nodeId The node id from canNodeId.h it's for, such as INPUT_NODE_ID
+ */
+void NodeBatchBegin(NodeBatch_t* batch, uint16_t nodeId)
+{
+    batch->nodeId = nodeId & CLEAR_NODE_ID_OFFSET;
+    batch->kind = NODE_DATA_REQUEST_BATCH;
+    batch->data[0] = m_uchrNodeSequence++;
+    batch->length = 1;
+    batch->gets = 0;
+    batch->responseLength = 2;
+}
+
+
+
+/**
+ * \brief Adds a get to a batch. Its value comes back in the response in the order the gets were added
+ * \param batch The batch
+ * \param type The NODE_DATA type
+ * \param channel The pin or channel
+ * \return False if the type can't be batched or the request or response is full
+ */
+bool NodeBatchGet(NodeBatch_t* batch, uint8_t type, uint8_t channel)
+{
+    //Variables
+    uint8_t width = NodeValueWidth(type); //The bytes of the value in the response
+
+    if(batch->kind != NODE_DATA_REQUEST_BATCH || width == 0 || batch->gets >= NODE_BATCH_MAX_OPS || batch->length + 2 > 8 || batch->responseLength + width > 8)
+    {
+        return false;
+    }
+
+    batch->data[batch->length++] = NODE_DATA_REQUEST_GET | type;
+    batch->data[batch->length++] = channel;
+    batch->getTypes[batch->gets++] = type;
+    batch->responseLength += width;
+
+    return true;
+}
+
+
+
+/**
+ * \brief Adds a pin operation to a batch, setting an output
+ * \param batch The batch
+ * \param type The NODE_DATA type
+ * \param channel The pin or channel
+ * \param value The value
+ * \return False if the type can't be batched or the request is full
+ */
+bool NodeBatchSet(NodeBatch_t* batch, uint8_t type, uint8_t channel, uint16_t value)
+{
+    //Variables
+    uint8_t width = NodeValueWidth(type); //The bytes of the value in the request
+
+    if(batch->kind != NODE_DATA_REQUEST_BATCH || width == 0 || batch->length + 2 + width > 8)
+    {
+        return false;
+    }
+
+    batch->data[batch->length++] = NODE_DATA_REQUEST_PIN_OP | type;
+    batch->data[batch->length++] = channel;
+    batch->data[batch->length++] = (uint8_t)value;
+
+    if(width > 1)
+    {
+        batch->data[batch->length++] = (uint8_t)(value >> 8);
+    }
+
+    return true;
+}
+
+
+
+/**
+ * \brief Sets up a subscribe request, with the next sequence. The node answers with a response with no values
+ * \param batch The request
+ * \param nodeId The node id from canNodeId.h it's for, such as INPUT_NODE_ID
+ * \param type The NODE_DATA type
+ * \param channel The pin or channel
+ * \param periodMs The milliseconds between checks for a change, 0 to end the subscription
+ * \param deadband How far the value must move to be pushed, 0 for any change
+ */
+void NodeBatchSubscribe(NodeBatch_t* batch, uint16_t nodeId, uint8_t type, uint8_t channel, uint16_t periodMs, uint16_t deadband)
+{
+    batch->nodeId = nodeId & CLEAR_NODE_ID_OFFSET;
+    batch->kind = NODE_DATA_REQUEST_SUBSCRIBE;
+    batch->data[0] = m_uchrNodeSequence++;
+    batch->data[1] = type;
+    batch->data[2] = channel;
+    batch->data[3] = (uint8_t)periodMs;
+    batch->data[4] = (uint8_t)(periodMs >> 8);
+    batch->data[5] = (uint8_t)deadband;
+    batch->data[6] = (uint8_t)(deadband >> 8);
+    batch->length = NODE_SUBSCRIBE_LENGTH;
+    batch->gets = 0;
+    batch->responseLength = 2;
+}
+
+
+
+/**
+ * \brief Sends a request
+ * \param batch The request
+ * \return True if it was loaded
+ */
+bool NodeBatchSend(NodeBatch_t* batch)
+{
+    //Variables
+    CAN_FRAME frame; //The request frame
+    uint8_t i = 0; //Loop index
+
+    NodeFrameSetup(&frame, batch->nodeId | batch->kind);
+    frame.length = batch->length;
+
+    for(i = 0; i < batch->length; i++)
+    {
+        frame.data.bytes[i] = batch->data[i];
+    }
+
+    return Can0.sendFrame(frame);
+}
+
+
+
+/**
+ * \brief Checks if a frame is the response to a request, and reads it if so
+ * \param batch The request
+ * \param frame The frame
+ * \param values Where to put the value of each get, in the order they were added. Can be 0 for a subscribe request
+ * \param failed Where to put the failed operations, bit 0 for the first. Can be 0
+ * \return True if it was the response
+ */
+bool NodeBatchResponse(NodeBatch_t* batch, const CAN_FRAME& frame, uint16_t values[], uint8_t* failed)
+{
+    //Variables
+    uint8_t index = 2; //Where the next value is
+    uint8_t width = 0; //The bytes of the value
+    uint8_t i = 0; //Loop index
+
+    if(frame.extended || frame.id != (uint32_t)(batch->nodeId | NODE_DATA_RESPONSE) || frame.length < 2 || frame.data.bytes[0] != batch->data[0])
+    {
+        return false;
+    }
+
+    if(failed != 0)
+    {
+        *failed = frame.data.bytes[1];
+    }
+
+    for(i = 0; i < batch->gets && values != 0; i++)
+    {
+        width = NodeValueWidth(batch->getTypes[i]);
+        values[i] = (index + width <= frame.length ? NodeGetValue(&frame, index, width) : 0);
+        index += width;
+    }
+
+    return true;
+}
+
+
+
+/**
+ * \brief Reads the values pushed in a publish frame
+ * \param frame The frame
+ * \param values Where to put them, room for NODE_PUBLISH_PER_FRAME
+ * \return The amount read, 0 if it isn't a publish frame
+ */
+uint8_t NodeReadPublish(const CAN_FRAME& frame, NodeValue_t values[])
+{
+    //Variables
+    uint8_t count = 0; //The values read
+    uint8_t index = 0; //Where the next value is
+
+    if(frame.extended || frame.rtr || (frame.id & CLEAR_NODE_ID) != NODE_DATA_PUBLISH)
+    {
+        return 0;
+    }
+
+    for(index = 0; index + NODE_PUBLISH_ENTRY_LENGTH <= frame.length && count < NODE_PUBLISH_PER_FRAME; index += NODE_PUBLISH_ENTRY_LENGTH)
+    {
+        values[count].nodeId = frame.id & CLEAR_NODE_ID_OFFSET;
+        values[count].type = frame.data.bytes[index];
+        values[count].channel = frame.data.bytes[index + 1];
+        values[count].value = NodeGetValue(&frame, index + 2, 2);
+        count++;
+    }
+
+    return count;
+}
+
+#endif /* __CAN_NODE_PROTOCOL_CPP__ */
+#endif
+#endif
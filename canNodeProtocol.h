@@ -0,0 +1,176 @@
+/**
+ * \file canNodeProtocol.h
+ * \author Timothy Robbins
+ * \brief Batched remote I/O between nodes, using the NODE_DATA_REQUEST kinds and NODE_DATA types from canNodeId.h. \n
+ * A batch request carries several get and pin operations in one frame, and the node answers all of them in one \n
+ * response tagged with the request's sequence, instead of a round trip per operation. \n
+ * A subscription has an input node push a value when it changes, checked at the period asked for, instead of being polled. \n
+ * All frames use standard ids of a node id from canNodeId.h plus the kind, so the target or sender is id & CLEAR_NODE_ID_OFFSET. \n
+ *
+ * Batch request, to node | NODE_DATA_REQUEST_BATCH: \n
+ * [sequence] then operations of [NODE_DATA_REQUEST_GET | type][channel], or [NODE_DATA_REQUEST_PIN_OP | type][channel][value] \n
+ * Subscribe request, to node | NODE_DATA_REQUEST_SUBSCRIBE: \n
+ * [sequence][type][channel][period ms low][period ms high][deadband low][deadband high]. A period of 0 ends the subscription \n
+ * Response, from node | NODE_DATA_RESPONSE: \n
+ * [sequence][failed operations, bit 0 for the first][the values of the gets in order, failed ones as 0] \n
+ * Publish, from node | NODE_DATA_PUBLISH: \n
+ * up to NODE_PUBLISH_PER_FRAME of [type][channel][value low][value high] \n
+ * Values are little endian, 1 byte for NODE_DATA_DIGITAL and NODE_DATA_PWM and 2 bytes for NODE_DATA_ADC and NODE_DATA_DAC. \n
+ *
+ * Example use, on the input node: \n
+ *
+ * NodeServer_t server; \n
+ * bool ReadIo(void* context, uint8_t type, uint8_t channel, uint16_t* value) { ... } \n
+ * bool WriteIo(void* context, uint8_t type, uint8_t channel, uint16_t value) { ... } \n
+ *
+ * NodeServerInit(&server, INPUT_NODE_ID, ReadIo, WriteIo, 0); \n
+ * int8_t OnFrame(CAN_FRAME& frame) { NodeServerReceive(&server, frame); return 0; } \n
+ * ... \n
+ * while(1) { CAN_process_frame(OnFrame); NodeServerPoll(&server, (uint16_t)SystemMillis()); } \n
+ *
+ * And on the hub node: \n
+ *
+ * NodeBatch_t batch; \n
+ * uint16_t values[NODE_BATCH_MAX_OPS]; \n
+ *
+ * NodeBatchBegin(&batch, INPUT_NODE_ID); \n
+ * NodeBatchGet(&batch, NODE_DATA_ADC, 3); \n
+ * NodeBatchGet(&batch, NODE_DATA_DIGITAL, 12); \n
+ * NodeBatchSend(&batch); \n
+ * ... \n
+ * if(NodeBatchResponse(&batch, frame, values, &failed)) { ... values[0] is ADC 3, values[1] is pin 12 ... } \n
+ */
+
+#if defined(__cplusplus) && defined(__AVR)
+#if defined(__AVR_ATmega32C1__) || defined(__AVR_ATmega64C1__) || defined(__AVR_ATmega16M1__) || defined(__AVR_ATmega32M1__) || defined(__AVR_ATmega64M1__)
+
+#ifndef __CAN_NODE_PROTOCOL_H__
+#define __CAN_NODE_PROTOCOL_H__
+
+#include <avr/io.h>
+#include "config.h"
+#include "avr_can.h"
+#include "canNodeId.h"
+
+
+#ifndef NODE_SUBSCRIPTIONS_MAX
+///The amount of subscriptions a node can serve at once
+#define NODE_SUBSCRIPTIONS_MAX          8
+#endif
+
+#ifndef NODE_SUBSCRIPTION_REFRESH
+///The periods a subscribed value can go unchanged before it's pushed anyway, so late listeners get it. 0 to only push changes
+#define NODE_SUBSCRIPTION_REFRESH       10
+#endif
+
+
+///The most operations a batch can hold, being 2 byte gets after the sequence
+#define NODE_BATCH_MAX_OPS              3
+
+///The amount of values in a publish frame
+#define NODE_PUBLISH_PER_FRAME          2
+
+
+/**
+ * \brief Reads an input for a get or a subscription
+ * \param context The server's context
+ * \param type The NODE_DATA type
+ * \param channel The pin or channel
+ * \param value Where to put the value
+ * \return False if the type or channel isn't supported
+ */
+typedef bool (*NodeRead_t)(void* context, uint8_t type, uint8_t channel, uint16_t* value);
+
+/**
+ * \brief Sets an output for a pin operation
+ * \param context The server's context
+ * \param type The NODE_DATA type
+ * \param channel The pin or channel
+ * \param value The value
+ * \return False if the type or channel isn't supported
+ */
+typedef bool (*NodeWrite_t)(void* context, uint8_t type, uint8_t channel, uint16_t value);
+
+
+typedef struct _NODE_SUBSCRIPTION_
+{
+    uint8_t type;                   ///The NODE_DATA type, 0 if the slot is free
+    uint8_t channel;                ///The pin or channel
+    uint16_t period;                ///The milliseconds between checks
+    uint16_t deadband;              ///How far the value must move to be pushed
+    uint16_t last;                  ///The value last pushed
+    uint16_t due;                   ///When the next check is
+    uint8_t quiet;                  ///The checks since the value was last pushed
+    bool send;                      ///If the value is waiting to be pushed
+
+}
+/**
+* \brief Struct for a value a node pushes when it changes
+*/
+NodeSubscription_t;
+
+
+typedef struct _NODE_SERVER_
+{
+    uint16_t nodeId;                ///The node id requests are addressed to and responses are sent from
+    NodeRead_t read;                ///Reads inputs
+    NodeWrite_t write;              ///Sets outputs, can be 0 for an input only node
+    void* context;                  ///Passed to the callbacks
+    uint16_t now;                   ///The milliseconds of the last poll
+    NodeSubscription_t subscriptions[NODE_SUBSCRIPTIONS_MAX]; ///The subscriptions being served
+
+}
+/**
+* \brief Struct for the node end of the protocol, serving the requests addressed to it
+*/
+NodeServer_t;
+
+
+typedef struct _NODE_BATCH_
+{
+    uint16_t nodeId;                ///The node the request is for
+    uint8_t kind;                   ///NODE_DATA_REQUEST_BATCH or NODE_DATA_REQUEST_SUBSCRIBE
+    uint8_t length;                 ///The bytes of the request used
+    uint8_t getTypes[NODE_BATCH_MAX_OPS]; ///The type of each get, in order, for reading the response
+    uint8_t gets;                   ///The amount of gets
+    uint8_t responseLength;         ///The bytes the response will need
+    uint8_t data[8];                ///The request, starting with the sequence
+
+}
+/**
+* \brief Struct for a request being built, sent, and matched to its response
+*/
+NodeBatch_t;
+
+
+typedef struct _NODE_VALUE_
+{
+    uint16_t nodeId;                ///The node that sent it
+    uint8_t type;                   ///The NODE_DATA type
+    uint8_t channel;                ///The pin or channel
+    uint16_t value;                 ///The value
+
+}
+/**
+* \brief Struct for a value pushed by a subscription
+*/
+NodeValue_t;
+
+
+uint8_t NodeValueWidth(uint8_t type);
+
+void NodeServerInit(NodeServer_t* server, uint16_t nodeId, NodeRead_t read, NodeWrite_t write, void* context);
+bool NodeServerReceive(NodeServer_t* server, CAN_FRAME& frame);
+void NodeServerPoll(NodeServer_t* server, uint16_t nowMs);
+
+void NodeBatchBegin(NodeBatch_t* batch, uint16_t nodeId);
+bool NodeBatchGet(NodeBatch_t* batch, uint8_t type, uint8_t channel);
+bool NodeBatchSet(NodeBatch_t* batch, uint8_t type, uint8_t channel, uint16_t value);
+void NodeBatchSubscribe(NodeBatch_t* batch, uint16_t nodeId, uint8_t type, uint8_t channel, uint16_t periodMs, uint16_t deadband);
+bool NodeBatchSend(NodeBatch_t* batch);
+bool NodeBatchResponse(NodeBatch_t* batch, const CAN_FRAME& frame, uint16_t values[], uint8_t* failed);
+uint8_t NodeReadPublish(const CAN_FRAME& frame, NodeValue_t values[]);
+
+#endif /* __CAN_NODE_PROTOCOL_H__ */
+#endif
+#endif
@@ -0,0 +1,234 @@
+/**
+ * \file canSchedule.cpp
+ * \author Timothy Robbins
+ * \brief Time triggered CAN schedule
+ */
+#if defined(__cplusplus) && defined(__AVR)
+#if defined(__AVR_ATmega32C1__) || defined(__AVR_ATmega64C1__) || defined(__AVR_ATmega16M1__) || defined(__AVR_ATmega32M1__) || defined(__AVR_ATmega64M1__)
+
+#ifndef __CAN_SCHEDULE_CPP__
+#define __CAN_SCHEDULE_CPP__
+
+
+#include "canSchedule.h"
+#include <avr/interrupt.h>
+
+
+///The schedule table
+static const CanScheduleSlot_t* m_canScheduleTable = 0;
+
+///The amount of slots in the table
+static uint8_t m_uchrCanScheduleCount = 0;
+
+///The microseconds in a cycle
+static uint32_t m_ulCanScheduleCycle = 0;
+
+///If the schedule is running
+static volatile bool m_bCanScheduleRunning = false;
+
+///If the cycle start has been found since the schedule was started
+static bool m_bCanScheduleAligned = false;
+
+///The time the current cycle started at
+static uint32_t m_ulCanScheduleStart = 0;
+
+///The next slot of the cycle
+static uint8_t m_uchrCanScheduleNext = 0;
+
+///The counters
+static CanScheduleStats_t m_canScheduleStats;
+
+
+
+/**
+ * \brief Finds the current cycle from the time, skipping the slots already past
+ * \param now The time
+ */
+static void CanScheduleAlign(uint32_t now)
+{
+    //Variables
+    uint32_t into = now % m_ulCanScheduleCycle; //The microseconds into the cycle
+
+    m_ulCanScheduleStart = now - into;
+    m_uchrCanScheduleNext = 0;
+
+    while(m_uchrCanScheduleNext < m_uchrCanScheduleCount && m_canScheduleTable[m_uchrCanScheduleNext].offset < into)
+    {
+        m_uchrCanScheduleNext++;
+    }
+
+    m_bCanScheduleAligned = true;
+    m_canScheduleStats.cycles++;
+}
+
+
+
+/**
+ * \brief Sets up the schedule and reserves a TX MOb for it, so CAN_init_tx needs at least 2 TX boxes
+ * \param table The slots, in order of their offsets. It's kept, not copied
+ * \param count The amount of slots
+ * \param cycleUs The microseconds in a cycle. Each slot's offset must be less than it
+ * \return False if the table is out of order or doesn't fit the cycle, or there's no TX MOb to reserve
+ */
+bool CanScheduleInit(const CanScheduleSlot_t table[], uint8_t count, uint32_t cycleUs)
+{
+    //Variables
+    uint8_t i = 0; //Loop index
+
+    if(count == 0 || cycleUs == 0)
+    {
+        return false;
+    }
+
+    for(i = 0; i < count; i++)
+    {
+        if(table[i].offset >= cycleUs || (i != 0 && table[i].offset < table[i - 1].offset))
+        {
+            return false;
+        }
+    }
+
+    if(Can0.reserveTxMob() < 0)
+    {
+        return false;
+    }
+
+    m_bCanScheduleRunning = false;
+    m_canScheduleTable = table;
+    m_uchrCanScheduleCount = count;
+    m_ulCanScheduleCycle = cycleUs;
+
+    m_canScheduleStats.cycles = 0;
+    m_canScheduleStats.sent = 0;
+    m_canScheduleStats.skipped = 0;
+    m_canScheduleStats.overruns = 0;
+
+    return true;
+}
+
+
+
+/**
+ * \brief Starts sending the schedule, from the next slot of the current cycle
+ */
+void CanScheduleStart(void)
+{
+    if(m_uchrCanScheduleCount != 0)
+    {
+        m_bCanScheduleAligned = false;
+        m_bCanScheduleRunning = true;
+    }
+}
+
+
+
+/**
+ * \brief Stops sending the schedule. The MOb stays reserved
+ */
+void CanScheduleStop(void)
+{
+    m_bCanScheduleRunning = false;
+}
+
+
+
+/**
+ * \brief Sends the slots that are due. Call from a periodic interrupt, such as with SYSTEM_TICK_HOOK
+ */
+extern "C" void CanScheduleRun(void)
+{
+    //Variables
+    const CanScheduleSlot_t* slot = 0; //The slot being sent
+    CAN_FRAME frame; //The slot's frame
+    uint32_t now = 0; //The time
+    uint32_t into = 0; //The microseconds into the cycle
+
+    if(m_bCanScheduleRunning == false)
+    {
+        return;
+    }
+
+    now = CanTimeNow();
+
+    //Not started, or the clock jumped, such as at the first sync, so find the cycle again
+    if(m_bCanScheduleAligned == false || (now - m_ulCanScheduleStart) >= 2 * m_ulCanScheduleCycle)
+    {
+        CanScheduleAlign(now);
+    }
+
+    into = now - m_ulCanScheduleStart;
+
+    while(1)
+    {
+        if(m_uchrCanScheduleNext >= m_uchrCanScheduleCount)
+        {
+            if(into < m_ulCanScheduleCycle)
+            {
+                break;
+            }
+
+            m_ulCanScheduleStart += m_ulCanScheduleCycle;
+            into -= m_ulCanScheduleCycle;
+            m_uchrCanScheduleNext = 0;
+            m_canScheduleStats.cycles++;
+            continue;
+        }
+
+        slot = &m_canScheduleTable[m_uchrCanScheduleNext];
+
+        if(into < slot->offset)
+        {
+            break;
+        }
+
+        m_uchrCanScheduleNext++;
+
+        if(into - slot->offset > CAN_SCHEDULE_LATE_US)
+        {
+            m_canScheduleStats.skipped++;
+            continue;
+        }
+
+        frame.id = slot->id;
+        frame.extended = slot->extended;
+        frame.rtr = 0;
+        frame.priority = 0;
+        frame.length = slot->length;
+        frame.data.value = 0;
+
+        if(slot->source != 0 && slot->source(slot->context, &frame) == false)
+        {
+            continue;
+        }
+
+        if(Can0.reservedBusy())
+        {
+            m_canScheduleStats.overruns++;
+        }
+
+        if(Can0.sendReserved(frame))
+        {
+            m_canScheduleStats.sent++;
+        }
+    }
+}
+
+
+
+/**
+ * \brief Gets the schedule's counters
+ * \param stats Where to put them
+ */
+void CanScheduleGetStats(CanScheduleStats_t* stats)
+{
+    //Variables
+    uint8_t sreg = SREG; //The interrupt state to go back to
+
+    cli();
+    *stats = m_canScheduleStats;
+    SREG = sreg;
+}
+
+#endif /* __CAN_SCHEDULE_CPP__ */
+#endif
+#endif
@@ -0,0 +1,96 @@
+/**
+ * \file canSchedule.h
+ * \author Timothy Robbins
+ * \brief Time triggered CAN schedule. A static table of slots, each an offset into a repeating cycle, an id, \n
+ * and a callback filling the payload, sent from a reserved TX MOb with no part for the application to play. \n
+ * Times come from canTimeSync's clock, which runs off the CAN timer, so once the nodes are synced their cycles line up \n
+ * and each node's slots can be kept clear of the others'. Cycles start on multiples of the cycle length in that clock. \n
+ * The M1 CAN controller has no per-MOb time marks, so CanScheduleRun has to be called from a periodic interrupt, \n
+ * and a slot goes out on the first call at or after its offset. The jitter is the period of that interrupt. \n
+ * A slot more than CAN_SCHEDULE_LATE_US late is skipped instead of sent late, and a frame still waiting in the MOb \n
+ * when the next slot comes is dropped for it, so one slot can never push the rest back. \n
+ * The source callbacks are called from the interrupt, so keep them short. \n
+ *
+ * Example use, with the system tick at 10kHz: \n
+ *
+ * #define SYSTEM_TICK_HZ 10000UL \n
+ * #define SYSTEM_TICK_HOOK() { extern void CanScheduleRun(void); CanScheduleRun(); } \n
+ * ... \n
+ * static const CanScheduleSlot_t schedule[] = \n
+ * { \n
+ *     { 0,    0x120, false, 8, SendSpeeds, 0 }, \n
+ *     { 2500, 0x121, false, 4, SendTemperatures, 0 }, \n
+ * }; \n
+ * ... \n
+ * CAN_init_tx(CAN_BPS_500K, false, 2); \n
+ * CanTimeInit(false); \n
+ * CanScheduleInit(schedule, 2, 10000); \n
+ * CanScheduleStart(); \n
+ */
+
+#if defined(__cplusplus) && defined(__AVR)
+#if defined(__AVR_ATmega32C1__) || defined(__AVR_ATmega64C1__) || defined(__AVR_ATmega16M1__) || defined(__AVR_ATmega32M1__) || defined(__AVR_ATmega64M1__)
+
+#ifndef __CAN_SCHEDULE_H__
+#define __CAN_SCHEDULE_H__
+
+#include <avr/io.h>
+#include "config.h"
+#include "avr_can.h"
+#include "canTimeSync.h"
+
+
+#ifndef CAN_SCHEDULE_LATE_US
+///The microseconds past its offset a slot can still be sent. Later than this and it's skipped for the cycle
+#define CAN_SCHEDULE_LATE_US            500
+#endif
+
+
+/**
+ * \brief Fills the payload of a slot's frame
+ * \param context The slot's context
+ * \param frame The frame, with the slot's id and length set and the data cleared. The length can be changed
+ * \return False to leave the slot empty this cycle
+ */
+typedef bool (*CanScheduleSource_t)(void* context, CAN_FRAME* frame);
+
+
+typedef struct _CAN_SCHEDULE_SLOT_
+{
+    uint32_t offset;                ///The microseconds into the cycle the slot starts at
+    uint32_t id;                    ///The id of the frame
+    bool extended;                  ///If the id is extended
+    uint8_t length;                 ///The data length of the frame
+    CanScheduleSource_t source;     ///Fills the payload
+    void* context;                  ///Passed to the source
+
+}
+/**
+* \brief Struct for a slot of the schedule table
+*/
+CanScheduleSlot_t;
+
+
+typedef struct _CAN_SCHEDULE_STATS_
+{
+    uint32_t cycles;                ///The cycles started
+    uint32_t sent;                  ///The frames loaded in their slots
+    uint16_t skipped;               ///The slots skipped for being too late to send
+    uint16_t overruns;              ///The frames dropped for not getting on the bus before the next slot
+
+}
+/**
+* \brief Struct for the schedule's counters
+*/
+CanScheduleStats_t;
+
+
+bool CanScheduleInit(const CanScheduleSlot_t table[], uint8_t count, uint32_t cycleUs);
+void CanScheduleStart(void);
+void CanScheduleStop(void);
+extern "C" void CanScheduleRun(void);
+void CanScheduleGetStats(CanScheduleStats_t* stats);
+
+#endif /* __CAN_SCHEDULE_H__ */
+#endif
+#endif
@@ -0,0 +1,276 @@
+/**
+ * \file canSignalCache.cpp
+ * \author Timothy Robbins
+ * \brief Latest value cache for periodic CAN messages
+ */ 
+#if defined(__cplusplus) && defined(__AVR)
+#if defined(__AVR_ATmega32C1__) || defined(__AVR_ATmega64C1__) || defined(__AVR_ATmega16M1__) || defined(__AVR_ATmega32M1__) || defined(__AVR_ATmega64M1__)
+
+#ifndef __CAN_SIGNAL_CACHE_CPP__
+#define __CAN_SIGNAL_CACHE_CPP__
+
+
+#include "canSignalCache.h"
+#include "avrTimers.h"
+#include <avr/interrupt.h>
+#include <string.h>
+
+
+///The slots, in range order
+static volatile CanCacheSlot_t m_canCacheSlots[CAN_CACHE_SLOTS];
+
+///The cached id ranges
+static CanCacheRange_t m_canCacheRanges[CAN_CACHE_RANGES];
+
+///The amount of ranges in use
+static uint8_t m_uchrCanCacheRangeCount = 0;
+
+///The amount of slots given to ranges
+static uint8_t m_uchrCanCacheSlotCount = 0;
+
+
+
+/**
+ * \brief Finds the slot for an id
+ * \param id The id
+ * \param extended If the id is extended
+ * \return The slot, or 0 if the id isn't cached
+ */
+static volatile CanCacheSlot_t* CanCacheFind(uint32_t id, bool extended)
+{
+    //Variables
+    uint8_t i = 0; //Loop index
+    
+    for(i = 0; i < m_uchrCanCacheRangeCount; i++)
+    {
+        if(m_canCacheRanges[i].extended == extended && id >= m_canCacheRanges[i].firstId && (id - m_canCacheRanges[i].firstId) < m_canCacheRanges[i].count)
+        {
+            return &m_canCacheSlots[m_canCacheRanges[i].slot + (uint8_t)(id - m_canCacheRanges[i].firstId)];
+        }
+    }
+    
+    return 0;
+}
+
+
+
+/**
+ * \brief Mailbox callback for CanCacheMailbox, caching what it can and dropping the rest
+ * \param frame The received frame
+ */
+static void CanCacheCallback(CAN_FRAME *frame)
+{
+    CanCacheStore(frame);
+}
+
+
+
+/**
+ * \brief Clears the ranges and slots and sets the CANRaw cache hook
+ */
+void CanCacheInit(void)
+{
+    //Variables
+    uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+    
+    cli();
+    m_uchrCanCacheRangeCount = 0;
+    m_uchrCanCacheSlotCount = 0;
+    memset((void *)m_canCacheSlots, 0, sizeof(m_canCacheSlots));
+    SREG = sreg;
+    
+    Can0.setCacheHook(CanCacheStore);
+}
+
+
+
+/**
+ * \brief Caches a range of ids, each getting its own slot
+ * \param firstId The first id
+ * \param count The amount of ids
+ * \param extended If the ids are extended
+ * \return True if added, false if there weren't enough slots or ranges left
+ */
+bool CanCacheAddRange(uint32_t firstId, uint8_t count, bool extended)
+{
+    //Variables
+    uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+    CanCacheRange_t* range = 0; //The range being added
+    
+    if(count == 0 || m_uchrCanCacheRangeCount >= CAN_CACHE_RANGES || count > CAN_CACHE_SLOTS - m_uchrCanCacheSlotCount)
+    {
+        return false;
+    }
+    
+    range = &m_canCacheRanges[m_uchrCanCacheRangeCount];
+    range->firstId = firstId;
+    range->count = count;
+    range->slot = m_uchrCanCacheSlotCount;
+    range->extended = extended;
+    
+    //Publish it with interrupts off so the hook never sees it half done
+    cli();
+    m_uchrCanCacheSlotCount += count;
+    m_uchrCanCacheRangeCount++;
+    SREG = sreg;
+    
+    return true;
+}
+
+
+
+/**
+ * \brief Gives a mailbox over to the cache. Its frames are cached if in a range and dropped if not
+ * \param mailbox The mailbox
+ */
+void CanCacheMailbox(uint8_t mailbox)
+{
+    Can0.setCallback(mailbox, CanCacheCallback);
+}
+
+
+
+/**
+ * \brief Overwrites the slot for a frame. Called from the receive interrupt through the cache hook
+ * \param frame The received frame
+ * \return True if the id is cached. Remote frames aren't
+ */
+bool CanCacheStore(CAN_FRAME *frame)
+{
+    //Variables
+    volatile CanCacheSlot_t* slot = 0; //The slot for the id
+    uint8_t seq = 0; //The sequence number before the write
+    uint8_t i = 0; //Loop index
+    
+    if(frame->rtr)
+    {
+        return false;
+    }
+    
+    slot = CanCacheFind(frame->id, frame->extended);
+    
+    if(slot == 0)
+    {
+        return false;
+    }
+    
+    seq = slot->seq;
+    slot->seq = seq + 1;
+    
+    slot->length = frame->length;
+    slot->time = frame->time;
+    #if AVR_TIMERS_USE_SYSTEM_TICK == 1
+    slot->stampMs = (uint16_t)SystemMillis();
+    #endif
+    for(i = 0; i < 8; i++)
+    {
+        slot->data[i] = frame->data.bytes[i];
+    }
+    
+    //Skip 0 when wrapping, since that means never received
+    seq += 2;
+    slot->seq = (seq == 0) ? 2 : seq;
+    
+    return true;
+}
+
+
+
+/**
+ * \brief Copies the newest frame of an id without turning interrupts off, trying again if the interrupt wrote it part way through.
+ * The slots are volatile so the copy is really done again each try
+ * \param id The id
+ * \param extended If the id is extended
+ * \param frame Where to copy it. The time is the CAN timer value when received
+ * \param seq Where to put the slot's sequence number, or 0
+ * \param stampMs Where to put the low 16 bits of SystemMillis when it was received, or 0. Always 0 without the system tick
+ * \return True if the id is cached and has been received
+ */
+bool CanCacheRead(uint32_t id, bool extended, CAN_FRAME *frame, uint8_t *seq, uint16_t *stampMs)
+{
+    //Variables
+    volatile CanCacheSlot_t* slot = CanCacheFind(id, extended); //The slot for the id
+    uint8_t before = 0; //The sequence number before the copy
+    uint16_t stamp = 0; //The millisecond it was received
+    uint8_t i = 0; //Loop index
+    
+    if(slot == 0)
+    {
+        return false;
+    }
+    
+    do
+    {
+        before = slot->seq;
+        frame->length = slot->length;
+        frame->time = slot->time;
+        stamp = slot->stampMs;
+        
+        for(i = 0; i < 8; i++)
+        {
+            frame->data.bytes[i] = slot->data[i];
+        }
+    }
+    while((before & 0x01) || before != slot->seq);
+    
+    if(before == 0)
+    {
+        return false;
+    }
+    
+    frame->id = id;
+    frame->extended = extended;
+    frame->rtr = 0;
+    frame->priority = 0;
+    
+    if(seq != 0)
+    {
+        *seq = before;
+    }
+    
+    if(stampMs != 0)
+    {
+        *stampMs = stamp;
+    }
+    
+    return true;
+}
+
+
+
+/**
+ * \brief Copies the newest frame of an id only if it changed since the last call
+ * \param id The id
+ * \param extended If the id is extended
+ * \param frame Where to copy it
+ * \param lastSeq The sequence number from the last call, updated. Start it at 0
+ * \param stampMs Where to put the low 16 bits of SystemMillis when it was received, or 0
+ * \return True if there is a newer frame
+ */
+bool CanCacheReadNew(uint32_t id, bool extended, CAN_FRAME *frame, uint8_t *lastSeq, uint16_t *stampMs)
+{
+    //Variables
+    volatile CanCacheSlot_t* slot = CanCacheFind(id, extended); //The slot for the id
+    uint8_t seq = 0; //The slot's sequence number
+    
+    //Cheap check first, without copying
+    if(slot == 0 || slot->seq == *lastSeq)
+    {
+        return false;
+    }
+    
+    if(CanCacheRead(id, extended, frame, &seq, stampMs) == false)
+    {
+        return false;
+    }
+    
+    *lastSeq = seq;
+    
+    return true;
+}
+
+
+
+#endif
+#endif /* __CAN_SIGNAL_CACHE_CPP__ */
+#endif
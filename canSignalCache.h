@@ -0,0 +1,83 @@
+/**
+ * \file canSignalCache.h
+ * \author Timothy Robbins
+ * \brief Latest value cache for periodic CAN messages. \n
+ * Ids in a configured range each get a slot that the receive interrupt overwrites in place, so a stream of status frames \n
+ * never crowds event frames out of rx_frame_buff, and the main loop only looks at the newest value. \n
+ * Each slot has a sequence number the interrupt makes odd while writing and even when done. Readers copy the slot and \n
+ * check the number didn't change, trying again if it did, so reading never turns interrupts off. \n
+ * Ranges are cached with CanCacheInit, which sets the CANRaw cache hook. A mailbox can also be given over to the cache with \n
+ * CanCacheMailbox, for a MOb filtered to the cached ids. Its frames outside the ranges are dropped. \n
+ * Remote frames carry no data, so they're never cached and go to rx_frame_buff as usual. \n
+ * With AVR_TIMERS_USE_SYSTEM_TICK as 1 each slot is stamped with the millisecond it was received, read back with the \n
+ * optional stampMs of CanCacheRead and CanCacheReadNew, so a signal that stopped coming can be told apart from a steady one. \n
+ *
+ * Example use: \n
+ *
+ * CanCacheInit(); \n
+ * CanCacheAddRange(0x300, 16, false); \n
+ * ... \n
+ * if(CanCacheReadNew(0x305, false, &frame, &lastSeq)) { ... a newer 0x305 than last time ... } \n
+ */ 
+
+#if defined(__cplusplus) && defined(__AVR)
+#if defined(__AVR_ATmega32C1__) || defined(__AVR_ATmega64C1__) || defined(__AVR_ATmega16M1__) || defined(__AVR_ATmega32M1__) || defined(__AVR_ATmega64M1__)
+
+#ifndef __CAN_SIGNAL_CACHE_H__
+#define __CAN_SIGNAL_CACHE_H__
+
+#include <avr/io.h>
+#include "config.h"
+#include "avr_can.h"
+
+
+#ifndef CAN_CACHE_SLOTS
+///The amount of ids that can be cached, 14 bytes of RAM each
+#define CAN_CACHE_SLOTS             16
+#endif
+
+#ifndef CAN_CACHE_RANGES
+///The amount of id ranges that can be cached
+#define CAN_CACHE_RANGES            4
+#endif
+
+
+typedef struct _CAN_CACHE_SLOT_
+{
+    volatile uint8_t seq;           ///Odd while being written, then 2 more per update. 0 if never received
+    uint8_t length;                 ///Number of data bytes
+    uint16_t time;                  ///CAN timer value when the frame was received
+    uint16_t stampMs;               ///Low 16 bits of SystemMillis when received, 0 without the system tick
+    uint8_t data[8];                ///The data
+
+}
+/**
+* \brief Struct for the newest frame of one id
+*/
+CanCacheSlot_t;
+
+
+typedef struct _CAN_CACHE_RANGE_
+{
+    uint32_t firstId;               ///The first id of the range
+    uint8_t count;                  ///The amount of ids
+    uint8_t slot;                   ///The slot of the first id
+    bool extended;                  ///If the ids are extended
+
+}
+/**
+* \brief Struct for a range of cached ids
+*/
+CanCacheRange_t;
+
+
+void CanCacheInit(void);
+bool CanCacheAddRange(uint32_t firstId, uint8_t count, bool extended);
+void CanCacheMailbox(uint8_t mailbox);
+bool CanCacheStore(CAN_FRAME *frame);
+bool CanCacheRead(uint32_t id, bool extended, CAN_FRAME *frame, uint8_t *seq, uint16_t *stampMs = 0);
+bool CanCacheReadNew(uint32_t id, bool extended, CAN_FRAME *frame, uint8_t *lastSeq, uint16_t *stampMs = 0);
+
+#endif /* __CAN_SIGNAL_CACHE_H__ */
+#endif
+#endif
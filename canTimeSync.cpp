@@ -0,0 +1,423 @@
+/**
+ * \file canTimeSync.cpp
+ * \author Timothy Robbins
+ * \brief Common time base between nodes from the CAN frame timestamps
+ */
+#if defined(__cplusplus) && defined(__AVR)
+#if defined(__AVR_ATmega32C1__) || defined(__AVR_ATmega64C1__) || defined(__AVR_ATmega16M1__) || defined(__AVR_ATmega32M1__) || defined(__AVR_ATmega64M1__)
+
+#ifndef __CAN_TIME_SYNC_CPP__
+#define __CAN_TIME_SYNC_CPP__
+
+
+#include "canTimeSync.h"
+#include <avr/interrupt.h>
+#include "mcuUtils.h"
+
+
+///The core cycles in a microsecond
+#define CAN_TIME_CYCLES_PER_US          (F_CPU / 1000000UL)
+
+#if F_CPU < 1000000UL || (F_CPU % 1000000UL) != 0
+#error canTimeSync.cpp: F_CPU must be a whole number of MHz, the clock counts whole cycles per microsecond
+#endif
+
+
+///If this node is the master
+static bool m_bCanTimeMaster = false;
+
+///The CAN timer when the local clock was last brought up to date
+static uint16_t m_uintCanTimeRaw = 0;
+
+///The local clock, in microseconds
+static uint32_t m_ulCanTimeLocal = 0;
+
+///The core cycles counted but not yet a whole microsecond
+static uint32_t m_ulCanTimeRemainder = 0;
+
+///The milliseconds of the last poll
+static uint16_t m_uintCanTimeNow = 0;
+
+///The sequence of the next SYNC, or of the SYNC being waited on for its FOLLOW_UP
+static uint8_t m_uchrCanTimeSequence = 0;
+
+///When the master sends the next SYNC
+static uint16_t m_uintCanTimeNextSync = 0;
+
+///The CAN timer when the master's SYNC went out, set by the tx hook
+static volatile uint16_t m_uintCanTimeTxStamp = 0;
+
+///If the tx hook has seen the master's SYNC go out
+static volatile bool m_bCanTimeTxStamped = false;
+
+///The master's time its SYNC went out, waiting to be sent in a FOLLOW_UP
+static uint32_t m_ulCanTimeFollowUp = 0;
+
+///If a FOLLOW_UP is waiting to be sent, or for a node, if a SYNC is waiting for its FOLLOW_UP
+static bool m_bCanTimePending = false;
+
+///The local clock when the SYNC being waited on was received
+static uint32_t m_ulCanTimeSyncLocal = 0;
+
+///The local clock at the last sync
+static uint32_t m_ulCanTimeRefLocal = 0;
+
+///The master's clock at the last sync
+static uint32_t m_ulCanTimeRefMaster = 0;
+
+///The syncs so far, stopping at 2 since the drift is known from then on
+static uint8_t m_uchrCanTimeSyncs = 0;
+
+///The milliseconds of the last sync
+static uint16_t m_uintCanTimeLastSync = 0;
+
+///How much faster the master's clock runs than the local one, in parts per million
+static int32_t m_lCanTimeDrift = 0;
+
+
+
+/**
+ * \brief Converts CAN timer ticks to microseconds, dropping the fraction
+ * \param ticks The ticks, at most a wrap of the timer
+ * \return The microseconds
+ */
+static uint32_t CanTimeTicksToUs(uint16_t ticks)
+{
+    return ((uint32_t)ticks * 8 * ((uint32_t)CANTCON + 1)) / CAN_TIME_CYCLES_PER_US;
+}
+
+
+
+/**
+ * \brief Brings the local clock up to date with the CAN timer
+ * \param raw Where to put the CAN timer value it was brought up to, can be 0
+ * \return The local clock, in microseconds
+ */
+static uint32_t CanTimeLocal(uint16_t* raw)
+{
+    //Variables
+    uint8_t sreg = SREG; //The interrupt state to go back to
+    uint16_t timer = 0; //The CAN timer
+    uint32_t cycles = 0; //The core cycles since the last update
+    uint32_t local = 0; //The local clock
+
+    cli();
+
+    timer = Can0.get_internal_timer_value();
+
+    cycles = (uint32_t)(uint16_t)(timer - m_uintCanTimeRaw) * 8 * ((uint32_t)CANTCON + 1) + m_ulCanTimeRemainder;
+    m_ulCanTimeLocal += cycles / CAN_TIME_CYCLES_PER_US;
+    m_ulCanTimeRemainder = cycles % CAN_TIME_CYCLES_PER_US;
+    m_uintCanTimeRaw = timer;
+    local = m_ulCanTimeLocal;
+
+    SREG = sreg;
+
+    if(raw != 0)
+    {
+        *raw = timer;
+    }
+
+    return local;
+}
+
+
+
+/**
+ * \brief Finds the local clock at a CAN timestamp, which must be less than a wrap of the timer ago
+ * \param stamp The timestamp
+ * \return The local clock at it, in microseconds
+ */
+static uint32_t CanTimeLocalAt(uint16_t stamp)
+{
+    //Variables
+    uint16_t timer = 0; //The CAN timer now
+    uint32_t local = CanTimeLocal(&timer); //The local clock now
+
+    return local - CanTimeTicksToUs(timer - stamp);
+}
+
+
+
+/**
+ * \brief Converts the local clock to the master's
+ * \param local The local clock, in microseconds
+ * \return The master's clock, in microseconds
+ */
+static uint32_t CanTimeToMaster(uint32_t local)
+{
+    //Variables
+    int32_t elapsed = (int32_t)(local - m_ulCanTimeRefLocal); //The microseconds since the last sync
+    int32_t seconds = elapsed / 1000000; //The whole seconds of it
+    int32_t correction = 0; //The drift over it
+
+    if(m_bCanTimeMaster || m_uchrCanTimeSyncs == 0)
+    {
+        return local;
+    }
+
+    //Split so the multiply fits 32 bits
+    correction = seconds * m_lCanTimeDrift + ((elapsed - seconds * 1000000) * m_lCanTimeDrift) / 1000000;
+
+    return m_ulCanTimeRefMaster + (uint32_t)(elapsed + correction);
+}
+
+
+
+/**
+ * \brief Moves the local clock onto the master's at a sync, and measures the drift since the last one
+ * \param local The local clock when the SYNC was received
+ * \param master The master's clock when it was sent
+ */
+static void CanTimeApply(uint32_t local, uint32_t master)
+{
+    //Variables
+    int32_t localElapsed = (int32_t)(local - m_ulCanTimeRefLocal); //The local microseconds between the syncs
+    int32_t masterElapsed = (int32_t)(master - m_ulCanTimeRefMaster); //The master's microseconds between them
+    int32_t measured = 0; //The drift over them
+    int32_t drift = m_lCanTimeDrift; //The drift to use from now on
+    uint8_t sreg = SREG; //The interrupt state to go back to
+
+    if(m_uchrCanTimeSyncs != 0 && localElapsed > 0)
+    {
+        measured = (int32_t)(((int64_t)(masterElapsed - localElapsed) * 1000000) / localElapsed);
+
+        if(measured > CAN_TIME_MAX_DRIFT_PPM)
+        {
+            measured = CAN_TIME_MAX_DRIFT_PPM;
+        }
+        else if(measured < -CAN_TIME_MAX_DRIFT_PPM)
+        {
+            measured = -CAN_TIME_MAX_DRIFT_PPM;
+        }
+
+        if(m_uchrCanTimeSyncs == 1)
+        {
+            drift = measured;
+        }
+        else
+        {
+            drift += (measured - drift) / CAN_TIME_DRIFT_FILTER;
+        }
+    }
+
+    //Changed together so CanTimeNow can be used from interrupts
+    cli();
+
+    m_ulCanTimeRefLocal = local;
+    m_ulCanTimeRefMaster = master;
+    m_lCanTimeDrift = drift;
+    m_uintCanTimeLastSync = m_uintCanTimeNow;
+
+    if(m_uchrCanTimeSyncs < 2)
+    {
+        m_uchrCanTimeSyncs++;
+    }
+
+    SREG = sreg;
+}
+
+
+
+/**
+ * \brief Tx hook for the master, catching when its SYNC went out
+ * \param frame The sent frame
+ */
+static void CanTimeTxHook(CAN_FRAME* frame)
+{
+    if(frame->id == CAN_TIME_SYNC_ID && frame->extended == false && frame->data.bytes[0] == m_uchrCanTimeSequence)
+    {
+        m_uintCanTimeTxStamp = frame->time;
+        m_bCanTimeTxStamped = true;
+    }
+}
+
+
+
+/**
+ * \brief Sets up the time sync, with the local clock starting from 0
+ * \param master True if this node is the master the others sync to
+ */
+void CanTimeInit(bool master)
+{
+    m_bCanTimeMaster = master;
+    m_ulCanTimeLocal = 0;
+    m_ulCanTimeRemainder = 0;
+    m_uintCanTimeRaw = Can0.get_internal_timer_value();
+    m_bCanTimePending = false;
+    m_bCanTimeTxStamped = false;
+    m_uchrCanTimeSyncs = 0;
+    m_lCanTimeDrift = 0;
+    m_ulCanTimeRefLocal = 0;
+    m_ulCanTimeRefMaster = 0;
+
+    if(master)
+    {
+        Can0.setTxHook(CanTimeTxHook);
+    }
+}
+
+
+
+/**
+ * \brief Keeps the local clock up to date, and on the master sends the SYNC and FOLLOW_UP frames
+ * \param nowMs The milliseconds now
+ */
+void CanTimePoll(uint16_t nowMs)
+{
+    //Variables
+    CAN_FRAME frame; //The frame being sent
+    uint8_t i = 0; //Loop index
+
+    m_uintCanTimeNow = nowMs;
+    CanTimeLocal(0);
+
+    if(m_bCanTimeMaster == false)
+    {
+        return;
+    }
+
+    frame.extended = false;
+    frame.rtr = 0;
+    frame.priority = 0;
+    frame.data.value = 0;
+
+    if(m_bCanTimeTxStamped)
+    {
+        m_bCanTimeTxStamped = false;
+        m_ulCanTimeFollowUp = CanTimeLocalAt(m_uintCanTimeTxStamp);
+        m_bCanTimePending = true;
+    }
+
+    if(m_bCanTimePending)
+    {
+        frame.id = CAN_TIME_FOLLOW_UP_ID;
+        frame.length = 5;
+        frame.data.bytes[0] = m_uchrCanTimeSequence;
+
+        for(i = 0; i < 4; i++)
+        {
+            frame.data.bytes[i + 1] = (uint8_t)(m_ulCanTimeFollowUp >> (8 * i));
+        }
+
+        //Left pending to try again next poll if the transmit buffer is full
+        if(Can0.sendFrame(frame))
+        {
+            m_bCanTimePending = false;
+        }
+    }
+    else if(TimeReached16(nowMs, m_uintCanTimeNextSync))
+    {
+        frame.id = CAN_TIME_SYNC_ID;
+        frame.length = 1;
+        frame.data.bytes[0] = ++m_uchrCanTimeSequence;
+
+        //Set before it's loaded, since the tx hook can see it go out before sendFrame returns
+        if(Can0.sendFrame(frame))
+        {
+            m_uintCanTimeNextSync = nowMs + CAN_TIME_SYNC_PERIOD_MS;
+        }
+        else
+        {
+            m_uchrCanTimeSequence--;
+        }
+    }
+}
+
+
+
+/**
+ * \brief Takes a received SYNC or FOLLOW_UP frame. Other nodes need to pass them in before the CAN timer wraps
+ * \param frame The received frame
+ * \return True if it was a time sync frame
+ */
+bool CanTimeReceive(CAN_FRAME& frame)
+{
+    //Variables
+    uint32_t master = 0; //The master's time in the FOLLOW_UP
+    uint8_t i = 0; //Loop index
+
+    if(frame.extended || m_bCanTimeMaster)
+    {
+        return false;
+    }
+
+    if(frame.id == CAN_TIME_SYNC_ID && frame.length >= 1)
+    {
+        m_ulCanTimeSyncLocal = CanTimeLocalAt(frame.time);
+        m_uchrCanTimeSequence = frame.data.bytes[0];
+        m_bCanTimePending = true;
+        return true;
+    }
+    else if(frame.id == CAN_TIME_FOLLOW_UP_ID && frame.length >= 5)
+    {
+        if(m_bCanTimePending && frame.data.bytes[0] == m_uchrCanTimeSequence)
+        {
+            for(i = 0; i < 4; i++)
+            {
+                master |= (uint32_t)frame.data.bytes[i + 1] << (8 * i);
+            }
+
+            CanTimeApply(m_ulCanTimeSyncLocal, master);
+            m_bCanTimePending = false;
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+
+
+/**
+ * \brief Gets the common time
+ * \return The master's clock, in microseconds
+ */
+uint32_t CanTimeNow(void)
+{
+    return CanTimeToMaster(CanTimeLocal(0));
+}
+
+
+
+/**
+ * \brief Gets the common time a frame was received at, from its timestamp. It must be less than a wrap of the CAN timer old
+ * \param frame The received frame
+ * \return The master's clock when it was received, in microseconds
+ */
+uint32_t CanTimeOfFrame(const CAN_FRAME& frame)
+{
+    return CanTimeToMaster(CanTimeLocalAt(frame.time));
+}
+
+
+
+/**
+ * \brief Checks if the clock is following the master's
+ * \return True for the master, or a node that has had two syncs with the last one in CAN_TIME_TIMEOUT_MS
+ */
+bool CanTimeSynced(void)
+{
+    if(m_bCanTimeMaster)
+    {
+        return true;
+    }
+
+    return (m_uchrCanTimeSyncs >= 2 && (uint16_t)(m_uintCanTimeNow - m_uintCanTimeLastSync) < CAN_TIME_TIMEOUT_MS);
+}
+
+
+
+/**
+ * \brief Gets the drift measured between the master's clock and this one
+ * \return How much faster the master's clock runs, in parts per million
+ */
+int32_t CanTimeDrift(void)
+{
+    return m_lCanTimeDrift;
+}
+
+#endif /* __CAN_TIME_SYNC_CPP__ */
+#endif
+#endif
@@ -0,0 +1,78 @@
+/**
+ * \file canTimeSync.h
+ * \author Timothy Robbins
+ * \brief Common time base between nodes from the CAN frame timestamps. \n
+ * The master sends a SYNC frame, gets the CAN timer value it went out at from the CANRaw tx hook, \n
+ * then sends a FOLLOW_UP frame carrying that time in its own clock. Every other node timestamps the SYNC as it's received, \n
+ * so the pair gives it the master's time at a moment it knows in its own clock, without the send and queue delays. \n
+ * Each pair moves the node's clock onto the master's, and the drift between the two clocks over the pairs is measured \n
+ * and applied in between, so the time stays close to the master's even with a slow sync period. \n
+ * Times are microseconds, wrapping every 71 minutes, compare them with a subtraction. \n
+ * The CAN timer is extended in software, so CanTimePoll or CanTimeNow must be called more often than it wraps, \n
+ * which with CANTCON at 0 is every 524288 cycles, or 32ms at 16MHz, and received frames must be passed in within the same time. \n
+ * The master uses the CANRaw tx hook, so nothing else can on that node. \n
+ *
+ * Example use: \n
+ *
+ * CAN_init_tx(CAN_BPS_500K, false, 1); \n
+ * CanTimeInit(nodeId == HUB_NODE_ID); \n
+ * int8_t OnFrame(CAN_FRAME& frame) { if(CanTimeReceive(frame)) return 0; ... } \n
+ * ... \n
+ * while(1) { CAN_process_frame(OnFrame); CanTimePoll((uint16_t)SystemMillis()); ... } \n
+ * ... \n
+ * sample.time = CanTimeNow(); \n
+ */
+
+#if defined(__cplusplus) && defined(__AVR)
+#if defined(__AVR_ATmega32C1__) || defined(__AVR_ATmega64C1__) || defined(__AVR_ATmega16M1__) || defined(__AVR_ATmega32M1__) || defined(__AVR_ATmega64M1__)
+
+#ifndef __CAN_TIME_SYNC_H__
+#define __CAN_TIME_SYNC_H__
+
+#include <avr/io.h>
+#include "config.h"
+#include "avr_can.h"
+
+
+#ifndef CAN_TIME_SYNC_ID
+///The standard id of the SYNC frame. Low, so it waits on the bus as little as possible
+#define CAN_TIME_SYNC_ID                0x080
+#endif
+
+#ifndef CAN_TIME_FOLLOW_UP_ID
+///The standard id of the FOLLOW_UP frame
+#define CAN_TIME_FOLLOW_UP_ID           0x081
+#endif
+
+#ifndef CAN_TIME_SYNC_PERIOD_MS
+///The milliseconds between SYNC frames sent by the master
+#define CAN_TIME_SYNC_PERIOD_MS         1000
+#endif
+
+#ifndef CAN_TIME_TIMEOUT_MS
+///The milliseconds without a sync before a node counts itself as not synced
+#define CAN_TIME_TIMEOUT_MS             5000
+#endif
+
+#ifndef CAN_TIME_MAX_DRIFT_PPM
+///The most drift accepted between clocks, in parts per million. Measurements past it are clamped
+#define CAN_TIME_MAX_DRIFT_PPM          1000
+#endif
+
+#ifndef CAN_TIME_DRIFT_FILTER
+///The drift moves 1 / this of the way to each new measurement, smoothing out the timestamp jitter
+#define CAN_TIME_DRIFT_FILTER           4
+#endif
+
+
+void CanTimeInit(bool master);
+void CanTimePoll(uint16_t nowMs);
+bool CanTimeReceive(CAN_FRAME& frame);
+uint32_t CanTimeNow(void);
+uint32_t CanTimeOfFrame(const CAN_FRAME& frame);
+bool CanTimeSynced(void);
+int32_t CanTimeDrift(void);
+
+#endif /* __CAN_TIME_SYNC_H__ */
+#endif
+#endif
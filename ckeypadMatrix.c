@@ -272,6 +272,397 @@ unsigned char uchrRowPinPositions[KP_ROWS], unsigned char uchrKeypadValues[KP_RO
 
 
 
+#if KP_USE_PCINT == 1 && defined(__AVR)
+
+#include <avr/interrupt.h>
+#include "mcuIsrStats.h"
+
+///The pin change mask register for the row pins
+#define KP_PCINT_MASK_REG		__PIN_UTIL_TOKENIZE_REG_NAME(PCMSK, KP_PCINT_GROUP)
+
+///The pin change interrupt enable bit in PCICR for the row pins
+#define KP_PCINT_ENABLE_BIT		__PIN_UTIL_TOKENIZE_REG_NAME(PCIE, KP_PCINT_GROUP)
+
+///The pin change interrupt flag bit in PCIFR for the row pins
+#define KP_PCINT_FLAG_BIT		__PIN_UTIL_TOKENIZE_REG_NAME(PCIF, KP_PCINT_GROUP)
+
+///Value for no key being tracked for repeats
+#define KP_NO_KEY				0xFF
+
+
+///The column pins passed on init
+static const unsigned char* m_uchrKpColumnPins = 0;
+
+///The row pins passed on init
+static const unsigned char* m_uchrKpRowPins = 0;
+
+///The keypad values passed on init
+static const unsigned char (*m_uchrKpValues)[KP_COLUMNS] = 0;
+
+///Mask for the column pins
+static uint8_t m_uchrKpColumnMask = 0;
+
+///Mask for the row pins
+static uint8_t m_uchrKpRowMask = 0;
+
+///If the keypad is being scanned, as opposed to parked and waiting on a pin change
+static volatile bool m_bKpScanning = false;
+
+///The column currently being driven low
+static volatile uint8_t m_uchrKpColumn = 0;
+
+///The keys read so far during the current scan
+static volatile kp_keymap_t m_kpScanKeys = 0;
+
+///The keys read on the last full scan
+static volatile kp_keymap_t m_kpLastScanKeys = 0;
+
+///The debounced keys
+static volatile kp_keymap_t m_kpKeys = 0;
+
+///The amount of full scans the keys have read the same for
+static volatile uint8_t m_uchrKpStableScans = 0;
+
+///The key index being tracked for repeats
+static volatile uint8_t m_uchrKpRepeatKey = KP_NO_KEY;
+
+///The amount of full scans the repeat key has been held for
+static volatile uint8_t m_uchrKpRepeatScans = 0;
+
+///The key event queue
+static volatile kp_event_t m_kpEvents[KP_EVENT_QUEUE_SIZE];
+
+///The write index of the event queue
+static volatile uint8_t m_uchrKpEventHead = 0;
+
+///The read index of the event queue
+static volatile uint8_t m_uchrKpEventTail = 0;
+
+
+
+/**
+* \brief Adds an event to the queue, dropping it if the queue is full
+* \param keyIndex The index of the key, row * KP_COLUMNS + column
+* \param type The type of event, KP_EVENT_X
+*/
+static void kp_QueueEvent(uint8_t keyIndex, uint8_t type)
+{
+	//Variables
+	uint8_t nextHead = (m_uchrKpEventHead + 1) & (KP_EVENT_QUEUE_SIZE - 1); //Where the head will be after this write
+	
+	if(nextHead == m_uchrKpEventTail)
+	{
+		return;
+	}
+	
+	//The values are stored row after row, so the key index is its place in them without a divide in the interrupt
+	m_kpEvents[m_uchrKpEventHead].key = (&m_uchrKpValues[0][0])[keyIndex];
+	m_kpEvents[m_uchrKpEventHead].type = type;
+	m_uchrKpEventHead = nextHead;
+}
+
+
+
+/**
+* \brief Drives a single column low with the rest left as pulled up inputs
+* \param column The index of the column to drive
+*/
+static void kp_DriveColumn(uint8_t column)
+{
+	writeMaskInput(KP_COLUMN_DIR, m_uchrKpColumnMask);
+	KP_COLUMN_PORT |= m_uchrKpColumnMask;
+	
+	KP_COLUMN_PORT &= ~(1 << m_uchrKpColumnPins[column]);
+	setBitOutput(KP_COLUMN_DIR, m_uchrKpColumnPins[column]);
+}
+
+
+
+/**
+* \brief Parks all the columns low and enables the pin change interrupt so any key press wakes the scanning back up
+*/
+static void kp_Park(void)
+{
+	//All columns low so any key pulls its row low
+	KP_COLUMN_PORT &= ~m_uchrKpColumnMask;
+	writeMaskOutput(KP_COLUMN_DIR, m_uchrKpColumnMask);
+	
+	m_bKpScanning = false;
+	
+	//Clear any change caused by the scanning itself before turning the interrupt back on
+	PCIFR = (1 << KP_PCINT_FLAG_BIT);
+	PCICR |= (1 << KP_PCINT_ENABLE_BIT);
+}
+
+
+
+/**
+* \brief Starts scanning from the first column with the pin change interrupt off
+*/
+static void kp_StartScanning(void)
+{
+	PCICR &= ~(1 << KP_PCINT_ENABLE_BIT);
+	
+	m_uchrKpColumn = 0;
+	m_kpScanKeys = 0;
+	m_uchrKpStableScans = 0;
+	m_bKpScanning = true;
+	
+	kp_DriveColumn(0);
+}
+
+
+
+/**
+* \brief Debounces a full scan of the keys, queuing down and up events for changed keys and repeat events for the held key
+* \param scanKeys The keys read on the scan
+*/
+static void kp_Debounce(kp_keymap_t scanKeys)
+{
+	//Variables
+	kp_keymap_t changedKeys = 0; //The keys that changed since the last debounced state
+	
+	//Count how long the keys have read the same
+	if(scanKeys != m_kpLastScanKeys)
+	{
+		m_kpLastScanKeys = scanKeys;
+		m_uchrKpStableScans = 0;
+	}
+	else if(m_uchrKpStableScans < 0xFF)
+	{
+		m_uchrKpStableScans++;
+	}
+	
+	//If stable long enough, take the new state
+	if(m_uchrKpStableScans >= (KP_DEBOUNCE_SCANS - 1))
+	{
+		changedKeys = scanKeys ^ m_kpKeys;
+		
+		for(uint8_t i = 0; changedKeys != 0; i++)
+		{
+			if(changedKeys & 0x01)
+			{
+				//If pressed, queue it and track it for repeats as the most recent key. Else, queue the release
+				if(readBit(scanKeys, i))
+				{
+					kp_QueueEvent(i, KP_EVENT_DOWN);
+					m_uchrKpRepeatKey = i;
+					m_uchrKpRepeatScans = 0;
+				}
+				else
+				{
+					kp_QueueEvent(i, KP_EVENT_UP);
+					
+					if(m_uchrKpRepeatKey == i)
+					{
+						m_uchrKpRepeatKey = KP_NO_KEY;
+					}
+				}
+			}
+			
+			changedKeys >>= 1;
+		}
+		
+		m_kpKeys = scanKeys;
+	}
+	
+	#if KP_REPEAT_DELAY_SCANS > 0
+	
+	//Repeat the most recently pressed key while it's held
+	if(m_uchrKpRepeatKey != KP_NO_KEY)
+	{
+		m_uchrKpRepeatScans++;
+		
+		if(m_uchrKpRepeatScans >= KP_REPEAT_DELAY_SCANS)
+		{
+			kp_QueueEvent(m_uchrKpRepeatKey, KP_EVENT_REPEAT);
+			m_uchrKpRepeatScans = KP_REPEAT_DELAY_SCANS - KP_REPEAT_RATE_SCANS;
+		}
+	}
+	
+	#endif
+}
+
+
+
+/**
+* \brief Pin change interrupt for the rows. A key was pressed while parked, so start scanning
+*/
+ISR(_GET_PCINT_VECT(KP_PCINT_GROUP))
+{
+	ISR_STATS_ENTER(ISR_STATS_ID_KEYPAD);
+	
+	if(m_bKpScanning == false)
+	{
+		kp_StartScanning();
+	}
+	
+	ISR_STATS_EXIT(ISR_STATS_ID_KEYPAD);
+}
+
+
+
+/**
+* \brief Sets up the interrupt driven scanning. The row pins must be on the KP_PCINT_GROUP pin change group, with the \n
+* row pin positions matching their bits in its mask register. Interrupts must be turned on by the caller.
+* \param uchrColumnPinPositions The column pin positions
+* \param uchrRowPinPositions The row pin positions
+* \param uchrKeypadValues The values of the keys
+*/
+void kp_InterruptInit(const unsigned char uchrColumnPinPositions[KP_COLUMNS],
+const unsigned char uchrRowPinPositions[KP_ROWS], const unsigned char uchrKeypadValues[KP_ROWS][KP_COLUMNS])
+{
+	//Variables
+	uint8_t i = 0; //Loop index
+	
+	PCICR &= ~(1 << KP_PCINT_ENABLE_BIT);
+	
+	m_uchrKpColumnPins = uchrColumnPinPositions;
+	m_uchrKpRowPins = uchrRowPinPositions;
+	m_uchrKpValues = uchrKeypadValues;
+	m_uchrKpColumnMask = 0;
+	m_uchrKpRowMask = 0;
+	
+	//Build the masks once here instead of on every scan
+	for(i = 0; i < KP_COLUMNS; i++)
+	{
+		m_uchrKpColumnMask |= (1 << uchrColumnPinPositions[i]);
+	}
+	
+	for(i = 0; i < KP_ROWS; i++)
+	{
+		m_uchrKpRowMask |= (1 << uchrRowPinPositions[i]);
+	}
+	
+	m_kpScanKeys = 0;
+	m_kpLastScanKeys = 0;
+	m_kpKeys = 0;
+	m_uchrKpRepeatKey = KP_NO_KEY;
+	m_uchrKpEventHead = 0;
+	m_uchrKpEventTail = 0;
+	
+	//Rows as pulled up inputs that wake on a change
+	writeMaskInput(KP_ROW_DIR, m_uchrKpRowMask);
+	KP_ROW_PORT |= m_uchrKpRowMask;
+	KP_PCINT_MASK_REG |= m_uchrKpRowMask;
+	
+	kp_Park();
+}
+
+
+
+/**
+* \brief Runs the keypad scanning. Call from a periodic timer interrupt, around every 1 to 5ms. \n
+* Each call reads the column driven on the last call and drives the next one, so there are no settling delays. \n
+* A full scan takes KP_COLUMNS calls, and does nothing while the keypad is parked.
+*/
+void kp_Tick(void)
+{
+	//Variables
+	uint8_t pressedRows = 0; //The rows pulled low by the driven column
+	uint8_t column = m_uchrKpColumn; //The column being read
+	kp_keymap_t scanKeys = m_kpScanKeys; //The keys read so far on this scan
+	
+	if(m_bKpScanning == false)
+	{
+		return;
+	}
+	
+	//Read the rows for the column driven on the last tick
+	pressedRows = (~KP_ROW_READ) & m_uchrKpRowMask;
+	
+	for(uint8_t i = 0; i < KP_ROWS && pressedRows != 0; i++)
+	{
+		if(readBit(pressedRows, m_uchrKpRowPins[i]))
+		{
+			scanKeys |= ((kp_keymap_t)1 << (i * KP_COLUMNS + column));
+		}
+	}
+	
+	column++;
+	
+	//If the scan is done, debounce it
+	if(column >= KP_COLUMNS)
+	{
+		kp_Debounce(scanKeys);
+		column = 0;
+		scanKeys = 0;
+		
+		//If everything has been released and settled, park and wait for the next press
+		if(m_kpKeys == 0 && m_kpLastScanKeys == 0 && m_uchrKpStableScans >= (KP_DEBOUNCE_SCANS - 1))
+		{
+			kp_Park();
+			
+			//Catch a press that happened just before the interrupt was turned back on
+			if((KP_ROW_READ & m_uchrKpRowMask) != m_uchrKpRowMask)
+			{
+				kp_StartScanning();
+			}
+			
+			return;
+		}
+	}
+	
+	m_uchrKpColumn = column;
+	m_kpScanKeys = scanKeys;
+	kp_DriveColumn(column);
+}
+
+
+
+/**
+* \brief Gets the next key event from the queue
+* \param keyEvent Where to load the event
+* \return True if there was an event, false if the queue was empty
+*/
+bool kp_GetEvent(kp_event_t* keyEvent)
+{
+	if(m_uchrKpEventTail == m_uchrKpEventHead)
+	{
+		return false;
+	}
+	
+	keyEvent->key = m_kpEvents[m_uchrKpEventTail].key;
+	keyEvent->type = m_kpEvents[m_uchrKpEventTail].type;
+	m_uchrKpEventTail = (m_uchrKpEventTail + 1) & (KP_EVENT_QUEUE_SIZE - 1);
+	
+	return true;
+}
+
+
+
+/**
+* \brief Gets if the keypad is parked and waiting on a pin change, meaning there is nothing to scan
+* \return True if idle
+*/
+bool kp_IsIdle(void)
+{
+	return (m_bKpScanning == false);
+}
+
+
+
+/**
+* \brief Gets the debounced state of all the keys, for chords and such. Any amount of keys can be held at once, \n
+* though a keypad without diodes can ghost a fourth key when three corners of a rectangle are held.
+* \return The keys bitmap, one bit per key at row * KP_COLUMNS + column
+*/
+kp_keymap_t kp_GetKeymap(void)
+{
+	//Variables
+	uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+	kp_keymap_t keys = 0; //The keys
+	
+	interruptsOff();
+	keys = m_kpKeys;
+	SREG = sreg;
+	
+	return keys;
+}
+
+
+#endif
+
 
 
 
@@ -43,6 +43,18 @@
  \n
  currentKeypress = kp_Scan_const(m_uchrKeypdMatrixColumnPins, m_uchrKeypdMatrixRowPins,m_uchrKeypadMatrixValues); \n
  
+ *
+ * Interrupt mode: \n
+ * Define KP_USE_PCINT as 1 and KP_PCINT_GROUP as the pin change group the row pins are on (0 for PCINT0-7, and so on). \n
+ * The columns are parked low and the rows wake the part with a pin change interrupt. kp_Tick is then called from a \n
+ * timer tick, scanning one column per call with no delays, and queues key down, up and repeat events. \n
+ \n
+ kp_InterruptInit(m_uchrKeypdMatrixColumnPins, m_uchrKeypdMatrixRowPins, m_uchrKeypadMatrixValues); \n
+ ISR(TIMER0_COMPA_vect) { kp_Tick(); } \n
+ ... \n
+ kp_event_t keyEvent; \n
+ while(kp_GetEvent(&keyEvent)) { if(keyEvent.type == KP_EVENT_DOWN) { ... } } \n
+ 
  *
  *
  *
@@ -145,6 +157,98 @@ unsigned char uchrRowPinPositions[KP_ROWS], unsigned char uchrKeypadValues[KP_RO
 
 
 
+#ifndef KP_USE_PCINT
+///Set as 1 to use the pin change interrupt driven scanning
+#define KP_USE_PCINT				0
+#endif
+
+
+#if KP_USE_PCINT == 1
+
+#include <stdbool.h>
+
+#ifndef KP_PCINT_GROUP
+///The pin change group of the row port
+#define KP_PCINT_GROUP				0
+#endif
+
+#ifndef KP_DEBOUNCE_SCANS
+///The amount of full scans the keys must read the same for before they are taken
+#define KP_DEBOUNCE_SCANS			3
+#endif
+
+#ifndef KP_REPEAT_DELAY_SCANS
+///The amount of full scans a key is held before it starts repeating. 0 turns off repeating
+#define KP_REPEAT_DELAY_SCANS		100
+#endif
+
+#ifndef KP_REPEAT_RATE_SCANS
+///The amount of full scans between repeats once a key is repeating
+#define KP_REPEAT_RATE_SCANS		20
+#endif
+
+#if KP_REPEAT_DELAY_SCANS > 255
+#error ckeypadMatrix.h: KP_REPEAT_DELAY_SCANS is counted in 8 bits, so it must be 255 or less
+#endif
+
+#if KP_REPEAT_DELAY_SCANS > 0 && (KP_REPEAT_RATE_SCANS < 1 || KP_REPEAT_RATE_SCANS > KP_REPEAT_DELAY_SCANS)
+#error ckeypadMatrix.h: KP_REPEAT_RATE_SCANS must be from 1 to KP_REPEAT_DELAY_SCANS
+#endif
+
+#ifndef KP_EVENT_QUEUE_SIZE
+///The size of the key event queue. Must be a power of 2
+#define KP_EVENT_QUEUE_SIZE			8
+#endif
+
+#if (KP_EVENT_QUEUE_SIZE & (KP_EVENT_QUEUE_SIZE - 1)) != 0
+#error ckeypadMatrix.h: KP_EVENT_QUEUE_SIZE must be a power of 2
+#endif
+
+#if (KP_ROWS * KP_COLUMNS) > 32
+#error ckeypadMatrix.h: The interrupt mode supports up to 32 keys
+#elif (KP_ROWS * KP_COLUMNS) > 16
+///Bitmap of the keys, one bit per key at row * KP_COLUMNS + column
+typedef uint32_t kp_keymap_t;
+#else
+///Bitmap of the keys, one bit per key at row * KP_COLUMNS + column
+typedef uint16_t kp_keymap_t;
+#endif
+
+
+///Event type for a key that was pressed
+#define KP_EVENT_DOWN				1
+
+///Event type for a key that was released
+#define KP_EVENT_UP					2
+
+///Event type for a key being held past the repeat delay
+#define KP_EVENT_REPEAT				3
+
+
+typedef struct _KP_EVENT_
+{
+	uint8_t key;		///The value of the key from the keypad values array
+	uint8_t type;		///The type of event, KP_EVENT_X
+
+}
+/**
+* \brief Struct for a key event from the interrupt driven scanning
+*/
+kp_event_t;
+
+
+extern void kp_InterruptInit(const unsigned char uchrColumnPinPositions[KP_COLUMNS],
+const unsigned char uchrRowPinPositions[KP_ROWS], const unsigned char uchrKeypadValues[KP_ROWS][KP_COLUMNS]);
+
+extern void kp_Tick(void);
+extern bool kp_GetEvent(kp_event_t* keyEvent);
+extern bool kp_IsIdle(void);
+extern kp_keymap_t kp_GetKeymap(void);
+
+#endif
+
+
+
 #else
 #if defined(__GNUC__)
 #pragma message __FILE__ ": Definitions missing. View required definitions to include."
@@ -11,6 +11,7 @@
 #include "mcuUtils.h"
 #include "mcuDelays.h"
 #include "mcuPinUtils.h"
+#include "mcuFormat.h"
 
 
 ///The first positions in each row, in order from top to bottom
@@ -991,27 +992,9 @@ void LcdPrintDelayAtPosition(char* strToSend, unsigned char uchrRow, unsigned ch
 void LcdPrintNumericalByte(uint8_t numVal)
 {
 	//Variables
-	uint8_t firstValue = (numVal / 100);
-	uint8_t secondValue = ((numVal / 10) % 10);
-	uint8_t thirdValue = ((numVal % 10));
-	char strToPrint[3] = {"   "};
-	//Form the characters
-	if(firstValue > 0)
-	{
-		firstValue += (0x30);
-		secondValue += (0x30);
-		strToPrint[0] = (char)firstValue;
-		strToPrint[1] = (char)secondValue;
-	}
-	else if (secondValue > 0)
-	{
-		secondValue += (0x30);
-		strToPrint[1] = (char)secondValue;
-	}
+	char strToPrint[FORMAT_BUFFER_SIZE]; //The value as characters, right justified in 3
 	
-	//Always print the 3rd value, 0 or not
-	thirdValue += 0x30;
-	strToPrint[2] = (char)thirdValue;
+	FormatUnsigned(strToPrint, numVal, 3, 0);
 	
 	for(uint8_t i = 0; i < 3; i++)
 	{
@@ -1029,27 +1012,9 @@ void LcdPrintNumericalByte(uint8_t numVal)
 void LcdPrintNumericalByteDelay(uint8_t numVal, unsigned short ushtDelayTime)
 {
 	//Variables
-	uint8_t firstValue = (numVal / 100);
-	uint8_t secondValue = ((numVal / 10) % 10);
-	uint8_t thirdValue = ((numVal % 10));
-	char strToPrint[3] = {"   "};
-	//Form the characters
-	if(firstValue > 0)
-	{
-		firstValue += (0x30);
-		secondValue += (0x30);
-		strToPrint[0] = (char)firstValue;
-		strToPrint[1] = (char)secondValue;
-	}
-	else if (secondValue > 0)
-	{
-		secondValue += (0x30);
-		strToPrint[1] = (char)secondValue;
-	}
+	char strToPrint[FORMAT_BUFFER_SIZE]; //The value as characters, right justified in 3
 	
-	//Always print the 3rd value, 0 or not
-	thirdValue += 0x30;
-	strToPrint[2] = (char)thirdValue;
+	FormatUnsigned(strToPrint, numVal, 3, 0);
 	
 	
 	for(uint8_t i = 0; i < 3; i++)
@@ -1069,27 +1034,9 @@ void LcdPrintNumericalByteDelay(uint8_t numVal, unsigned short ushtDelayTime)
 void LcdPrintNumericalByteAtPosition(uint8_t numVal, unsigned char uchrRow, unsigned char uchrColumn)
 {
 	//Variables
-	uint8_t firstValue = (numVal / 100);
-	uint8_t secondValue = ((numVal / 10) % 10);
-	uint8_t thirdValue = ((numVal % 10));
-	char strToPrint[3] = {"   "};
-	//Form the characters
-	if(firstValue > 0)
-	{
-		firstValue += (0x30);
-		secondValue += (0x30);
-		strToPrint[0] = (char)firstValue;
-		strToPrint[1] = (char)secondValue;
-	}
-	else if (secondValue > 0)
-	{
-		secondValue += (0x30);
-		strToPrint[1] = (char)secondValue;
-	}
+	char strToPrint[FORMAT_BUFFER_SIZE]; //The value as characters, right justified in 3
 	
-	//Always print the 3rd value, 0 or not
-	thirdValue += 0x30;
-	strToPrint[2] = (char)thirdValue;
+	FormatUnsigned(strToPrint, numVal, 3, 0);
 	
 	LcdGoToPosition(uchrRow, uchrColumn);
 	
@@ -1111,27 +1058,9 @@ void LcdPrintNumericalByteAtPosition(uint8_t numVal, unsigned char uchrRow, unsi
 void LcdPrintNumericalByteDelayAtPosition(uint8_t numVal, unsigned char uchrRow, unsigned char uchrColumn, unsigned short ushtDelayTime)
 {
 	//Variables
-	uint8_t firstValue = (numVal / 100);
-	uint8_t secondValue = ((numVal / 10) % 10);
-	uint8_t thirdValue = ((numVal % 10));
-	char strToPrint[3] = {"   "};
-	//Form the characters
-	if(firstValue > 0)
-	{
-		firstValue += (0x30);
-		secondValue += (0x30);
-		strToPrint[0] = (char)firstValue;
-		strToPrint[1] = (char)secondValue;
-	}
-	else if (secondValue > 0)
-	{
-		secondValue += (0x30);
-		strToPrint[1] = (char)secondValue;
-	}
+	char strToPrint[FORMAT_BUFFER_SIZE]; //The value as characters, right justified in 3
 	
-	//Always print the 3rd value, 0 or not
-	thirdValue += 0x30;
-	strToPrint[2] = (char)thirdValue;
+	FormatUnsigned(strToPrint, numVal, 3, 0);
 	
 	LcdGoToPosition(uchrRow, uchrColumn);
 	
@@ -1150,51 +1079,9 @@ void LcdPrintNumericalByteDelayAtPosition(uint8_t numVal, unsigned char uchrRow,
 void LcdPrintNumericalShort(uint16_t numVal)
 {
 	//Variables
-	uint8_t firstValue =  (numVal / 10000);
-	uint8_t secondValue = ((numVal / 1000) % 10);
-	uint8_t thirdValue =  ((numVal % 1000)/100);
-	uint8_t fourthValue = ((numVal % 100) / 10);
-	uint8_t fifthValue =  ((numVal % 10));
-	
-	char strToPrint[5] = {"     "};
-		
-	//Form the characters
-	if(firstValue > 0)
-	{
-		firstValue += (0x30);
-		secondValue += (0x30);
-		thirdValue += 0x30;
-		fourthValue += 0x30;
-		strToPrint[0] = (char)firstValue;
-		strToPrint[1] = (char)secondValue;
-		strToPrint[2] = (char)thirdValue;
-		strToPrint[3] = (char)fourthValue;
-	}
-	else if (secondValue > 0)
-	{
-		secondValue += (0x30);
-		thirdValue += 0x30;
-		fourthValue += 0x30;
-		strToPrint[1] = (char)secondValue;
-		strToPrint[2] = (char)thirdValue;
-		strToPrint[3] = (char)fourthValue;
-	}
-	else if (thirdValue > 0)
-	{
-		thirdValue += 0x30;
-		fourthValue += 0x30;
-		strToPrint[2] = (char)thirdValue;
-		strToPrint[3] = (char)fourthValue;
-	}
-	else if(fourthValue > 0)
-	{
-		fourthValue += 0x30;
-		strToPrint[3] = (char)fourthValue;
-	}
+	char strToPrint[FORMAT_BUFFER_SIZE]; //The value as characters, right justified in 5
 	
-	//Always print the last value, 0 or not
-	fifthValue += 0x30;
-	strToPrint[4] = (char)fifthValue;
+	FormatUnsigned(strToPrint, numVal, 5, 0);
 	
 	
 
@@ -1213,53 +1100,10 @@ void LcdPrintNumericalShort(uint16_t numVal)
 */
 void LcdPrintNumericalShortDelay(uint16_t numVal, unsigned short ushtDelayTime)
 {
-
 	//Variables
-	uint8_t firstValue =  (numVal / 10000);
-	uint8_t secondValue = ((numVal / 1000) % 10);
-	uint8_t thirdValue =  ((numVal % 1000)/100);
-	uint8_t fourthValue = ((numVal % 100) / 10);
-	uint8_t fifthValue =  ((numVal % 10));
-	
-	char strToPrint[5] = {"     "};
-	
-	//Form the characters
-	if(firstValue > 0)
-	{
-		firstValue += (0x30);
-		secondValue += (0x30);
-		thirdValue += 0x30;
-		fourthValue += 0x30;
-		strToPrint[0] = (char)firstValue;
-		strToPrint[1] = (char)secondValue;
-		strToPrint[2] = (char)thirdValue;
-		strToPrint[3] = (char)fourthValue;
-	}
-	else if (secondValue > 0)
-	{
-		secondValue += (0x30);
-		thirdValue += 0x30;
-		fourthValue += 0x30;
-		strToPrint[1] = (char)secondValue;
-		strToPrint[2] = (char)thirdValue;
-		strToPrint[3] = (char)fourthValue;
-	}
-	else if (thirdValue > 0)
-	{
-		thirdValue += 0x30;
-		fourthValue += 0x30;
-		strToPrint[2] = (char)thirdValue;
-		strToPrint[3] = (char)fourthValue;
-	}
-	else if(fourthValue > 0)
-	{
-		fourthValue += 0x30;
-		strToPrint[3] = (char)fourthValue;
-	}
+	char strToPrint[FORMAT_BUFFER_SIZE]; //The value as characters, right justified in 5
 	
-	//Always print the last value, 0 or not
-	fifthValue += 0x30;
-	strToPrint[4] = (char)fifthValue;
+	FormatUnsigned(strToPrint, numVal, 5, 0);
 	
 	
 
@@ -1280,51 +1124,9 @@ void LcdPrintNumericalShortDelay(uint16_t numVal, unsigned short ushtDelayTime)
 void LcdPrintNumericalShortAtPosition(uint16_t numVal, unsigned char uchrRow, unsigned char uchrColumn)
 {
 	//Variables
-	uint8_t firstValue =  (numVal / 10000);
-	uint8_t secondValue = ((numVal / 1000) % 10);
-	uint8_t thirdValue =  ((numVal % 1000)/100);
-	uint8_t fourthValue = ((numVal % 100) / 10);
-	uint8_t fifthValue =  ((numVal % 10));
+	char strToPrint[FORMAT_BUFFER_SIZE]; //The value as characters, right justified in 5
 	
-	char strToPrint[5] = {"     "};
-	
-	//Form the characters
-	if(firstValue > 0)
-	{
-		firstValue += (0x30);
-		secondValue += (0x30);
-		thirdValue += 0x30;
-		fourthValue += 0x30;
-		strToPrint[0] = (char)firstValue;
-		strToPrint[1] = (char)secondValue;
-		strToPrint[2] = (char)thirdValue;
-		strToPrint[3] = (char)fourthValue;
-	}
-	else if (secondValue > 0)
-	{
-		secondValue += (0x30);
-		thirdValue += 0x30;
-		fourthValue += 0x30;
-		strToPrint[1] = (char)secondValue;
-		strToPrint[2] = (char)thirdValue;
-		strToPrint[3] = (char)fourthValue;
-	}
-	else if (thirdValue > 0)
-	{
-		thirdValue += 0x30;
-		fourthValue += 0x30;
-		strToPrint[2] = (char)thirdValue;
-		strToPrint[3] = (char)fourthValue;
-	}
-	else if(fourthValue > 0)
-	{
-		fourthValue += 0x30;
-		strToPrint[3] = (char)fourthValue;
-	}
-	
-	//Always print the last value, 0 or not
-	fifthValue += 0x30;
-	strToPrint[4] = (char)fifthValue;
+	FormatUnsigned(strToPrint, numVal, 5, 0);
 	
 	
 	LcdGoToPosition(uchrRow, uchrColumn);
@@ -1347,51 +1149,9 @@ void LcdPrintNumericalShortAtPosition(uint16_t numVal, unsigned char uchrRow, un
 void LcdPrintNumericalShortDelayAtPosition(uint16_t numVal, unsigned char uchrRow, unsigned char uchrColumn, unsigned short ushtDelayTime)
 {
 	//Variables
-	uint8_t firstValue =  (numVal / 10000);
-	uint8_t secondValue = ((numVal / 1000) % 10);
-	uint8_t thirdValue =  ((numVal % 1000)/100);
-	uint8_t fourthValue = ((numVal % 100) / 10);
-	uint8_t fifthValue =  ((numVal % 10));
-	
-	char strToPrint[5] = {"     "};
-	
-	//Form the characters
-	if(firstValue > 0)
-	{
-		firstValue += (0x30);
-		secondValue += (0x30);
-		thirdValue += 0x30;
-		fourthValue += 0x30;
-		strToPrint[0] = (char)firstValue;
-		strToPrint[1] = (char)secondValue;
-		strToPrint[2] = (char)thirdValue;
-		strToPrint[3] = (char)fourthValue;
-	}
-	else if (secondValue > 0)
-	{
-		secondValue += (0x30);
-		thirdValue += 0x30;
-		fourthValue += 0x30;
-		strToPrint[1] = (char)secondValue;
-		strToPrint[2] = (char)thirdValue;
-		strToPrint[3] = (char)fourthValue;
-	}
-	else if (thirdValue > 0)
-	{
-		thirdValue += 0x30;
-		fourthValue += 0x30;
-		strToPrint[2] = (char)thirdValue;
-		strToPrint[3] = (char)fourthValue;
-	}
-	else if(fourthValue > 0)
-	{
-		fourthValue += 0x30;
-		strToPrint[3] = (char)fourthValue;
-	}
+	char strToPrint[FORMAT_BUFFER_SIZE]; //The value as characters, right justified in 5
 	
-	//Always print the last value, 0 or not
-	fifthValue += 0x30;
-	strToPrint[4] = (char)fifthValue;
+	FormatUnsigned(strToPrint, numVal, 5, 0);
 	
 	LcdGoToPosition(uchrRow, uchrColumn);
 	
@@ -1411,9 +1171,9 @@ void LcdPrintNumericalShortDelayAtPosition(uint16_t numVal, unsigned char uchrRo
 void LcdDisplayByteHex(uint8_t byteValue)
 {
 	//variables
-	char displayString[4] = "0x00";
-	displayString[2] += (char)((byteValue & 0xF0) >> 4);
-	displayString[3] += (char)(byteValue & 0x0F);
+	char displayString[FORMAT_BUFFER_SIZE] = "0x"; //The prefix and hex digits
+	
+	FormatHex(&displayString[2], byteValue, 2, FORMAT_PAD_ZERO | FORMAT_UPPER);
 	LcdPrintString(displayString);
 }
 
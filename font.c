@@ -8,7 +8,7 @@
 
 #include "font.h"
 
-char ssd1306oled_font_A[] = 
+uint8_t ssd1306oled_font_A[] = 
 {
  0x00, 0x00, 0x00, 0x00, 0x00, 0x00 // space
 ,0x00, 0x00, 0x00, 0x2f, 0x00, 0x00 // !
@@ -44,7 +44,7 @@ extern "C" {
 
 #define ssd1306oled_font_A_length		95
 #define ssd1306oled_font_A_char_length	6
-extern char ssd1306oled_font_A[];
+extern uint8_t ssd1306oled_font_A[];
 
 #define FONT_BIG_NUM_WIDTH	24
 #define FONT_BIG_NUM_HEIGHT 19
@@ -0,0 +1,32 @@
+/**
+ * \file interrupt.h
+ * \author Tim Robbins
+ * \brief Host stand in for avr/interrupt.h. An ISR is a plain C function the simulation calls when its flag is set and enabled.
+ */
+#ifndef HOST_AVR_INTERRUPT_H_
+#define HOST_AVR_INTERRUPT_H_ 1
+
+#include <avr/io.h>
+
+///Defines the interrupt service routine for a vector
+#define ISR(vector, ...)				extern "C" void vector(void); extern "C" void vector(void)
+
+///Defines an interrupt service routine that does nothing
+#define EMPTY_INTERRUPT(vector)			extern "C" void vector(void) { }
+
+///ISR attributes, which don't mean anything on the host
+#define ISR_BLOCK
+#define ISR_NOBLOCK
+#define ISR_NAKED
+#define ISR_ALIASOF(vector)
+
+///Enables global interrupts
+#define sei()							HostSimInterruptsOn()
+
+///Disables global interrupts
+#define cli()							HostSimInterruptsOff()
+
+///Returns from an interrupt
+#define reti()							return
+
+#endif
@@ -0,0 +1,920 @@
+/**
+ * \file io.h
+ * \author Tim Robbins
+ * \brief Host stand in for avr/io.h. Declares the simulated registers, their bits and the interrupt vectors. \n
+ * See hostSim.h for how the host build works.
+ */
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_ 1
+
+#include "../hostSim.h"
+
+#ifndef __AVR_ATmega32M1__
+#define __AVR_ATmega32M1__
+#endif
+
+///Bit value
+#define _BV(bit)						(1 << (bit))
+
+///Checks if a bit in a register is set
+#define bit_is_set(sfr, bit)			((sfr) & _BV(bit))
+
+///Checks if a bit in a register is clear
+#define bit_is_clear(sfr, bit)			(!((sfr) & _BV(bit)))
+
+///Waits until a bit in a register is set
+#define loop_until_bit_is_set(sfr, bit)		do { } while (bit_is_clear(sfr, bit))
+
+///Waits until a bit in a register is clear
+#define loop_until_bit_is_clear(sfr, bit)	do { } while (bit_is_set(sfr, bit))
+
+//mcuUtils.h turns interrupts on and off and sleeps with inline assembly, which won't build for the host
+#define interruptsOn()					HostSimInterruptsOn()
+#define interruptsOff()					HostSimInterruptsOff()
+#define sleep_cpu()						HostSimSleep()
+
+
+//GPIO, plain variables. PINx is driven by the test with HostGpioSetPin
+#ifdef	__cplusplus
+extern "C" {
+#endif
+extern volatile uint8_t PINB;
+#define PINB PINB
+extern volatile uint8_t DDRB;
+#define DDRB DDRB
+extern volatile uint8_t PORTB;
+#define PORTB PORTB
+
+extern volatile uint8_t PINC;
+#define PINC PINC
+extern volatile uint8_t DDRC;
+#define DDRC DDRC
+extern volatile uint8_t PORTC;
+#define PORTC PORTC
+
+extern volatile uint8_t PIND;
+#define PIND PIND
+extern volatile uint8_t DDRD;
+#define DDRD DDRD
+extern volatile uint8_t PORTD;
+#define PORTD PORTD
+
+extern volatile uint8_t PINE;
+#define PINE PINE
+extern volatile uint8_t DDRE;
+#define DDRE DDRE
+extern volatile uint8_t PORTE;
+#define PORTE PORTE
+
+#ifdef	__cplusplus
+}
+#endif
+
+
+//Core
+extern HostReg8 SREG;
+#define SREG SREG
+extern HostReg8 SMCR;
+#define SMCR SMCR
+extern HostReg8 MCUCR;
+#define MCUCR MCUCR
+extern HostReg8 MCUSR;
+#define MCUSR MCUSR
+extern HostReg8 PRR;
+#define PRR PRR
+
+//Pin change interrupts
+extern HostReg8 PCICR;
+#define PCICR PCICR
+extern HostReg8 PCIFR;
+#define PCIFR PCIFR
+extern HostReg8 PCMSK0;
+#define PCMSK0 PCMSK0
+extern HostReg8 PCMSK1;
+#define PCMSK1 PCMSK1
+extern HostReg8 PCMSK2;
+#define PCMSK2 PCMSK2
+extern HostReg8 PCMSK3;
+#define PCMSK3 PCMSK3
+
+//Timer0
+extern HostReg8 TCCR0A;
+#define TCCR0A TCCR0A
+extern HostReg8 TCCR0B;
+#define TCCR0B TCCR0B
+extern HostReg8 TCNT0;
+#define TCNT0 TCNT0
+extern HostReg8 OCR0A;
+#define OCR0A OCR0A
+extern HostReg8 OCR0B;
+#define OCR0B OCR0B
+extern HostReg8 TIMSK0;
+#define TIMSK0 TIMSK0
+extern HostReg8 TIFR0;
+#define TIFR0 TIFR0
+
+//Timer1
+extern HostReg8 TCCR1A;
+#define TCCR1A TCCR1A
+extern HostReg8 TCCR1B;
+#define TCCR1B TCCR1B
+extern HostReg8 TCCR1C;
+#define TCCR1C TCCR1C
+extern HostReg8 TCNT1L;
+#define TCNT1L TCNT1L
+extern HostReg8 TCNT1H;
+#define TCNT1H TCNT1H
+extern HostReg8 OCR1AL;
+#define OCR1AL OCR1AL
+extern HostReg8 OCR1AH;
+#define OCR1AH OCR1AH
+extern HostReg8 OCR1BL;
+#define OCR1BL OCR1BL
+extern HostReg8 OCR1BH;
+#define OCR1BH OCR1BH
+extern HostReg8 ICR1L;
+#define ICR1L ICR1L
+extern HostReg8 ICR1H;
+#define ICR1H ICR1H
+extern HostReg8 TIMSK1;
+#define TIMSK1 TIMSK1
+extern HostReg8 TIFR1;
+#define TIFR1 TIFR1
+extern HostReg16 TCNT1;
+#define TCNT1 TCNT1
+extern HostReg16 OCR1A;
+#define OCR1A OCR1A
+extern HostReg16 OCR1B;
+#define OCR1B OCR1B
+extern HostReg16 ICR1;
+#define ICR1 ICR1
+
+//ADC
+extern HostReg8 ADMUX;
+#define ADMUX ADMUX
+extern HostReg8 ADCSRA;
+#define ADCSRA ADCSRA
+extern HostReg8 ADCSRB;
+#define ADCSRB ADCSRB
+extern HostReg8 ADCL;
+#define ADCL ADCL
+extern HostReg8 ADCH;
+#define ADCH ADCH
+extern HostReg8 DIDR0;
+#define DIDR0 DIDR0
+extern HostReg8 DIDR1;
+#define DIDR1 DIDR1
+extern HostReg16 ADC;
+#define ADC ADC
+extern HostReg16 ADCW;
+#define ADCW ADCW
+
+//SPI
+extern HostReg8 SPCR;
+#define SPCR SPCR
+extern HostReg8 SPSR;
+#define SPSR SPSR
+extern HostReg8 SPDR;
+#define SPDR SPDR
+
+//USART0
+extern HostReg8 UCSR0A;
+#define UCSR0A UCSR0A
+extern HostReg8 UCSR0B;
+#define UCSR0B UCSR0B
+extern HostReg8 UCSR0C;
+#define UCSR0C UCSR0C
+extern HostReg8 UBRR0L;
+#define UBRR0L UBRR0L
+extern HostReg8 UBRR0H;
+#define UBRR0H UBRR0H
+extern HostReg8 UDR0;
+#define UDR0 UDR0
+extern HostReg16 UBRR0;
+#define UBRR0 UBRR0
+
+//USART1
+extern HostReg8 UCSR1A;
+#define UCSR1A UCSR1A
+extern HostReg8 UCSR1B;
+#define UCSR1B UCSR1B
+extern HostReg8 UCSR1C;
+#define UCSR1C UCSR1C
+extern HostReg8 UBRR1L;
+#define UBRR1L UBRR1L
+extern HostReg8 UBRR1H;
+#define UBRR1H UBRR1H
+extern HostReg8 UDR1;
+#define UDR1 UDR1
+extern HostReg16 UBRR1;
+#define UBRR1 UBRR1
+
+//TWI
+extern HostReg8 TWBR;
+#define TWBR TWBR
+extern HostReg8 TWSR;
+#define TWSR TWSR
+extern HostReg8 TWAR;
+#define TWAR TWAR
+extern HostReg8 TWDR;
+#define TWDR TWDR
+extern HostReg8 TWCR;
+#define TWCR TWCR
+extern HostReg8 TWAMR;
+#define TWAMR TWAMR
+
+//CAN
+extern HostReg8 CANGCON;
+#define CANGCON CANGCON
+extern HostReg8 CANGSTA;
+#define CANGSTA CANGSTA
+extern HostReg8 CANGIT;
+#define CANGIT CANGIT
+extern HostReg8 CANGIE;
+#define CANGIE CANGIE
+extern HostReg8 CANEN2;
+#define CANEN2 CANEN2
+extern HostReg8 CANEN1;
+#define CANEN1 CANEN1
+extern HostReg8 CANIE2;
+#define CANIE2 CANIE2
+extern HostReg8 CANIE1;
+#define CANIE1 CANIE1
+extern HostReg8 CANSIT2;
+#define CANSIT2 CANSIT2
+extern HostReg8 CANSIT1;
+#define CANSIT1 CANSIT1
+extern HostReg8 CANBT1;
+#define CANBT1 CANBT1
+extern HostReg8 CANBT2;
+#define CANBT2 CANBT2
+extern HostReg8 CANBT3;
+#define CANBT3 CANBT3
+extern HostReg8 CANTCON;
+#define CANTCON CANTCON
+extern HostReg8 CANTIML;
+#define CANTIML CANTIML
+extern HostReg8 CANTIMH;
+#define CANTIMH CANTIMH
+extern HostReg8 CANTTCL;
+#define CANTTCL CANTTCL
+extern HostReg8 CANTTCH;
+#define CANTTCH CANTTCH
+extern HostReg8 CANTEC;
+#define CANTEC CANTEC
+extern HostReg8 CANREC;
+#define CANREC CANREC
+extern HostReg8 CANHPMOB;
+#define CANHPMOB CANHPMOB
+extern HostReg8 CANPAGE;
+#define CANPAGE CANPAGE
+extern HostReg8 CANSTMOB;
+#define CANSTMOB CANSTMOB
+extern HostReg8 CANCDMOB;
+#define CANCDMOB CANCDMOB
+extern HostReg8 CANIDT4;
+#define CANIDT4 CANIDT4
+extern HostReg8 CANIDT3;
+#define CANIDT3 CANIDT3
+extern HostReg8 CANIDT2;
+#define CANIDT2 CANIDT2
+extern HostReg8 CANIDT1;
+#define CANIDT1 CANIDT1
+extern HostReg8 CANIDM4;
+#define CANIDM4 CANIDM4
+extern HostReg8 CANIDM3;
+#define CANIDM3 CANIDM3
+extern HostReg8 CANIDM2;
+#define CANIDM2 CANIDM2
+extern HostReg8 CANIDM1;
+#define CANIDM1 CANIDM1
+extern HostReg8 CANSTML;
+#define CANSTML CANSTML
+extern HostReg8 CANSTMH;
+#define CANSTMH CANSTMH
+extern HostReg8 CANMSG;
+#define CANMSG CANMSG
+extern HostReg16 CANTIM;
+#define CANTIM CANTIM
+extern HostReg16 CANTTC;
+#define CANTTC CANTTC
+extern HostReg16 CANSTM;
+#define CANSTM CANSTM
+
+//LIN/UART
+extern HostReg8 LINCR;
+#define LINCR LINCR
+extern HostReg8 LINSIR;
+#define LINSIR LINSIR
+extern HostReg8 LINENIR;
+#define LINENIR LINENIR
+extern HostReg8 LINERR;
+#define LINERR LINERR
+extern HostReg8 LINBTR;
+#define LINBTR LINBTR
+extern HostReg8 LINBRRL;
+#define LINBRRL LINBRRL
+extern HostReg8 LINBRRH;
+#define LINBRRH LINBRRH
+extern HostReg8 LINDLR;
+#define LINDLR LINDLR
+extern HostReg8 LINIDR;
+#define LINIDR LINIDR
+extern HostReg8 LINSEL;
+#define LINSEL LINSEL
+extern HostReg8 LINDAT;
+#define LINDAT LINDAT
+extern HostReg16 LINBRR;
+#define LINBRR LINBRR
+
+
+//Register bits
+
+//PINx, DDRx and PORTx
+#define PINB0							0
+#define PINB1							1
+#define PINB2							2
+#define PINB3							3
+#define PINB4							4
+#define PINB5							5
+#define PINB6							6
+#define PINB7							7
+#define DDB0							0
+#define DDB1							1
+#define DDB2							2
+#define DDB3							3
+#define DDB4							4
+#define DDB5							5
+#define DDB6							6
+#define DDB7							7
+#define PORTB0							0
+#define PORTB1							1
+#define PORTB2							2
+#define PORTB3							3
+#define PORTB4							4
+#define PORTB5							5
+#define PORTB6							6
+#define PORTB7							7
+#define PINC0							0
+#define PINC1							1
+#define PINC2							2
+#define PINC3							3
+#define PINC4							4
+#define PINC5							5
+#define PINC6							6
+#define PINC7							7
+#define DDC0							0
+#define DDC1							1
+#define DDC2							2
+#define DDC3							3
+#define DDC4							4
+#define DDC5							5
+#define DDC6							6
+#define DDC7							7
+#define PORTC0							0
+#define PORTC1							1
+#define PORTC2							2
+#define PORTC3							3
+#define PORTC4							4
+#define PORTC5							5
+#define PORTC6							6
+#define PORTC7							7
+#define PIND0							0
+#define PIND1							1
+#define PIND2							2
+#define PIND3							3
+#define PIND4							4
+#define PIND5							5
+#define PIND6							6
+#define PIND7							7
+#define DDD0							0
+#define DDD1							1
+#define DDD2							2
+#define DDD3							3
+#define DDD4							4
+#define DDD5							5
+#define DDD6							6
+#define DDD7							7
+#define PORTD0							0
+#define PORTD1							1
+#define PORTD2							2
+#define PORTD3							3
+#define PORTD4							4
+#define PORTD5							5
+#define PORTD6							6
+#define PORTD7							7
+#define PINE0							0
+#define PINE1							1
+#define PINE2							2
+#define PINE3							3
+#define PINE4							4
+#define PINE5							5
+#define PINE6							6
+#define PINE7							7
+#define DDE0							0
+#define DDE1							1
+#define DDE2							2
+#define DDE3							3
+#define DDE4							4
+#define DDE5							5
+#define DDE6							6
+#define DDE7							7
+#define PORTE0							0
+#define PORTE1							1
+#define PORTE2							2
+#define PORTE3							3
+#define PORTE4							4
+#define PORTE5							5
+#define PORTE6							6
+#define PORTE7							7
+
+//SREG
+#define SREG_I							7
+#define SREG_T							6
+#define SREG_H							5
+#define SREG_S							4
+#define SREG_V							3
+#define SREG_N							2
+#define SREG_Z							1
+#define SREG_C							0
+
+//SMCR
+#define SM2								3
+#define SM1								2
+#define SM0								1
+#define SE								0
+
+//MCUCR
+#define PUD								4
+#define IVSEL							1
+#define IVCE							0
+
+//PRR
+#define PRTWI							7
+#define PRCAN							6
+#define PRPSC							5
+#define PRTIM1							4
+#define PRTIM0							3
+#define PRSPI							2
+#define PRLIN							1
+#define PRADC							0
+
+//PCICR
+#define PCIE3							3
+#define PCIE2							2
+#define PCIE1							1
+#define PCIE0							0
+
+//PCIFR
+#define PCIF3							3
+#define PCIF2							2
+#define PCIF1							1
+#define PCIF0							0
+
+//PCMSK0-3
+#define PCINT0							0
+#define PCINT1							1
+#define PCINT2							2
+#define PCINT3							3
+#define PCINT4							4
+#define PCINT5							5
+#define PCINT6							6
+#define PCINT7							7
+#define PCINT8							0
+#define PCINT9							1
+#define PCINT10							2
+#define PCINT11							3
+#define PCINT12							4
+#define PCINT13							5
+#define PCINT14							6
+#define PCINT15							7
+#define PCINT16							0
+#define PCINT17							1
+#define PCINT18							2
+#define PCINT19							3
+#define PCINT20							4
+#define PCINT21							5
+#define PCINT22							6
+#define PCINT23							7
+#define PCINT24							0
+#define PCINT25							1
+#define PCINT26							2
+
+//TCCR0A
+#define COM0A1							7
+#define COM0A0							6
+#define COM0B1							5
+#define COM0B0							4
+#define WGM01							1
+#define WGM00							0
+
+//TCCR0B
+#define FOC0A							7
+#define FOC0B							6
+#define WGM02							3
+#define CS02							2
+#define CS01							1
+#define CS00							0
+
+//TIMSK0
+#define OCIE0B							2
+#define OCIE0A							1
+#define TOIE0							0
+
+//TIFR0
+#define OCF0B							2
+#define OCF0A							1
+#define TOV0							0
+
+//TCCR1A
+#define COM1A1							7
+#define COM1A0							6
+#define COM1B1							5
+#define COM1B0							4
+#define WGM11							1
+#define WGM10							0
+
+//TCCR1B
+#define ICNC1							7
+#define ICES1							6
+#define WGM13							4
+#define WGM12							3
+#define CS12							2
+#define CS11							1
+#define CS10							0
+
+//TCCR1C
+#define FOC1A							7
+#define FOC1B							6
+
+//TIMSK1
+#define ICIE1							5
+#define OCIE1B							2
+#define OCIE1A							1
+#define TOIE1							0
+
+//TIFR1
+#define ICF1							5
+#define OCF1B							2
+#define OCF1A							1
+#define TOV1							0
+
+//ADMUX
+#define REFS1							7
+#define REFS0							6
+#define ADLAR							5
+#define MUX4							4
+#define MUX3							3
+#define MUX2							2
+#define MUX1							1
+#define MUX0							0
+
+//ADCSRA
+#define ADEN							7
+#define ADSC							6
+#define ADATE							5
+#define ADIF							4
+#define ADIE							3
+#define ADPS2							2
+#define ADPS1							1
+#define ADPS0							0
+
+//ADCSRB
+#define ADHSM							7
+#define ISRCEN							6
+#define AREFEN							5
+#define ADTS3							3
+#define ADTS2							2
+#define ADTS1							1
+#define ADTS0							0
+
+//SPCR
+#define SPIE							7
+#define SPE								6
+#define DORD							5
+#define MSTR							4
+#define CPOL							3
+#define CPHA							2
+#define SPR1							1
+#define SPR0							0
+
+//SPSR
+#define SPIF							7
+#define WCOL							6
+#define SPI2X							0
+
+//UCSR0A
+#define RXC0							7
+#define TXC0							6
+#define UDRE0							5
+#define FE0								4
+#define DOR0							3
+#define UPE0							2
+#define U2X0							1
+#define MPCM0							0
+
+//UCSR0B
+#define RXCIE0							7
+#define TXCIE0							6
+#define UDRIE0							5
+#define RXEN0							4
+#define TXEN0							3
+#define UCSZ02							2
+#define RXB80							1
+#define TXB80							0
+
+//UCSR0C
+#define UMSEL01							7
+#define UMSEL00							6
+#define UPM01							5
+#define UPM00							4
+#define USBS0							3
+#define UCSZ01							2
+#define UCSZ00							1
+#define UCPOL0							0
+
+//UCSR1A
+#define RXC1							7
+#define TXC1							6
+#define UDRE1							5
+#define FE1								4
+#define DOR1							3
+#define UPE1							2
+#define U2X1							1
+#define MPCM1							0
+
+//UCSR1B
+#define RXCIE1							7
+#define TXCIE1							6
+#define UDRIE1							5
+#define RXEN1							4
+#define TXEN1							3
+#define UCSZ12							2
+#define RXB81							1
+#define TXB81							0
+
+//UCSR1C
+#define UMSEL11							7
+#define UMSEL10							6
+#define UPM11							5
+#define UPM10							4
+#define USBS1							3
+#define UCSZ11							2
+#define UCSZ10							1
+#define UCPOL1							0
+
+//TWCR
+#define TWINT							7
+#define TWEA							6
+#define TWSTA							5
+#define TWSTO							4
+#define TWWC							3
+#define TWEN							2
+#define TWIE							0
+
+//TWSR
+#define TWS7							7
+#define TWS6							6
+#define TWS5							5
+#define TWS4							4
+#define TWS3							3
+#define TWPS1							1
+#define TWPS0							0
+
+//TWAR
+#define TWGCE							0
+
+//CANGCON
+#define ABRQ							7
+#define OVRQ							6
+#define TTC								5
+#define SYNTTC							4
+#define LISTEN							3
+#define TEST							2
+#define ENASTB							1
+#define SWRES							0
+
+//CANGSTA
+#define OVRG							6
+#define TXBSY							4
+#define RXBSY							3
+#define ENFG							2
+#define BOFF							1
+#define ERRP							0
+
+//CANGIT
+#define CANIT							7
+#define BOFFIT							6
+#define OVRTIM							5
+#define BXOK							4
+#define SERG							3
+#define CERG							2
+#define FERG							1
+#define AERG							0
+
+//CANGIE
+#define ENIT							7
+#define ENBOFF							6
+#define ENRX							5
+#define ENTX							4
+#define ENERR							3
+#define ENBX							2
+#define ENERG							1
+#define ENOVRT							0
+
+//CANEN2
+#define ENMOB5							5
+#define ENMOB4							4
+#define ENMOB3							3
+#define ENMOB2							2
+#define ENMOB1							1
+#define ENMOB0							0
+
+//CANIE2
+#define IEMOB5							5
+#define IEMOB4							4
+#define IEMOB3							3
+#define IEMOB2							2
+#define IEMOB1							1
+#define IEMOB0							0
+
+//CANSIT2
+#define SIT5							5
+#define SIT4							4
+#define SIT3							3
+#define SIT2							2
+#define SIT1							1
+#define SIT0							0
+
+//CANBT1
+#define BRP5							6
+#define BRP4							5
+#define BRP3							4
+#define BRP2							3
+#define BRP1							2
+#define BRP0							1
+
+//CANBT2
+#define SJW1							6
+#define SJW0							5
+#define PRS2							3
+#define PRS1							2
+#define PRS0							1
+
+//CANBT3
+#define PHS22							6
+#define PHS21							5
+#define PHS20							4
+#define PHS12							3
+#define PHS11							2
+#define PHS10							1
+#define SMP								0
+
+//CANHPMOB
+#define HPMOB3							7
+#define HPMOB2							6
+#define HPMOB1							5
+#define HPMOB0							4
+#define CGP3							3
+#define CGP2							2
+#define CGP1							1
+#define CGP0							0
+
+//CANPAGE
+#define MOBNB3							7
+#define MOBNB2							6
+#define MOBNB1							5
+#define MOBNB0							4
+#define AINC							3
+#define INDX2							2
+#define INDX1							1
+#define INDX0							0
+
+//CANSTMOB
+#define DLCW							7
+#define TXOK							6
+#define RXOK							5
+#define BERR							4
+#define SERR							3
+#define CERR							2
+#define FERR							1
+#define AERR							0
+
+//CANCDMOB
+#define CONMOB1							7
+#define CONMOB0							6
+#define RPLV							5
+#define IDE								4
+#define DLC3							3
+#define DLC2							2
+#define DLC1							1
+#define DLC0							0
+
+//CANIDT4
+#define RTRTAG							2
+#define RB1TAG							1
+#define RB0TAG							0
+
+//CANIDM4
+#define RTRMSK							2
+#define IDEMSK							0
+
+//LINCR
+#define LSWRES							7
+#define LIN13							6
+#define LCONF1							5
+#define LCONF0							4
+#define LENA							3
+#define LCMD2							2
+#define LCMD1							1
+#define LCMD0							0
+
+//LINSIR
+#define LIDST2							7
+#define LIDST1							6
+#define LIDST0							5
+#define LBUSY							4
+#define LERR							3
+#define LIDOK							2
+#define LTXOK							1
+#define LRXOK							0
+
+//LINENIR
+#define LENERR							3
+#define LENIDOK							2
+#define LENTXOK							1
+#define LENRXOK							0
+
+//LINERR
+#define LABORT							7
+#define LTOERR							6
+#define LOVERR							5
+#define LFERR							4
+#define LSERR							3
+#define LPERR							2
+#define LCERR							1
+#define LBERR							0
+
+//LINBTR
+#define LDISR							7
+#define LBT5							5
+#define LBT4							4
+#define LBT3							3
+#define LBT2							2
+#define LBT1							1
+#define LBT0							0
+
+//LINDLR
+#define LTXDL3							7
+#define LTXDL2							6
+#define LTXDL1							5
+#define LTXDL0							4
+#define LRXDL3							3
+#define LRXDL2							2
+#define LRXDL1							1
+#define LRXDL0							0
+
+//LINIDR
+#define LP1								7
+#define LP0								6
+#define LID5							5
+#define LID4							4
+#define LID3							3
+#define LID2							2
+#define LID1							1
+#define LID0							0
+
+//LINSEL
+#define LAINC							3
+#define LINDX2							2
+#define LINDX1							1
+#define LINDX0							0
+
+
+//Interrupt vectors, each one the name of the ISR function
+#define PCINT0_vect						__vector_PCINT0
+#define PCINT1_vect						__vector_PCINT1
+#define PCINT2_vect						__vector_PCINT2
+#define PCINT3_vect						__vector_PCINT3
+#define TIMER1_CAPT_vect				__vector_TIMER1_CAPT
+#define TIMER1_COMPA_vect				__vector_TIMER1_COMPA
+#define TIMER1_COMPB_vect				__vector_TIMER1_COMPB
+#define TIMER1_OVF_vect					__vector_TIMER1_OVF
+#define TIMER0_COMPA_vect				__vector_TIMER0_COMPA
+#define TIMER0_COMPB_vect				__vector_TIMER0_COMPB
+#define TIMER0_OVF_vect					__vector_TIMER0_OVF
+#define CAN_INT_vect					__vector_CAN_INT
+#define CAN_TOVF_vect					__vector_CAN_TOVF
+#define LIN_TC_vect						__vector_LIN_TC
+#define LIN_ERR_vect					__vector_LIN_ERR
+#define SPI_STC_vect					__vector_SPI_STC
+#define ADC_vect						__vector_ADC
+#define USART0_RX_vect					__vector_USART0_RX
+#define USART0_UDRE_vect				__vector_USART0_UDRE
+#define USART0_TX_vect					__vector_USART0_TX
+#define USART1_RX_vect					__vector_USART1_RX
+#define USART1_UDRE_vect				__vector_USART1_UDRE
+#define USART1_TX_vect					__vector_USART1_TX
+#define TWI_vect						__vector_TWI
+
+#endif
@@ -0,0 +1,34 @@
+/**
+ * \file pgmspace.h
+ * \author Tim Robbins
+ * \brief Host stand in for avr/pgmspace.h. There is only one address space on the host, so program memory reads are plain reads.
+ */
+#ifndef HOST_AVR_PGMSPACE_H_
+#define HOST_AVR_PGMSPACE_H_ 1
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P							const char*
+#define PGM_VOID_P						const void*
+#define PSTR(s)							(s)
+
+#define pgm_read_byte(address)			(*(const uint8_t*)(address))
+#define pgm_read_word(address)			(*(const uint16_t*)(address))
+#define pgm_read_dword(address)			(*(const uint32_t*)(address))
+#define pgm_read_float(address)			(*(const float*)(address))
+#define pgm_read_ptr(address)			(*(void* const*)(address))
+#define pgm_read_byte_near(address)		pgm_read_byte(address)
+#define pgm_read_word_near(address)		pgm_read_word(address)
+#define pgm_read_byte_far(address)		pgm_read_byte(address)
+
+#define memcpy_P						memcpy
+#define memcmp_P						memcmp
+#define strcpy_P						strcpy
+#define strncpy_P						strncpy
+#define strcmp_P						strcmp
+#define strncmp_P						strncmp
+#define strlen_P						strlen
+
+#endif
@@ -0,0 +1,97 @@
+/**
+ * \file crcBench.cpp
+ * \author Tim Robbins
+ * \brief Benchmarks of the CRCs in mcuCrc, built once for each CRC_METHOD to compare the bitwise, nibble and table ways of working them out. \n
+ * Each build first checks every CRC against its check value, the CRC of "123456789", so a method that's fast but wrong fails. \n
+ * The budgets are the cycles per call over a 1024 byte image with the library's basic blocks counted, and the host throughput is printed beside them. \n
+ * The nibble and table methods both run a block a byte and so cost the same there, the host throughput is what tells them apart. \n
+ */
+#include <stdio.h>
+#include <string.h>
+#include "hostSim.h"
+#include "mcuCrc.h"
+
+
+#if CRC_METHOD == CRC_METHOD_BITWISE
+#define CRC_BENCH_METHOD			"bitwise"
+#define CRC8_J1850_BUDGET			107000
+#define CRC16_MODBUS_BUDGET			107000
+#define CRC16_CCITT_BUDGET			107000
+#define CRC32_BUDGET				107000
+#elif CRC_METHOD == CRC_METHOD_NIBBLE
+#define CRC_BENCH_METHOD			"nibble"
+#define CRC8_J1850_BUDGET			4200
+#define CRC16_MODBUS_BUDGET			4200
+#define CRC16_CCITT_BUDGET			4200
+#define CRC32_BUDGET				4200
+#else
+#define CRC_BENCH_METHOD			"table"
+#define CRC8_J1850_BUDGET			4200
+#define CRC16_MODBUS_BUDGET			4200
+#define CRC16_CCITT_BUDGET			4200
+#define CRC32_BUDGET				4200
+#endif
+
+
+static uint8_t m_uchrImage[1024];
+static volatile uint32_t m_ulResult;
+
+
+static void BenchCrc8J1850(void* arg)
+{
+	(void)arg;
+	m_ulResult = Crc8J1850(m_uchrImage, sizeof(m_uchrImage));
+}
+
+static void BenchCrc16Modbus(void* arg)
+{
+	(void)arg;
+	m_ulResult = Crc16Modbus(m_uchrImage, sizeof(m_uchrImage));
+}
+
+static void BenchCrc16Ccitt(void* arg)
+{
+	(void)arg;
+	m_ulResult = Crc16Ccitt(m_uchrImage, sizeof(m_uchrImage));
+}
+
+static void BenchCrc32(void* arg)
+{
+	(void)arg;
+	m_ulResult = Crc32(m_uchrImage, sizeof(m_uchrImage));
+}
+
+
+int main()
+{
+	//Variables
+	bool passed = true;
+	const uint8_t* check = (const uint8_t*)"123456789";
+	const HostBench_t benches[] =
+	{
+		{ "Crc8J1850", BenchCrc8J1850, 0, 20, CRC8_J1850_BUDGET, sizeof(m_uchrImage) },
+		{ "Crc16Modbus", BenchCrc16Modbus, 0, 20, CRC16_MODBUS_BUDGET, sizeof(m_uchrImage) },
+		{ "Crc16Ccitt", BenchCrc16Ccitt, 0, 20, CRC16_CCITT_BUDGET, sizeof(m_uchrImage) },
+		{ "Crc32", BenchCrc32, 0, 20, CRC32_BUDGET, sizeof(m_uchrImage) }
+	};
+
+	printf("CRCs worked out %s\n", CRC_BENCH_METHOD);
+
+	if(Crc8J1850(check, 9) != 0x4B || Crc16Modbus(check, 9) != 0x4B37 ||
+		Crc16Ccitt(check, 9) != 0x29B1 || Crc32(check, 9) != 0xCBF43926UL)
+	{
+		printf("a CRC doesn't match its check value\n");
+		return 1;
+	}
+
+	for(uint16_t i = 0; i < sizeof(m_uchrImage); i++) m_uchrImage[i] = (uint8_t)(i * 131 + 7);
+
+	HostSimReset();
+
+	for(uint8_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++)
+	{
+		passed &= HostBenchRun(&benches[i], 0);
+	}
+
+	return passed ? 0 : 1;
+}
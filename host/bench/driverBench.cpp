@@ -0,0 +1,108 @@
+/**
+ * \file driverBench.cpp
+ * \author Tim Robbins
+ * \brief Benchmarks of the drivers' hot paths: SSD1306Update, LcdPrintString, CANRaw::read, kp_Scan and AdcSample. \n
+ * The budgets are the cycles per call measured with the library built to count its basic blocks, as make -C host bench builds it. \n
+ * A change that takes a path more than HOST_BENCH_TOLERANCE percent over its budget fails the run. \n
+ * Where a change makes a path cheaper on purpose, its budget here is lowered with it. \n
+ */
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "hostSim.h"
+#include "spi.h"
+#include "ssd1306.h"
+#include "clcd.h"
+#include "avr_can.h"
+#include "ckeypadMatrix.h"
+#include "mcuAdc.h"
+
+
+//Keypad wiring, columns on PC4-6 and rows on PB4-7
+static unsigned char m_uchrKpColumnPins[KP_COLUMNS] = { 4, 5, 6 };
+static unsigned char m_uchrKpRowPins[KP_ROWS] = { 4, 5, 6, 7 };
+static unsigned char m_uchrKpValues[KP_ROWS][KP_COLUMNS] =
+{
+	{ '1', '2', '3' },
+	{ '4', '5', '6' },
+	{ '7', '8', '9' },
+	{ '*', '0', '#' }
+};
+
+static char m_strLcdLine[] = "Bench 0123456789";
+
+
+static void BenchSsd1306Update(void* arg)
+{
+	(void)arg;
+	SSD1306Update();
+}
+
+static void BenchLcdPrintString(void* arg)
+{
+	(void)arg;
+	LcdPrintString(m_strLcdLine);
+}
+
+static void BenchCanRead(void* arg)
+{
+	//Variables
+	CAN_FRAME frame;
+
+	(void)arg;
+	Can0.read(frame);
+}
+
+static void BenchKpScan(void* arg)
+{
+	(void)arg;
+	kp_Scan(m_uchrKpColumnPins, m_uchrKpRowPins, m_uchrKpValues);
+}
+
+static void BenchAdcSample(void* arg)
+{
+	(void)arg;
+	AdcSample((adc_channel_t)3, 4);
+}
+
+
+int main()
+{
+	//Variables
+	bool passed = true;
+	HostCanFrame_t frame = { 0x123, 0, 0, 8, { 1, 2, 3, 4, 5, 6, 7, 8 } };
+	const HostBench_t benches[] =
+	{
+		{ "SSD1306Update", BenchSsd1306Update, 0, 4, 46000, 0 },
+		{ "LcdPrintString", BenchLcdPrintString, 0, 10, 390000, 0 },
+		{ "CANRaw::read", BenchCanRead, 0, SIZE_RX_BUFFER - 1, 24, 0 },
+		{ "kp_Scan", BenchKpScan, 0, 100, 220, 0 },
+		{ "AdcSample", BenchAdcSample, 0, 100, 190, 0 }
+	};
+
+	HostSimReset();
+	sei();
+
+	SpiInitParent(0, true, false);
+	SSD1306Initialize(true, 0);
+
+	Can0.begin(CAN_BPS_500K);
+	Can0.watchFor();
+	for(uint8_t i = 0; i < SIZE_RX_BUFFER - 1; i++)
+	{
+		HostCanInject(&frame);
+		HostSimRunMilliseconds(1);
+	}
+
+	//No key down, the rows are pulled up
+	for(uint8_t i = 0; i < KP_ROWS; i++) HostGpioSetPin(&KP_ROW_READ, m_uchrKpRowPins[i], true);
+
+	HostAdcSetInput(3, 512);
+	ADC_enable();
+
+	for(uint8_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++)
+	{
+		passed &= HostBenchRun(&benches[i], 0);
+	}
+
+	return passed ? 0 : 1;
+}
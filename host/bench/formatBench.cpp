@@ -0,0 +1,226 @@
+/**
+ * \file formatBench.cpp
+ * \author Tim Robbins
+ * \brief Benchmarks of mcuFormat against the division based conversions it replaced in ShortToCharArray and the LCD byte printers. \n
+ * The old conversions are kept here as they were, with their divisions done by the shift and subtract loop libgcc runs on the part, \n
+ * since the AVR has no divide instruction. The host divides in a single instruction, which would hide what the old code cost. \n
+ * Every value is first converted both ways and compared, so the new conversion is also checked against the old one. \n
+ * Only the new conversions have budgets, the old ones are there to compare against. \n
+ */
+#include <stdio.h>
+#include <string.h>
+#include "hostSim.h"
+#include "mcuUtils.h"
+#include "mcuFormat.h"
+
+
+///The value converted by the next call
+static uint16_t m_uintBenchValue = 0;
+
+static char m_strBenchBuffer[FORMAT_BUFFER_SIZE];
+
+
+/**
+ * \brief Divides like libgcc's __udivmodhi4 on the AVR, a bit of the quotient per pass
+ * \param dividend The value to divide
+ * \param divisor The value to divide by
+ * \param remainder Where to put the remainder
+ * \return The quotient
+ */
+static uint16_t AvrDivide(uint16_t dividend, uint16_t divisor, uint16_t* remainder)
+{
+	//Variables
+	uint16_t rem = 0;
+
+	for(uint8_t i = 0; i < 16; i++)
+	{
+		rem = (uint16_t)((rem << 1) | (dividend >> 15));
+		dividend = (uint16_t)(dividend << 1);
+
+		if(rem >= divisor)
+		{
+			rem -= divisor;
+			dividend |= 1;
+		}
+	}
+
+	*remainder = rem;
+	return dividend;
+}
+
+static uint16_t AvrDiv(uint16_t dividend, uint16_t divisor)
+{
+	uint16_t rem;
+	return AvrDivide(dividend, divisor, &rem);
+}
+
+static uint16_t AvrMod(uint16_t dividend, uint16_t divisor)
+{
+	uint16_t rem;
+	AvrDivide(dividend, divisor, &rem);
+	return rem;
+}
+
+
+/**
+ * \brief ShortToCharArray as it was before mcuFormat
+ */
+static void OldShortToCharArray(char valueAsCharArray[6], uint16_t numVal, uint8_t ignoreInitialEmpties)
+{
+	//Variables
+	uint8_t firstValue =  (uint8_t)AvrDiv(numVal, 10000);
+	uint8_t secondValue = (uint8_t)AvrMod(AvrDiv(numVal, 1000), 10);
+	uint8_t thirdValue =  (uint8_t)AvrDiv(AvrMod(numVal, 1000), 100);
+	uint8_t fourthValue = (uint8_t)AvrDiv(AvrMod(numVal, 100), 10);
+	uint8_t fifthValue =  (uint8_t)AvrMod(numVal, 10);
+
+	for(uint8_t i = 0; i < 6; i++)
+	{
+		valueAsCharArray[i] = ' ';
+	}
+
+	valueAsCharArray[4] = (char)(fifthValue + 0x30);
+
+	if(ignoreInitialEmpties == 0 || firstValue > 0)
+	{
+		valueAsCharArray[0] = (char)(firstValue + 0x30);
+		valueAsCharArray[1] = (char)(secondValue + 0x30);
+		valueAsCharArray[2] = (char)(thirdValue + 0x30);
+		valueAsCharArray[3] = (char)(fourthValue + 0x30);
+	}
+	else if(secondValue > 0)
+	{
+		valueAsCharArray[1] = (char)(secondValue + 0x30);
+		valueAsCharArray[2] = (char)(thirdValue + 0x30);
+		valueAsCharArray[3] = (char)(fourthValue + 0x30);
+	}
+	else if(thirdValue > 0)
+	{
+		valueAsCharArray[2] = (char)(thirdValue + 0x30);
+		valueAsCharArray[3] = (char)(fourthValue + 0x30);
+	}
+	else if(fourthValue > 0)
+	{
+		valueAsCharArray[3] = (char)(fourthValue + 0x30);
+	}
+}
+
+
+/**
+ * \brief The conversion LcdPrintNumericalByte did before mcuFormat, into a buffer instead of onto the display
+ */
+static void OldByteToChars(char strToPrint[4], uint8_t numVal)
+{
+	//Variables
+	uint8_t firstValue = (uint8_t)AvrDiv(numVal, 100);
+	uint8_t secondValue = (uint8_t)AvrMod(AvrDiv(numVal, 10), 10);
+	uint8_t thirdValue = (uint8_t)AvrMod(numVal, 10);
+
+	strToPrint[0] = ' ';
+	strToPrint[1] = ' ';
+
+	if(firstValue > 0)
+	{
+		strToPrint[0] = (char)(firstValue + 0x30);
+		strToPrint[1] = (char)(secondValue + 0x30);
+	}
+	else if(secondValue > 0)
+	{
+		strToPrint[1] = (char)(secondValue + 0x30);
+	}
+
+	strToPrint[2] = (char)(thirdValue + 0x30);
+	strToPrint[3] = '\0';
+}
+
+
+//Each call converts the next of a spread of values
+static uint16_t NextValue(void)
+{
+	m_uintBenchValue = (uint16_t)(m_uintBenchValue + 7919);
+	return m_uintBenchValue;
+}
+
+static void BenchOldShort(void* arg)
+{
+	(void)arg;
+	OldShortToCharArray(m_strBenchBuffer, NextValue(), 1);
+}
+
+static void BenchNewShort(void* arg)
+{
+	(void)arg;
+	ShortToCharArray(m_strBenchBuffer, NextValue(), 1);
+}
+
+static void BenchOldByte(void* arg)
+{
+	(void)arg;
+	OldByteToChars(m_strBenchBuffer, (uint8_t)NextValue());
+}
+
+static void BenchNewByte(void* arg)
+{
+	(void)arg;
+	FormatUnsigned(m_strBenchBuffer, (uint8_t)NextValue(), 3, 0);
+}
+
+static void BenchFormatString(void* arg)
+{
+	(void)arg;
+	FormatString(m_strBenchBuffer, sizeof(m_strBenchBuffer), "%5u", NextValue());
+}
+
+
+int main()
+{
+	//Variables
+	bool passed = true;
+	char oldText[6];
+	char newText[6];
+	const HostBench_t benches[] =
+	{
+		{ "ShortToCharArray old", BenchOldShort, 0, 1000, 0, 0 },
+		{ "ShortToCharArray", BenchNewShort, 0, 1000, 220, 0 },
+		{ "Byte to chars old", BenchOldByte, 0, 1000, 0, 0 },
+		{ "FormatUnsigned byte", BenchNewByte, 0, 1000, 150, 0 },
+		{ "FormatString %5u", BenchFormatString, 0, 1000, 430, 0 }
+	};
+
+	//The new conversions give what the old ones did for every value
+	for(uint32_t value = 0; value <= 0xFFFF; value++)
+	{
+		for(uint8_t blanks = 0; blanks < 2; blanks++)
+		{
+			OldShortToCharArray(oldText, (uint16_t)value, blanks);
+			ShortToCharArray(newText, (uint16_t)value, blanks);
+
+			if(memcmp(oldText, newText, sizeof(oldText)) != 0)
+			{
+				printf("ShortToCharArray differs for %lu\n", (unsigned long)value);
+				return 1;
+			}
+		}
+
+		if(value <= 0xFF)
+		{
+			OldByteToChars(oldText, (uint8_t)value);
+			FormatUnsigned(newText, (uint8_t)value, 3, 0);
+
+			if(strcmp(oldText, newText) != 0)
+			{
+				printf("The byte conversion differs for %lu\n", (unsigned long)value);
+				return 1;
+			}
+		}
+	}
+
+	HostSimReset();
+
+	for(uint8_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++)
+	{
+		passed &= HostBenchRun(&benches[i], 0);
+	}
+
+	return passed ? 0 : 1;
+}
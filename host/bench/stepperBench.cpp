@@ -0,0 +1,123 @@
+/**
+ * \file stepperBench.cpp
+ * \author Tim Robbins
+ * \brief Benchmarks of a step with the precomputed stepper objects against the older step functions, which build the sequence on every call. \n
+ * First checks that changing a stepper's mode keeps the rotor where it was, for every mode and step: \n
+ * going to half stepping lands on the step with the same phases on, as every step is in the half step cycle. \n
+ * Going to wave or full stepping lands on the same phases, or on the step sharing a phase with the one it left where there's no such step. \n
+ * Only StepperStep has budgets, the older functions are there to compare against. \n
+ */
+#include <stdio.h>
+#include <avr/io.h>
+#include "hostSim.h"
+#include "steppers.h"
+
+
+static const uint8_t m_uchrPins[4] = { 0, 1, 2, 3 };
+static uint8_t m_uchrOldPins[4] = { 0, 1, 2, 3 };
+static uint8_t m_uchrOldIndex = 0;
+static Stepper_t m_stepper;
+
+
+static void BenchStepperStep(void* arg)
+{
+	(void)arg;
+	StepperStep(&m_stepper, false);
+}
+
+static void BenchWaveStep(void* arg)
+{
+	(void)arg;
+	StepperWaveStep(&PORTB, m_uchrOldPins, &m_uchrOldIndex, false);
+}
+
+static void BenchFullStep(void* arg)
+{
+	(void)arg;
+	StepperFullStep(&PORTB, m_uchrOldPins, &m_uchrOldIndex, false);
+}
+
+static void BenchHalfStep(void* arg)
+{
+	(void)arg;
+	StepperHalfStep(&PORTB, m_uchrOldPins, &m_uchrOldIndex, false);
+}
+
+
+/**
+ * \brief Checks every step of every mode keeps its phases across a change to every other mode
+ * \return False if a change moved the rotor
+ */
+static bool CheckModeChanges(void)
+{
+	//Variables
+	Stepper_t stepper;
+	uint8_t before = 0;		//Phases on before the change
+	uint8_t after = 0;		//Phases on after it
+
+	for(uint8_t from = STEPPER_MODE_WAVE; from <= STEPPER_MODE_HALF; from++)
+	{
+		for(uint8_t to = STEPPER_MODE_WAVE; to <= STEPPER_MODE_HALF; to++)
+		{
+			StepperInit(&stepper, &PORTB, m_uchrPins, from);
+
+			for(uint8_t step = 0; step < stepper.sequenceLength; step++)
+			{
+				stepper.sequenceIndex = step;
+				before = stepper.sequence[step];
+
+				StepperSetMode(&stepper, m_uchrPins, to);
+				after = stepper.sequence[stepper.sequenceIndex];
+
+				if((to == STEPPER_MODE_HALF && before != after) || (before != after && (before & after) == 0))
+				{
+					printf("changing mode %u step %u to mode %u lands on %02X from %02X\n", from, step, to, after, before);
+					return false;
+				}
+
+				StepperSetMode(&stepper, m_uchrPins, from);
+			}
+		}
+	}
+
+	return true;
+}
+
+
+int main()
+{
+	//Variables
+	bool passed = true;
+	const HostBench_t oldBenches[] =
+	{
+		{ "StepperWaveStep", BenchWaveStep, 0, 100, 0, 0 },
+		{ "StepperFullStep", BenchFullStep, 0, 100, 0, 0 },
+		{ "StepperHalfStep", BenchHalfStep, 0, 100, 0, 0 }
+	};
+	const HostBench_t stepBenches[] =
+	{
+		{ "StepperStep wave", BenchStepperStep, 0, 100, 4, 0 },
+		{ "StepperStep full", BenchStepperStep, 0, 100, 4, 0 },
+		{ "StepperStep half", BenchStepperStep, 0, 100, 4, 0 }
+	};
+
+	if(!CheckModeChanges())
+	{
+		return 1;
+	}
+
+	HostSimReset();
+
+	for(uint8_t i = 0; i < sizeof(oldBenches) / sizeof(oldBenches[0]); i++)
+	{
+		passed &= HostBenchRun(&oldBenches[i], 0);
+	}
+
+	for(uint8_t mode = STEPPER_MODE_WAVE; mode <= STEPPER_MODE_HALF; mode++)
+	{
+		StepperInit(&m_stepper, &PORTB, m_uchrPins, mode);
+		passed &= HostBenchRun(&stepBenches[mode], 0);
+	}
+
+	return passed ? 0 : 1;
+}
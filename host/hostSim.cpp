@@ -0,0 +1,2493 @@
+/**
+ * \file hostSim.cpp
+ * \author Tim Robbins
+ * \brief Source file for the simulated peripherals of the host build. See hostSim.h \n
+ * The models are kept simple: each operation is started by a register access, finishes after the time it would take on the part, \n
+ * and sets the same flags the hardware would. Timer phase correct modes count up only.
+ */
+#ifndef HOST_SIM_CPP_
+#define HOST_SIM_CPP_ 1
+
+#include "hostSim.h"
+#include "config.h"
+#include <avr/io.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+
+
+//Queue of bytes for the serial models
+typedef struct _SIM_BYTE_QUEUE_
+{
+	uint8_t data[HOST_SIM_QUEUE_SIZE];	//The bytes
+	uint16_t head;						//Index of the oldest byte
+	uint16_t count;						//Number of bytes in the queue
+} SimByteQueue_t;
+
+
+//Queue of frames for the CAN model
+typedef struct _SIM_FRAME_QUEUE_
+{
+	HostCanFrame_t data[HOST_SIM_QUEUE_SIZE / 8];	//The frames
+	uint16_t head;									//Index of the oldest frame
+	uint16_t count;									//Number of frames in the queue
+} SimFrameQueue_t;
+
+
+//An interrupt source, in vector order
+typedef struct _SIM_IRQ_
+{
+	HostReg8* flagReg;			//Register with the flag
+	uint8_t flagMask;			//The flag
+	HostReg8* enableReg;		//Register with the enable, also cleared if there's no ISR for the vector
+	uint8_t enableMask;			//The enable
+	bool clearOnEntry;			//If the flag is cleared when the vector is run
+	bool (*pending)(void);		//Used instead of the flag and enable when it's set
+	void (*vector)(void);		//The ISR
+} SimIrq_t;
+
+
+//Timer state
+typedef struct _SIM_TIMER_
+{
+	uint16_t count;				//The counter
+	uint32_t prescaleCount;		//Cycles counted toward the next timer clock
+} SimTimer_t;
+
+
+//USART state
+typedef struct _SIM_UART_
+{
+	bool txBusy;				//If a byte is being shifted out
+	bool txPending;				//If a byte is waiting in the data register behind it
+	uint8_t txShift;			//The byte being shifted out
+	uint8_t txNext;				//The byte waiting
+	uint64_t txDoneAt;			//When the byte being shifted out is done
+	uint8_t rxFifo[2];			//The hardware receive buffer
+	uint8_t rxCount;			//Bytes in the hardware receive buffer
+	uint64_t rxNextAt;			//When the next injected byte arrives
+	SimByteQueue_t rxQueue;		//Injected bytes on their way in
+	SimByteQueue_t txLog;		//Bytes sent, for HostUartTake
+} SimUart_t;
+
+
+//CAN message object
+typedef struct _SIM_MOB_
+{
+	uint8_t status;				//CANSTMOB
+	uint8_t control;			//CANCDMOB
+	uint8_t idt[4];				//CANIDT1-4
+	uint8_t idm[4];				//CANIDM1-4
+	uint16_t stamp;				//CANSTM
+	uint8_t msg[8];				//CANMSG
+	bool enabled;				//If the MOb is enabled and hasn't finished
+} SimMob_t;
+
+
+//Actions of the LIN controller
+enum SIM_LIN_ACTIONS
+{
+	LIN_ACTION_NONE,
+	LIN_ACTION_TX_BYTE,
+	LIN_ACTION_TX_HEADER,
+	LIN_ACTION_RX_HEADER,
+	LIN_ACTION_TX_RESPONSE,
+	LIN_ACTION_RX_RESPONSE
+};
+
+
+//TWI master states
+enum SIM_TWI_STATES
+{
+	TWI_STATE_IDLE,
+	TWI_STATE_STARTED,
+	TWI_STATE_WRITING,
+	TWI_STATE_READING,
+	TWI_STATE_NACKED
+};
+
+
+
+//Core
+static uint64_t m_ulCycles = 0;						//Simulated time in core cycles
+static uint32_t m_ulUnhandled = 0;					//Interrupts that had no ISR
+static HostReg8* m_regList8 = 0;					//Every 8 bit register
+static HostReg16* m_regList16 = 0;					//Every 16 bit register
+static HostSimCost_t m_cost;						//Running totals for the cost model
+static const void* m_lastRead = 0;					//The register read last, for counting polls
+static uint16_t m_lastReadValue = 0;				//The value it gave
+static uint32_t m_ulPendingCycles = 0;				//Cycles of counted blocks not yet run through the models
+static bool m_bCountingBlocks = false;				//Set once code built to count its basic blocks has run
+
+//Models
+static SimTimer_t m_timer0;
+static SimTimer_t m_timer1;
+static SimUart_t m_uart[HOST_UART_QUANTITY];
+static HostUartTxHook_t m_uartHook = 0;
+
+static struct
+{
+	bool busy;
+	bool flagSeen;
+	uint64_t doneAt;
+	uint8_t dataOut;
+	HostSpiResponder_t responder;
+	uint32_t transfers;
+} m_spi;
+
+static struct
+{
+	uint8_t state;
+	bool busy;
+	uint64_t doneAt;
+	uint8_t status;
+	uint8_t data;
+	const HostTwiDevice_t* device;
+	HostTwiDevice_t devices[HOST_TWI_MAX_DEVICES];
+	uint8_t deviceCount;
+} m_twi;
+
+static struct
+{
+	bool busy;
+	bool started;
+	uint8_t channel;
+	uint64_t doneAt;
+	uint16_t inputs[32];
+	HostAdcSource_t source;
+	uint32_t conversions;
+} m_adc;
+
+static struct
+{
+	SimMob_t mobs[HOST_CAN_MOB_QUANTITY + 1];
+	uint16_t timer;
+	uint32_t prescaleCount;
+	uint16_t lastFrameTime;
+	bool busy;
+	int8_t txMob;
+	uint64_t doneAt;
+	HostCanFrame_t frame;
+	SimFrameQueue_t rxQueue;
+	SimFrameQueue_t txLog;
+	uint8_t failBits;
+	uint8_t failCount;
+	bool busOff;
+	uint64_t recoverAt;
+	uint32_t lost;
+	HostCanTxHook_t hook;
+} m_can;
+
+static struct
+{
+	uint8_t buffer[8];
+	uint8_t action;
+	bool busy;
+	bool waitingResponse;
+	uint64_t doneAt;
+	uint8_t txShift;
+	bool headerPending;
+	uint8_t headerId;
+	bool responsePending;
+	uint8_t response[8];
+	uint8_t responseLength;
+	uint64_t rxNextAt;
+	SimByteQueue_t rxQueue;
+	SimByteQueue_t txLog;
+	HostLinHeaderHook_t hook;
+} m_lin;
+
+
+
+static void SimAccess(void);
+static void SimStep(uint32_t cycles);
+static void SimDispatch(void);
+static const SimIrq_t* SimPendingIrq(void);
+static void SimAdcTrigger(uint8_t source);
+
+
+
+/*****************************************************************************************************
+ * Registers
+*****************************************************************************************************/
+
+HostReg8::HostReg8(const char* regName, ReadHook_t readHook, WriteHook_t writeHook, uint8_t regIndex, uint8_t reset, HostReg16* wideReg)
+	: value(reset), name(regName), onRead(readHook), onWrite(writeHook), index(regIndex), resetValue(reset), wide(wideReg), next(m_regList8)
+{
+	m_regList8 = this;
+}
+
+
+//Counts a register read for the cost model
+static void SimCountRead(const void* reg, uint16_t value)
+{
+	m_cost.reads++;
+	if(reg == m_lastRead && value == m_lastReadValue) m_cost.polls++;
+
+	m_lastRead = reg;
+	m_lastReadValue = value;
+}
+
+
+HostReg8::operator uint8_t() const
+{
+	HostReg8& self = const_cast<HostReg8&>(*this);
+	uint8_t result;
+
+	SimAccess();
+	result = (onRead != 0) ? onRead(self) : value;
+	SimCountRead(this, result);
+	return result;
+}
+
+
+HostReg8& HostReg8::operator=(int newValue)
+{
+	if(onWrite != 0) onWrite(*this, (uint8_t)newValue);
+	else value = (uint8_t)newValue;
+
+	m_cost.writes++;
+	m_lastRead = 0;
+	SimAccess();
+	return *this;
+}
+
+
+HostReg16::HostReg16(const char* regName, ReadHook_t readHook, WriteHook_t writeHook, uint8_t regIndex, uint16_t reset)
+	: value(reset), name(regName), onRead(readHook), onWrite(writeHook), index(regIndex), resetValue(reset), next(m_regList16)
+{
+	m_regList16 = this;
+}
+
+
+HostReg16::operator uint16_t() const
+{
+	HostReg16& self = const_cast<HostReg16&>(*this);
+	uint16_t result;
+
+	SimAccess();
+	result = (onRead != 0) ? onRead(self) : value;
+	SimCountRead(this, result);
+	return result;
+}
+
+
+HostReg16& HostReg16::operator=(int newValue)
+{
+	if(onWrite != 0) onWrite(*this, (uint16_t)newValue);
+	else value = (uint16_t)newValue;
+
+	m_cost.writes++;
+	m_lastRead = 0;
+	SimAccess();
+	return *this;
+}
+
+
+//Reads a 16 bit register without it counting as an access
+static uint16_t SimPeek16(HostReg16& reg)
+{
+	return (reg.onRead != 0) ? reg.onRead(reg) : reg.value;
+}
+
+
+//Writes a 16 bit register without it counting as an access
+static void SimPoke16(HostReg16& reg, uint16_t value)
+{
+	if(reg.onWrite != 0) reg.onWrite(reg, value);
+	else reg.value = value;
+}
+
+
+//Reads the low (index 0) or high (index 1) byte of a 16 bit register
+static uint8_t SimByteRead(HostReg8& reg)
+{
+	uint16_t value = SimPeek16(*reg.wide);
+	return (reg.index != 0) ? (uint8_t)(value >> 8) : (uint8_t)value;
+}
+
+
+//Writes the low (index 0) or high (index 1) byte of a 16 bit register
+static void SimByteWrite(HostReg8& reg, uint8_t value)
+{
+	uint16_t wide = SimPeek16(*reg.wide);
+
+	if(reg.index != 0) wide = (wide & 0x00FF) | ((uint16_t)value << 8);
+	else wide = (wide & 0xFF00) | value;
+
+	SimPoke16(*reg.wide, wide);
+}
+
+
+//Write one to clear flag registers
+static void SimFlagWrite(HostReg8& reg, uint8_t value)
+{
+	reg.value &= ~value;
+}
+
+
+//Read only registers
+static void SimReadOnlyWrite(HostReg8& reg, uint8_t value)
+{
+	(void)reg;
+	(void)value;
+}
+
+
+static uint16_t SimPairRead(HostReg16& reg);
+static void SimPairWrite(HostReg16& reg, uint16_t value);
+static uint8_t SimTimerCountRead(HostReg8& reg);
+static void SimTimerCountWrite(HostReg8& reg, uint8_t value);
+static uint16_t SimTimer1CountRead(HostReg16& reg);
+static void SimTimer1CountWrite(HostReg16& reg, uint16_t value);
+static void SimTimerControlWrite(HostReg8& reg, uint8_t value);
+static void SimAdcControlWrite(HostReg8& reg, uint8_t value);
+static uint8_t SimSpiStatusRead(HostReg8& reg);
+static void SimSpiStatusWrite(HostReg8& reg, uint8_t value);
+static uint8_t SimSpiDataRead(HostReg8& reg);
+static void SimSpiDataWrite(HostReg8& reg, uint8_t value);
+static void SimUartStatusWrite(HostReg8& reg, uint8_t value);
+static uint8_t SimUartDataRead(HostReg8& reg);
+static void SimUartDataWrite(HostReg8& reg, uint8_t value);
+static void SimTwiControlWrite(HostReg8& reg, uint8_t value);
+static void SimTwiStatusWrite(HostReg8& reg, uint8_t value);
+static void SimCanControlWrite(HostReg8& reg, uint8_t value);
+static uint32_t SimCanBitCycles(void);
+static uint8_t SimCanStatusRead(HostReg8& reg);
+static uint8_t SimCanInterruptRead(HostReg8& reg);
+static void SimCanInterruptWrite(HostReg8& reg, uint8_t value);
+static uint8_t SimCanEnableRead(HostReg8& reg);
+static uint8_t SimCanMobStatusRead(HostReg8& reg);
+static uint8_t SimCanHighestRead(HostReg8& reg);
+static uint8_t SimCanPageRead(HostReg8& reg);
+static void SimCanPageWrite(HostReg8& reg, uint8_t value);
+static uint16_t SimCanTimeRead(HostReg16& reg);
+static void SimLinControlWrite(HostReg8& reg, uint8_t value);
+static uint8_t SimLinStatusRead(HostReg8& reg);
+static void SimLinStatusWrite(HostReg8& reg, uint8_t value);
+static void SimLinIdWrite(HostReg8& reg, uint8_t value);
+static uint8_t SimLinDataRead(HostReg8& reg);
+static void SimLinDataWrite(HostReg8& reg, uint8_t value);
+
+
+//GPIO
+volatile uint8_t PINB = 0;
+volatile uint8_t DDRB = 0;
+volatile uint8_t PORTB = 0;
+volatile uint8_t PINC = 0;
+volatile uint8_t DDRC = 0;
+volatile uint8_t PORTC = 0;
+volatile uint8_t PIND = 0;
+volatile uint8_t DDRD = 0;
+volatile uint8_t PORTD = 0;
+volatile uint8_t PINE = 0;
+volatile uint8_t DDRE = 0;
+volatile uint8_t PORTE = 0;
+
+//Core
+HostReg8 SREG("SREG");
+HostReg8 SMCR("SMCR");
+HostReg8 MCUCR("MCUCR");
+HostReg8 MCUSR("MCUSR");
+HostReg8 PRR("PRR");
+
+//Pin change interrupts
+HostReg8 PCICR("PCICR");
+HostReg8 PCIFR("PCIFR", 0, SimFlagWrite);
+HostReg8 PCMSK0("PCMSK0");
+HostReg8 PCMSK1("PCMSK1");
+HostReg8 PCMSK2("PCMSK2");
+HostReg8 PCMSK3("PCMSK3");
+
+//Timer0
+HostReg8 TCCR0A("TCCR0A");
+HostReg8 TCCR0B("TCCR0B", 0, SimTimerControlWrite);
+HostReg8 TCNT0("TCNT0", SimTimerCountRead, SimTimerCountWrite);
+HostReg8 OCR0A("OCR0A");
+HostReg8 OCR0B("OCR0B");
+HostReg8 TIMSK0("TIMSK0");
+HostReg8 TIFR0("TIFR0", 0, SimFlagWrite);
+
+//Timer1
+HostReg16 TCNT1("TCNT1", SimTimer1CountRead, SimTimer1CountWrite);
+HostReg16 OCR1A("OCR1A");
+HostReg16 OCR1B("OCR1B");
+HostReg16 ICR1("ICR1");
+HostReg8 TCCR1A("TCCR1A");
+HostReg8 TCCR1B("TCCR1B");
+HostReg8 TCCR1C("TCCR1C", 0, SimTimerControlWrite);
+HostReg8 TCNT1L("TCNT1L", SimByteRead, SimByteWrite, 0, 0, &TCNT1);
+HostReg8 TCNT1H("TCNT1H", SimByteRead, SimByteWrite, 1, 0, &TCNT1);
+HostReg8 OCR1AL("OCR1AL", SimByteRead, SimByteWrite, 0, 0, &OCR1A);
+HostReg8 OCR1AH("OCR1AH", SimByteRead, SimByteWrite, 1, 0, &OCR1A);
+HostReg8 OCR1BL("OCR1BL", SimByteRead, SimByteWrite, 0, 0, &OCR1B);
+HostReg8 OCR1BH("OCR1BH", SimByteRead, SimByteWrite, 1, 0, &OCR1B);
+HostReg8 ICR1L("ICR1L", SimByteRead, SimByteWrite, 0, 0, &ICR1);
+HostReg8 ICR1H("ICR1H", SimByteRead, SimByteWrite, 1, 0, &ICR1);
+HostReg8 TIMSK1("TIMSK1");
+HostReg8 TIFR1("TIFR1", 0, SimFlagWrite);
+
+//ADC
+HostReg8 ADMUX("ADMUX");
+HostReg8 ADCSRA("ADCSRA", 0, SimAdcControlWrite);
+HostReg8 ADCSRB("ADCSRB");
+HostReg8 ADCL("ADCL", 0, SimReadOnlyWrite);
+HostReg8 ADCH("ADCH", 0, SimReadOnlyWrite);
+HostReg8 DIDR0("DIDR0");
+HostReg8 DIDR1("DIDR1");
+HostReg16 ADC("ADC", SimPairRead, SimPairWrite, 0);
+HostReg16 ADCW("ADCW", SimPairRead, SimPairWrite, 0);
+
+//SPI
+HostReg8 SPCR("SPCR");
+HostReg8 SPSR("SPSR", SimSpiStatusRead, SimSpiStatusWrite);
+HostReg8 SPDR("SPDR", SimSpiDataRead, SimSpiDataWrite);
+
+//USART0
+HostReg8 UCSR0A("UCSR0A", 0, SimUartStatusWrite, 0, (1 << UDRE0));
+HostReg8 UCSR0B("UCSR0B");
+HostReg8 UCSR0C("UCSR0C", 0, 0, 0, 0x06);
+HostReg8 UBRR0L("UBRR0L");
+HostReg8 UBRR0H("UBRR0H");
+HostReg8 UDR0("UDR0", SimUartDataRead, SimUartDataWrite, 0);
+HostReg16 UBRR0("UBRR0", SimPairRead, SimPairWrite, 1);
+
+//USART1
+HostReg8 UCSR1A("UCSR1A", 0, SimUartStatusWrite, 1, (1 << UDRE1));
+HostReg8 UCSR1B("UCSR1B");
+HostReg8 UCSR1C("UCSR1C", 0, 0, 0, 0x06);
+HostReg8 UBRR1L("UBRR1L");
+HostReg8 UBRR1H("UBRR1H");
+HostReg8 UDR1("UDR1", SimUartDataRead, SimUartDataWrite, 1);
+HostReg16 UBRR1("UBRR1", SimPairRead, SimPairWrite, 2);
+
+//TWI
+HostReg8 TWBR("TWBR");
+HostReg8 TWSR("TWSR", 0, SimTwiStatusWrite, 0, 0xF8);
+HostReg8 TWAR("TWAR", 0, 0, 0, 0xFE);
+HostReg8 TWDR("TWDR", 0, 0, 0, 0xFF);
+HostReg8 TWCR("TWCR", 0, SimTwiControlWrite);
+HostReg8 TWAMR("TWAMR");
+
+//CAN
+HostReg8 CANGCON("CANGCON", 0, SimCanControlWrite);
+HostReg8 CANGSTA("CANGSTA", SimCanStatusRead, SimReadOnlyWrite);
+HostReg8 CANGIT("CANGIT", SimCanInterruptRead, SimCanInterruptWrite);
+HostReg8 CANGIE("CANGIE");
+HostReg8 CANEN2("CANEN2", SimCanEnableRead, SimReadOnlyWrite);
+HostReg8 CANEN1("CANEN1", 0, SimReadOnlyWrite);
+HostReg8 CANIE2("CANIE2");
+HostReg8 CANIE1("CANIE1");
+HostReg8 CANSIT2("CANSIT2", SimCanMobStatusRead, SimReadOnlyWrite);
+HostReg8 CANSIT1("CANSIT1", 0, SimReadOnlyWrite);
+HostReg8 CANBT1("CANBT1");
+HostReg8 CANBT2("CANBT2");
+HostReg8 CANBT3("CANBT3");
+HostReg8 CANTCON("CANTCON");
+HostReg16 CANTIM("CANTIM", SimCanTimeRead, 0, 0);
+HostReg16 CANTTC("CANTTC", SimCanTimeRead, 0, 1);
+HostReg16 CANSTM("CANSTM", SimCanTimeRead, 0, 2);
+HostReg8 CANTIML("CANTIML", SimByteRead, SimReadOnlyWrite, 0, 0, &CANTIM);
+HostReg8 CANTIMH("CANTIMH", SimByteRead, SimReadOnlyWrite, 1, 0, &CANTIM);
+HostReg8 CANTTCL("CANTTCL", SimByteRead, SimReadOnlyWrite, 0, 0, &CANTTC);
+HostReg8 CANTTCH("CANTTCH", SimByteRead, SimReadOnlyWrite, 1, 0, &CANTTC);
+HostReg8 CANSTML("CANSTML", SimByteRead, SimReadOnlyWrite, 0, 0, &CANSTM);
+HostReg8 CANSTMH("CANSTMH", SimByteRead, SimReadOnlyWrite, 1, 0, &CANSTM);
+HostReg8 CANTEC("CANTEC", 0, SimReadOnlyWrite);
+HostReg8 CANREC("CANREC", 0, SimReadOnlyWrite);
+HostReg8 CANHPMOB("CANHPMOB", SimCanHighestRead, 0, 0, 0xF0);
+HostReg8 CANPAGE("CANPAGE");
+HostReg8 CANSTMOB("CANSTMOB", SimCanPageRead, SimCanPageWrite, 0);
+HostReg8 CANCDMOB("CANCDMOB", SimCanPageRead, SimCanPageWrite, 1);
+HostReg8 CANIDT1("CANIDT1", SimCanPageRead, SimCanPageWrite, 2);
+HostReg8 CANIDT2("CANIDT2", SimCanPageRead, SimCanPageWrite, 3);
+HostReg8 CANIDT3("CANIDT3", SimCanPageRead, SimCanPageWrite, 4);
+HostReg8 CANIDT4("CANIDT4", SimCanPageRead, SimCanPageWrite, 5);
+HostReg8 CANIDM1("CANIDM1", SimCanPageRead, SimCanPageWrite, 6);
+HostReg8 CANIDM2("CANIDM2", SimCanPageRead, SimCanPageWrite, 7);
+HostReg8 CANIDM3("CANIDM3", SimCanPageRead, SimCanPageWrite, 8);
+HostReg8 CANIDM4("CANIDM4", SimCanPageRead, SimCanPageWrite, 9);
+HostReg8 CANMSG("CANMSG", SimCanPageRead, SimCanPageWrite, 10);
+
+//LIN/UART
+HostReg16 LINBRR("LINBRR");
+HostReg8 LINCR("LINCR", 0, SimLinControlWrite);
+HostReg8 LINSIR("LINSIR", SimLinStatusRead, SimLinStatusWrite);
+HostReg8 LINENIR("LINENIR");
+HostReg8 LINERR("LINERR", 0, SimReadOnlyWrite);
+HostReg8 LINBTR("LINBTR", 0, 0, 0, 0x20);
+HostReg8 LINBRRL("LINBRRL", SimByteRead, SimByteWrite, 0, 0, &LINBRR);
+HostReg8 LINBRRH("LINBRRH", SimByteRead, SimByteWrite, 1, 0, &LINBRR);
+HostReg8 LINDLR("LINDLR");
+HostReg8 LINIDR("LINIDR", 0, SimLinIdWrite, 0, 0x80);
+HostReg8 LINSEL("LINSEL");
+HostReg8 LINDAT("LINDAT", SimLinDataRead, SimLinDataWrite);
+
+
+//The 8 bit register pairs behind ADC, UBRR0 and UBRR1
+static HostReg8* const m_pairs[3][2] =
+{
+	{ &ADCL, &ADCH },
+	{ &UBRR0L, &UBRR0H },
+	{ &UBRR1L, &UBRR1H }
+};
+
+
+static uint16_t SimPairRead(HostReg16& reg)
+{
+	return m_pairs[reg.index][0]->value | ((uint16_t)m_pairs[reg.index][1]->value << 8);
+}
+
+
+static void SimPairWrite(HostReg16& reg, uint16_t value)
+{
+	//The ADC result is read only
+	if(reg.index == 0) return;
+
+	m_pairs[reg.index][0]->value = (uint8_t)value;
+	m_pairs[reg.index][1]->value = (uint8_t)(value >> 8);
+}
+
+
+
+/*****************************************************************************************************
+ * Interrupts
+*****************************************************************************************************/
+
+static bool SimCanPending(void);
+static bool SimLinPending(void);
+
+//The ISRs, weak so the ones the program doesn't have are 0
+extern "C" {
+extern void __vector_PCINT0(void) __attribute__((weak));
+extern void __vector_PCINT1(void) __attribute__((weak));
+extern void __vector_PCINT2(void) __attribute__((weak));
+extern void __vector_PCINT3(void) __attribute__((weak));
+extern void __vector_TIMER1_CAPT(void) __attribute__((weak));
+extern void __vector_TIMER1_COMPA(void) __attribute__((weak));
+extern void __vector_TIMER1_COMPB(void) __attribute__((weak));
+extern void __vector_TIMER1_OVF(void) __attribute__((weak));
+extern void __vector_TIMER0_COMPA(void) __attribute__((weak));
+extern void __vector_TIMER0_COMPB(void) __attribute__((weak));
+extern void __vector_TIMER0_OVF(void) __attribute__((weak));
+extern void __vector_CAN_INT(void) __attribute__((weak));
+extern void __vector_CAN_TOVF(void) __attribute__((weak));
+extern void __vector_LIN_TC(void) __attribute__((weak));
+extern void __vector_LIN_ERR(void) __attribute__((weak));
+extern void __vector_SPI_STC(void) __attribute__((weak));
+extern void __vector_ADC(void) __attribute__((weak));
+extern void __vector_USART0_RX(void) __attribute__((weak));
+extern void __vector_USART0_UDRE(void) __attribute__((weak));
+extern void __vector_USART0_TX(void) __attribute__((weak));
+extern void __vector_USART1_RX(void) __attribute__((weak));
+extern void __vector_USART1_UDRE(void) __attribute__((weak));
+extern void __vector_USART1_TX(void) __attribute__((weak));
+extern void __vector_TWI(void) __attribute__((weak));
+}
+
+
+
+//Interrupt sources, highest priority first
+static const SimIrq_t m_irqs[] =
+{
+	{ &PCIFR, (1 << PCIF0), &PCICR, (1 << PCIE0), true, 0, __vector_PCINT0 },
+	{ &PCIFR, (1 << PCIF1), &PCICR, (1 << PCIE1), true, 0, __vector_PCINT1 },
+	{ &PCIFR, (1 << PCIF2), &PCICR, (1 << PCIE2), true, 0, __vector_PCINT2 },
+	{ &PCIFR, (1 << PCIF3), &PCICR, (1 << PCIE3), true, 0, __vector_PCINT3 },
+	{ &TIFR1, (1 << ICF1), &TIMSK1, (1 << ICIE1), true, 0, __vector_TIMER1_CAPT },
+	{ &TIFR1, (1 << OCF1A), &TIMSK1, (1 << OCIE1A), true, 0, __vector_TIMER1_COMPA },
+	{ &TIFR1, (1 << OCF1B), &TIMSK1, (1 << OCIE1B), true, 0, __vector_TIMER1_COMPB },
+	{ &TIFR1, (1 << TOV1), &TIMSK1, (1 << TOIE1), true, 0, __vector_TIMER1_OVF },
+	{ &TIFR0, (1 << OCF0A), &TIMSK0, (1 << OCIE0A), true, 0, __vector_TIMER0_COMPA },
+	{ &TIFR0, (1 << OCF0B), &TIMSK0, (1 << OCIE0B), true, 0, __vector_TIMER0_COMPB },
+	{ &TIFR0, (1 << TOV0), &TIMSK0, (1 << TOIE0), true, 0, __vector_TIMER0_OVF },
+	{ &CANGIT, 0, &CANGIE, (1 << ENIT), false, SimCanPending, __vector_CAN_INT },
+	{ &CANGIT, (1 << OVRTIM), &CANGIE, (1 << ENOVRT), true, 0, __vector_CAN_TOVF },
+	{ &LINSIR, 0, &LINENIR, 0x07, false, SimLinPending, __vector_LIN_TC },
+	{ &LINSIR, (1 << LERR), &LINENIR, (1 << LENERR), false, 0, __vector_LIN_ERR },
+	{ &SPSR, (1 << SPIF), &SPCR, (1 << SPIE), true, 0, __vector_SPI_STC },
+	{ &ADCSRA, (1 << ADIF), &ADCSRA, (1 << ADIE), true, 0, __vector_ADC },
+	{ &UCSR0A, (1 << RXC0), &UCSR0B, (1 << RXCIE0), false, 0, __vector_USART0_RX },
+	{ &UCSR0A, (1 << UDRE0), &UCSR0B, (1 << UDRIE0), false, 0, __vector_USART0_UDRE },
+	{ &UCSR0A, (1 << TXC0), &UCSR0B, (1 << TXCIE0), true, 0, __vector_USART0_TX },
+	{ &UCSR1A, (1 << RXC1), &UCSR1B, (1 << RXCIE1), false, 0, __vector_USART1_RX },
+	{ &UCSR1A, (1 << UDRE1), &UCSR1B, (1 << UDRIE1), false, 0, __vector_USART1_UDRE },
+	{ &UCSR1A, (1 << TXC1), &UCSR1B, (1 << TXCIE1), true, 0, __vector_USART1_TX },
+	{ &TWCR, (1 << TWINT), &TWCR, (1 << TWIE), false, 0, __vector_TWI }
+};
+
+
+/**
+ * \brief Finds the highest priority interrupt that's flagged and enabled
+ * \return The interrupt or 0 for none
+ */
+static const SimIrq_t* SimPendingIrq(void)
+{
+	for(uint8_t i = 0; i < sizeof(m_irqs) / sizeof(m_irqs[0]); i++)
+	{
+		const SimIrq_t* irq = &m_irqs[i];
+
+		if(irq->pending != 0)
+		{
+			if(irq->pending()) return irq;
+		}
+		else if((irq->flagReg->value & irq->flagMask) && (irq->enableReg->value & irq->enableMask))
+		{
+			return irq;
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+ * \brief Runs the ISRs of pending interrupts while global interrupts are on. \n
+ * Like the part, the I bit is cleared for the ISR and set again when it returns. \n
+ * A pending interrupt without an ISR would jump to the reset on the part. Here it's counted and its enable is cleared.
+ */
+static void SimDispatch(void)
+{
+	//Variables
+	uint8_t chrRuns = 0;		//Number of ISRs run, a limit for ISRs that never clear their flag
+
+	while((SREG.value & (1 << SREG_I)) && chrRuns < 64)
+	{
+		const SimIrq_t* irq = SimPendingIrq();
+		if(irq == 0) break;
+
+		chrRuns++;
+		if(irq->clearOnEntry) irq->flagReg->value &= ~irq->flagMask;
+
+		if(irq->vector == 0)
+		{
+			m_ulUnhandled++;
+			irq->enableReg->value &= ~irq->enableMask;
+			continue;
+		}
+
+		m_cost.interrupts++;
+		SREG.value &= ~(1 << SREG_I);
+		irq->vector();
+		SREG.value |= (1 << SREG_I);
+	}
+}
+
+
+/**
+ * \brief Runs the models for a register access
+ */
+static void SimAccess(void)
+{
+	//Variables
+	uint32_t ulCycles = m_bCountingBlocks ? HOST_SIM_IO_CYCLES : HOST_SIM_ACCESS_CYCLES;		//Cycles for the access
+	uint32_t ulPending = m_ulPendingCycles;														//Cycles of the blocks run since the last access
+
+	//The blocks are already in the time, the models catch up with them here
+	m_ulPendingCycles = 0;
+	while(ulPending != 0)
+	{
+		uint32_t slice = (ulPending < HOST_SIM_SLICE_CYCLES) ? ulPending : HOST_SIM_SLICE_CYCLES;
+
+		SimStep(slice);
+		ulPending -= slice;
+	}
+
+	m_ulCycles += ulCycles;
+	SimStep(ulCycles);
+	SimDispatch();
+}
+
+
+/**
+ * \brief Called by GCC at the start of every basic block of code built with -fsanitize-coverage=trace-pc. \n
+ * Charges the block's cycles. The models catch up at the next register access, so ISRs still only run between accesses.
+ */
+extern "C" void __sanitizer_cov_trace_pc(void)
+{
+	m_bCountingBlocks = true;
+	m_cost.blocks++;
+	m_ulCycles += HOST_SIM_BLOCK_CYCLES;
+	m_ulPendingCycles += HOST_SIM_BLOCK_CYCLES;
+}
+
+
+/**
+ * \brief Turns global interrupts on, running any that are pending
+ */
+void HostSimInterruptsOn(void)
+{
+	SREG.value |= (1 << SREG_I);
+	SimAccess();
+}
+
+
+/**
+ * \brief Turns global interrupts off
+ */
+void HostSimInterruptsOff(void)
+{
+	SREG.value &= ~(1 << SREG_I);
+	SimAccess();
+}
+
+
+/**
+ * \brief Saves SREG and turns interrupts off for an ATOMIC_BLOCK
+ * \return The saved SREG
+ */
+uint8_t HostSimAtomicEnter(void)
+{
+	uint8_t sreg = SREG.value;
+	HostSimInterruptsOff();
+	return sreg;
+}
+
+
+/**
+ * \brief Puts SREG back at the end of an ATOMIC_BLOCK
+ * \param sreg The SREG to put back
+ */
+void HostSimAtomicExit(uint8_t sreg)
+{
+	SREG.value = sreg;
+	SimAccess();
+}
+
+
+/**
+ * \brief Returns the number of interrupts that were flagged and enabled with no ISR
+ */
+uint32_t HostSimUnhandledInterrupts(void)
+{
+	return m_ulUnhandled;
+}
+
+
+
+/*****************************************************************************************************
+ * Time
+*****************************************************************************************************/
+
+/**
+ * \brief Returns the simulated time in core cycles
+ */
+uint64_t HostSimCycles(void)
+{
+	return m_ulCycles;
+}
+
+
+/**
+ * \brief Runs the simulation, running ISRs as they come up
+ * \param cycles The number of core cycles to run
+ */
+void HostSimRun(uint32_t cycles)
+{
+	while(cycles != 0)
+	{
+		uint32_t slice = (cycles < HOST_SIM_SLICE_CYCLES) ? cycles : HOST_SIM_SLICE_CYCLES;
+
+		m_ulCycles += slice;
+		SimStep(slice);
+		SimDispatch();
+		cycles -= slice;
+	}
+}
+
+
+/**
+ * \brief Runs the simulation for a number of microseconds of F_CPU
+ * \param us The microseconds
+ */
+void HostSimRunMicroseconds(uint32_t us)
+{
+	HostSimRun((uint32_t)(((uint64_t)us * F_CPU) / 1000000UL));
+}
+
+
+/**
+ * \brief Runs the simulation for a number of milliseconds of F_CPU
+ * \param ms The milliseconds
+ */
+void HostSimRunMilliseconds(uint32_t ms)
+{
+	while(ms-- != 0) HostSimRunMicroseconds(1000);
+}
+
+
+/**
+ * \brief The busy wait delays from util/delay.h
+ * \param cycles The number of cycles to delay for
+ */
+void HostSimDelayCycles(double cycles)
+{
+	uint64_t count = (cycles > 0) ? (uint64_t)cycles : 0;
+
+	while(count > 0xFFFFFFFFUL)
+	{
+		HostSimRun(0xFFFFFFFFUL);
+		count -= 0xFFFFFFFFUL;
+	}
+
+	HostSimRun((uint32_t)count);
+}
+
+
+/**
+ * \brief The sleep instruction. If sleep is enabled, runs the simulation until an interrupt wakes the core and its ISR has run. \n
+ * Gives up after HOST_SIM_SLEEP_LIMIT cycles, where the part would sleep forever.
+ */
+void HostSimSleep(void)
+{
+	//Variables
+	uint32_t ulSlept = 0;		//Cycles slept for
+
+	if(!(SMCR.value & (1 << SE)))
+	{
+		SimAccess();
+		return;
+	}
+
+	while(ulSlept < HOST_SIM_SLEEP_LIMIT)
+	{
+		m_ulCycles += HOST_SIM_SLICE_CYCLES;
+		ulSlept += HOST_SIM_SLICE_CYCLES;
+		SimStep(HOST_SIM_SLICE_CYCLES);
+
+		if(SimPendingIrq() != 0)
+		{
+			SimDispatch();
+			return;
+		}
+	}
+}
+
+
+
+/*****************************************************************************************************
+ * Queues
+*****************************************************************************************************/
+
+static bool SimQueuePush(SimByteQueue_t* queue, uint8_t data)
+{
+	if(queue->count >= HOST_SIM_QUEUE_SIZE) return false;
+
+	queue->data[(queue->head + queue->count) % HOST_SIM_QUEUE_SIZE] = data;
+	queue->count++;
+	return true;
+}
+
+
+static uint8_t SimQueuePop(SimByteQueue_t* queue)
+{
+	uint8_t data = queue->data[queue->head];
+
+	queue->head = (queue->head + 1) % HOST_SIM_QUEUE_SIZE;
+	queue->count--;
+	return data;
+}
+
+
+static bool SimFramePush(SimFrameQueue_t* queue, const HostCanFrame_t* frame)
+{
+	const uint16_t size = sizeof(queue->data) / sizeof(queue->data[0]);
+
+	if(queue->count >= size) return false;
+
+	queue->data[(queue->head + queue->count) % size] = *frame;
+	queue->count++;
+	return true;
+}
+
+
+static void SimFramePop(SimFrameQueue_t* queue, HostCanFrame_t* frame)
+{
+	const uint16_t size = sizeof(queue->data) / sizeof(queue->data[0]);
+
+	*frame = queue->data[queue->head];
+	queue->head = (queue->head + 1) % size;
+	queue->count--;
+}
+
+
+
+/*****************************************************************************************************
+ * GPIO
+*****************************************************************************************************/
+
+/**
+ * \brief Sets the level of an input pin, raising its pin change interrupt flag if the pin is in the group's mask
+ * \param pinRegister The PINx register of the port
+ * \param pin The pin of the port
+ * \param level The new level
+ */
+void HostGpioSetPin(volatile uint8_t* pinRegister, uint8_t pin, bool level)
+{
+	//Variables
+	static HostReg8* const masks[4] = { &PCMSK0, &PCMSK1, &PCMSK2, &PCMSK3 };
+	static volatile uint8_t* const ports[4] = { &PINB, &PINC, &PIND, &PINE };
+	uint8_t before = *pinRegister;
+	uint8_t after = level ? (before | (1 << pin)) : (before & ~(1 << pin));
+
+	*pinRegister = after;
+
+	for(uint8_t i = 0; i < 4; i++)
+	{
+		if(ports[i] == pinRegister && ((before ^ after) & masks[i]->value))
+		{
+			PCIFR.value |= (1 << i);
+		}
+	}
+
+	SimDispatch();
+}
+
+
+
+/*****************************************************************************************************
+ * Timers
+*****************************************************************************************************/
+
+//Timer clock division for each of the clock select settings
+static const uint16_t m_timerPrescale[8] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+
+//Timer1 top for each of the waveform generation modes, 0 where it comes from OCR1A and 1 where it comes from ICR1
+static const uint16_t m_timer1Top[16] = { 0xFFFF, 0x00FF, 0x01FF, 0x03FF, 0, 0x00FF, 0x01FF, 0x03FF, 1, 0, 1, 0, 1, 0xFFFF, 1, 0 };
+
+
+/**
+ * \brief Counts a timer for a number of core cycles, setting the overflow and compare flags
+ * \param timer The timer
+ * \param flags The timer's flag register, with the bits laid out like TIFR0
+ * \param cycles The core cycles
+ * \param clockSelect The clock select bits
+ * \param top The value the count goes back to 0 after
+ * \param ctc If top comes from a clear timer on compare mode, where overflow is only at the maximum
+ * \param max The maximum count
+ * \param compareA The A compare value
+ * \param compareB The B compare value
+ * \param triggers ADC auto trigger sources for overflow, compare A and compare B
+ */
+static void SimTimerCount(SimTimer_t* timer, HostReg8* flags, uint32_t cycles, uint8_t clockSelect, uint16_t top, bool ctc,
+							uint16_t max, uint16_t compareA, uint16_t compareB, const uint8_t* triggers)
+{
+	uint16_t prescale = m_timerPrescale[clockSelect & 0x07];
+
+	if(prescale == 0) return;
+
+	timer->prescaleCount += cycles;
+
+	while(timer->prescaleCount >= prescale)
+	{
+		timer->prescaleCount -= prescale;
+
+		if(timer->count == top)
+		{
+			timer->count = 0;
+
+			if(!ctc || top == max)
+			{
+				flags->value |= (1 << TOV0);
+				SimAdcTrigger(triggers[0]);
+			}
+		}
+		else
+		{
+			timer->count++;
+		}
+
+		if(timer->count == compareA)
+		{
+			flags->value |= (1 << OCF0A);
+			SimAdcTrigger(triggers[1]);
+		}
+
+		if(timer->count == compareB)
+		{
+			flags->value |= (1 << OCF0B);
+			SimAdcTrigger(triggers[2]);
+		}
+	}
+}
+
+
+static void SimTimerStep(uint32_t cycles)
+{
+	static const uint8_t timer0Triggers[3] = { 3, 2, 0 };
+	static const uint8_t timer1Triggers[3] = { 5, 0, 4 };
+	uint8_t mode;
+	uint16_t top;
+
+	if(!(PRR.value & (1 << PRTIM0)))
+	{
+		mode = (TCCR0A.value & 0x03) | ((TCCR0B.value >> WGM02) & 0x01) << 2;
+		top = (mode == 2 || mode == 5 || mode == 7) ? OCR0A.value : 0xFF;
+		SimTimerCount(&m_timer0, &TIFR0, cycles, TCCR0B.value, top, mode == 2, 0xFF, OCR0A.value, OCR0B.value, timer0Triggers);
+	}
+
+	if(!(PRR.value & (1 << PRTIM1)))
+	{
+		mode = (TCCR1A.value & 0x03) | ((TCCR1B.value >> WGM12) & 0x03) << 2;
+		top = m_timer1Top[mode];
+		if(top == 0) top = OCR1A.value;
+		else if(top == 1) top = ICR1.value;
+		SimTimerCount(&m_timer1, &TIFR1, cycles, TCCR1B.value, top, mode == 4 || mode == 12, 0xFFFF, OCR1A.value, OCR1B.value, timer1Triggers);
+	}
+}
+
+
+static uint8_t SimTimerCountRead(HostReg8& reg)
+{
+	(void)reg;
+
+	return (uint8_t)m_timer0.count;
+}
+
+
+static void SimTimerCountWrite(HostReg8& reg, uint8_t value)
+{
+	(void)reg;
+
+	m_timer0.count = value;
+}
+
+
+static uint16_t SimTimer1CountRead(HostReg16& reg)
+{
+	(void)reg;
+
+	return m_timer1.count;
+}
+
+
+static void SimTimer1CountWrite(HostReg16& reg, uint16_t value)
+{
+	(void)reg;
+
+	m_timer1.count = value;
+}
+
+
+//The force output compare strobes read back as 0
+static void SimTimerControlWrite(HostReg8& reg, uint8_t value)
+{
+	reg.value = value & 0x3F;
+}
+
+
+
+/*****************************************************************************************************
+ * ADC
+*****************************************************************************************************/
+
+static void SimAdcStart(void)
+{
+	static const uint8_t prescale[8] = { 2, 2, 4, 8, 16, 32, 64, 128 };
+
+	if(PRR.value & (1 << PRADC)) return;
+
+	//The multiplexer is latched as the conversion starts, so changing it after only takes effect on the next
+	m_adc.busy = true;
+	m_adc.channel = ADMUX.value & 0x1F;
+	m_adc.doneAt = m_ulCycles + (uint32_t)(m_adc.started ? 13 : 25) * prescale[ADCSRA.value & 0x07];
+	m_adc.started = true;
+	ADCSRA.value |= (1 << ADSC);
+}
+
+
+/**
+ * \brief Starts a conversion on an auto trigger event
+ * \param source The ADTS setting for the event, 0 for none
+ */
+static void SimAdcTrigger(uint8_t source)
+{
+	if(source == 0 || m_adc.busy) return;
+
+	if((ADCSRA.value & ((1 << ADEN) | (1 << ADATE))) == ((1 << ADEN) | (1 << ADATE)) && (ADCSRB.value & 0x0F) == source)
+	{
+		SimAdcStart();
+	}
+}
+
+
+static void SimAdcControlWrite(HostReg8& reg, uint8_t value)
+{
+	uint8_t flag = reg.value & (1 << ADIF) & ~value;
+
+	reg.value = (value & ~((1 << ADIF) | (1 << ADSC))) | flag | (m_adc.busy ? (1 << ADSC) : 0);
+
+	if(!(value & (1 << ADEN)))
+	{
+		m_adc.busy = false;
+		m_adc.started = false;
+		reg.value &= ~(1 << ADSC);
+	}
+	else if((value & (1 << ADSC)) && !m_adc.busy)
+	{
+		SimAdcStart();
+	}
+}
+
+
+static void SimAdcStep(void)
+{
+	uint8_t channel;
+	uint16_t sample;
+
+	if(!m_adc.busy || m_ulCycles < m_adc.doneAt) return;
+
+	m_adc.busy = false;
+	ADCSRA.value &= ~(1 << ADSC);
+
+	channel = m_adc.channel;
+	sample = ((m_adc.source != 0) ? m_adc.source(channel) : m_adc.inputs[channel]) & 0x03FF;
+
+	if(ADMUX.value & (1 << ADLAR))
+	{
+		ADCH.value = (uint8_t)(sample >> 2);
+		ADCL.value = (uint8_t)(sample << 6);
+	}
+	else
+	{
+		ADCH.value = (uint8_t)(sample >> 8);
+		ADCL.value = (uint8_t)sample;
+	}
+
+	ADCSRA.value |= (1 << ADIF);
+	m_adc.conversions++;
+
+	//Free running
+	if((ADCSRA.value & (1 << ADATE)) && (ADCSRB.value & 0x0F) == 0) SimAdcStart();
+}
+
+
+/**
+ * \brief Sets the reading for an ADC channel
+ * \param channel The MUX setting
+ * \param value The 10 bit reading
+ */
+void HostAdcSetInput(uint8_t channel, uint16_t value)
+{
+	m_adc.inputs[channel & 0x1F] = value;
+}
+
+
+/**
+ * \brief Sets a function to get the ADC readings from at each conversion, in place of the inputs set with HostAdcSetInput
+ * \param source The function, or 0 to go back to the set inputs
+ */
+void HostAdcSetSource(HostAdcSource_t source)
+{
+	m_adc.source = source;
+}
+
+
+/**
+ * \brief Returns the number of ADC conversions done
+ */
+uint32_t HostAdcConversions(void)
+{
+	return m_adc.conversions;
+}
+
+
+
+/*****************************************************************************************************
+ * SPI
+*****************************************************************************************************/
+
+static uint8_t SimSpiStatusRead(HostReg8& reg)
+{
+	if(reg.value & (1 << SPIF)) m_spi.flagSeen = true;
+	return reg.value;
+}
+
+
+static void SimSpiStatusWrite(HostReg8& reg, uint8_t value)
+{
+	reg.value = (reg.value & 0xFE) | (value & (1 << SPI2X));
+}
+
+
+//Reading the status with SPIF set, then the data register clears SPIF and WCOL
+static void SimSpiClearFlags(void)
+{
+	if(m_spi.flagSeen)
+	{
+		SPSR.value &= ~((1 << SPIF) | (1 << WCOL));
+		m_spi.flagSeen = false;
+	}
+}
+
+
+static uint8_t SimSpiDataRead(HostReg8& reg)
+{
+	SimSpiClearFlags();
+	return reg.value;
+}
+
+
+static void SimSpiDataWrite(HostReg8& reg, uint8_t value)
+{
+	(void)reg;
+
+	static const uint8_t divider[4] = { 4, 16, 64, 128 };
+
+	SimSpiClearFlags();
+
+	if(!(SPCR.value & (1 << SPE)) || (PRR.value & (1 << PRSPI))) return;
+
+	if(m_spi.busy)
+	{
+		SPSR.value |= (1 << WCOL);
+		return;
+	}
+
+	m_spi.busy = true;
+	m_spi.dataOut = value;
+	m_spi.doneAt = m_ulCycles + 8 * (divider[SPCR.value & 0x03] >> (SPSR.value & (1 << SPI2X)));
+}
+
+
+static void SimSpiStep(void)
+{
+	if(!m_spi.busy || m_ulCycles < m_spi.doneAt) return;
+
+	m_spi.busy = false;
+	m_spi.transfers++;
+	m_cost.busBytes++;
+	SPDR.value = (m_spi.responder != 0) ? m_spi.responder(m_spi.dataOut) : 0xFF;
+	SPSR.value |= (1 << SPIF);
+}
+
+
+/**
+ * \brief Sets the function that gives the byte shifted in for each byte shifted out
+ * \param responder The function, or 0 to shift in 0xFF
+ */
+void HostSpiSetResponder(HostSpiResponder_t responder)
+{
+	m_spi.responder = responder;
+}
+
+
+/**
+ * \brief Returns the number of bytes transferred over SPI
+ */
+uint32_t HostSpiTransfers(void)
+{
+	return m_spi.transfers;
+}
+
+
+
+/*****************************************************************************************************
+ * USART
+*****************************************************************************************************/
+
+//The registers of each USART: status, control, baud low, baud high
+static HostReg8* const m_uartRegs[HOST_UART_QUANTITY][4] =
+{
+	{ &UCSR0A, &UCSR0B, &UBRR0L, &UBRR0H },
+	{ &UCSR1A, &UCSR1B, &UBRR1L, &UBRR1H }
+};
+
+
+//Cycles to send or receive a start bit, 8 data bits and a stop bit
+static uint32_t SimUartFrameCycles(uint8_t uart)
+{
+	uint16_t baud = m_uartRegs[uart][2]->value | ((uint16_t)(m_uartRegs[uart][3]->value & 0x0F) << 8);
+	return (uint32_t)(baud + 1) * ((m_uartRegs[uart][0]->value & (1 << U2X0)) ? 8 : 16) * 10;
+}
+
+
+static void SimUartStatusWrite(HostReg8& reg, uint8_t value)
+{
+	reg.value = (reg.value & ~((1 << U2X0) | (1 << MPCM0))) | (value & ((1 << U2X0) | (1 << MPCM0)));
+	if(value & (1 << TXC0)) reg.value &= ~(1 << TXC0);
+}
+
+
+static uint8_t SimUartDataRead(HostReg8& reg)
+{
+	SimUart_t* uart = &m_uart[reg.index];
+	HostReg8* status = m_uartRegs[reg.index][0];
+
+	if(uart->rxCount != 0)
+	{
+		reg.value = uart->rxFifo[0];
+		uart->rxFifo[0] = uart->rxFifo[1];
+		uart->rxCount--;
+	}
+
+	if(uart->rxCount == 0) status->value &= ~(1 << RXC0);
+	status->value &= ~(1 << DOR0);
+
+	return reg.value;
+}
+
+
+static void SimUartStartTx(uint8_t index, uint8_t value)
+{
+	m_uart[index].txBusy = true;
+	m_uart[index].txShift = value;
+	m_uart[index].txDoneAt = m_ulCycles + SimUartFrameCycles(index);
+}
+
+
+static void SimUartDataWrite(HostReg8& reg, uint8_t value)
+{
+	SimUart_t* uart = &m_uart[reg.index];
+	HostReg8* status = m_uartRegs[reg.index][0];
+
+	if(!(m_uartRegs[reg.index][1]->value & (1 << TXEN0))) return;
+
+	if(!uart->txBusy)
+	{
+		SimUartStartTx(reg.index, value);
+	}
+	else
+	{
+		uart->txPending = true;
+		uart->txNext = value;
+		status->value &= ~(1 << UDRE0);
+	}
+}
+
+
+static void SimUartStep(uint8_t index)
+{
+	SimUart_t* uart = &m_uart[index];
+	HostReg8* status = m_uartRegs[index][0];
+
+	if(uart->txBusy && m_ulCycles >= uart->txDoneAt)
+	{
+		uart->txBusy = false;
+		m_cost.busBytes++;
+		SimQueuePush(&uart->txLog, uart->txShift);
+		if(m_uartHook != 0) m_uartHook(index, uart->txShift);
+
+		if(uart->txPending)
+		{
+			uart->txPending = false;
+			SimUartStartTx(index, uart->txNext);
+			status->value |= (1 << UDRE0);
+		}
+		else
+		{
+			status->value |= (1 << TXC0);
+		}
+	}
+
+	if(uart->rxQueue.count != 0 && m_ulCycles >= uart->rxNextAt)
+	{
+		uint8_t data = SimQueuePop(&uart->rxQueue);
+
+		m_cost.busBytes++;
+
+		if(m_uartRegs[index][1]->value & (1 << RXEN0))
+		{
+			if(uart->rxCount < 2) uart->rxFifo[uart->rxCount++] = data;
+			else status->value |= (1 << DOR0);
+
+			status->value |= (1 << RXC0);
+		}
+
+		uart->rxNextAt = m_ulCycles + SimUartFrameCycles(index);
+	}
+}
+
+
+
+/*****************************************************************************************************
+ * TWI
+*****************************************************************************************************/
+
+static void SimTwiStatusWrite(HostReg8& reg, uint8_t value)
+{
+	reg.value = (reg.value & 0xF8) | (value & 0x03);
+}
+
+
+static void SimTwiControlWrite(HostReg8& reg, uint8_t value)
+{
+	uint8_t flag = reg.value & (1 << TWINT);
+	uint32_t bit = 16 + 2 * (uint32_t)TWBR.value * (1 << (2 * (TWSR.value & 0x03)));
+	uint8_t address;
+	bool read;
+	bool ack;
+
+	if(value & (1 << TWINT)) flag = 0;
+	reg.value = (value & ~((1 << TWINT) | (1 << TWWC))) | flag;
+
+	if(!(value & (1 << TWEN)))
+	{
+		m_twi.state = TWI_STATE_IDLE;
+		m_twi.busy = false;
+		m_twi.device = 0;
+		return;
+	}
+
+	//Actions only start when TWINT is cleared
+	if(!(value & (1 << TWINT))) return;
+
+	if(value & (1 << TWSTA))
+	{
+		m_twi.status = (m_twi.state == TWI_STATE_IDLE) ? 0x08 : 0x10;
+		m_twi.state = TWI_STATE_STARTED;
+		m_twi.device = 0;
+		m_twi.busy = true;
+		m_twi.doneAt = m_ulCycles + bit;
+		return;
+	}
+
+	if(value & (1 << TWSTO))
+	{
+		if(m_twi.device != 0 && m_twi.device->stop != 0) m_twi.device->stop();
+
+		m_twi.device = 0;
+		m_twi.state = TWI_STATE_IDLE;
+		m_twi.busy = false;
+		reg.value &= ~(1 << TWSTO);
+		return;
+	}
+
+	m_twi.data = TWDR.value;
+
+	switch(m_twi.state)
+	{
+		case TWI_STATE_STARTED:
+			address = TWDR.value >> 1;
+			read = TWDR.value & 0x01;
+
+			for(uint8_t i = 0; i < m_twi.deviceCount; i++)
+			{
+				if(m_twi.devices[i].address == address) m_twi.device = &m_twi.devices[i];
+			}
+
+			if(m_twi.device != 0)
+			{
+				if(m_twi.device->start != 0) m_twi.device->start(read);
+				m_twi.status = read ? 0x40 : 0x18;
+				m_twi.state = read ? TWI_STATE_READING : TWI_STATE_WRITING;
+			}
+			else
+			{
+				m_twi.status = read ? 0x48 : 0x20;
+				m_twi.state = TWI_STATE_NACKED;
+			}
+		break;
+
+		case TWI_STATE_WRITING:
+			ack = (m_twi.device->write != 0) ? m_twi.device->write(TWDR.value) : true;
+			m_twi.status = ack ? 0x28 : 0x30;
+		break;
+
+		case TWI_STATE_READING:
+			ack = (value & (1 << TWEA)) != 0;
+			m_twi.data = (m_twi.device->read != 0) ? m_twi.device->read(ack) : 0xFF;
+			m_twi.status = ack ? 0x50 : 0x58;
+		break;
+
+		default:
+			//Bus error
+			m_twi.status = 0x00;
+		break;
+	}
+
+	m_twi.busy = true;
+	m_twi.doneAt = m_ulCycles + 9 * bit;
+}
+
+
+static void SimTwiStep(void)
+{
+	if(!m_twi.busy || m_ulCycles < m_twi.doneAt) return;
+
+	m_twi.busy = false;
+	if(m_twi.status != 0x08 && m_twi.status != 0x10) m_cost.busBytes++;
+	TWDR.value = m_twi.data;
+	TWSR.value = m_twi.status | (TWSR.value & 0x03);
+	TWCR.value |= (1 << TWINT);
+}
+
+
+/**
+ * \brief Attaches a device to the simulated TWI bus
+ * \param device The device, copied
+ * \return If there was room for it
+ */
+bool HostTwiAttach(const HostTwiDevice_t* device)
+{
+	if(m_twi.deviceCount >= HOST_TWI_MAX_DEVICES) return false;
+
+	m_twi.devices[m_twi.deviceCount++] = *device;
+	return true;
+}
+
+
+/**
+ * \brief Removes all devices from the simulated TWI bus
+ */
+void HostTwiDetachAll(void)
+{
+	m_twi.deviceCount = 0;
+	m_twi.device = 0;
+}
+
+
+
+/*****************************************************************************************************
+ * CAN
+*****************************************************************************************************/
+
+//Puts an identifier into the CANIDT or CANIDM layout
+static void SimCanSetId(uint8_t* regs, uint32_t id, bool extended)
+{
+	if(extended)
+	{
+		regs[0] = (uint8_t)(id >> 21);
+		regs[1] = (uint8_t)(id >> 13);
+		regs[2] = (uint8_t)(id >> 5);
+		regs[3] = (uint8_t)((id << 3) | (regs[3] & 0x07));
+	}
+	else
+	{
+		regs[0] = (uint8_t)(id >> 3);
+		regs[1] = (uint8_t)(id << 5);
+	}
+}
+
+
+//Takes an identifier out of the CANIDT or CANIDM layout
+static uint32_t SimCanGetId(const uint8_t* regs, bool extended)
+{
+	if(extended)
+	{
+		return ((uint32_t)regs[0] << 21) | ((uint32_t)regs[1] << 13) | ((uint32_t)regs[2] << 5) | (regs[3] >> 3);
+	}
+
+	return ((uint16_t)regs[0] << 3) | (regs[1] >> 5);
+}
+
+
+//The MOb selected by CANPAGE, or a spare for pages past the last MOb
+static SimMob_t* SimCanMob(void)
+{
+	uint8_t mob = CANPAGE.value >> 4;
+	return &m_can.mobs[(mob < HOST_CAN_MOB_QUANTITY) ? mob : HOST_CAN_MOB_QUANTITY];
+}
+
+
+//MObs with a finished transfer or an error
+static uint8_t SimCanSit(void)
+{
+	uint8_t sit = 0;
+
+	for(uint8_t i = 0; i < HOST_CAN_MOB_QUANTITY; i++)
+	{
+		if(m_can.mobs[i].status & 0x7F) sit |= (1 << i);
+	}
+
+	return sit;
+}
+
+
+static uint8_t SimCanPageRead(HostReg8& reg)
+{
+	SimMob_t* mob = SimCanMob();
+	uint8_t value;
+
+	switch(reg.index)
+	{
+		case 0: return mob->status;
+		case 1: return mob->control;
+		case 2: case 3: case 4: case 5: return mob->idt[reg.index - 2];
+		case 6: case 7: case 8: case 9: return mob->idm[reg.index - 6];
+	}
+
+	value = mob->msg[CANPAGE.value & 0x07];
+	if(!(CANPAGE.value & (1 << AINC))) CANPAGE.value = (CANPAGE.value & 0xF8) | ((CANPAGE.value + 1) & 0x07);
+	return value;
+}
+
+
+static void SimCanPageWrite(HostReg8& reg, uint8_t value)
+{
+	SimMob_t* mob = SimCanMob();
+
+	switch(reg.index)
+	{
+		case 0:
+			//The flags can only be cleared
+			mob->status &= value;
+		break;
+
+		case 1:
+			mob->control = value;
+			mob->enabled = (value >> 6) != 0;
+		break;
+
+		case 2: case 3: case 4: case 5:
+			mob->idt[reg.index - 2] = value;
+		break;
+
+		case 6: case 7: case 8: case 9:
+			mob->idm[reg.index - 6] = value;
+		break;
+
+		default:
+			mob->msg[CANPAGE.value & 0x07] = value;
+			if(!(CANPAGE.value & (1 << AINC))) CANPAGE.value = (CANPAGE.value & 0xF8) | ((CANPAGE.value + 1) & 0x07);
+		break;
+	}
+}
+
+
+//Puts the CAN controller's registers and MObs back to reset
+static void SimCanReset(void)
+{
+	for(HostReg8* reg = m_regList8; reg != 0; reg = reg->next)
+	{
+		if(strncmp(reg->name, "CAN", 3) == 0) reg->value = reg->resetValue;
+	}
+
+	memset(m_can.mobs, 0, sizeof(m_can.mobs));
+	m_can.timer = 0;
+	m_can.busy = false;
+	m_can.busOff = false;
+	m_can.recoverAt = 0;
+}
+
+
+static void SimCanControlWrite(HostReg8& reg, uint8_t value)
+{
+	if(value & (1 << SWRES))
+	{
+		SimCanReset();
+		return;
+	}
+
+	//Enabling while bus off starts the recovery, which takes 128 runs of 11 recessive bits
+	if(m_can.busOff && (value & (1 << ENASTB)) && !(reg.value & (1 << ENASTB)))
+	{
+		m_can.recoverAt = m_ulCycles + 128UL * 11 * SimCanBitCycles();
+	}
+
+	reg.value = value;
+
+	//Abort request disables the MObs waiting to send
+	if(value & (1 << ABRQ))
+	{
+		for(uint8_t i = 0; i < HOST_CAN_MOB_QUANTITY; i++)
+		{
+			if((m_can.mobs[i].control >> 6) == 1 && !(m_can.busy && m_can.txMob == (int8_t)i)) m_can.mobs[i].enabled = false;
+		}
+	}
+}
+
+
+static uint8_t SimCanStatusRead(HostReg8& reg)
+{
+	(void)reg;
+
+	uint8_t value = 0;
+
+	if(CANGCON.value & (1 << ENASTB)) value |= (1 << ENFG);
+	if(m_can.busy) value |= (m_can.txMob >= 0) ? (1 << TXBSY) : (1 << RXBSY);
+	if(m_can.busOff) value |= (1 << BOFF);
+	if(CANTEC.value >= 128 || CANREC.value >= 128) value |= (1 << ERRP);
+
+	return value;
+}
+
+
+static uint8_t SimCanInterruptRead(HostReg8& reg)
+{
+	bool canit = (SimCanSit() & CANIE2.value) != 0 || (reg.value & 0x5F) != 0;
+	return (reg.value & 0x7F) | (canit ? (1 << CANIT) : 0);
+}
+
+
+static void SimCanInterruptWrite(HostReg8& reg, uint8_t value)
+{
+	reg.value &= ~(value & 0x7F);
+}
+
+
+static uint8_t SimCanEnableRead(HostReg8& reg)
+{
+	(void)reg;
+
+	uint8_t value = 0;
+
+	for(uint8_t i = 0; i < HOST_CAN_MOB_QUANTITY; i++)
+	{
+		if(m_can.mobs[i].enabled) value |= (1 << i);
+	}
+
+	return value;
+}
+
+
+static uint8_t SimCanMobStatusRead(HostReg8& reg)
+{
+	(void)reg;
+
+	return SimCanSit();
+}
+
+
+static uint8_t SimCanHighestRead(HostReg8& reg)
+{
+	uint8_t sit = SimCanSit() & CANIE2.value;
+
+	for(uint8_t i = 0; i < HOST_CAN_MOB_QUANTITY; i++)
+	{
+		if(sit & (1 << i)) return (i << 4) | (reg.value & 0x0F);
+	}
+
+	return 0xF0 | (reg.value & 0x0F);
+}
+
+
+static uint16_t SimCanTimeRead(HostReg16& reg)
+{
+	switch(reg.index)
+	{
+		case 0: return m_can.timer;
+		case 1: return m_can.lastFrameTime;
+	}
+
+	return SimCanMob()->stamp;
+}
+
+
+static bool SimCanPending(void)
+{
+	uint8_t enables = CANGIE.value;
+	uint8_t general = CANGIT.value;
+
+	if(!(enables & (1 << ENIT))) return false;
+
+	for(uint8_t i = 0; i < HOST_CAN_MOB_QUANTITY; i++)
+	{
+		uint8_t status = m_can.mobs[i].status;
+
+		if(!(CANIE2.value & (1 << i))) continue;
+		if((enables & (1 << ENRX)) && (status & (1 << RXOK))) return true;
+		if((enables & (1 << ENTX)) && (status & (1 << TXOK))) return true;
+		if((enables & (1 << ENERR)) && (status & 0x1F)) return true;
+	}
+
+	if((enables & (1 << ENBOFF)) && (general & (1 << BOFFIT))) return true;
+	if((enables & (1 << ENBX)) && (general & (1 << BXOK))) return true;
+	if((enables & (1 << ENERG)) && (general & 0x0F)) return true;
+
+	return false;
+}
+
+
+//Core cycles for one bit, from the bit timing registers
+static uint32_t SimCanBitCycles(void)
+{
+	uint32_t brp = ((CANBT1.value >> 1) & 0x3F) + 1;
+	uint32_t quanta = 1 + (((CANBT2.value >> 1) & 0x07) + 1) + (((CANBT3.value >> 1) & 0x07) + 1) + (((CANBT3.value >> 4) & 0x07) + 1);
+	return brp * quanta;
+}
+
+
+static bool SimCanMatches(const SimMob_t* mob, const HostCanFrame_t* frame)
+{
+	bool extended = (mob->control & (1 << IDE)) != 0;
+	uint32_t tag;
+	uint32_t mask;
+
+	if((mob->idm[3] & (1 << IDEMSK)) && extended != (frame->extended != 0)) return false;
+	if((mob->idm[3] & (1 << RTRMSK)) && ((mob->idt[3] >> RTRTAG) & 0x01) != frame->remote) return false;
+
+	tag = SimCanGetId(mob->idt, frame->extended);
+	mask = SimCanGetId(mob->idm, frame->extended);
+
+	return ((frame->id ^ tag) & mask) == 0;
+}
+
+
+//Puts a frame off the bus in the first enabled receive MOb that accepts it
+static void SimCanDeliver(const HostCanFrame_t* frame)
+{
+	for(uint8_t i = 0; i < HOST_CAN_MOB_QUANTITY; i++)
+	{
+		SimMob_t* mob = &m_can.mobs[i];
+
+		if(!mob->enabled || (mob->control >> 6) < 2 || !SimCanMatches(mob, frame)) continue;
+
+		SimCanSetId(mob->idt, frame->id, frame->extended);
+		mob->idt[3] = (mob->idt[3] & ~(1 << RTRTAG)) | (frame->remote ? (1 << RTRTAG) : 0);
+		if((mob->control & 0x0F) != frame->length) mob->status |= (1 << DLCW);
+		mob->control = (mob->control & 0xE0) | (frame->extended ? (1 << IDE) : 0) | frame->length;
+		memcpy(mob->msg, frame->data, 8);
+		mob->stamp = m_can.timer;
+		mob->status |= (1 << RXOK);
+		mob->enabled = false;
+
+		if(CANREC.value != 0) CANREC.value--;
+		return;
+	}
+
+	m_can.lost++;
+}
+
+
+static void SimCanFinish(void)
+{
+	m_can.busy = false;
+	m_can.lastFrameTime = m_can.timer;
+	m_cost.busBytes += m_can.frame.length;
+
+	if(m_can.txMob < 0)
+	{
+		SimCanDeliver(&m_can.frame);
+		return;
+	}
+
+	SimMob_t* mob = &m_can.mobs[m_can.txMob];
+
+	if(m_can.failCount != 0)
+	{
+		//The MOb stays enabled and the controller tries again
+		m_can.failCount--;
+		mob->status |= m_can.failBits;
+
+		if(CANTEC.value > 247)
+		{
+			HostCanSetBusOff(true);
+		}
+		else
+		{
+			CANTEC.value += 8;
+		}
+
+		return;
+	}
+
+	mob->status |= (1 << TXOK);
+	mob->stamp = m_can.timer;
+	mob->enabled = false;
+	if(CANTEC.value != 0) CANTEC.value--;
+
+	SimFramePush(&m_can.txLog, &m_can.frame);
+	if(m_can.hook != 0) m_can.hook(&m_can.frame);
+}
+
+
+//Starts the next frame on the bus, the lowest identifier of the first MOb waiting to send and the injected frames
+static void SimCanStart(void)
+{
+	int8_t txMob = -1;
+	HostCanFrame_t frame;
+
+	for(uint8_t i = 0; i < HOST_CAN_MOB_QUANTITY; i++)
+	{
+		SimMob_t* mob = &m_can.mobs[i];
+
+		if(mob->enabled && (mob->control >> 6) == 1)
+		{
+			txMob = i;
+			frame.extended = (mob->control & (1 << IDE)) ? 1 : 0;
+			frame.id = SimCanGetId(mob->idt, frame.extended);
+			frame.remote = (mob->idt[3] >> RTRTAG) & 0x01;
+			frame.length = mob->control & 0x0F;
+			if(frame.length > 8) frame.length = 8;
+			memcpy(frame.data, mob->msg, 8);
+			break;
+		}
+	}
+
+	if(m_can.rxQueue.count != 0)
+	{
+		const HostCanFrame_t* rx = &m_can.rxQueue.data[m_can.rxQueue.head];
+		uint32_t rxPriority = rx->extended ? rx->id : ((uint32_t)rx->id << 18);
+
+		if(txMob < 0 || rxPriority < (frame.extended ? frame.id : ((uint32_t)frame.id << 18)))
+		{
+			SimFramePop(&m_can.rxQueue, &frame);
+			txMob = -1;
+		}
+	}
+	else if(txMob < 0)
+	{
+		return;
+	}
+
+	m_can.frame = frame;
+	m_can.txMob = txMob;
+	m_can.busy = true;
+	m_can.doneAt = m_ulCycles + ((frame.extended ? 67 : 47) + (frame.remote ? 0 : 8 * frame.length)) * SimCanBitCycles();
+}
+
+
+static void SimCanStep(uint32_t cycles)
+{
+	uint32_t prescale = 8 * ((uint32_t)CANTCON.value + 1);
+
+	if(!(CANGCON.value & (1 << ENASTB)) || (PRR.value & (1 << PRCAN))) return;
+
+	m_can.prescaleCount += cycles;
+
+	while(m_can.prescaleCount >= prescale)
+	{
+		m_can.prescaleCount -= prescale;
+		if(++m_can.timer == 0) CANGIT.value |= (1 << OVRTIM);
+	}
+
+	if(m_can.busOff && m_can.recoverAt != 0 && m_ulCycles >= m_can.recoverAt) HostCanSetBusOff(false);
+	if(m_can.busy && m_ulCycles >= m_can.doneAt) SimCanFinish();
+	if(!m_can.busy && !m_can.busOff) SimCanStart();
+}
+
+
+/**
+ * \brief Puts a frame on the simulated bus. It arrives after the time it takes to send, in the first receive MOb that accepts it
+ * \param frame The frame, copied
+ * \return If there was room in the queue for it
+ */
+bool HostCanInject(const HostCanFrame_t* frame)
+{
+	if(!SimFramePush(&m_can.rxQueue, frame))
+	{
+		m_can.lost++;
+		return false;
+	}
+
+	return true;
+}
+
+
+/**
+ * \brief Takes the oldest frame sent by the CAN controller
+ * \param frame Where to put the frame
+ * \return If there was one
+ */
+bool HostCanTake(HostCanFrame_t* frame)
+{
+	if(m_can.txLog.count == 0) return false;
+
+	SimFramePop(&m_can.txLog, frame);
+	return true;
+}
+
+
+/**
+ * \brief Sets the function called with each frame sent, where a test can answer it with HostCanInject
+ * \param hook The function or 0
+ */
+void HostCanSetTxHook(HostCanTxHook_t hook)
+{
+	m_can.hook = hook;
+}
+
+
+/**
+ * \brief Sets the transmit and receive error counters
+ */
+void HostCanSetErrorCounters(uint8_t tec, uint8_t rec)
+{
+	CANTEC.value = tec;
+	CANREC.value = rec;
+}
+
+
+/**
+ * \brief Makes the next transmissions fail, with the MOb kept enabled to try again and the transmit error counter going up
+ * \param errorBits The CANSTMOB error bits to set for each failure
+ * \param count The number of transmissions to fail
+ */
+void HostCanFailTransmits(uint8_t errorBits, uint8_t count)
+{
+	m_can.failBits = errorBits;
+	m_can.failCount = count;
+}
+
+
+/**
+ * \brief Puts the controller in or out of bus off. Once in, it comes out 128 x 11 bit times after the controller is disabled and enabled again
+ * \param busOff True for bus off, where nothing is sent or received and BOFFIT is set
+ */
+void HostCanSetBusOff(bool busOff)
+{
+	m_can.busOff = busOff;
+	m_can.recoverAt = 0;
+
+	if(busOff)
+	{
+		CANTEC.value = 255;
+		CANGIT.value |= (1 << BOFFIT);
+	}
+	else
+	{
+		CANTEC.value = 0;
+		CANREC.value = 0;
+	}
+}
+
+
+/**
+ * \brief Returns the number of frames lost, either with no MOb to take them or no room in the queue
+ */
+uint32_t HostCanLost(void)
+{
+	return m_can.lost;
+}
+
+
+
+/*****************************************************************************************************
+ * LIN/UART
+*****************************************************************************************************/
+
+//Core cycles for one bit
+static uint32_t SimLinBitCycles(void)
+{
+	uint8_t samples = LINBTR.value & 0x3F;
+	return ((uint32_t)LINBRR.value + 1) * (samples ? samples : 32);
+}
+
+
+//Adds the parity bits to an identifier
+static uint8_t SimLinProtect(uint8_t id)
+{
+	uint8_t p0 = ((id >> 0) ^ (id >> 1) ^ (id >> 2) ^ (id >> 4)) & 0x01;
+	uint8_t p1 = ~((id >> 1) ^ (id >> 3) ^ (id >> 4) ^ (id >> 5)) & 0x01;
+	return (id & 0x3F) | (p0 << 6) | (p1 << 7);
+}
+
+
+static void SimLinAction(uint8_t action, uint32_t bits)
+{
+	m_lin.action = action;
+	m_lin.busy = true;
+	m_lin.doneAt = m_ulCycles + bits * SimLinBitCycles();
+}
+
+
+static void SimLinControlWrite(HostReg8& reg, uint8_t value)
+{
+	if(value & (1 << LSWRES))
+	{
+		for(HostReg8* r = m_regList8; r != 0; r = r->next)
+		{
+			if(strncmp(r->name, "LIN", 3) == 0) r->value = r->resetValue;
+		}
+
+		m_lin.busy = false;
+		m_lin.waitingResponse = false;
+		return;
+	}
+
+	reg.value = value;
+	m_lin.waitingResponse = false;
+
+	if(!(value & (1 << LENA)))
+	{
+		m_lin.busy = false;
+		return;
+	}
+
+	//UART mode
+	if(value & (1 << LCMD2)) return;
+
+	switch(value & 0x03)
+	{
+		case 1:
+			SimLinAction(LIN_ACTION_TX_HEADER, 34);
+		break;
+
+		case 2:
+			m_lin.waitingResponse = true;
+		break;
+
+		case 3:
+			SimLinAction(LIN_ACTION_TX_RESPONSE, 10 * ((LINDLR.value >> 4) + 1));
+		break;
+
+		default:
+			m_lin.busy = false;
+		break;
+	}
+}
+
+
+static uint8_t SimLinStatusRead(HostReg8& reg)
+{
+	return reg.value | (m_lin.busy ? (1 << LBUSY) : 0);
+}
+
+
+static void SimLinStatusWrite(HostReg8& reg, uint8_t value)
+{
+	reg.value &= ~(value & 0x0F);
+	if(!(reg.value & (1 << LERR))) LINERR.value = 0;
+}
+
+
+static void SimLinIdWrite(HostReg8& reg, uint8_t value)
+{
+	reg.value = SimLinProtect(value);
+}
+
+
+static uint8_t SimLinDataRead(HostReg8& reg)
+{
+	uint8_t value;
+
+	if(LINCR.value & (1 << LCMD2)) return reg.value;
+
+	value = m_lin.buffer[LINSEL.value & 0x07];
+	if(!(LINSEL.value & (1 << LAINC))) LINSEL.value = (LINSEL.value & 0xF8) | ((LINSEL.value + 1) & 0x07);
+	return value;
+}
+
+
+static void SimLinDataWrite(HostReg8& reg, uint8_t value)
+{
+	(void)reg;
+
+	if(LINCR.value & (1 << LCMD2))
+	{
+		if((LINCR.value & ((1 << LENA) | (1 << LCMD0))) != ((1 << LENA) | (1 << LCMD0)) || m_lin.busy) return;
+
+		m_lin.txShift = value;
+		SimLinAction(LIN_ACTION_TX_BYTE, 10);
+		return;
+	}
+
+	m_lin.buffer[LINSEL.value & 0x07] = value;
+	if(!(LINSEL.value & (1 << LAINC))) LINSEL.value = (LINSEL.value & 0xF8) | ((LINSEL.value + 1) & 0x07);
+}
+
+
+static bool SimLinPending(void)
+{
+	return (LINSIR.value & LINENIR.value & 0x07) != 0;
+}
+
+
+static void SimLinStep(void)
+{
+	bool uartMode = (LINCR.value & (1 << LCMD2)) != 0;
+	uint8_t length;
+
+	if(!(LINCR.value & (1 << LENA))) return;
+
+	if(m_lin.busy && m_ulCycles >= m_lin.doneAt)
+	{
+		m_lin.busy = false;
+
+		switch(m_lin.action)
+		{
+			case LIN_ACTION_TX_BYTE:
+				m_cost.busBytes++;
+				SimQueuePush(&m_lin.txLog, m_lin.txShift);
+				if(m_uartHook != 0) m_uartHook(HOST_UART_LIN, m_lin.txShift);
+				LINSIR.value |= (1 << LTXOK);
+			break;
+
+			case LIN_ACTION_TX_HEADER:
+				LINCR.value &= ~0x03;
+				LINSIR.value |= (1 << LIDOK);
+				if(m_lin.hook != 0) m_lin.hook(LINIDR.value);
+			break;
+
+			case LIN_ACTION_RX_HEADER:
+				LINIDR.value = SimLinProtect(m_lin.headerId);
+				LINSIR.value |= (1 << LIDOK);
+			break;
+
+			case LIN_ACTION_TX_RESPONSE:
+				length = LINDLR.value >> 4;
+				m_cost.busBytes += length;
+				for(uint8_t i = 0; i < length && i < 8; i++)
+				{
+					SimQueuePush(&m_lin.txLog, m_lin.buffer[i]);
+					if(m_uartHook != 0) m_uartHook(HOST_UART_LIN, m_lin.buffer[i]);
+				}
+				LINCR.value &= ~0x03;
+				LINSIR.value |= (1 << LTXOK);
+			break;
+
+			case LIN_ACTION_RX_RESPONSE:
+				m_cost.busBytes += m_lin.responseLength;
+				memcpy(m_lin.buffer, m_lin.response, 8);
+				LINCR.value &= ~0x03;
+				LINSIR.value |= (1 << LRXOK);
+			break;
+		}
+	}
+
+	if(m_lin.busy) return;
+
+	if(uartMode)
+	{
+		if(m_lin.rxQueue.count != 0 && m_ulCycles >= m_lin.rxNextAt)
+		{
+			if(LINSIR.value & (1 << LRXOK))
+			{
+				LINERR.value |= (1 << LOVERR);
+				LINSIR.value |= (1 << LERR);
+			}
+
+			LINDAT.value = SimQueuePop(&m_lin.rxQueue);
+			m_cost.busBytes++;
+			LINSIR.value |= (1 << LRXOK);
+			m_lin.rxNextAt = m_ulCycles + 10 * SimLinBitCycles();
+		}
+	}
+	else if(m_lin.waitingResponse && m_lin.responsePending)
+	{
+		m_lin.waitingResponse = false;
+		m_lin.responsePending = false;
+		SimLinAction(LIN_ACTION_RX_RESPONSE, 10 * (m_lin.responseLength + 1));
+	}
+	else if(m_lin.headerPending && (LINCR.value & 0x03) == 0)
+	{
+		m_lin.headerPending = false;
+		SimLinAction(LIN_ACTION_RX_HEADER, 34);
+	}
+}
+
+
+/**
+ * \brief Puts a LIN header on the bus for a slave to receive
+ * \param id The 6 bit identifier
+ */
+void HostLinInjectHeader(uint8_t id)
+{
+	m_lin.headerId = id & 0x3F;
+	m_lin.headerPending = true;
+}
+
+
+/**
+ * \brief Sets the response a slave sends, received once the master asks for it by setting the receive response command
+ * \param data The data bytes
+ * \param length The number of data bytes, up to 8
+ */
+void HostLinInjectResponse(const uint8_t* data, uint8_t length)
+{
+	if(length > 8) length = 8;
+
+	memset(m_lin.response, 0, sizeof(m_lin.response));
+	memcpy(m_lin.response, data, length);
+	m_lin.responseLength = length;
+	m_lin.responsePending = true;
+}
+
+
+/**
+ * \brief Sets the function called with each header the master sends, where a test can answer it with HostLinInjectResponse
+ * \param hook The function or 0
+ */
+void HostLinSetHeaderHook(HostLinHeaderHook_t hook)
+{
+	m_lin.hook = hook;
+}
+
+
+
+/*****************************************************************************************************
+ * Serial injection, shared by the USARTs and the LIN/UART
+*****************************************************************************************************/
+
+/**
+ * \brief Queues bytes to be received, arriving one frame time apart
+ * \param uart The USART number or HOST_UART_LIN
+ * \param data The bytes
+ * \param length The number of bytes
+ */
+void HostUartInject(uint8_t uart, const uint8_t* data, uint16_t length)
+{
+	SimByteQueue_t* queue;
+
+	if(uart < HOST_UART_QUANTITY)
+	{
+		queue = &m_uart[uart].rxQueue;
+		if(queue->count == 0) m_uart[uart].rxNextAt = m_ulCycles + SimUartFrameCycles(uart);
+	}
+	else
+	{
+		queue = &m_lin.rxQueue;
+		if(queue->count == 0) m_lin.rxNextAt = m_ulCycles + 10 * SimLinBitCycles();
+	}
+
+	while(length-- != 0) SimQueuePush(queue, *data++);
+}
+
+
+/**
+ * \brief Takes the bytes sent so far
+ * \param uart The USART number or HOST_UART_LIN
+ * \param buffer Where to put the bytes
+ * \param size The size of the buffer
+ * \return The number of bytes taken
+ */
+uint16_t HostUartTake(uint8_t uart, uint8_t* buffer, uint16_t size)
+{
+	SimByteQueue_t* queue = (uart < HOST_UART_QUANTITY) ? &m_uart[uart].txLog : &m_lin.txLog;
+	uint16_t count = 0;
+
+	while(count < size && queue->count != 0) buffer[count++] = SimQueuePop(queue);
+
+	return count;
+}
+
+
+/**
+ * \brief Sets the function called with each byte sent, from the USARTs and the LIN/UART
+ * \param hook The function or 0
+ */
+void HostUartSetTxHook(HostUartTxHook_t hook)
+{
+	m_uartHook = hook;
+}
+
+
+
+/*****************************************************************************************************
+ * Simulation
+*****************************************************************************************************/
+
+/**
+ * \brief Runs every model for a number of core cycles, after the time has been added
+ */
+static void SimStep(uint32_t cycles)
+{
+	SimTimerStep(cycles);
+	SimCanStep(cycles);
+	SimAdcStep();
+	SimSpiStep();
+	SimTwiStep();
+	SimLinStep();
+
+	for(uint8_t i = 0; i < HOST_UART_QUANTITY; i++) SimUartStep(i);
+}
+
+
+/**
+ * \brief Puts every register and model back to reset, clears the hooks and devices and sets the time back to 0
+ */
+void HostSimReset(void)
+{
+	for(HostReg8* reg = m_regList8; reg != 0; reg = reg->next) reg->value = reg->resetValue;
+	for(HostReg16* reg = m_regList16; reg != 0; reg = reg->next) reg->value = reg->resetValue;
+
+	PINB = DDRB = PORTB = 0;
+	PINC = DDRC = PORTC = 0;
+	PIND = DDRD = PORTD = 0;
+	PINE = DDRE = PORTE = 0;
+
+	memset(&m_timer0, 0, sizeof(m_timer0));
+	memset(&m_timer1, 0, sizeof(m_timer1));
+	memset(m_uart, 0, sizeof(m_uart));
+	memset(&m_spi, 0, sizeof(m_spi));
+	memset(&m_twi, 0, sizeof(m_twi));
+	memset(&m_adc, 0, sizeof(m_adc));
+	memset(&m_can, 0, sizeof(m_can));
+	memset(&m_lin, 0, sizeof(m_lin));
+
+	m_uartHook = 0;
+	m_ulCycles = 0;
+	m_ulUnhandled = 0;
+	memset(&m_cost, 0, sizeof(m_cost));
+	m_lastRead = 0;
+	m_ulPendingCycles = 0;
+}
+
+
+
+/*****************************************************************************************************
+ * Cost model
+*****************************************************************************************************/
+
+/**
+ * \brief Gets the running totals of the cost model
+ * \param cost Where to put them
+ */
+void HostSimCostGet(HostSimCost_t* cost)
+{
+	*cost = m_cost;
+	cost->cycles = m_ulCycles;
+}
+
+
+/**
+ * \brief Gets the cost since a point taken with HostSimCostGet
+ * \param start The totals at the start
+ * \param cost Where to put the difference
+ */
+void HostSimCostSince(const HostSimCost_t* start, HostSimCost_t* cost)
+{
+	HostSimCostGet(cost);
+
+	cost->cycles -= start->cycles;
+	cost->reads -= start->reads;
+	cost->writes -= start->writes;
+	cost->polls -= start->polls;
+	cost->busBytes -= start->busBytes;
+	cost->interrupts -= start->interrupts;
+	cost->blocks -= start->blocks;
+}
+
+
+/**
+ * \brief Runs a benchmark and prints a line with its cost per call
+ * \param bench The benchmark
+ * \param perCall Where to put the cost per call, or 0
+ * \return False if the cycles per call went over the budget by more than HOST_BENCH_TOLERANCE percent
+ */
+bool HostBenchRun(const HostBench_t* bench, HostSimCost_t* perCall)
+{
+	//Variables
+	HostSimCost_t start;		//Totals before the calls
+	HostSimCost_t cost;			//Cost of all the calls, then of one
+	uint16_t calls = (bench->calls != 0) ? bench->calls : 1;
+	uint64_t limit = bench->cycleBudget + ((uint64_t)bench->cycleBudget * HOST_BENCH_TOLERANCE) / 100;
+	bool passed;
+	struct timespec hostStart;	//Host time before the calls
+	struct timespec hostEnd;	//Host time after them
+	double seconds;
+
+	HostSimCostGet(&start);
+	clock_gettime(CLOCK_MONOTONIC, &hostStart);
+	for(uint16_t i = 0; i < calls; i++) bench->run(bench->arg);
+	clock_gettime(CLOCK_MONOTONIC, &hostEnd);
+	HostSimCostSince(&start, &cost);
+
+	seconds = (double)(hostEnd.tv_sec - hostStart.tv_sec) + (double)(hostEnd.tv_nsec - hostStart.tv_nsec) / 1e9;
+
+	cost.cycles /= calls;
+	cost.reads /= calls;
+	cost.writes /= calls;
+	cost.polls /= calls;
+	cost.busBytes /= calls;
+	cost.interrupts /= calls;
+	cost.blocks /= calls;
+
+	passed = (bench->cycleBudget == 0 || cost.cycles <= limit);
+
+	printf("%-24s %10llu cycles %8lu blocks %8lu reads %8lu writes %8lu polls %6lu bus bytes %4lu ISRs",
+			bench->name, (unsigned long long)cost.cycles, (unsigned long)cost.blocks, (unsigned long)cost.reads, (unsigned long)cost.writes,
+			(unsigned long)cost.polls, (unsigned long)cost.busBytes, (unsigned long)cost.interrupts);
+
+	if(bench->cycleBudget != 0) printf("  budget %lu %s", (unsigned long)bench->cycleBudget, passed ? "ok" : "OVER");
+	if(bench->bytes != 0 && seconds > 0) printf("  %9.2f MB/s on the host", ((double)bench->bytes * calls) / seconds / 1e6);
+	printf("\n");
+
+	if(perCall != 0) *perCall = cost;
+	return passed;
+}
+
+
+#endif
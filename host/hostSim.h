@@ -0,0 +1,365 @@
+/**
+ * \file hostSim.h
+ * \author Tim Robbins
+ * \brief Header file for building and running the library on a Linux host against simulated peripherals. \n
+ * The headers in host/ stand in for avr-libc. Every register with behaviour behind it is a HostReg8 or HostReg16, \n
+ * whose reads and writes run the peripheral models in hostSim.cpp, so the drivers compile and run without changes. \n
+ * Each register access takes HOST_SIM_ACCESS_CYCLES of simulated time, which is what moves busy wait loops along. \n
+ * Interrupt flags are checked after each access and the driver's ISR is called when it is enabled and SREG_I is set. \n
+ *
+ * The simulated part is an ATmega32M1 with a USART0, USART1 and TWI added: \n
+ * Timer0, Timer1, ADC, SPI, CAN with 6 MObs, LIN/UART, pin change interrupts, USART0/1 and TWI. \n
+ * The GPIO port, pin and direction registers are plain variables, so PINx is set from the test with HostGpioSetPin. \n
+ *
+ * Everything is built as C++ since the registers are classes. avr/io.h is forced in first for the files that check for a register before including anything. \n
+ * Example build: \n
+ *
+ * g++ -x c++ -D__AVR -D__AVR_ATmega32M1__ -include avr/io.h -Ihost -I. -o test test.cpp mcuAdc.c avr_can.cpp -x none host/hostSim.cpp \n
+ *
+ * The tests in host/tests are built and run with make -C host test, each checking with the macros in hostTest.h. \n
+ * The benchmarks in host/bench are built and run with make -C host bench, which fails if any went over its budget. \n
+ *
+ * Example use: \n
+ *
+ * HostSimReset(); \n
+ * HostAdcSetInput(3, 512); \n
+ * ADC_enable(); \n
+ * value = AdcGet(3); \n
+ * ... \n
+ * HostCanInject(&frame); \n
+ * HostSimRunMilliseconds(2); \n
+ * CAN_process_frame(OnFrame); \n
+ *
+ * The simulation also keeps a cost model: cycles, register reads and writes, busy wait polls, bytes on the buses and ISRs run. \n
+ * HostBenchRun calls a piece of code a number of times, prints its cost per call, and fails if it went over its cycle budget: \n
+ *
+ * static void BenchUpdate(void* arg) { SSD1306Update(); } \n
+ * ... \n
+ * const HostBench_t bench = { "SSD1306Update", BenchUpdate, 0, 10, 250000 }; \n
+ * if(!HostBenchRun(&bench, 0)) return 1; \n
+ *
+ * Built as it is, plain computation such as a CRC touches no registers and so costs no simulated cycles. \n
+ * Library sources built with -fsanitize-coverage=trace-pc, as make -C host bench does, also have every basic block they run counted \n
+ * and charged HOST_SIM_BLOCK_CYCLES, so loops and computation are costed too, and register accesses drop to HOST_SIM_IO_CYCLES. \n
+ * Giving a benchmark the bytes it handles per call also times it on the host and prints its throughput there, to compare ways of doing the same work. \n
+ */
+#ifndef HOST_SIM_H_
+#define HOST_SIM_H_ 1
+
+#ifndef __cplusplus
+#error hostSim.h: the host build has to be compiled as C++ (g++ -x c++)
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+///The number of core cycles each register access takes, about one pass of a loop polling a flag on the part
+#ifndef HOST_SIM_ACCESS_CYCLES
+#define HOST_SIM_ACCESS_CYCLES			8
+#endif
+
+///The number of core cycles each register access takes in code that has its basic blocks counted, where the loop around it is charged separately
+#ifndef HOST_SIM_IO_CYCLES
+#define HOST_SIM_IO_CYCLES				2
+#endif
+
+///The number of core cycles charged for each basic block run in code built with -fsanitize-coverage=trace-pc, about the few instructions and branch of a block on the part
+#ifndef HOST_SIM_BLOCK_CYCLES
+#define HOST_SIM_BLOCK_CYCLES			4
+#endif
+
+///The most cycles run before the interrupt flags are checked while delaying or sleeping
+#ifndef HOST_SIM_SLICE_CYCLES
+#define HOST_SIM_SLICE_CYCLES			16
+#endif
+
+///The longest a sleep without a wake up source lasts, in cycles, before it gives up and returns
+#ifndef HOST_SIM_SLEEP_LIMIT
+#define HOST_SIM_SLEEP_LIMIT			100000000UL
+#endif
+
+///The size of the receive queues for injected serial and CAN traffic and of the transmit logs
+#ifndef HOST_SIM_QUEUE_SIZE
+#define HOST_SIM_QUEUE_SIZE				256
+#endif
+
+///The number of devices that can be attached to the simulated TWI bus
+#ifndef HOST_TWI_MAX_DEVICES
+#define HOST_TWI_MAX_DEVICES			4
+#endif
+
+///The number of message objects in the simulated CAN controller
+#define HOST_CAN_MOB_QUANTITY			6
+
+///The number of simulated USARTs
+#define HOST_UART_QUANTITY				2
+
+///Index used with the HostUart functions for the LIN/UART peripheral
+#define HOST_UART_LIN					HOST_UART_QUANTITY
+
+///How far, in percent, a benchmark can go over its cycle budget before it fails
+#ifndef HOST_BENCH_TOLERANCE
+#define HOST_BENCH_TOLERANCE			10
+#endif
+
+
+extern "C++" {
+
+class HostReg16;
+
+/**
+ * \brief An 8 bit peripheral register. Reads and writes call the hooks set for it, or just use the stored value when there are none
+ */
+class HostReg8
+{
+	public:
+
+	///Read hook, returns the value of the register
+	typedef uint8_t (*ReadHook_t)(HostReg8& reg);
+
+	///Write hook, takes the value written to the register
+	typedef void (*WriteHook_t)(HostReg8& reg, uint8_t value);
+
+	HostReg8(const char* regName, ReadHook_t readHook = 0, WriteHook_t writeHook = 0, uint8_t regIndex = 0, uint8_t reset = 0, HostReg16* wideReg = 0);
+
+	operator uint8_t() const;
+	HostReg8& operator=(int newValue);
+	HostReg8& operator=(const HostReg8& other)	{ return *this = (uint8_t)other; }
+	HostReg8& operator|=(int v)					{ return *this = (uint8_t)(*this | v); }
+	HostReg8& operator&=(int v)					{ return *this = (uint8_t)(*this & v); }
+	HostReg8& operator^=(int v)					{ return *this = (uint8_t)(*this ^ v); }
+	HostReg8& operator+=(int v)					{ return *this = (uint8_t)(*this + v); }
+	HostReg8& operator-=(int v)					{ return *this = (uint8_t)(*this - v); }
+	HostReg8& operator<<=(int v)				{ return *this = (uint8_t)(*this << v); }
+	HostReg8& operator>>=(int v)				{ return *this = (uint8_t)(*this >> v); }
+	HostReg8& operator++()						{ return *this += 1; }
+	HostReg8& operator--()						{ return *this -= 1; }
+	uint8_t operator++(int)						{ uint8_t v = *this; *this = (uint8_t)(v + 1); return v; }
+	uint8_t operator--(int)						{ uint8_t v = *this; *this = (uint8_t)(v - 1); return v; }
+
+	///The stored value, which the models use directly so they don't count as accesses
+	uint8_t value;
+
+	///The register's name
+	const char* name;
+
+	///Hook for reads, 0 to read value
+	ReadHook_t onRead;
+
+	///Hook for writes, 0 to store to value
+	WriteHook_t onWrite;
+
+	///Which register of a group sharing the same hooks this is
+	uint8_t index;
+
+	///The value after a reset
+	uint8_t resetValue;
+
+	///The 16 bit register this is the high or low byte of, or 0
+	HostReg16* wide;
+
+	///The next register in the list of all registers
+	HostReg8* next;
+
+	private:
+	HostReg8(const HostReg8&);
+};
+
+
+/**
+ * \brief A 16 bit peripheral register, with the same behaviour as HostReg8
+ */
+class HostReg16
+{
+	public:
+
+	///Read hook, returns the value of the register
+	typedef uint16_t (*ReadHook_t)(HostReg16& reg);
+
+	///Write hook, takes the value written to the register
+	typedef void (*WriteHook_t)(HostReg16& reg, uint16_t value);
+
+	HostReg16(const char* regName, ReadHook_t readHook = 0, WriteHook_t writeHook = 0, uint8_t regIndex = 0, uint16_t reset = 0);
+
+	operator uint16_t() const;
+	HostReg16& operator=(int newValue);
+	HostReg16& operator=(const HostReg16& other)	{ return *this = (uint16_t)other; }
+	HostReg16& operator|=(int v)					{ return *this = (uint16_t)(*this | v); }
+	HostReg16& operator&=(int v)					{ return *this = (uint16_t)(*this & v); }
+	HostReg16& operator^=(int v)					{ return *this = (uint16_t)(*this ^ v); }
+	HostReg16& operator+=(int v)					{ return *this = (uint16_t)(*this + v); }
+	HostReg16& operator-=(int v)					{ return *this = (uint16_t)(*this - v); }
+
+	///The stored value
+	uint16_t value;
+
+	///The register's name
+	const char* name;
+
+	///Hook for reads, 0 to read value
+	ReadHook_t onRead;
+
+	///Hook for writes, 0 to store to value
+	WriteHook_t onWrite;
+
+	///Which register of a group sharing the same hooks this is
+	uint8_t index;
+
+	///The value after a reset
+	uint16_t resetValue;
+
+	///The next register in the list of all registers
+	HostReg16* next;
+
+	private:
+	HostReg16(const HostReg16&);
+};
+
+}
+
+
+/**
+ * \brief A CAN frame put on or taken off the simulated bus
+ */
+typedef struct _HOST_CAN_FRAME_
+{
+	uint32_t id;		///The 11 or 29 bit identifier
+	uint8_t extended;	///1 for a 29 bit identifier
+	uint8_t remote;		///1 for a remote frame
+	uint8_t length;		///The data length code, 0-8
+	uint8_t data[8];	///The data bytes
+} 
+/** \brief A CAN frame put on or taken off the simulated bus */
+HostCanFrame_t;
+
+
+///Called with a byte as it finishes sending from a simulated USART or the LIN/UART
+typedef void (*HostUartTxHook_t)(uint8_t uart, uint8_t data);
+
+///Called with a CAN frame once it has been sent, from inside the register access that finished it
+typedef void (*HostCanTxHook_t)(const HostCanFrame_t* frame);
+
+///Called with the protected identifier of a LIN header once it has been sent
+typedef void (*HostLinHeaderHook_t)(uint8_t protectedId);
+
+///Returns the next byte an SPI slave shifts out, given the byte shifted in
+typedef uint8_t (*HostSpiResponder_t)(uint8_t dataIn);
+
+///Returns the 10 bit reading for an ADC channel at the time of the conversion
+typedef uint16_t (*HostAdcSource_t)(uint8_t channel);
+
+///The code run by a benchmark
+typedef void (*HostBenchFunc_t)(void* arg);
+
+
+/**
+ * \brief Cost of the code run, in the terms of the simulation
+ */
+typedef struct _HOST_SIM_COST_
+{
+	uint64_t cycles;		///Simulated core cycles, including delays and ISRs
+	uint32_t reads;			///Register reads
+	uint32_t writes;		///Register writes
+	uint32_t polls;			///Reads of the same register giving the same value as the read before, the busy wait iterations
+	uint32_t busBytes;		///Bytes sent or received over SPI, TWI, the USARTs, LIN and CAN
+	uint32_t interrupts;	///ISRs run
+	uint32_t blocks;		///Basic blocks run in code built with -fsanitize-coverage=trace-pc
+} 
+/** \brief Cost of the code run, in the terms of the simulation */
+HostSimCost_t;
+
+
+/**
+ * \brief A benchmark of a hot path
+ */
+typedef struct _HOST_BENCH_
+{
+	const char* name;		///Name for the report
+	HostBenchFunc_t run;	///The code to measure
+	void* arg;				///Passed to run
+	uint16_t calls;			///Number of times to call run, the cost is the average
+	uint32_t cycleBudget;	///Most cycles per call before the benchmark fails, past HOST_BENCH_TOLERANCE. 0 for no budget
+	uint32_t bytes;			///Bytes handled per call, for the host throughput. 0 to leave it out
+} 
+/** \brief A benchmark of a hot path */
+HostBench_t;
+
+
+/**
+ * \brief A device on the simulated TWI bus. Any of the callbacks can be 0
+ */
+typedef struct _HOST_TWI_DEVICE_
+{
+	uint8_t address;						///The 7 bit address
+	void (*start)(bool read);				///Called when the device is addressed
+	bool (*write)(uint8_t data);			///Takes a byte written to the device, returns true to acknowledge it
+	uint8_t (*read)(bool ack);				///Returns the next byte read from the device. ack is false for the last byte
+	void (*stop)(void);						///Called on a stop condition
+} 
+/** \brief A device on the simulated TWI bus */
+HostTwiDevice_t;
+
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+//Core
+extern void HostSimReset(void);
+extern uint64_t HostSimCycles(void);
+extern void HostSimRun(uint32_t cycles);
+extern void HostSimRunMicroseconds(uint32_t us);
+extern void HostSimRunMilliseconds(uint32_t ms);
+extern void HostSimDelayCycles(double cycles);
+extern void HostSimSleep(void);
+extern void HostSimInterruptsOn(void);
+extern void HostSimInterruptsOff(void);
+extern uint8_t HostSimAtomicEnter(void);
+extern void HostSimAtomicExit(uint8_t sreg);
+extern uint32_t HostSimUnhandledInterrupts(void);
+
+//Cost model
+extern void HostSimCostGet(HostSimCost_t* cost);
+extern void HostSimCostSince(const HostSimCost_t* start, HostSimCost_t* cost);
+extern bool HostBenchRun(const HostBench_t* bench, HostSimCost_t* perCall);
+
+//GPIO
+extern void HostGpioSetPin(volatile uint8_t* pinRegister, uint8_t pin, bool level);
+
+//USART and LIN/UART
+extern void HostUartInject(uint8_t uart, const uint8_t* data, uint16_t length);
+extern uint16_t HostUartTake(uint8_t uart, uint8_t* buffer, uint16_t size);
+extern void HostUartSetTxHook(HostUartTxHook_t hook);
+
+//SPI
+extern void HostSpiSetResponder(HostSpiResponder_t responder);
+extern uint32_t HostSpiTransfers(void);
+
+//TWI
+extern bool HostTwiAttach(const HostTwiDevice_t* device);
+extern void HostTwiDetachAll(void);
+
+//ADC
+extern void HostAdcSetInput(uint8_t channel, uint16_t value);
+extern void HostAdcSetSource(HostAdcSource_t source);
+extern uint32_t HostAdcConversions(void);
+
+//CAN
+extern bool HostCanInject(const HostCanFrame_t* frame);
+extern bool HostCanTake(HostCanFrame_t* frame);
+extern void HostCanSetTxHook(HostCanTxHook_t hook);
+extern void HostCanSetErrorCounters(uint8_t tec, uint8_t rec);
+extern void HostCanFailTransmits(uint8_t errorBits, uint8_t count);
+extern void HostCanSetBusOff(bool busOff);
+extern uint32_t HostCanLost(void);
+
+//LIN
+extern void HostLinInjectHeader(uint8_t id);
+extern void HostLinInjectResponse(const uint8_t* data, uint8_t length);
+extern void HostLinSetHeaderHook(HostLinHeaderHook_t hook);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,72 @@
+/**
+ * \file hostTest.h
+ * \author Tim Robbins
+ * \brief Header file for the checks used by the host tests in host/tests. \n
+ * A test is a program built against hostSim.cpp that runs a driver against the simulated peripherals and returns nonzero when a check failed. \n
+ * A failed check prints where it was and carries on, so one run reports every failure. \n
+ *
+ * Example use: \n
+ *
+ * int main() \n
+ * { \n
+ * 	HostSimReset(); \n
+ * 	HostAdcSetInput(3, 512); \n
+ * 	ADC_enable(); \n
+ * 	HOST_CHECK_EQUAL(AdcGet(3), 512); \n
+ * 	return HostTestResult("adc"); \n
+ * } \n
+ */
+#ifndef HOST_TEST_H_
+#define HOST_TEST_H_ 1
+
+#include <stdio.h>
+
+///The number of checks failed so far
+static unsigned int m_uintHostTestFailures = 0;
+
+///The number of checks run so far
+static unsigned int m_uintHostTestChecks = 0;
+
+
+/**
+ * \brief Checks a condition is true, printing it and counting a failure if not
+ */
+#define HOST_CHECK(condition)																		\
+	do {																							\
+		m_uintHostTestChecks++;																		\
+		if(!(condition)) {																			\
+			printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);					\
+			m_uintHostTestFailures++;																\
+		}																							\
+	} while(0)
+
+
+/**
+ * \brief Checks two integers are equal, printing both if not
+ */
+#define HOST_CHECK_EQUAL(actual, expected)															\
+	do {																							\
+		long long hostActual = (long long)(actual);													\
+		long long hostExpected = (long long)(expected);												\
+		m_uintHostTestChecks++;																		\
+		if(hostActual != hostExpected) {															\
+			printf("%s:%d: check failed: %s is %lld, expected %s, %lld\n",							\
+				__FILE__, __LINE__, #actual, hostActual, #expected, hostExpected);					\
+			m_uintHostTestFailures++;																\
+		}																							\
+	} while(0)
+
+
+/**
+ * \brief Prints how the test went
+ * \param name The test's name for the report
+ * \return 0 if every check passed, 1 if not, to return from main
+ */
+static inline int HostTestResult(const char* name)
+{
+	printf("%s: %u checks, %u failed\n", name, m_uintHostTestChecks, m_uintHostTestFailures);
+	return (m_uintHostTestFailures == 0) ? 0 : 1;
+}
+
+
+#endif
@@ -0,0 +1,265 @@
+/**
+ * \file adcFilterTest.cpp
+ * \author Tim Robbins
+ * \brief Runs the ADC filters over synthetic signals: a step, a noisy constant and a constant with spikes in it. \n
+ * Also checks the moving average's window range check and that attaching a filter to a scanned channel resets it. \n
+ */
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdlib.h>
+#include "hostSim.h"
+#include "hostTest.h"
+#include "mcuAdc.h"
+
+
+///The state of the noise generator, a fixed seed so every run sees the same signal
+static uint32_t m_ulNoiseState = 12345;
+
+
+/**
+ * \brief Gives the next value of a noisy constant, the level plus or minus up to amplitude
+ */
+static uint16_t Noisy(uint16_t level, uint8_t amplitude)
+{
+	m_ulNoiseState = m_ulNoiseState * 1103515245UL + 12345UL;
+	return (uint16_t)(level + (int16_t)((m_ulNoiseState >> 16) % (2 * amplitude + 1)) - amplitude);
+}
+
+
+static void TestStep(void)
+{
+	//Variables
+	AdcFilter_t filter;
+	uint16_t output = 0;
+	uint16_t last = 0;
+
+	//The average settles on the first sample, then moves a window's share of the step per sample
+	HOST_CHECK(AdcFilterInitAverage(&filter, 3));
+	for(uint8_t i = 0; i < 8; i++) AdcFilterProcess(&filter, 100, &output);
+	HOST_CHECK_EQUAL(output, 100);
+	for(uint8_t i = 0; i < 4; i++) AdcFilterProcess(&filter, 900, &output);
+	HOST_CHECK_EQUAL(output, 500);
+	for(uint8_t i = 0; i < 4; i++) AdcFilterProcess(&filter, 900, &output);
+	HOST_CHECK_EQUAL(output, 900);
+
+	//The IIR rises toward the step without overshooting and gets there
+	AdcFilterInitIir(&filter, 2);
+	AdcFilterProcess(&filter, 100, &output);
+	HOST_CHECK_EQUAL(output, 100);
+	last = output;
+	for(uint8_t i = 0; i < 40; i++)
+	{
+		AdcFilterProcess(&filter, 900, &output);
+		HOST_CHECK(output >= last && output <= 900);
+		last = output;
+	}
+	HOST_CHECK(output >= 899);
+
+	//The median follows a step once more than half its window is past it
+	AdcFilterInitMedian(&filter, 5);
+	for(uint8_t i = 0; i < 5; i++) AdcFilterProcess(&filter, 100, &output);
+	AdcFilterProcess(&filter, 900, &output);
+	AdcFilterProcess(&filter, 900, &output);
+	HOST_CHECK_EQUAL(output, 100);
+	AdcFilterProcess(&filter, 900, &output);
+	HOST_CHECK_EQUAL(output, 900);
+}
+
+
+static void TestNoise(void)
+{
+	//Variables
+	AdcFilter_t filter;
+	uint16_t output = 0;
+	uint16_t outputs = 0;
+	int16_t worst = 0;
+
+	//A 16 sample average of noise of up to 32 stays well inside it
+	HOST_CHECK(AdcFilterInitAverage(&filter, 4));
+	for(uint16_t i = 0; i < 1000; i++)
+	{
+		AdcFilterProcess(&filter, Noisy(512, 32), &output);
+		if(i >= 16 && abs((int16_t)output - 512) > worst) worst = (int16_t)abs((int16_t)output - 512);
+	}
+	HOST_CHECK(worst <= 20);
+
+	//The IIR smooths it as well
+	worst = 0;
+	AdcFilterInitIir(&filter, 4);
+	for(uint16_t i = 0; i < 1000; i++)
+	{
+		AdcFilterProcess(&filter, Noisy(512, 32), &output);
+		if(i >= 64 && abs((int16_t)output - 512) > worst) worst = (int16_t)abs((int16_t)output - 512);
+	}
+	HOST_CHECK(worst <= 20);
+
+	//Oversampling by 2 bits gives an output every 16 samples, 4 times the level, the noise working as dither
+	worst = 0;
+	AdcFilterInitOversample(&filter, 2);
+	for(uint16_t i = 0; i < 1600; i++)
+	{
+		if(AdcFilterProcess(&filter, Noisy(512, 32), &output))
+		{
+			outputs++;
+			if(abs((int16_t)output - 2048) > worst) worst = (int16_t)abs((int16_t)output - 2048);
+		}
+	}
+	HOST_CHECK_EQUAL(outputs, 100);
+	HOST_CHECK(worst <= 64);
+}
+
+
+static void TestSpikes(void)
+{
+	//Variables
+	AdcFilter_t filter;
+	uint16_t output = 0;
+	uint16_t highest = 0;
+
+	//Single sample spikes at either rail never get through a median of 5
+	AdcFilterInitMedian(&filter, 5);
+	for(uint16_t i = 0; i < 200; i++)
+	{
+		uint16_t sample = (i % 7 == 3) ? 1023 : ((i % 11 == 5) ? 0 : 500);
+
+		AdcFilterProcess(&filter, sample, &output);
+		if(i >= 5) HOST_CHECK_EQUAL(output, 500);
+	}
+
+	//The average lets an eighth of a spike through
+	HOST_CHECK(AdcFilterInitAverage(&filter, 3));
+	for(uint16_t i = 0; i < 16; i++) AdcFilterProcess(&filter, 500, &output);
+	for(uint16_t i = 0; i < 9; i++)
+	{
+		AdcFilterProcess(&filter, (i == 0) ? 1012 : 500, &output);
+		if(output > highest) highest = output;
+	}
+	HOST_CHECK_EQUAL(highest, 564);
+	HOST_CHECK_EQUAL(output, 500);
+}
+
+
+static void TestRangeChecks(void)
+{
+	//Variables
+	AdcFilter_t filter;
+	uint16_t output = 0;
+
+	HOST_CHECK(AdcFilterInitAverage(&filter, 4));
+
+	//Too large a window is refused and leaves the filter as it was
+	HOST_CHECK(!AdcFilterInitAverage(&filter, 5));
+	HOST_CHECK(!AdcFilterInitAverage(&filter, 31));
+	HOST_CHECK(!AdcFilterInitAverage(&filter, 200));
+	HOST_CHECK_EQUAL(filter.length, 16);
+
+	AdcFilterProcess(&filter, 300, &output);
+	HOST_CHECK_EQUAL(output, 300);
+}
+
+
+static void TestScanAttachResets(void)
+{
+	//Variables
+	const adc_channel_t channels[] = { (adc_channel_t)2 };
+	AdcFilter_t filter;
+	uint16_t output = 0;
+	uint16_t value = 0;
+	bool gotValue = false;
+
+	HostSimReset();
+	HostAdcSetInput(2, 800);
+	ADC_enable();
+	sei();
+
+	//A filter that has seen a different signal starts over when attached
+	HOST_CHECK(AdcFilterInitAverage(&filter, 2));
+	AdcFilterProcess(&filter, 10, &output);
+	HOST_CHECK(filter.count != 0);
+
+	HOST_CHECK_EQUAL(AdcScanInit(channels, 1, ADC_SCAN_TRIGGER_CHAINED), 1);
+	AdcScanSetFilter(0, &filter);
+	HOST_CHECK_EQUAL(filter.count, 0);
+
+	AdcScanStart();
+	HostSimRunMilliseconds(2);
+	AdcScanStop();
+
+	while(AdcScanRead(0, &value))
+	{
+		gotValue = true;
+		HOST_CHECK_EQUAL(value, 800);
+	}
+	HOST_CHECK(gotValue);
+}
+
+
+/**
+ * \brief Scans three channels with different inputs and checks every result lands under its own channel
+ */
+static void TestScanChannels(uint8_t trigger)
+{
+	//Variables
+	const adc_channel_t channels[] = { (adc_channel_t)1, (adc_channel_t)4, (adc_channel_t)6 };
+	const uint16_t inputs[] = { 100, 500, 900 };
+	uint16_t value = 0;
+	uint8_t results = 0;
+
+	HostSimReset();
+	for(uint8_t i = 0; i < 3; i++) HostAdcSetInput(channels[i], inputs[i]);
+	ADCSRA = (1 << ADEN) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);
+	sei();
+
+	HOST_CHECK_EQUAL(AdcScanInit(channels, 3, trigger), 3);
+	AdcScanStart();
+	HostSimRunMilliseconds(4);
+	AdcScanStop();
+
+	for(uint8_t i = 0; i < 3; i++)
+	{
+		results = 0;
+
+		while(AdcScanRead(i, &value))
+		{
+			results++;
+			HOST_CHECK_EQUAL(value, inputs[i]);
+		}
+
+		HOST_CHECK(results > 2);
+	}
+}
+
+
+static void TestControlKeepsFlag(void)
+{
+	HostSimReset();
+	ADC_enable();
+	ADC_start_conversion();
+	HostSimRunMilliseconds(1);
+	HOST_CHECK(ADCSRA & (1 << ADIF));
+
+	//Setting and clearing other bits leaves a result not yet taken
+	ADC_enable_auto_trigger();
+	ADC_disable_auto_trigger();
+	ADC_enable_interrupt();
+	ADC_disable_interrupt();
+	HOST_CHECK(ADCSRA & (1 << ADIF));
+
+	ADC_clear_interrupt_flag();
+	HOST_CHECK((ADCSRA & (1 << ADIF)) == 0);
+}
+
+
+int main()
+{
+	TestStep();
+	TestNoise();
+	TestSpikes();
+	TestRangeChecks();
+	TestScanAttachResets();
+	TestScanChannels(ADC_SCAN_TRIGGER_CHAINED);
+	TestScanChannels(ADC_SCAN_TRIGGER_FREE_RUNNING);
+	TestControlKeepsFlag();
+
+	return HostTestResult("adcFilterTest");
+}
@@ -0,0 +1,331 @@
+/**
+ * \file canGatewayTest.cpp
+ * \author Tim Robbins
+ * \brief Runs canGateway between the simulated CAN bus and the LIN/UART, decoding the packets the way the host would. \n
+ * Bus to UART, frames of every length with standard and extended ids are checked to arrive whole, in order and in time order. \n
+ * UART to bus, frames sent by the host go out, filters set by the host are applied, the status packet carries the counters \n
+ * and a packet with a bad check is counted and ignored. \n
+ */
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <string.h>
+#include "hostSim.h"
+#include "hostTest.h"
+#include "avrCanUtilities.h"
+#include "canGateway.h"
+
+
+///The frames sent over the bus in the bus to UART test
+#define TEST_FRAMES					300
+
+///The bytes of serial output kept
+#define TEST_SERIAL_SIZE			8192
+
+
+typedef struct _TEST_RECORD_
+{
+	uint32_t id;
+	uint8_t extended;
+	uint8_t length;
+	uint8_t data[8];
+	uint32_t time;
+}
+/**
+* \brief Struct for a frame record decoded from a packet
+*/
+TestRecord_t;
+
+
+///The bytes the gateway sent to the host
+static uint8_t m_uchrSerial[TEST_SERIAL_SIZE];
+static uint16_t m_uintSerialLength = 0;
+
+///Where decoding is up to in m_uchrSerial
+static uint16_t m_uintDecoded = 0;
+
+///The frame records decoded
+static TestRecord_t m_records[TEST_FRAMES];
+static uint16_t m_uintRecordCount = 0;
+
+///Packets that didn't decode
+static uint16_t m_uintBadPackets = 0;
+
+///The payload of the last status packet, and how many came
+static uint8_t m_uchrStatus[32];
+static uint8_t m_uchrStatusCount = 0;
+
+
+static void OnSerial(uint8_t uart, uint8_t data)
+{
+	if(uart == HOST_UART_LIN && m_uintSerialLength < TEST_SERIAL_SIZE) m_uchrSerial[m_uintSerialLength++] = data;
+}
+
+
+///Reads a little endian value
+static uint32_t Value(const uint8_t* bytes, uint8_t length)
+{
+	//Variables
+	uint32_t value = 0;
+
+	while(length-- != 0) value = (value << 8) | bytes[length];
+	return value;
+}
+
+
+/**
+ * \brief Decodes the whole packets sent since the last call
+ */
+static void Decode(void)
+{
+	//Variables
+	const uint8_t* packet;
+	const uint8_t* payload;
+	uint8_t type, length, sum, at;
+	uint32_t base;
+	TestRecord_t* record;
+
+	while(m_uintDecoded + 4 <= m_uintSerialLength)
+	{
+		packet = &m_uchrSerial[m_uintDecoded];
+
+		if(packet[0] != CAN_GATEWAY_SYNC)
+		{
+			m_uintBadPackets++;
+			m_uintDecoded++;
+			continue;
+		}
+
+		type = packet[1];
+		length = packet[2];
+		if(m_uintDecoded + 4 + length > m_uintSerialLength) return;
+
+		sum = type + length;
+		for(uint16_t i = 0; i <= length; i++) sum += packet[3 + i];
+
+		if(sum != 0)
+		{
+			m_uintBadPackets++;
+			m_uintDecoded++;
+			continue;
+		}
+
+		payload = &packet[3];
+
+		if(type == CAN_GATEWAY_FRAMES)
+		{
+			base = Value(payload, 4);
+			at = 4;
+
+			while(at < length && m_uintRecordCount < TEST_FRAMES)
+			{
+				record = &m_records[m_uintRecordCount++];
+				record->length = payload[at] & CAN_GATEWAY_LENGTH_MASK;
+				record->extended = (payload[at] & CAN_GATEWAY_EXTENDED) ? 1 : 0;
+				record->time = base + (uint16_t)(Value(&payload[at + 1], 2) - (uint16_t)base);
+				at += 3;
+				record->id = Value(&payload[at], record->extended ? 4 : 2);
+				at += record->extended ? 4 : 2;
+				memcpy(record->data, &payload[at], record->length);
+				at += record->length;
+			}
+		}
+		else if(type == CAN_GATEWAY_STATUS)
+		{
+			memcpy(m_uchrStatus, payload, length);
+			m_uchrStatusCount++;
+		}
+
+		m_uintDecoded += 4 + length;
+	}
+}
+
+
+///Clears the serial output and the decoded records
+static void ClearSerial(void)
+{
+	m_uintSerialLength = 0;
+	m_uintDecoded = 0;
+	m_uintRecordCount = 0;
+	m_uintBadPackets = 0;
+}
+
+
+///Sends a packet from the host, with a check byte that's off by the error given
+static void HostSend(uint8_t type, const uint8_t* payload, uint8_t length, uint8_t error)
+{
+	//Variables
+	uint8_t packet[CAN_GATEWAY_COMMAND_MAX + 4];
+	uint8_t sum = type + length;
+
+	packet[0] = CAN_GATEWAY_SYNC;
+	packet[1] = type;
+	packet[2] = length;
+
+	for(uint8_t i = 0; i < length; i++)
+	{
+		packet[3 + i] = payload[i];
+		sum += payload[i];
+	}
+
+	packet[3 + length] = (uint8_t)(0 - sum + error);
+	HostUartInject(HOST_UART_LIN, packet, length + 4);
+}
+
+
+///Runs the gateway for some milliseconds, polling it as the main loop would
+static void Run(uint16_t milliseconds)
+{
+	for(uint16_t i = 0; i < milliseconds * 5; i++)
+	{
+		HostSimRunMicroseconds(200);
+		CanGatewayPoll();
+	}
+
+	Decode();
+}
+
+
+///The frame sent n-th in the bus to UART test. Every length from 0 to 8, every third id extended
+static void TestFrame(uint16_t n, HostCanFrame_t* frame)
+{
+	memset(frame, 0, sizeof(HostCanFrame_t));
+	frame->extended = (n % 3 == 0);
+	frame->id = frame->extended ? ((0x1234567UL + n) & 0x1FFFFFFF) : ((0x100 + n) & 0x7FF);
+	frame->length = n % 9;
+	for(uint8_t i = 0; i < 8; i++) frame->data[i] = (uint8_t)(n * 7 + i);
+}
+
+
+static void TestBusToUart(void)
+{
+	//Variables
+	HostCanFrame_t frame;
+	uint16_t injected = 0;
+	uint16_t mismatches = 0;
+	TestRecord_t* record;
+	CanGatewayStats_t stats;
+
+	//Put the frames on the bus as fast as the receive MObs take them
+	ClearSerial();
+
+	for(uint16_t loop = 0; loop < 20000 && m_uintRecordCount < TEST_FRAMES; loop++)
+	{
+		while(injected < TEST_FRAMES)
+		{
+			TestFrame(injected, &frame);
+			if(HostCanInject(&frame) == false) break;
+			injected++;
+		}
+
+		HostSimRunMicroseconds(200);
+		CanGatewayPoll();
+		Decode();
+	}
+
+	Run(5);
+
+	HOST_CHECK_EQUAL(injected, TEST_FRAMES);
+	HOST_CHECK_EQUAL(m_uintRecordCount, TEST_FRAMES);
+	HOST_CHECK_EQUAL(m_uintBadPackets, 0);
+
+	for(uint16_t i = 0; i < m_uintRecordCount; i++)
+	{
+		record = &m_records[i];
+		TestFrame(i, &frame);
+
+		if(record->id != frame.id || record->extended != frame.extended || record->length != frame.length
+			|| memcmp(record->data, frame.data, frame.length) != 0 || (i != 0 && record->time < m_records[i - 1].time))
+		{
+			mismatches++;
+		}
+	}
+
+	HOST_CHECK_EQUAL(mismatches, 0);
+
+	CanGatewayGetStats(&stats);
+	HOST_CHECK_EQUAL(stats.forwarded, TEST_FRAMES);
+	HOST_CHECK_EQUAL(stats.dropped, 0);
+	HOST_CHECK_EQUAL(stats.badPackets, 0);
+}
+
+
+static void TestUartToBus(void)
+{
+	//Variables
+	const uint8_t standard[] = { 0x03, 0x23, 0x01, 0xAA, 0xBB, 0xCC };
+	const uint8_t extended[] = { 0x82, 0x67, 0x45, 0x23, 0x11, 0x5A, 0xA5 };
+	const uint8_t filter[] = { 0, CAN_GATEWAY_FILTER_ENABLE, 0x00, 0x02, 0, 0, 0xF0, 0x07, 0, 0 };
+	HostCanFrame_t frame;
+	CanGatewayStats_t stats;
+
+	//Frames from the host go onto the bus
+	HostSend(CAN_GATEWAY_SEND, standard, sizeof(standard), 0);
+	Run(2);
+	HOST_CHECK(HostCanTake(&frame));
+	HOST_CHECK_EQUAL(frame.id, 0x123);
+	HOST_CHECK_EQUAL(frame.extended, 0);
+	HOST_CHECK_EQUAL(frame.length, 3);
+	HOST_CHECK_EQUAL(frame.data[0], 0xAA);
+	HOST_CHECK_EQUAL(frame.data[2], 0xCC);
+
+	HostSend(CAN_GATEWAY_SEND, extended, sizeof(extended), 0);
+	Run(2);
+	HOST_CHECK(HostCanTake(&frame));
+	HOST_CHECK_EQUAL(frame.id, 0x11234567);
+	HOST_CHECK_EQUAL(frame.extended, 1);
+	HOST_CHECK_EQUAL(frame.length, 2);
+	HOST_CHECK_EQUAL(frame.data[1], 0xA5);
+
+	//A bad check is counted and the frame isn't sent
+	HostSend(CAN_GATEWAY_SEND, standard, sizeof(standard), 1);
+	Run(2);
+	HOST_CHECK(HostCanTake(&frame) == false);
+	CanGatewayGetStats(&stats);
+	HOST_CHECK_EQUAL(stats.badPackets, 1);
+
+	//A filter on 0x200 to 0x20F passes only those
+	HostSend(CAN_GATEWAY_FILTER, filter, sizeof(filter), 0);
+	Run(2);
+	ClearSerial();
+
+	for(uint8_t i = 0; i < 32; i++)
+	{
+		memset(&frame, 0, sizeof(frame));
+		frame.id = 0x1F8 + i;
+		frame.length = 1;
+		HostCanInject(&frame);
+		Run(1);
+	}
+
+	Run(5);
+	HOST_CHECK_EQUAL(m_uintRecordCount, 16);
+	HOST_CHECK_EQUAL(m_records[0].id, 0x200);
+	HOST_CHECK_EQUAL(m_records[15].id, 0x20F);
+
+	//The status has the counters
+	HostSend(CAN_GATEWAY_GET_STATUS, 0, 0, 0);
+	Run(3);
+	HOST_CHECK_EQUAL(m_uchrStatusCount, 1);
+	HOST_CHECK_EQUAL(Value(&m_uchrStatus[2], 4), TEST_FRAMES + 16);
+	HOST_CHECK_EQUAL(Value(&m_uchrStatus[6], 4), 16);
+	HOST_CHECK_EQUAL(Value(&m_uchrStatus[10], 2), 0);
+	HOST_CHECK_EQUAL(Value(&m_uchrStatus[14], 2), 1);
+	HOST_CHECK_EQUAL(Value(&m_uchrStatus[16], 2), 0);
+}
+
+
+int main(void)
+{
+	HostSimReset();
+	HostUartSetTxHook(OnSerial);
+	CAN_init_tx(CAN_BPS_500K, false, 1);
+	HOST_CHECK(CanGatewayInit(1000000));
+	sei();
+
+	TestBusToUart();
+	TestUartToBus();
+
+	HOST_CHECK_EQUAL(HostSimUnhandledInterrupts(), 0);
+
+	return HostTestResult("canGateway");
+}
@@ -0,0 +1,377 @@
+/**
+ * \file canIsoTpTest.cpp
+ * \author Tim Robbins
+ * \brief Runs canIsoTp against a peer played by the test on the simulated CAN bus. \n
+ * Covers single frames and segmented transfers both ways, the sender honouring the block size, \n
+ * flow control waits and the wait limit, an overflow from either end, and the timeouts of both sides. \n
+ */
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <string.h>
+#include "hostSim.h"
+#include "hostTest.h"
+#include "avrCanUtilities.h"
+#include "canIsoTp.h"
+
+
+///The id the link sends with, the peer receives it
+#define TEST_TX_ID					0x7E8
+
+///The id the link receives with, the peer sends it
+#define TEST_RX_ID					0x7E0
+
+///No result passed to the done callback yet
+#define TEST_NO_RESULT				0xFF
+
+///The most frames the link may send in one pump
+#define TEST_MAX_SENT				64
+
+
+///The link under test
+static IsoTpLink_t m_link;
+
+///The payload byte the source fills next
+static uint32_t m_ulSourcePosition = 0;
+
+///The payload received by the sink
+static uint8_t m_uchrReceived[64];
+
+///The payload bytes received by the sink
+static uint32_t m_ulReceivedLength = 0;
+
+///If the sink refuses a new segmented transfer
+static bool m_bRefuse = false;
+
+///The result of the last send and receive, TEST_NO_RESULT until the done callback
+static uint8_t m_uchrTxResult = TEST_NO_RESULT;
+static uint8_t m_uchrRxResult = TEST_NO_RESULT;
+
+///The frames the link sent in the last pump
+static HostCanFrame_t m_sent[TEST_MAX_SENT];
+static uint8_t m_uchrSentCount = 0;
+
+
+///The byte at a position of the payload the source sends
+static uint8_t PayloadByte(uint32_t position)
+{
+	return (uint8_t)(position * 7 + 1);
+}
+
+
+static uint8_t Source(void* context, uint8_t* buffer, uint8_t length)
+{
+	for(uint8_t i = 0; i < length; i++) buffer[i] = PayloadByte(m_ulSourcePosition++);
+	return length;
+}
+
+
+static bool Sink(void* context, uint32_t offset, const uint8_t* data, uint8_t length, uint32_t total)
+{
+	if(offset == 0 && m_bRefuse) return false;
+	if(offset + length > sizeof(m_uchrReceived)) return false;
+	memcpy(&m_uchrReceived[offset], data, length);
+	m_ulReceivedLength = offset + length;
+	return true;
+}
+
+
+static void Done(void* context, bool transmit, uint8_t result)
+{
+	if(transmit) m_uchrTxResult = result;
+	else m_uchrRxResult = result;
+}
+
+
+static int8_t OnFrame(CAN_FRAME& frame)
+{
+	IsoTpReceive(&m_link, frame);
+	return 0;
+}
+
+
+///The simulated milliseconds since the reset
+static uint16_t Millis(void)
+{
+	return (uint16_t)(HostSimCycles() / (F_CPU / 1000UL));
+}
+
+
+/**
+ * \brief Runs the link and the bus for some milliseconds, keeping the frames it sent in m_sent
+ */
+static void Pump(uint16_t milliseconds)
+{
+	//Variables
+	uint16_t start = Millis();
+	HostCanFrame_t frame;
+
+	m_uchrSentCount = 0;
+
+	while((uint16_t)(Millis() - start) < milliseconds)
+	{
+		IsoTpPoll(&m_link, Millis());
+		HostSimRun(200);
+		CAN_process_frame(OnFrame);
+
+		while(HostCanTake(&frame))
+		{
+			HOST_CHECK(m_uchrSentCount < TEST_MAX_SENT);
+			if(m_uchrSentCount < TEST_MAX_SENT) m_sent[m_uchrSentCount++] = frame;
+		}
+	}
+}
+
+
+///Puts a frame from the peer on the bus, padded to 8 bytes
+static void PeerSend(const uint8_t* data, uint8_t length)
+{
+	//Variables
+	HostCanFrame_t frame = { TEST_RX_ID, 0, 0, 8, { 0 } };
+
+	memset(frame.data, ISOTP_PADDING, sizeof(frame.data));
+	memcpy(frame.data, data, length);
+	HOST_CHECK(HostCanInject(&frame));
+}
+
+
+///Puts a flow control from the peer on the bus
+static void PeerFlow(uint8_t status, uint8_t blockSize)
+{
+	//Variables
+	const uint8_t flow[3] = { (uint8_t)(0x30 | status), blockSize, 0 };
+
+	PeerSend(flow, sizeof(flow));
+}
+
+
+///Starts a send of some length from the start of the payload
+static void StartSend(uint32_t length)
+{
+	m_ulSourcePosition = 0;
+	m_uchrTxResult = TEST_NO_RESULT;
+	HOST_CHECK(IsoTpSend(&m_link, length));
+}
+
+
+static void TestSingleFrame(void)
+{
+	//Variables
+	const uint8_t single[4] = { 0x03, 0xA1, 0xA2, 0xA3 };
+
+	//A send of 5 goes as one padded frame and finishes once it's out
+	StartSend(5);
+	Pump(5);
+	HOST_CHECK_EQUAL(m_uchrSentCount, 1);
+	HOST_CHECK_EQUAL(m_sent[0].id, TEST_TX_ID);
+	HOST_CHECK_EQUAL(m_sent[0].length, 8);
+	HOST_CHECK_EQUAL(m_sent[0].data[0], 0x05);
+	for(uint8_t i = 0; i < 5; i++) HOST_CHECK_EQUAL(m_sent[0].data[1 + i], PayloadByte(i));
+	HOST_CHECK_EQUAL(m_sent[0].data[6], ISOTP_PADDING);
+	HOST_CHECK_EQUAL(m_sent[0].data[7], ISOTP_PADDING);
+	HOST_CHECK_EQUAL(m_uchrTxResult, ISOTP_RESULT_OK);
+	HOST_CHECK(IsoTpBusy(&m_link) == false);
+
+	//A single frame received goes to the sink whole, with no flow control sent
+	m_uchrRxResult = TEST_NO_RESULT;
+	PeerSend(single, sizeof(single));
+	Pump(5);
+	HOST_CHECK_EQUAL(m_uchrSentCount, 0);
+	HOST_CHECK_EQUAL(m_uchrRxResult, ISOTP_RESULT_OK);
+	HOST_CHECK_EQUAL(m_ulReceivedLength, 3);
+	HOST_CHECK_EQUAL(m_uchrReceived[0], 0xA1);
+	HOST_CHECK_EQUAL(m_uchrReceived[2], 0xA3);
+}
+
+
+static void TestMultiFrameSend(void)
+{
+	//Variables
+	uint32_t position = 6;
+
+	//30 bytes are a first frame with 6, then consecutive frames of 7, 7, 7 and 3
+	StartSend(30);
+	Pump(5);
+	HOST_CHECK_EQUAL(m_uchrSentCount, 1);
+	HOST_CHECK_EQUAL(m_sent[0].data[0], 0x10);
+	HOST_CHECK_EQUAL(m_sent[0].data[1], 30);
+	for(uint8_t i = 0; i < 6; i++) HOST_CHECK_EQUAL(m_sent[0].data[2 + i], PayloadByte(i));
+
+	//Nothing more until the flow control, then only the block asked for
+	Pump(20);
+	HOST_CHECK_EQUAL(m_uchrSentCount, 0);
+	PeerFlow(0, 2);
+	Pump(5);
+	HOST_CHECK_EQUAL(m_uchrSentCount, 2);
+	HOST_CHECK_EQUAL(m_uchrTxResult, TEST_NO_RESULT);
+
+	for(uint8_t frame = 0; frame < 2; frame++)
+	{
+		HOST_CHECK_EQUAL(m_sent[frame].data[0], 0x21 + frame);
+		for(uint8_t i = 1; i < 8; i++) HOST_CHECK_EQUAL(m_sent[frame].data[i], PayloadByte(position++));
+	}
+
+	//A block size of 0 lets the rest go
+	PeerFlow(0, 0);
+	Pump(5);
+	HOST_CHECK_EQUAL(m_uchrSentCount, 2);
+	HOST_CHECK_EQUAL(m_sent[0].data[0], 0x23);
+	HOST_CHECK_EQUAL(m_sent[1].data[0], 0x24);
+	for(uint8_t i = 1; i < 8; i++) HOST_CHECK_EQUAL(m_sent[0].data[i], PayloadByte(position++));
+	for(uint8_t i = 1; i < 4; i++) HOST_CHECK_EQUAL(m_sent[1].data[i], PayloadByte(position++));
+	HOST_CHECK_EQUAL(m_sent[1].data[4], ISOTP_PADDING);
+	HOST_CHECK_EQUAL(m_uchrTxResult, ISOTP_RESULT_OK);
+}
+
+
+static void TestMultiFrameReceive(void)
+{
+	//Variables
+	uint8_t frame[8] = { 0x10, 27, 0, 1, 2, 3, 4, 5 };
+	uint8_t value = 6;
+
+	//27 bytes are a first frame with 6 then three consecutive frames of 7, with a flow control after every two
+	m_link.blockSize = 2;
+	m_uchrRxResult = TEST_NO_RESULT;
+	m_ulReceivedLength = 0;
+	PeerSend(frame, sizeof(frame));
+	Pump(5);
+	HOST_CHECK_EQUAL(m_uchrSentCount, 1);
+	HOST_CHECK_EQUAL(m_sent[0].id, TEST_TX_ID);
+	HOST_CHECK_EQUAL(m_sent[0].data[0], 0x30);
+	HOST_CHECK_EQUAL(m_sent[0].data[1], 2);
+
+	for(uint8_t sequence = 1; sequence <= 3; sequence++)
+	{
+		frame[0] = 0x20 | sequence;
+		for(uint8_t i = 1; i < 8; i++) frame[i] = value++;
+		PeerSend(frame, sizeof(frame));
+		Pump(5);
+
+		//The flow control for the next block comes after the second, not after the last
+		HOST_CHECK_EQUAL(m_uchrSentCount, (sequence == 2) ? 1 : 0);
+		if(sequence == 2) HOST_CHECK_EQUAL(m_sent[0].data[0], 0x30);
+	}
+
+	HOST_CHECK_EQUAL(m_uchrRxResult, ISOTP_RESULT_OK);
+	HOST_CHECK_EQUAL(m_ulReceivedLength, 27);
+	for(uint8_t i = 0; i < 27; i++) HOST_CHECK_EQUAL(m_uchrReceived[i], i);
+
+	//A consecutive frame out of order ends the transfer
+	frame[0] = 0x10;
+	frame[1] = 20;
+	m_uchrRxResult = TEST_NO_RESULT;
+	PeerSend(frame, sizeof(frame));
+	Pump(5);
+	frame[0] = 0x22;
+	PeerSend(frame, sizeof(frame));
+	Pump(5);
+	HOST_CHECK_EQUAL(m_uchrRxResult, ISOTP_RESULT_SEQUENCE);
+	m_link.blockSize = ISOTP_BLOCK_SIZE;
+}
+
+
+static void TestFlowWait(void)
+{
+	//A few waits hold the sender without ending the transfer
+	StartSend(20);
+	Pump(5);
+
+	for(uint8_t i = 0; i < 3; i++)
+	{
+		PeerFlow(1, 0);
+		Pump(5);
+		HOST_CHECK_EQUAL(m_uchrSentCount, 0);
+	}
+
+	HOST_CHECK_EQUAL(m_uchrTxResult, TEST_NO_RESULT);
+	PeerFlow(0, 0);
+	Pump(5);
+	HOST_CHECK_EQUAL(m_uchrSentCount, 2);
+	HOST_CHECK_EQUAL(m_uchrTxResult, ISOTP_RESULT_OK);
+
+	//One wait more than allowed gives up
+	StartSend(20);
+	Pump(5);
+
+	for(uint8_t i = 0; i < ISOTP_MAX_WAITS; i++)
+	{
+		PeerFlow(1, 0);
+		Pump(5);
+	}
+
+	HOST_CHECK_EQUAL(m_uchrTxResult, TEST_NO_RESULT);
+	PeerFlow(1, 0);
+	Pump(5);
+	HOST_CHECK_EQUAL(m_uchrTxResult, ISOTP_RESULT_WAIT_LIMIT);
+	HOST_CHECK(IsoTpBusy(&m_link) == false);
+}
+
+
+static void TestOverflow(void)
+{
+	//Variables
+	const uint8_t first[8] = { 0x10, 40, 0, 1, 2, 3, 4, 5 };
+
+	//The receiver refusing the length ends the send
+	StartSend(20);
+	Pump(5);
+	PeerFlow(2, 0);
+	Pump(5);
+	HOST_CHECK_EQUAL(m_uchrSentCount, 0);
+	HOST_CHECK_EQUAL(m_uchrTxResult, ISOTP_RESULT_OVERFLOW);
+
+	//A sink refusing a first frame answers it with an overflow
+	m_bRefuse = true;
+	m_uchrRxResult = TEST_NO_RESULT;
+	PeerSend(first, sizeof(first));
+	Pump(5);
+	HOST_CHECK_EQUAL(m_uchrSentCount, 1);
+	HOST_CHECK_EQUAL(m_sent[0].data[0], 0x32);
+	HOST_CHECK_EQUAL(m_uchrRxResult, TEST_NO_RESULT);
+	m_bRefuse = false;
+}
+
+
+static void TestTimeout(void)
+{
+	//Variables
+	const uint8_t first[8] = { 0x10, 20, 0, 1, 2, 3, 4, 5 };
+
+	//No flow control for the first frame
+	StartSend(20);
+	Pump(ISOTP_TIMEOUT_MS - 20);
+	HOST_CHECK_EQUAL(m_uchrTxResult, TEST_NO_RESULT);
+	Pump(40);
+	HOST_CHECK_EQUAL(m_uchrTxResult, ISOTP_RESULT_TIMEOUT);
+
+	//No consecutive frame after the flow control
+	m_uchrRxResult = TEST_NO_RESULT;
+	PeerSend(first, sizeof(first));
+	Pump(ISOTP_TIMEOUT_MS - 20);
+	HOST_CHECK_EQUAL(m_uchrRxResult, TEST_NO_RESULT);
+	Pump(40);
+	HOST_CHECK_EQUAL(m_uchrRxResult, ISOTP_RESULT_TIMEOUT);
+	HOST_CHECK(IsoTpBusy(&m_link) == false);
+}
+
+
+int main(void)
+{
+	HostSimReset();
+	CAN_init_tx(CAN_BPS_500K, false, 1);
+	Can0.watchFor();
+
+	IsoTpInit(&m_link, TEST_TX_ID, TEST_RX_ID, false);
+	m_link.source = Source;
+	m_link.sink = Sink;
+	m_link.done = Done;
+
+	TestSingleFrame();
+	TestMultiFrameSend();
+	TestMultiFrameReceive();
+	TestFlowWait();
+	TestOverflow();
+	TestTimeout();
+
+	return HostTestResult("canIsoTp");
+}
@@ -0,0 +1,291 @@
+/**
+ * \file canMonitorTest.cpp
+ * \author Tim Robbins
+ * \brief Runs canMonitor on the simulated CAN bus, polled on each millisecond. \n
+ * Checks the bus load over a window against the frames counted in it, that MOb errors from failed transmits and \n
+ * the general CANGIT errors are counted in the window they happened in, and the bus off recovery: the controller is disabled \n
+ * on bus off and enabled again after the backoff, which doubles up to CAN_MONITOR_BACKOFF_MAX_MS for a node that keeps going \n
+ * bus off, and goes back to CAN_MONITOR_BACKOFF_MIN_MS once the bus has stayed up for CAN_MONITOR_STABLE_MS. \n
+ */
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <string.h>
+#include "hostSim.h"
+#include "hostTest.h"
+#include "avrCanUtilities.h"
+#include "canMonitor.h"
+
+
+///The microseconds of a bit at 500k
+#define TEST_BIT_US					2
+
+///The most state changes kept
+#define TEST_MAX_STATES				32
+
+
+///The milliseconds the test has run, and the cycle of the next poll so each lands on its millisecond
+static uint16_t m_uintNow = 0;
+static uint64_t m_ulNextPoll = 0;
+
+///The state changes told to the callback and the milliseconds of each
+static uint8_t m_uchrStates[TEST_MAX_STATES];
+static uint16_t m_uintStateAt[TEST_MAX_STATES];
+static uint8_t m_uchrStateCount = 0;
+
+
+static void OnState(uint8_t state)
+{
+	if(m_uchrStateCount < TEST_MAX_STATES)
+	{
+		m_uchrStates[m_uchrStateCount] = state;
+		m_uintStateAt[m_uchrStateCount] = m_uintNow;
+		m_uchrStateCount++;
+	}
+}
+
+
+static int8_t OnFrame(CAN_FRAME& frame)
+{
+	(void)frame;
+	return 0;
+}
+
+
+///Runs a millisecond and polls, taking any frames
+static void Step(void)
+{
+	//Variables
+	HostCanFrame_t sent;
+
+	m_ulNextPoll += F_CPU / 1000UL;
+	if(m_ulNextPoll > HostSimCycles()) HostSimRun((uint32_t)(m_ulNextPoll - HostSimCycles()));
+
+	while(CAN_process_frame(OnFrame) >= 0);
+	while(HostCanTake(&sent));
+	CanMonitorPoll(++m_uintNow);
+}
+
+
+///Runs some milliseconds
+static void Run(uint16_t milliseconds)
+{
+	for(uint16_t i = 0; i < milliseconds; i++) Step();
+}
+
+
+///Runs until a window has just closed
+static void RunToWindow(void)
+{
+	do
+	{
+		Step();
+	}
+	while(m_uintNow % CAN_MONITOR_WINDOW_MS != 0);
+}
+
+
+///Sends a frame of 8 bytes with a standard id
+static void Send(void)
+{
+	//Variables
+	uint8_t data[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+	HOST_CHECK(CAN_send_bytes(data, 8, 0x100, 0));
+}
+
+
+///Puts a frame of 4 bytes with an extended id on the bus from another node
+static void Inject(void)
+{
+	//Variables
+	HostCanFrame_t frame;
+
+	memset(&frame, 0, sizeof(frame));
+	frame.id = 0x12345;
+	frame.extended = true;
+	frame.length = 4;
+
+	HOST_CHECK(HostCanInject(&frame));
+}
+
+
+static void TestLoad(void)
+{
+	//Variables
+	CanMonitorWindow_t window;
+	uint32_t expected = 0;
+
+	//Nothing on the bus
+	RunToWindow();
+	RunToWindow();
+	CanMonitorGetWindow(&window);
+	HOST_CHECK_EQUAL(window.busLoad, 0);
+	HOST_CHECK_EQUAL(window.txFrames, 0);
+
+	//A frame each way every millisecond, the load being the bits they take over the window
+	for(uint8_t i = 0; i < CAN_MONITOR_WINDOW_MS; i++)
+	{
+		Send();
+		Inject();
+		Step();
+	}
+
+	CanMonitorGetWindow(&window);
+	HOST_CHECK(window.txFrames >= CAN_MONITOR_WINDOW_MS - 1 && window.txFrames <= CAN_MONITOR_WINDOW_MS);
+	HOST_CHECK(window.rxFrames >= CAN_MONITOR_WINDOW_MS - 1 && window.rxFrames <= CAN_MONITOR_WINDOW_MS);
+	HOST_CHECK_EQUAL(window.errors, 0);
+	HOST_CHECK_EQUAL(window.rxOverruns, 0);
+
+	expected = ((uint32_t)window.txFrames * (CAN_FRAME_BITS_STD + 64) + (uint32_t)window.rxFrames * (CAN_FRAME_BITS_EXT + 32)) * TEST_BIT_US * 1000 / (CAN_MONITOR_WINDOW_MS * 1000UL);
+	HOST_CHECK((uint32_t)window.busLoad + 3 >= expected && window.busLoad <= expected + 3);
+	HOST_CHECK_EQUAL(CanMonitorBusLoad(), window.busLoad);
+
+	//Back to nothing
+	RunToWindow();
+	CanMonitorGetWindow(&window);
+	HOST_CHECK_EQUAL(window.busLoad, 0);
+}
+
+
+static void TestErrors(void)
+{
+	//Variables
+	CanMonitorWindow_t window;
+	CAN_STATS before;
+	CAN_STATS after;
+
+	Can0.get_stats(before);
+
+	//Three unacknowledged tries before the frame gets out, and a stuff and form error off the bus
+	HostCanFailTransmits((1 << AERR), 3);
+	Send();
+	Step();
+	CANGIT.value |= (1 << SERG) | (1 << FERG);
+	RunToWindow();
+
+	Can0.get_stats(after);
+	HOST_CHECK_EQUAL(after.ackErrors - before.ackErrors, 3);
+	HOST_CHECK_EQUAL(after.stuffErrors - before.stuffErrors, 1);
+	HOST_CHECK_EQUAL(after.formErrors - before.formErrors, 1);
+	HOST_CHECK_EQUAL(after.bitErrors - before.bitErrors, 0);
+
+	CanMonitorGetWindow(&window);
+	HOST_CHECK_EQUAL(window.errors, 5);
+	HOST_CHECK_EQUAL(window.txFrames, 1);
+
+	//Bit and CRC errors together on each try count both
+	HostCanFailTransmits((1 << BERR) | (1 << CERR), 2);
+	Send();
+	RunToWindow();
+	CanMonitorGetWindow(&window);
+	HOST_CHECK_EQUAL(window.errors, 4);
+	HOST_CHECK_EQUAL(window.txFrames, 1);
+
+	//Counted in their own window only
+	RunToWindow();
+	CanMonitorGetWindow(&window);
+	HOST_CHECK_EQUAL(window.errors, 0);
+	HOST_CHECK_EQUAL(CanMonitorState(), CAN_MONITOR_RUNNING);
+	HOST_CHECK_EQUAL(m_uchrStateCount, 0);
+}
+
+
+///Runs until the state changes, up to some milliseconds, returning if it did
+static bool RunToState(uint16_t limit)
+{
+	//Variables
+	uint8_t count = m_uchrStateCount;
+
+	for(uint16_t i = 0; i < limit && m_uchrStateCount == count; i++) Step();
+
+	return (m_uchrStateCount != count);
+}
+
+
+static void TestBusOff(void)
+{
+	//Variables
+	uint16_t backoff = CAN_MONITOR_BACKOFF_MIN_MS;
+	uint16_t offAt = 0;
+
+	//Nobody acknowledging, with the error counter near the limit, so the node goes bus off on its next frames
+	HostCanSetErrorCounters(240, 0);
+	HostCanFailTransmits((1 << AERR), 255);
+	Send();
+	HOST_CHECK(RunToState(10));
+	HOST_CHECK_EQUAL(m_uchrStates[m_uchrStateCount - 1], CAN_MONITOR_BUS_OFF);
+	HOST_CHECK_EQUAL(CanMonitorState(), CAN_MONITOR_BUS_OFF);
+	HOST_CHECK_EQUAL(CANGCON & (1 << ENASTB), 0);
+
+	//Each bus off waits out the backoff before enabling again, the frame still waiting makes it go bus off again and the backoff doubles
+	for(uint8_t i = 0; i < 10; i++)
+	{
+		offAt = m_uintNow;
+		HOST_CHECK_EQUAL(CanMonitorBackoff(), (backoff < CAN_MONITOR_BACKOFF_MAX_MS / 2) ? backoff * 2 : CAN_MONITOR_BACKOFF_MAX_MS);
+
+		HOST_CHECK(RunToState(CAN_MONITOR_BACKOFF_MAX_MS + 10));
+		HOST_CHECK_EQUAL(m_uchrStates[m_uchrStateCount - 1], CAN_MONITOR_RECOVERING);
+		HOST_CHECK_EQUAL((uint16_t)(m_uintNow - offAt), backoff);
+		HOST_CHECK(CANGCON & (1 << ENASTB));
+		HOST_CHECK_EQUAL(CanMonitorRecoveries(), i + 1);
+
+		//The controller's own recovery of 128 x 11 bits, then 32 failed tries at 8 each take it off again
+		HostCanFailTransmits((1 << AERR), 255);
+		HOST_CHECK(RunToState(20));
+		HOST_CHECK_EQUAL(m_uchrStates[m_uchrStateCount - 1], CAN_MONITOR_BUS_OFF);
+		HOST_CHECK_EQUAL(CANGCON & (1 << ENASTB), 0);
+
+		backoff = (backoff < CAN_MONITOR_BACKOFF_MAX_MS / 2) ? backoff * 2 : CAN_MONITOR_BACKOFF_MAX_MS;
+	}
+
+	HOST_CHECK_EQUAL(CanMonitorBackoff(), CAN_MONITOR_BACKOFF_MAX_MS);
+
+	//Someone acknowledges again. After the last backoff it comes back and stays up, and the backoff only resets once it's been stable
+	HostCanFailTransmits(0, 0);
+	HOST_CHECK(RunToState(CAN_MONITOR_BACKOFF_MAX_MS + 10));
+	HOST_CHECK_EQUAL(CanMonitorState(), CAN_MONITOR_RECOVERING);
+	offAt = m_uintNow;
+	Run(10);
+	HOST_CHECK_EQUAL(Can0.get_error_state(), CAN_STATE_ERROR_ACTIVE);
+	HOST_CHECK_EQUAL(CanMonitorBackoff(), CAN_MONITOR_BACKOFF_MAX_MS);
+
+	HOST_CHECK(RunToState(CAN_MONITOR_STABLE_MS + 10));
+	HOST_CHECK_EQUAL(CanMonitorState(), CAN_MONITOR_RUNNING);
+	HOST_CHECK_EQUAL((uint16_t)(m_uintNow - offAt), CAN_MONITOR_STABLE_MS);
+	HOST_CHECK_EQUAL(CanMonitorBackoff(), CAN_MONITOR_BACKOFF_MIN_MS);
+
+	//Traffic goes out again
+	Send();
+	Run(1);
+	HOST_CHECK_EQUAL(Can0.txRoom(), 1 + SIZE_TX_BUFFER - 1);
+
+	//Bus off from another cause is caught the same way, and waits the minimum again
+	HostCanSetBusOff(true);
+	HOST_CHECK(RunToState(2));
+	HOST_CHECK_EQUAL(CanMonitorState(), CAN_MONITOR_BUS_OFF);
+	offAt = m_uintNow;
+	HOST_CHECK(RunToState(CAN_MONITOR_BACKOFF_MIN_MS + 2));
+	HOST_CHECK_EQUAL(CanMonitorState(), CAN_MONITOR_RECOVERING);
+	HOST_CHECK_EQUAL((uint16_t)(m_uintNow - offAt), CAN_MONITOR_BACKOFF_MIN_MS);
+	Run(5);
+	HOST_CHECK_EQUAL(Can0.get_error_state(), CAN_STATE_ERROR_ACTIVE);
+}
+
+
+int main(void)
+{
+	HostSimReset();
+	CAN_init_tx(CAN_BPS_500K, false, 1);
+	Can0.watchFor();
+	CanMonitorInit(OnState);
+	m_ulNextPoll = HostSimCycles();
+	sei();
+
+	TestLoad();
+	TestErrors();
+	TestBusOff();
+
+	HOST_CHECK_EQUAL(HostSimUnhandledInterrupts(), 0);
+
+	return HostTestResult("canMonitor");
+}
@@ -0,0 +1,370 @@
+/**
+ * \file canNodeProtocolTest.cpp
+ * \author Tim Robbins
+ * \brief Runs a hub and an input node with canNodeProtocol on the simulated CAN bus. \n
+ * The sim has one controller, so both nodes send through it and each frame that goes out is handed to the node it's addressed to. \n
+ * Covers batch gets and pin operations round trip, the failure bits, responses matched by sequence and node, \n
+ * and subscriptions pushing on a change past the deadband, no more often than their period, and again after the refresh. \n
+ */
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <string.h>
+#include "hostSim.h"
+#include "hostTest.h"
+#include "avrCanUtilities.h"
+#include "canNodeProtocol.h"
+
+
+///The most responses or published values kept
+#define TEST_MAX_RECEIVED			64
+
+///The input node's inputs and outputs
+static uint16_t m_uintAdc[16];
+static uint8_t m_uchrPins[32];
+
+///The input node
+static NodeServer_t m_server;
+
+///The milliseconds the test has run
+static uint16_t m_uintNow = 0;
+
+///The responses the hub got
+static CAN_FRAME m_responses[TEST_MAX_RECEIVED];
+static uint8_t m_uchrResponses = 0;
+
+///The values pushed to the hub, and when
+static NodeValue_t m_published[TEST_MAX_RECEIVED];
+static uint16_t m_uintPublishedAt[TEST_MAX_RECEIVED];
+static uint8_t m_uchrPublished = 0;
+
+
+static bool ReadIo(void* context, uint8_t type, uint8_t channel, uint16_t* value)
+{
+	if(type == NODE_DATA_ADC && channel < 16)
+	{
+		*value = m_uintAdc[channel];
+		return true;
+	}
+	else if(type == NODE_DATA_DIGITAL && channel < 32)
+	{
+		*value = m_uchrPins[channel];
+		return true;
+	}
+
+	return false;
+}
+
+
+static bool WriteIo(void* context, uint8_t type, uint8_t channel, uint16_t value)
+{
+	if(type != NODE_DATA_DIGITAL || channel >= 32) return false;
+
+	m_uchrPins[channel] = (uint8_t)value;
+	return true;
+}
+
+
+///Copies a frame from the bus into the library's frame
+static void ToFrame(const HostCanFrame_t* from, CAN_FRAME& to)
+{
+	memset(&to, 0, sizeof(to));
+	to.id = from->id;
+	to.extended = from->extended;
+	to.rtr = from->remote;
+	to.length = from->length;
+	memcpy(to.data.bytes, from->data, 8);
+}
+
+
+///Runs for some milliseconds, handing the frames that went out to the node they're for and polling the input node
+static void Run(uint16_t milliseconds)
+{
+	//Variables
+	HostCanFrame_t sent;
+	CAN_FRAME frame;
+	NodeValue_t values[NODE_PUBLISH_PER_FRAME];
+	uint8_t count = 0;
+
+	for(uint16_t i = 0; i < milliseconds; i++)
+	{
+		HostSimRunMilliseconds(1);
+		m_uintNow++;
+
+		while(HostCanTake(&sent))
+		{
+			ToFrame(&sent, frame);
+
+			if((frame.id & CLEAR_NODE_ID) == NODE_DATA_RESPONSE && m_uchrResponses < TEST_MAX_RECEIVED)
+			{
+				m_responses[m_uchrResponses++] = frame;
+			}
+			else if((count = NodeReadPublish(frame, values)) != 0)
+			{
+				for(uint8_t j = 0; j < count && m_uchrPublished < TEST_MAX_RECEIVED; j++)
+				{
+					m_uintPublishedAt[m_uchrPublished] = m_uintNow;
+					m_published[m_uchrPublished++] = values[j];
+				}
+			}
+			else
+			{
+				NodeServerReceive(&m_server, frame);
+			}
+		}
+
+		NodeServerPoll(&m_server, m_uintNow);
+	}
+}
+
+
+///Sends a request and gives the node time to answer, returning the response or 0
+static const CAN_FRAME* Request(NodeBatch_t* batch)
+{
+	m_uchrResponses = 0;
+	HOST_CHECK(NodeBatchSend(batch));
+	Run(3);
+	return (m_uchrResponses == 1) ? &m_responses[0] : 0;
+}
+
+
+static void TestBatch(void)
+{
+	//Variables
+	NodeBatch_t batch;
+	const CAN_FRAME* response = 0;
+	uint16_t values[NODE_BATCH_MAX_OPS];
+	uint8_t failed = 0xAA;
+
+	//A get, a pin operation and a get of the pin set, answered in one response
+	NodeBatchBegin(&batch, INPUT_NODE_ID);
+	HOST_CHECK(NodeBatchGet(&batch, NODE_DATA_ADC, 3));
+	HOST_CHECK(NodeBatchSet(&batch, NODE_DATA_DIGITAL, 12, 1));
+	HOST_CHECK(NodeBatchGet(&batch, NODE_DATA_DIGITAL, 12));
+	response = Request(&batch);
+	HOST_CHECK(response != 0);
+	if(response == 0) return;
+	HOST_CHECK_EQUAL(response->id, INPUT_NODE_ID | NODE_DATA_RESPONSE);
+	HOST_CHECK(NodeBatchResponse(&batch, *response, values, &failed));
+	HOST_CHECK_EQUAL(failed, 0);
+	HOST_CHECK_EQUAL(values[0], 1000);
+	HOST_CHECK_EQUAL(values[1], 1);
+	HOST_CHECK_EQUAL(m_uchrPins[12], 1);
+
+	//Three 2 byte gets fill the response, a fourth is refused
+	NodeBatchBegin(&batch, INPUT_NODE_ID);
+	HOST_CHECK(NodeBatchGet(&batch, NODE_DATA_ADC, 1));
+	HOST_CHECK(NodeBatchGet(&batch, NODE_DATA_ADC, 2));
+	HOST_CHECK(NodeBatchGet(&batch, NODE_DATA_ADC, 15));
+	HOST_CHECK(!NodeBatchGet(&batch, NODE_DATA_DIGITAL, 1));
+	response = Request(&batch);
+	HOST_CHECK(response != 0 && NodeBatchResponse(&batch, *response, values, &failed));
+	HOST_CHECK_EQUAL(response->length, 8);
+	HOST_CHECK_EQUAL(failed, 0);
+	HOST_CHECK_EQUAL(values[0], 0x0101);
+	HOST_CHECK_EQUAL(values[1], 0x0202);
+	HOST_CHECK_EQUAL(values[2], 0x0F0F);
+
+	//A failed get still takes its place, as 0, so the values after it line up
+	NodeBatchBegin(&batch, INPUT_NODE_ID);
+	HOST_CHECK(NodeBatchGet(&batch, NODE_DATA_ADC, 20));
+	HOST_CHECK(NodeBatchGet(&batch, NODE_DATA_ADC, 3));
+	HOST_CHECK(NodeBatchSet(&batch, NODE_DATA_DIGITAL, 40, 1));
+	response = Request(&batch);
+	HOST_CHECK(response != 0 && NodeBatchResponse(&batch, *response, values, &failed));
+	HOST_CHECK_EQUAL(failed, 0x05);
+	HOST_CHECK_EQUAL(values[0], 0);
+	HOST_CHECK_EQUAL(values[1], 1000);
+}
+
+
+static void TestUnknownOperation(void)
+{
+	//Variables
+	CAN_FRAME request;
+
+	//Where the operation after an unknown one starts isn't known, so it and the rest fail
+	memset(&request, 0, sizeof(request));
+	request.id = INPUT_NODE_ID | NODE_DATA_REQUEST_BATCH;
+	request.length = 7;
+	request.data.bytes[0] = 0x55;
+	request.data.bytes[1] = NODE_DATA_REQUEST_GET | NODE_DATA_ADC;
+	request.data.bytes[2] = 3;
+	request.data.bytes[3] = NODE_DATA_REQUEST_SEND | NODE_DATA_ADC;
+	request.data.bytes[4] = 3;
+	request.data.bytes[5] = NODE_DATA_REQUEST_GET | NODE_DATA_ADC;
+	request.data.bytes[6] = 4;
+
+	m_uchrResponses = 0;
+	HOST_CHECK(Can0.sendFrame(request));
+	Run(3);
+	HOST_CHECK_EQUAL(m_uchrResponses, 1);
+	HOST_CHECK_EQUAL(m_responses[0].data.bytes[0], 0x55);
+	HOST_CHECK_EQUAL(m_responses[0].data.bytes[1], 0xFE);
+	HOST_CHECK_EQUAL(m_responses[0].length, 4);
+}
+
+
+static void TestSequence(void)
+{
+	//Variables
+	NodeBatch_t first;
+	NodeBatch_t second;
+	CAN_FRAME other;
+	uint16_t values[NODE_BATCH_MAX_OPS];
+
+	NodeBatchBegin(&first, INPUT_NODE_ID);
+	NodeBatchGet(&first, NODE_DATA_ADC, 3);
+	NodeBatchBegin(&second, INPUT_NODE_ID);
+	NodeBatchGet(&second, NODE_DATA_ADC, 4);
+	HOST_CHECK(first.data[0] != second.data[0]);
+
+	m_uchrResponses = 0;
+	HOST_CHECK(NodeBatchSend(&first));
+	HOST_CHECK(NodeBatchSend(&second));
+	Run(5);
+	HOST_CHECK_EQUAL(m_uchrResponses, 2);
+
+	//Each response only matches the request with its sequence
+	HOST_CHECK(!NodeBatchResponse(&second, m_responses[0], values, 0));
+	HOST_CHECK(NodeBatchResponse(&first, m_responses[0], values, 0));
+	HOST_CHECK_EQUAL(values[0], 1000);
+	HOST_CHECK(!NodeBatchResponse(&first, m_responses[1], values, 0));
+	HOST_CHECK(NodeBatchResponse(&second, m_responses[1], values, 0));
+	HOST_CHECK_EQUAL(values[0], 0x0404);
+
+	//And from the node it was sent to
+	other = m_responses[0];
+	other.id = OUTPUT_NODE_ID | NODE_DATA_RESPONSE;
+	HOST_CHECK(!NodeBatchResponse(&first, other, values, 0));
+
+	//Requests for another node are left alone
+	NodeBatchBegin(&first, OUTPUT_NODE_ID);
+	NodeBatchGet(&first, NODE_DATA_ADC, 3);
+	HOST_CHECK(Request(&first) == 0);
+	HOST_CHECK_EQUAL(m_uchrResponses, 0);
+}
+
+
+///Counts the values pushed for a channel from the index given
+static uint8_t CountPublished(uint8_t channel, uint8_t from)
+{
+	//Variables
+	uint8_t count = 0;
+
+	for(uint8_t i = from; i < m_uchrPublished; i++)
+	{
+		if(m_published[i].channel == channel) count++;
+	}
+
+	return count;
+}
+
+
+static void TestSubscribe(void)
+{
+	//Variables
+	NodeBatch_t batch;
+	const CAN_FRAME* response = 0;
+	uint8_t failed = 0xAA;
+	uint8_t start = 0;
+	uint16_t changedAt = 0;
+	uint16_t shortest = 0xFFFF;
+
+	//Subscribing pushes the value straight away
+	m_uchrPublished = 0;
+	NodeBatchSubscribe(&batch, INPUT_NODE_ID, NODE_DATA_ADC, 3, 50, 5);
+	response = Request(&batch);
+	HOST_CHECK(response != 0 && NodeBatchResponse(&batch, *response, 0, &failed));
+	HOST_CHECK_EQUAL(failed, 0);
+	HOST_CHECK_EQUAL(m_uchrPublished, 1);
+	HOST_CHECK_EQUAL(m_published[0].nodeId, INPUT_NODE_ID);
+	HOST_CHECK_EQUAL(m_published[0].type, NODE_DATA_ADC);
+	HOST_CHECK_EQUAL(m_published[0].channel, 3);
+	HOST_CHECK_EQUAL(m_published[0].value, 1000);
+
+	//A move inside the deadband isn't pushed
+	m_uintAdc[3] = 1004;
+	Run(200);
+	HOST_CHECK_EQUAL(m_uchrPublished, 1);
+
+	//One past it is, by the next check
+	m_uintAdc[3] = 1010;
+	changedAt = m_uintNow;
+	Run(60);
+	HOST_CHECK_EQUAL(m_uchrPublished, 2);
+	HOST_CHECK_EQUAL(m_published[1].value, 1010);
+	HOST_CHECK((uint16_t)(m_uintPublishedAt[1] - changedAt) <= 51);
+
+	//Left unchanged, it's pushed again after the refresh
+	Run(NODE_SUBSCRIPTION_REFRESH * 50 + 10);
+	HOST_CHECK_EQUAL(m_uchrPublished, 3);
+	HOST_CHECK_EQUAL((uint16_t)(m_uintPublishedAt[2] - m_uintPublishedAt[1]), NODE_SUBSCRIPTION_REFRESH * 50);
+	HOST_CHECK_EQUAL(m_published[2].value, 1010);
+
+	//A value changing every millisecond is pushed no more often than the period
+	NodeBatchSubscribe(&batch, INPUT_NODE_ID, NODE_DATA_ADC, 5, 20, 0);
+	response = Request(&batch);
+	HOST_CHECK(response != 0 && NodeBatchResponse(&batch, *response, 0, &failed));
+	HOST_CHECK_EQUAL(failed, 0);
+	start = m_uchrPublished;
+
+	for(uint16_t i = 0; i < 200; i++)
+	{
+		m_uintAdc[5]++;
+		Run(1);
+	}
+
+	HOST_CHECK(CountPublished(5, start) >= 9 && CountPublished(5, start) <= 11);
+
+	for(uint8_t i = start + 1, last = start; i < m_uchrPublished; i++)
+	{
+		if(m_published[i].channel != 5) continue;
+		if(m_published[last].channel == 5 && (uint16_t)(m_uintPublishedAt[i] - m_uintPublishedAt[last]) < shortest)
+		{
+			shortest = m_uintPublishedAt[i] - m_uintPublishedAt[last];
+		}
+		last = i;
+	}
+
+	HOST_CHECK(shortest >= 20 && shortest != 0xFFFF);
+
+	//A period of 0 ends it
+	NodeBatchSubscribe(&batch, INPUT_NODE_ID, NODE_DATA_ADC, 5, 0, 0);
+	response = Request(&batch);
+	HOST_CHECK(response != 0 && NodeBatchResponse(&batch, *response, 0, &failed));
+	HOST_CHECK_EQUAL(failed, 0);
+	start = m_uchrPublished;
+	for(uint16_t i = 0; i < 100; i++)
+	{
+		m_uintAdc[5]++;
+		Run(1);
+	}
+	HOST_CHECK_EQUAL(CountPublished(5, start), 0);
+
+	//An input the node can't read can't be subscribed to
+	NodeBatchSubscribe(&batch, INPUT_NODE_ID, NODE_DATA_ADC, 40, 50, 0);
+	response = Request(&batch);
+	HOST_CHECK(response != 0 && NodeBatchResponse(&batch, *response, 0, &failed));
+	HOST_CHECK_EQUAL(failed, 1);
+}
+
+
+int main(void)
+{
+	for(uint8_t i = 0; i < 16; i++) m_uintAdc[i] = i * 0x0101;
+	m_uintAdc[3] = 1000;
+
+	HostSimReset();
+	CAN_init_tx(CAN_BPS_500K, false, 1);
+	NodeServerInit(&m_server, INPUT_NODE_ID, ReadIo, WriteIo, 0);
+	sei();
+
+	TestBatch();
+	TestUnknownOperation();
+	TestSequence();
+	TestSubscribe();
+
+	HOST_CHECK_EQUAL(HostSimUnhandledInterrupts(), 0);
+
+	return HostTestResult("canNodeProtocol");
+}
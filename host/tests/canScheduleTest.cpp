@@ -0,0 +1,304 @@
+/**
+ * \file canScheduleTest.cpp
+ * \author Tim Robbins
+ * \brief Runs a canSchedule table from the system tick at 10kHz, as the header's example does, on the simulated CAN bus. \n
+ * Checks each slot is loaded no later than a tick after its offset and reaches the bus, that an empty slot is left out, \n
+ * that a slot the tick comes too late for is skipped, that a frame held off the bus until the next slot is counted as an overrun, \n
+ * and that the schedule finds its cycle again when the clock jumps either way at a sync. \n
+ * Also covers the reserved TX MOb, kept out of the way of frames sent with sendFrame. \n
+ */
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <string.h>
+#include "hostSim.h"
+#include "hostTest.h"
+#include "avrTimers.h"
+#include "avrCanUtilities.h"
+#include "canTimeSync.h"
+#include "canSchedule.h"
+
+
+///The microseconds in a cycle
+#define TEST_CYCLE_US				10000UL
+
+///The microseconds between ticks
+#define TEST_TICK_US				(1000000UL / SYSTEM_TICK_HZ)
+
+///The id the application sends its own frames with
+#define TEST_APP_ID					0x300
+
+///The id of the frames flooding the bus, ahead of the schedule's
+#define TEST_FLOOD_ID				0x010
+
+
+///The frames each slot loaded and that reached the bus, by the id less 0x120
+static uint16_t m_uintLoaded[3];
+static uint16_t m_uintSent[3];
+static uint16_t m_uintAppSent = 0;
+
+///The latest a slot was loaded after its offset, in microseconds
+static uint32_t m_ulLatest = 0;
+
+///The earliest, which is more than its offset when nothing was loaded early
+static int32_t m_lEarliest = 0;
+
+///The calls to the slot that's only filled every other cycle
+static uint16_t m_uintAlternateCalls = 0;
+
+///The milliseconds the test has run
+static uint16_t m_uintNow = 0;
+
+///The cycles the node's clock started at
+static uint64_t m_ulStart = 0;
+
+///The cycles the last SYNC was received at
+static uint64_t m_ulSyncCycles = 0;
+
+
+///Fills a slot, checking how far into the cycle it was loaded
+static bool Fill(void* context, CAN_FRAME* frame)
+{
+	//Variables
+	const CanScheduleSlot_t* slot = (const CanScheduleSlot_t*)context;
+	int32_t late = (int32_t)(CanTimeNow() % TEST_CYCLE_US) - (int32_t)slot->offset;
+
+	if(late > (int32_t)m_ulLatest) m_ulLatest = late;
+	if(late < m_lEarliest) m_lEarliest = late;
+
+	m_uintLoaded[slot->id - 0x120]++;
+	frame->data.bytes[0] = (uint8_t)m_uintLoaded[slot->id - 0x120];
+	return true;
+}
+
+
+///Fills a slot every other cycle
+static bool Alternate(void* context, CAN_FRAME* frame)
+{
+	if((++m_uintAlternateCalls & 1) == 0) return false;
+
+	return Fill(context, frame);
+}
+
+
+extern const CanScheduleSlot_t m_schedule[];
+
+const CanScheduleSlot_t m_schedule[] =
+{
+	{ 0,    0x120, false, 8, Fill,      (void*)&m_schedule[0] },
+	{ 2500, 0x121, false, 4, Fill,      (void*)&m_schedule[1] },
+	{ 6000, 0x122, false, 2, Alternate, (void*)&m_schedule[2] },
+};
+
+
+static void OnSend(const HostCanFrame_t* frame)
+{
+	if(frame->id >= 0x120 && frame->id <= 0x122) m_uintSent[frame->id - 0x120]++;
+	if(frame->id == TEST_APP_ID) m_uintAppSent++;
+}
+
+
+static int8_t OnFrame(CAN_FRAME& frame)
+{
+	if(frame.id == CAN_TIME_SYNC_ID) m_ulSyncCycles = HostSimCycles();
+	CanTimeReceive(frame);
+	return 0;
+}
+
+
+///Runs for some milliseconds, taking frames and polling as the main loop would
+static void Run(uint16_t milliseconds)
+{
+	for(uint16_t i = 0; i < milliseconds; i++)
+	{
+		HostSimRunMilliseconds(1);
+		while(CAN_process_frame(OnFrame) >= 0);
+		CanTimePoll(++m_uintNow);
+	}
+}
+
+
+///Runs until the time is some microseconds into a cycle
+static void RunUntil(uint32_t into)
+{
+	while((CanTimeNow() % TEST_CYCLE_US) / 100 != into / 100) HostSimRunMicroseconds(20);
+}
+
+
+///Starts the counts over
+static void Clear(void)
+{
+	memset(m_uintLoaded, 0, sizeof(m_uintLoaded));
+	memset(m_uintSent, 0, sizeof(m_uintSent));
+	m_uintAppSent = 0;
+	m_ulLatest = 0;
+	m_lEarliest = TEST_CYCLE_US;
+}
+
+
+///Puts a frame on the bus from another node
+static void Inject(uint16_t id, uint8_t length, uint32_t value)
+{
+	//Variables
+	HostCanFrame_t frame;
+
+	memset(&frame, 0, sizeof(frame));
+	frame.id = id;
+	frame.length = length;
+	frame.data[0] = 1;
+	for(uint8_t i = 0; i < 4; i++) frame.data[i + 1] = (uint8_t)(value >> (8 * i));
+
+	HOST_CHECK(HostCanInject(&frame));
+}
+
+
+///Moves the clock to a master's some microseconds off it with a SYNC and FOLLOW_UP
+static void Jump(int32_t by)
+{
+	//Variables
+	uint32_t local = 0;
+
+	Inject(CAN_TIME_SYNC_ID, 1, 0);
+	Run(1);
+	local = (uint32_t)((m_ulSyncCycles - m_ulStart) / (F_CPU / 1000000UL));
+	Inject(CAN_TIME_FOLLOW_UP_ID, 5, local + (uint32_t)by);
+	Run(1);
+}
+
+
+///Checks a run of whole cycles, at least the amount given, sent every slot in time and the alternating one every other cycle
+static void CheckCycles(uint16_t least, const CanScheduleStats_t* before)
+{
+	//Variables
+	CanScheduleStats_t stats;
+	uint16_t cycles = 0;
+
+	CanScheduleGetStats(&stats);
+	cycles = (uint16_t)(stats.cycles - before->cycles);
+	HOST_CHECK(cycles >= least);
+	HOST_CHECK_EQUAL(m_uintLoaded[0], cycles);
+	HOST_CHECK_EQUAL(m_uintLoaded[1], cycles);
+	HOST_CHECK_EQUAL(m_uintLoaded[2], (cycles + 1) / 2);
+	HOST_CHECK_EQUAL(m_uintSent[0], m_uintLoaded[0]);
+	HOST_CHECK_EQUAL(m_uintSent[1], m_uintLoaded[1]);
+	HOST_CHECK_EQUAL(m_uintSent[2], m_uintLoaded[2]);
+	HOST_CHECK(m_lEarliest >= 0);
+	HOST_CHECK(m_ulLatest < TEST_TICK_US + 10);
+	HOST_CHECK_EQUAL(stats.sent - before->sent, cycles * 2 + (cycles + 1) / 2);
+	HOST_CHECK_EQUAL(stats.skipped, before->skipped);
+	HOST_CHECK_EQUAL(stats.overruns, before->overruns);
+}
+
+
+int main(void)
+{
+	//Variables
+	const CanScheduleSlot_t unordered[] = { { 5000, 1, false, 1, 0, 0 }, { 100, 2, false, 1, 0, 0 } };
+	const CanScheduleSlot_t tooLate[] = { { TEST_CYCLE_US, 1, false, 1, 0, 0 } };
+	CanScheduleStats_t stats;
+	CanScheduleStats_t before;
+	CAN_FRAME app;
+	int8_t mob = -1;
+
+	HostSimReset();
+	HostCanSetTxHook(OnSend);
+	SystemTickInit();
+
+	//The schedule needs a TX MOb of its own
+	CAN_init_tx(CAN_BPS_500K, false, 1);
+	HOST_CHECK(!CanScheduleInit(m_schedule, 3, TEST_CYCLE_US));
+	CAN_init_tx(CAN_BPS_500K, false, 2);
+	Can0.watchFor();
+	HOST_CHECK(!CanScheduleInit(unordered, 2, TEST_CYCLE_US));
+	HOST_CHECK(!CanScheduleInit(tooLate, 1, TEST_CYCLE_US));
+	HOST_CHECK(CanScheduleInit(m_schedule, 3, TEST_CYCLE_US));
+	mob = Can0.reserveTxMob();
+	HOST_CHECK(mob >= 0);
+	HOST_CHECK_EQUAL(Can0.reserveTxMob(), mob);
+
+	m_ulStart = HostSimCycles();
+	CanTimeInit(false);
+	sei();
+
+	//Each slot in its place, from the start of the next cycle, with the application's frames going out around them
+	RunUntil(TEST_CYCLE_US - 500);
+	CanScheduleStart();
+	HostSimRunMicroseconds(TEST_TICK_US);
+	Clear();
+	CanScheduleGetStats(&before);
+	m_uintAlternateCalls = 0;
+
+	memset(&app, 0, sizeof(app));
+	app.id = TEST_APP_ID;
+	app.length = 8;
+
+	for(uint16_t i = 0; i < 200; i++)
+	{
+		if(i % 7 == 0) HOST_CHECK(Can0.sendFrame(app));
+		Run(1);
+	}
+
+	RunUntil(TEST_CYCLE_US - 500);
+	CheckCycles(20, &before);
+	HOST_CHECK_EQUAL(m_uintAppSent, 29);
+
+	//A tick held off past CAN_SCHEDULE_LATE_US skips the slot rather than sending it late
+	Clear();
+	CanScheduleGetStats(&before);
+	RunUntil(2400);
+	cli();
+	HostSimRunMicroseconds(CAN_SCHEDULE_LATE_US + 300);
+	sei();
+	RunUntil(TEST_CYCLE_US - 500);
+	CanScheduleGetStats(&stats);
+	HOST_CHECK_EQUAL(stats.skipped - before.skipped, 1);
+	HOST_CHECK_EQUAL(m_uintLoaded[1], 0);
+	HOST_CHECK_EQUAL(m_uintLoaded[0], 1);
+
+	//A frame kept off the bus until the next slot is dropped for it and counted
+	Clear();
+	CanScheduleGetStats(&before);
+	RunUntil(TEST_CYCLE_US - 100);
+	for(uint8_t i = 0; i < 14; i++) Inject(TEST_FLOOD_ID, 8, 0);
+	RunUntil(TEST_CYCLE_US - 500);
+	CanScheduleGetStats(&stats);
+	HOST_CHECK_EQUAL(stats.overruns - before.overruns, 1);
+	HOST_CHECK_EQUAL(m_uintLoaded[0], 1);
+	HOST_CHECK_EQUAL(m_uintSent[0], 0);
+	HOST_CHECK_EQUAL(m_uintSent[1], 1);
+
+	//The clock jumping forward at a sync, by far more than a cycle, finds the cycle again instead of skipping every slot in between
+	Clear();
+	CanScheduleGetStats(&before);
+	Jump(5003300);
+	RunUntil(TEST_CYCLE_US - 500);
+	Clear();
+	m_uintAlternateCalls = 0;
+	CanScheduleGetStats(&stats);
+	HOST_CHECK_EQUAL(stats.skipped, before.skipped);
+	CanScheduleGetStats(&before);
+	Run(100);
+	RunUntil(TEST_CYCLE_US - 500);
+	CheckCycles(10, &before);
+
+	//And back
+	Jump(-2000000);
+	RunUntil(TEST_CYCLE_US - 500);
+	Clear();
+	m_uintAlternateCalls = 0;
+	CanScheduleGetStats(&stats);
+	HOST_CHECK_EQUAL(stats.skipped, before.skipped);
+	CanScheduleGetStats(&before);
+	Run(100);
+	RunUntil(TEST_CYCLE_US - 500);
+	CheckCycles(10, &before);
+
+	//Stopped, nothing more goes out
+	CanScheduleStop();
+	Clear();
+	Run(50);
+	HOST_CHECK_EQUAL(m_uintLoaded[0] + m_uintLoaded[1] + m_uintLoaded[2], 0);
+
+	HOST_CHECK_EQUAL(HostSimUnhandledInterrupts(), 0);
+
+	return HostTestResult("canSchedule");
+}
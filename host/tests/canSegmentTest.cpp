@@ -0,0 +1,238 @@
+/**
+ * \file canSegmentTest.cpp
+ * \author Tim Robbins
+ * \brief Sends buffers as segments with avrCanUtilities on the simulated CAN bus and puts them back together from what went out. \n
+ * Checks the segments reach the bus in order with one TX MOb and with several, where the controller would otherwise send \n
+ * a later segment first from a lower MOb, that the sequence wraps past 0x3F, and the limits of CAN_send_buffer. \n
+ * Also checks CAN_segment_receive catches a segment out of order or missing and a buffer that's too small. \n
+ */
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <string.h>
+#include "hostSim.h"
+#include "hostTest.h"
+#include "avrCanUtilities.h"
+
+
+///The id the segments are sent with
+#define TEST_ID						0x321
+
+///The biggest buffer sent, enough segments to wrap the sequence
+#define TEST_MAX_LENGTH				500
+
+
+///The buffer sent
+static uint8_t m_uchrSource[TEST_MAX_LENGTH];
+
+///Where the segments that went out are put back together
+static uint8_t m_uchrReceived[TEST_MAX_LENGTH];
+static CanSegmentRx_t m_rx;
+
+///The segments that went out, and the ones out of sequence or failing to be put back together
+static uint16_t m_uintSegments = 0;
+static uint16_t m_uintOutOfOrder = 0;
+static uint16_t m_uintErrors = 0;
+
+///How many buffers were put back together
+static uint8_t m_uchrComplete = 0;
+
+
+///Copies a frame from the bus into the library's frame
+static void ToFrame(const HostCanFrame_t* from, CAN_FRAME& to)
+{
+	memset(&to, 0, sizeof(to));
+	to.id = from->id;
+	to.extended = from->extended;
+	to.length = from->length;
+	memcpy(to.data.bytes, from->data, 8);
+}
+
+
+static void OnSend(const HostCanFrame_t* frame)
+{
+	//Variables
+	CAN_FRAME received;
+	int8_t result = 0;
+
+	if(frame->id != TEST_ID) return;
+	if((frame->data[0] & CAN_SEGMENT_SEQUENCE_MASK) != (m_uintSegments & CAN_SEGMENT_SEQUENCE_MASK)) m_uintOutOfOrder++;
+	m_uintSegments++;
+
+	ToFrame(frame, received);
+	result = CAN_segment_receive(&m_rx, received);
+	if(result < 0) m_uintErrors++;
+	if(result == 1) m_uchrComplete++;
+}
+
+
+///Starts over with the TX MObs given
+static void Start(uint8_t txMobs)
+{
+	HostSimReset();
+	HostCanSetTxHook(OnSend);
+	CAN_init_tx(CAN_BPS_500K, false, txMobs);
+	CAN_segment_init(&m_rx, m_uchrReceived, sizeof(m_uchrReceived));
+	memset(m_uchrReceived, 0, sizeof(m_uchrReceived));
+	m_uintSegments = 0;
+	m_uintOutOfOrder = 0;
+	m_uintErrors = 0;
+	m_uchrComplete = 0;
+}
+
+
+///Checks one buffer of the length given came out whole and in order
+static void CheckReceived(uint16_t length)
+{
+	HOST_CHECK_EQUAL(m_uchrComplete, 1);
+	HOST_CHECK_EQUAL(m_uintOutOfOrder, 0);
+	HOST_CHECK_EQUAL(m_uintErrors, 0);
+	HOST_CHECK_EQUAL(m_rx.length, length);
+	HOST_CHECK(memcmp(m_uchrReceived, m_uchrSource, length) == 0);
+}
+
+
+///Sends a buffer with CAN_segment_send, pumped as a main loop would, returning the calls it took
+static uint16_t SendSegmented(uint16_t length)
+{
+	//Variables
+	CanSegmentTx_t tx;
+	uint16_t calls = 1;
+
+	CAN_segment_send_init(&tx, m_uchrSource, length, TEST_ID, 0);
+
+	while(CAN_segment_send(&tx) == 0 && calls < 1000)
+	{
+		HostSimRunMicroseconds(100);
+		calls++;
+	}
+
+	HostSimRunMilliseconds(5);
+	return calls;
+}
+
+
+static void TestOneMob(void)
+{
+	Start(1);
+
+	//The MOb and the 7 frames the transmit buffer holds, in order through the one MOb
+	HOST_CHECK_EQUAL(Can0.txOrderedRoom(), 8);
+	HOST_CHECK(!CAN_send_buffer(m_uchrSource, 57, TEST_ID, 0));
+	HOST_CHECK(CAN_send_buffer(m_uchrSource, 56, TEST_ID, 0));
+	HOST_CHECK_EQUAL(Can0.txOrderedRoom(), 0);
+	HOST_CHECK(!CAN_send_buffer(m_uchrSource, 1, TEST_ID, 0));
+	HostSimRunMilliseconds(5);
+	HOST_CHECK_EQUAL(m_uintSegments, 8);
+	CheckReceived(56);
+
+	//Past the limit it goes a few segments at a time, the sequence wrapping past 0x3F
+	Start(1);
+	SendSegmented(TEST_MAX_LENGTH);
+	HOST_CHECK_EQUAL(m_uintSegments, (TEST_MAX_LENGTH + CAN_SEGMENT_PAYLOAD - 1) / CAN_SEGMENT_PAYLOAD);
+	CheckReceived(TEST_MAX_LENGTH);
+}
+
+
+static void TestSeveralMobs(void)
+{
+	//Variables
+	uint8_t segment[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+	Start(3);
+
+	//Only one segment at a time is sure to go out in order, so CAN_send_buffer can't take more than one
+	HOST_CHECK_EQUAL(Can0.txRoom(), 3 + 7);
+	HOST_CHECK_EQUAL(Can0.txOrderedRoom(), 1);
+	HOST_CHECK(!CAN_send_buffer(m_uchrSource, 8, TEST_ID, 0));
+	HOST_CHECK(CAN_send_buffer(m_uchrSource, 7, TEST_ID, 0));
+	HOST_CHECK_EQUAL(Can0.txOrderedRoom(), 0);
+	HostSimRunMilliseconds(1);
+	HOST_CHECK_EQUAL(Can0.txOrderedRoom(), 1);
+	CheckReceived(7);
+
+	//Another frame still going out holds the segments back
+	Start(3);
+	HOST_CHECK(CAN_send_bytes(segment, 8, TEST_ID + 1, 0));
+	HOST_CHECK_EQUAL(Can0.txOrderedRoom(), 0);
+	HOST_CHECK(!CAN_send_buffer(m_uchrSource, 1, TEST_ID, 0));
+
+	//The controller sends the lowest MOb waiting first, so loading every free one would reorder them
+	Start(3);
+	SendSegmented(TEST_MAX_LENGTH);
+	HOST_CHECK_EQUAL(m_uintSegments, (TEST_MAX_LENGTH + CAN_SEGMENT_PAYLOAD - 1) / CAN_SEGMENT_PAYLOAD);
+	CheckReceived(TEST_MAX_LENGTH);
+
+	//A reserved MOb leaves one for the segments, which the queue can drain through in order again
+	Start(2);
+	HOST_CHECK(Can0.reserveTxMob() >= 0);
+	HOST_CHECK_EQUAL(Can0.txOrderedRoom(), 8);
+	HOST_CHECK(CAN_send_buffer(m_uchrSource, 56, TEST_ID, 0));
+	HostSimRunMilliseconds(5);
+	CheckReceived(56);
+}
+
+
+static void TestReceive(void)
+{
+	//Variables
+	CAN_FRAME frame;
+	uint8_t small[10];
+
+	memset(&frame, 0, sizeof(frame));
+	frame.id = TEST_ID;
+	frame.length = 8;
+	CAN_segment_init(&m_rx, m_uchrReceived, sizeof(m_uchrReceived));
+
+	//A segment before a first one is ignored
+	frame.data.bytes[0] = 1;
+	HOST_CHECK_EQUAL(CAN_segment_receive(&m_rx, frame), 0);
+
+	//A missing segment is caught, and nothing more is taken until the next first segment
+	frame.data.bytes[0] = CAN_SEGMENT_FIRST | 0;
+	HOST_CHECK_EQUAL(CAN_segment_receive(&m_rx, frame), 0);
+	frame.data.bytes[0] = 2;
+	HOST_CHECK_EQUAL(CAN_segment_receive(&m_rx, frame), -1);
+	frame.data.bytes[0] = CAN_SEGMENT_LAST | 1;
+	HOST_CHECK_EQUAL(CAN_segment_receive(&m_rx, frame), 0);
+
+	//So is one out of order
+	frame.data.bytes[0] = CAN_SEGMENT_FIRST | 0;
+	HOST_CHECK_EQUAL(CAN_segment_receive(&m_rx, frame), 0);
+	frame.data.bytes[0] = 1;
+	HOST_CHECK_EQUAL(CAN_segment_receive(&m_rx, frame), 0);
+	frame.data.bytes[0] = 0;
+	HOST_CHECK_EQUAL(CAN_segment_receive(&m_rx, frame), -1);
+
+	//The sequence wraps from 0x3F to 0
+	frame.data.bytes[0] = CAN_SEGMENT_FIRST | 0;
+	HOST_CHECK_EQUAL(CAN_segment_receive(&m_rx, frame), 0);
+	for(uint8_t i = 1; i <= CAN_SEGMENT_SEQUENCE_MASK; i++)
+	{
+		frame.data.bytes[0] = i;
+		HOST_CHECK_EQUAL(CAN_segment_receive(&m_rx, frame), 0);
+	}
+	frame.data.bytes[0] = CAN_SEGMENT_LAST | 0;
+	HOST_CHECK_EQUAL(CAN_segment_receive(&m_rx, frame), 1);
+	HOST_CHECK_EQUAL(m_rx.length, (CAN_SEGMENT_SEQUENCE_MASK + 2) * CAN_SEGMENT_PAYLOAD);
+
+	//Too much for the buffer
+	CAN_segment_init(&m_rx, small, sizeof(small));
+	frame.data.bytes[0] = CAN_SEGMENT_FIRST | 0;
+	HOST_CHECK_EQUAL(CAN_segment_receive(&m_rx, frame), 0);
+	frame.data.bytes[0] = CAN_SEGMENT_LAST | 1;
+	HOST_CHECK_EQUAL(CAN_segment_receive(&m_rx, frame), -2);
+}
+
+
+int main(void)
+{
+	for(uint16_t i = 0; i < TEST_MAX_LENGTH; i++) m_uchrSource[i] = (uint8_t)(i * 7 + (i >> 8));
+
+	TestOneMob();
+	TestSeveralMobs();
+	TestReceive();
+
+	HOST_CHECK_EQUAL(HostSimUnhandledInterrupts(), 0);
+
+	return HostTestResult("canSegment");
+}
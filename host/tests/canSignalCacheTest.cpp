@@ -0,0 +1,86 @@
+/**
+ * \file canSignalCacheTest.cpp
+ * \author Tim Robbins
+ * \brief Runs canSignalCache on frames from the simulated CAN bus. \n
+ * Checks cached ids keep only their newest frame with the millisecond it came, read back whole and only once as new, \n
+ * and that remote frames and ids outside the ranges go to the receive queue instead. \n
+ */
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <string.h>
+#include "hostSim.h"
+#include "hostTest.h"
+#include "avrTimers.h"
+#include "avrCanUtilities.h"
+#include "canSignalCache.h"
+
+
+///Puts a standard frame on the bus, with its first data byte as given
+static void Inject(uint32_t id, uint8_t first, bool remote)
+{
+	//Variables
+	HostCanFrame_t frame = { id, 0, (uint8_t)(remote ? 1 : 0), 4, { first, 2, 3, 4 } };
+
+	HOST_CHECK(HostCanInject(&frame));
+	HostSimRunMilliseconds(1);
+}
+
+
+int main(void)
+{
+	//Variables
+	CAN_FRAME frame;
+	uint8_t lastSeq = 0;
+	uint16_t stamp = 0;
+	uint16_t firstStamp = 0;
+	uint16_t sent = 0;
+
+	HostSimReset();
+	SystemTickInit();
+	CAN_init_tx(CAN_BPS_500K, false, 1);
+	Can0.watchFor();
+	CanCacheInit();
+	HOST_CHECK(CanCacheAddRange(0x300, 4, false));
+	sei();
+
+	//Nothing received yet
+	HOST_CHECK(CanCacheRead(0x301, false, &frame, 0) == false);
+
+	//A cached id is read back with its stamp, then isn't new until it comes again
+	HostSimRunMilliseconds(10);
+	sent = (uint16_t)SystemMillis();
+	Inject(0x301, 0x11, false);
+	HOST_CHECK(CanCacheReadNew(0x301, false, &frame, &lastSeq, &firstStamp));
+	HOST_CHECK_EQUAL(frame.id, 0x301);
+	HOST_CHECK_EQUAL(frame.length, 4);
+	HOST_CHECK_EQUAL(frame.data.bytes[0], 0x11);
+	HOST_CHECK((uint16_t)(firstStamp - sent) <= 1);
+	HOST_CHECK(CanCacheReadNew(0x301, false, &frame, &lastSeq) == false);
+	HOST_CHECK_EQUAL(Can0.available(), 0);
+
+	//Only the newest is kept, stamped when it came
+	HostSimRunMilliseconds(20);
+	Inject(0x301, 0x22, false);
+	Inject(0x301, 0x33, false);
+	HOST_CHECK(CanCacheReadNew(0x301, false, &frame, &lastSeq, &stamp));
+	HOST_CHECK_EQUAL(frame.data.bytes[0], 0x33);
+	HOST_CHECK(stamp - firstStamp >= 21 && stamp - firstStamp <= 23);
+
+	//A remote frame for a cached id isn't cached, it's queued with its flag set
+	Inject(0x302, 0, true);
+	HOST_CHECK(CanCacheRead(0x302, false, &frame, 0) == false);
+	HOST_CHECK_EQUAL(Can0.available(), 1);
+	HOST_CHECK(Can0.read(frame) != 0);
+	HOST_CHECK_EQUAL(frame.id, 0x302);
+	HOST_CHECK_EQUAL(frame.rtr, 1);
+
+	//An id outside the ranges is queued as a data frame
+	Inject(0x310, 0x44, false);
+	HOST_CHECK_EQUAL(Can0.available(), 1);
+	HOST_CHECK(Can0.read(frame) != 0);
+	HOST_CHECK_EQUAL(frame.id, 0x310);
+	HOST_CHECK_EQUAL(frame.rtr, 0);
+	HOST_CHECK_EQUAL(frame.data.bytes[0], 0x44);
+
+	return HostTestResult("canSignalCache");
+}
@@ -0,0 +1,127 @@
+/**
+ * \file canSignalGenTest.cpp
+ * \author Tim Robbins
+ * \brief Builds the header tools/canSignalGen.py makes from tools/canSignals.example.dbc and runs it. \n
+ * Checks each message packs to the bytes worked out by hand from the DBC layout, for little and big endian, \n
+ * signed and unsigned, aligned and unaligned signals, that signals don't spill into their neighbours, \n
+ * and that every value of the signed ones comes back the same from unpack. \n
+ */
+#include <avr/io.h>
+#include <string.h>
+#include "hostSim.h"
+#include "hostTest.h"
+#include "canSignals.h"
+
+
+///Checks a frame has the bytes given
+static void CheckBytes(const CAN_FRAME& frame, const uint8_t* expected)
+{
+	for(uint8_t i = 0; i < 8; i++) HOST_CHECK_EQUAL(frame.data.bytes[i], expected[i]);
+}
+
+
+static void TestEngineStatus(void)
+{
+	//Variables
+	const uint8_t expected[8] = { 0x34, 0x12, 0x56, 0xAB, 0x36, 0xFD, 0x0F, 0x00 };
+	EngineStatus_t msg = { 0x1234, 0x56, 0x2AB, 5, 1, -3 };
+	EngineStatus_t back;
+	CAN_FRAME frame;
+	uint16_t mismatches = 0;
+
+	EngineStatus_pack(frame, &msg);
+	HOST_CHECK_EQUAL(frame.id, 0x100);
+	HOST_CHECK_EQUAL(frame.extended, 0);
+	HOST_CHECK_EQUAL(frame.length, 8);
+	CheckBytes(frame, expected);
+
+	memset(&back, 0, sizeof(back));
+	EngineStatus_unpack(frame, &back);
+	HOST_CHECK_EQUAL(back.Rpm, 0x1234);
+	HOST_CHECK_EQUAL(back.ThrottlePosition, 0x2AB);
+	HOST_CHECK_EQUAL(back.Gear, 5);
+	HOST_CHECK_EQUAL(back.CheckEngine, 1);
+	HOST_CHECK_EQUAL(back.Torque, -3);
+	HOST_CHECK(EngineStatus_CoolantTemp_value(&back) == 46.0f);
+
+	//Every 12 bit torque, with the signals around it left alone
+	for(int16_t torque = -2048; torque < 2048; torque++)
+	{
+		msg.Torque = torque;
+		EngineStatus_pack(frame, &msg);
+		EngineStatus_unpack(frame, &back);
+		if(back.Torque != torque || frame.data.bytes[4] != 0x36 || (frame.data.bytes[6] & 0xF0) != 0) mismatches++;
+	}
+
+	HOST_CHECK_EQUAL(mismatches, 0);
+}
+
+
+static void TestBatteryPack(void)
+{
+	//Variables
+	const uint8_t expected[8] = { 0x12, 0x34, 0xFF, 0xFE, 0xC9, 0x00, 0x00, 0x00 };
+	BatteryPack_t msg = { 0x1234, -2, 100, 1 };
+	BatteryPack_t back;
+	CAN_FRAME frame;
+
+	BatteryPack_pack(frame, &msg);
+	HOST_CHECK_EQUAL(frame.id, 0x300);
+	HOST_CHECK_EQUAL(frame.extended, 1);
+	CheckBytes(frame, expected);
+
+	memset(&back, 0, sizeof(back));
+	BatteryPack_unpack(frame, &back);
+	HOST_CHECK_EQUAL(back.Voltage, 0x1234);
+	HOST_CHECK_EQUAL(back.Current, -2);
+	HOST_CHECK_EQUAL(back.StateOfCharge, 100);
+	HOST_CHECK_EQUAL(back.Fault, 1);
+}
+
+
+static void TestWheelSpeeds(void)
+{
+	//Variables
+	const uint8_t expected[8] = { 0xD8, 0xFF, 0x7F, 0x35, 0x78, 0x00, 0x00, 0xAA };
+	WheelSpeeds_t msg = { -5, 0x1ABC, 0x0A, 5 };
+	WheelSpeeds_t back;
+	CAN_FRAME frame;
+	uint16_t mismatches = 0;
+
+	WheelSpeeds_pack(frame, &msg);
+	CheckBytes(frame, expected);
+
+	memset(&back, 0, sizeof(back));
+	WheelSpeeds_unpack(frame, &back);
+	HOST_CHECK_EQUAL(back.Distance, -5);
+	HOST_CHECK_EQUAL(back.SpeedFrontLeft, 0x1ABC);
+	HOST_CHECK_EQUAL(back.Counter, 0x0A);
+	HOST_CHECK_EQUAL(back.Checksum, 5);
+
+	//The 20 bit distance over three bytes, at both ends of its range and around 0
+	for(int32_t distance = -524288; distance < 524288; distance += (distance > -1000 && distance < 1000) ? 1 : 997)
+	{
+		msg.Distance = distance;
+		WheelSpeeds_pack(frame, &msg);
+		WheelSpeeds_unpack(frame, &back);
+		if(back.Distance != distance || (frame.data.bytes[0] & 0x07) != 0 || frame.data.bytes[3] != 0x35) mismatches++;
+	}
+
+	msg.Distance = 524287;
+	WheelSpeeds_pack(frame, &msg);
+	WheelSpeeds_unpack(frame, &back);
+	HOST_CHECK_EQUAL(back.Distance, 524287);
+	HOST_CHECK_EQUAL(mismatches, 0);
+}
+
+
+int main(void)
+{
+	HostSimReset();
+
+	TestEngineStatus();
+	TestBatteryPack();
+	TestWheelSpeeds();
+
+	return HostTestResult("canSignalGen");
+}
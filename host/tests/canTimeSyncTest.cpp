@@ -0,0 +1,305 @@
+/**
+ * \file canTimeSyncTest.cpp
+ * \author Tim Robbins
+ * \brief Runs canTimeSync as the master and then as a node on the simulated CAN bus. \n
+ * The module keeps one node's state, so the two are run one after the other. The master's SYNC and FOLLOW_UP frames are checked \n
+ * against the simulator's clock, and the node is synced to a master played by the test whose clock runs a few hundred ppm \n
+ * fast or slow of its own. Checks the node's time converges on the master's, the drift lands on the difference, \n
+ * that a SYNC stamped just before the CAN timer wraps is taken right, that a lost or late FOLLOW_UP is ignored, \n
+ * and that the time still follows the master's for seconds with no sync. \n
+ */
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <string.h>
+#include "hostSim.h"
+#include "hostTest.h"
+#include "avrCanUtilities.h"
+#include "canTimeSync.h"
+
+
+///The master's time when the node's test starts, in microseconds
+#define TEST_MASTER_OFFSET			5000000UL
+
+///How far the node's time can be from the master's just after a sync, in microseconds
+#define TEST_SYNCED_US				3
+
+///How far the measured drift can be from the real one, in parts per million
+#define TEST_DRIFT_PPM				2
+
+///Register accesses take simulated time, so times read from the module are checked against the cycles before and after
+
+
+///The milliseconds the test has run
+static uint16_t m_uintNow = 0;
+
+///The cycles the test's master clock started at, and how much faster it runs than the simulator's in parts per million. \n
+///For the module's master, the cycles before and after its clock started
+static uint64_t m_ulMasterStart = 0;
+static uint64_t m_ulMasterStartAfter = 0;
+static int32_t m_lMasterPpm = 0;
+
+///The cycles the last SYNC was received or sent at
+static uint64_t m_ulSyncCycles = 0;
+
+///The CAN timer stamp of the last SYNC received, and the timer when it was taken
+static uint16_t m_uintSyncStamp = 0;
+static uint16_t m_uintSyncTakenAt = 0;
+
+///The SYNC and FOLLOW_UP frames the master sent
+static uint8_t m_uchrSyncs = 0;
+static uint8_t m_uchrFollowUps = 0;
+static uint8_t m_uchrSyncSequence = 0;
+static bool m_bFollowUpMatched = true;
+static bool m_bFollowUpInRange = true;
+
+
+///The cycles of a CAN timer tick
+static uint32_t TickCycles(void)
+{
+	return 8 * ((uint32_t)CANTCON + 1);
+}
+
+
+///The simulator's cycles at a CAN timer stamp less than a wrap old
+static uint64_t StampCycles(uint16_t stamp)
+{
+	//Variables
+	uint16_t timer = CANTIM;
+
+	return HostSimCycles() - (uint64_t)(uint16_t)(timer - stamp) * TickCycles();
+}
+
+
+///The microseconds since a number of cycles
+static uint32_t MicrosecondsSince(uint64_t start, uint64_t cycles)
+{
+	return (uint32_t)((cycles - start) / (F_CPU / 1000000UL));
+}
+
+
+///The time of the test's master at a number of cycles
+static uint32_t MasterTime(uint64_t cycles)
+{
+	return TEST_MASTER_OFFSET + (uint32_t)((double)(cycles - m_ulMasterStart) / (F_CPU / 1000000UL) * (1.0 + m_lMasterPpm / 1000000.0));
+}
+
+
+///How far a time is from another, either way
+static uint32_t Distance(uint32_t time, uint32_t expected)
+{
+	return ((int32_t)(time - expected) < 0) ? (expected - time) : (time - expected);
+}
+
+
+///If a time is no more than some microseconds outside the times given
+static bool Within(uint32_t time, uint32_t earliest, uint32_t latest, uint32_t tolerance)
+{
+	return ((int32_t)(time - earliest) >= -(int32_t)tolerance && (int32_t)(time - latest) <= (int32_t)tolerance);
+}
+
+
+static int8_t OnFrame(CAN_FRAME& frame)
+{
+	if(frame.id == CAN_TIME_SYNC_ID)
+	{
+		m_ulSyncCycles = StampCycles(frame.time);
+		m_uintSyncStamp = frame.time;
+		m_uintSyncTakenAt = CANTIM;
+	}
+
+	CanTimeReceive(frame);
+	return 0;
+}
+
+
+///Runs for some milliseconds, taking frames and polling as the main loop would
+static void Run(uint16_t milliseconds)
+{
+	for(uint16_t i = 0; i < milliseconds; i++)
+	{
+		HostSimRunMilliseconds(1);
+		while(CAN_process_frame(OnFrame) >= 0);
+		CanTimePoll(++m_uintNow);
+	}
+}
+
+
+///Puts a frame from the test's master on the bus
+static void Inject(uint16_t id, uint8_t sequence, bool followUp, uint32_t time)
+{
+	//Variables
+	HostCanFrame_t frame;
+
+	memset(&frame, 0, sizeof(frame));
+	frame.id = id;
+	frame.length = followUp ? 5 : 1;
+	frame.data[0] = sequence;
+
+	for(uint8_t i = 0; i < 4 && followUp; i++) frame.data[i + 1] = (uint8_t)(time >> (8 * i));
+
+	HOST_CHECK(HostCanInject(&frame));
+}
+
+
+///Sends a SYNC from the test's master, with its FOLLOW_UP if asked
+static void Sync(uint8_t sequence, bool followUp)
+{
+	Inject(CAN_TIME_SYNC_ID, sequence, false, 0);
+	Run(1);
+
+	if(followUp)
+	{
+		Inject(CAN_TIME_FOLLOW_UP_ID, sequence, true, MasterTime(m_ulSyncCycles));
+		Run(1);
+	}
+}
+
+
+///Checks the node's time is within some microseconds of the test's master
+static void CheckTime(uint32_t tolerance)
+{
+	//Variables
+	uint64_t before = HostSimCycles();
+	uint32_t now = CanTimeNow();
+	uint64_t after = HostSimCycles();
+
+	HOST_CHECK(Within(now, MasterTime(before), MasterTime(after), tolerance));
+}
+
+
+static void TestNode(int32_t ppm)
+{
+	//Variables
+	uint8_t sequence = 0;
+
+	HostSimReset();
+	CAN_init_tx(CAN_BPS_500K, false, 1);
+	Can0.watchFor();
+	CanTimeInit(false);
+	m_ulMasterStart = HostSimCycles();
+	m_lMasterPpm = ppm;
+	sei();
+
+	Run(100);
+	HOST_CHECK(!CanTimeSynced());
+
+	//The first sync moves the clock onto the master's, the second measures the drift
+	Sync(++sequence, true);
+	CheckTime(TEST_SYNCED_US);
+	HOST_CHECK(!CanTimeSynced());
+	Run(1000);
+	Sync(++sequence, true);
+	HOST_CHECK(CanTimeSynced());
+	HOST_CHECK(Distance((uint32_t)CanTimeDrift(), (uint32_t)ppm) <= TEST_DRIFT_PPM);
+
+	//Then it stays on the master's time between syncs
+	for(uint8_t i = 0; i < 4; i++)
+	{
+		Run(500);
+		CheckTime(TEST_SYNCED_US);
+		Run(500);
+		Sync(++sequence, true);
+		CheckTime(TEST_SYNCED_US);
+	}
+
+	HOST_CHECK(Distance((uint32_t)CanTimeDrift(), (uint32_t)ppm) <= TEST_DRIFT_PPM);
+
+	//A SYNC whose FOLLOW_UP was lost is dropped, and its FOLLOW_UP turning up after the next SYNC is ignored
+	Run(1000);
+	Sync(++sequence, false);
+	Run(1000);
+	Sync(++sequence, false);
+	Inject(CAN_TIME_FOLLOW_UP_ID, sequence - 1, true, MasterTime(m_ulSyncCycles) + 100000);
+	Run(1);
+	CheckTime(TEST_SYNCED_US + 6);
+	Inject(CAN_TIME_FOLLOW_UP_ID, sequence, true, MasterTime(m_ulSyncCycles));
+	Run(1);
+	CheckTime(TEST_SYNCED_US);
+	HOST_CHECK(Distance((uint32_t)CanTimeDrift(), (uint32_t)ppm) <= TEST_DRIFT_PPM);
+
+	//A SYNC stamped just before the CAN timer wraps and taken after
+	Run(900);
+	while(CANTIM < 0xFF00)
+	{
+		HostSimRunMicroseconds(20);
+		CanTimePoll(m_uintNow);
+	}
+	Sync(++sequence, true);
+	HOST_CHECK(m_uintSyncStamp > m_uintSyncTakenAt);
+	CheckTime(TEST_SYNCED_US);
+	HOST_CHECK(Distance((uint32_t)CanTimeDrift(), (uint32_t)ppm) <= TEST_DRIFT_PPM);
+
+	//Seconds with no sync, kept up by the drift, with the timer wrapping all the while
+	Run(8000);
+	CheckTime(TEST_SYNCED_US + 8 * TEST_DRIFT_PPM);
+	HOST_CHECK(!CanTimeSynced());
+
+	HOST_CHECK_EQUAL(HostSimUnhandledInterrupts(), 0);
+}
+
+
+static void OnMasterSent(const HostCanFrame_t* frame)
+{
+	//Variables
+	uint32_t time = 0;
+
+	if(frame->id == CAN_TIME_SYNC_ID)
+	{
+		m_ulSyncCycles = HostSimCycles();
+		m_uchrSyncSequence = frame->data[0];
+		m_uchrSyncs++;
+	}
+	else if(frame->id == CAN_TIME_FOLLOW_UP_ID)
+	{
+		for(uint8_t i = 0; i < 4; i++) time |= (uint32_t)frame->data[i + 1] << (8 * i);
+
+		if(frame->data[0] != m_uchrSyncSequence) m_bFollowUpMatched = false;
+		if(!Within(time, MicrosecondsSince(m_ulMasterStartAfter, m_ulSyncCycles), MicrosecondsSince(m_ulMasterStart, m_ulSyncCycles), 2)) m_bFollowUpInRange = false;
+		m_uchrFollowUps++;
+	}
+}
+
+
+static void TestMaster(void)
+{
+	//Variables
+	uint64_t before = 0;
+	uint32_t now = 0;
+
+	HostSimReset();
+	HostCanSetTxHook(OnMasterSent);
+	CAN_init_tx(CAN_BPS_500K, false, 1);
+	Can0.watchFor();
+	m_ulMasterStart = HostSimCycles();
+	CanTimeInit(true);
+	m_ulMasterStartAfter = HostSimCycles();
+	sei();
+
+	HOST_CHECK(CanTimeSynced());
+	Run(CAN_TIME_SYNC_PERIOD_MS * 3 + 500);
+
+	//A SYNC each period, each followed by the time on the master's clock it went out at
+	HOST_CHECK_EQUAL(m_uchrSyncs, 4);
+	HOST_CHECK_EQUAL(m_uchrFollowUps, 4);
+	HOST_CHECK(m_bFollowUpMatched);
+	HOST_CHECK(m_bFollowUpInRange);
+
+	//The master's clock is the CAN timer extended, and it kept count over every wrap
+	before = HostSimCycles();
+	now = CanTimeNow();
+	HOST_CHECK(Within(now, MicrosecondsSince(m_ulMasterStartAfter, before), MicrosecondsSince(m_ulMasterStart, HostSimCycles()), 2));
+	HOST_CHECK_EQUAL(CanTimeDrift(), 0);
+
+	HostCanSetTxHook(0);
+	HOST_CHECK_EQUAL(HostSimUnhandledInterrupts(), 0);
+}
+
+
+int main(void)
+{
+	TestMaster();
+	TestNode(300);
+	TestNode(-250);
+
+	return HostTestResult("canTimeSync");
+}
@@ -0,0 +1,199 @@
+/**
+ * \file formatTest.cpp
+ * \author Tim Robbins
+ * \brief Checks the strings mcuFormat makes. The value formatters at their limits, such as INT32_MIN, with widths, \n
+ * zero padding and left justifying, fixed point values smaller than their decimals, and the FormatString printf subset, \n
+ * including the lengths returned when the buffer cuts the string short. \n
+ */
+#include <stdarg.h>
+#include <string.h>
+#include "hostTest.h"
+#include "mcuFormat.h"
+
+
+///Checks the buffer holds the string expected, and the length returned was its length
+#define TEST_CHECK_STRING(length, expected)													\
+	do {																					\
+		size_t testLength = (length);														\
+		HOST_CHECK(strcmp(m_strBuffer, expected) == 0);										\
+		HOST_CHECK_EQUAL(testLength, strlen(expected));										\
+	} while(0)
+
+
+///Where the strings are formatted into, with room past FORMAT_BUFFER_SIZE for the widest width FormatString takes
+static char m_strBuffer[64];
+
+///What FormatPrint sent to the sink
+static char m_strPrinted[64];
+static uint8_t m_uchrPrinted = 0;
+
+
+static void Sink(char c)
+{
+	if(m_uchrPrinted < sizeof(m_strPrinted) - 1) m_strPrinted[m_uchrPrinted++] = c;
+}
+
+
+///Formats through FormatStringV, as a wrapper of the caller's would
+static uint16_t Format(char* buffer, uint16_t bufferSize, const char* format, ...)
+{
+	//Variables
+	va_list args;
+	uint16_t length = 0;
+
+	va_start(args, format);
+	length = FormatStringV(buffer, bufferSize, format, args);
+	va_end(args);
+
+	return length;
+}
+
+
+static void TestUnsigned(void)
+{
+	TEST_CHECK_STRING(FormatUnsigned(m_strBuffer, 0, 0, 0), "0");
+	TEST_CHECK_STRING(FormatUnsigned(m_strBuffer, 4294967295UL, 0, 0), "4294967295");
+	TEST_CHECK_STRING(FormatUnsigned(m_strBuffer, 1000000000UL, 0, 0), "1000000000");
+	TEST_CHECK_STRING(FormatUnsigned(m_strBuffer, 42, 5, 0), "   42");
+	TEST_CHECK_STRING(FormatUnsigned(m_strBuffer, 42, 5, FORMAT_PAD_ZERO), "00042");
+	TEST_CHECK_STRING(FormatUnsigned(m_strBuffer, 42, 5, FORMAT_LEFT), "42   ");
+	TEST_CHECK_STRING(FormatUnsigned(m_strBuffer, 12345, 3, FORMAT_PAD_ZERO), "12345");
+}
+
+
+static void TestSigned(void)
+{
+	TEST_CHECK_STRING(FormatSigned(m_strBuffer, 0, 0, 0), "0");
+	TEST_CHECK_STRING(FormatSigned(m_strBuffer, -5, 0, 0), "-5");
+	TEST_CHECK_STRING(FormatSigned(m_strBuffer, INT32_MAX, 0, 0), "2147483647");
+	TEST_CHECK_STRING(FormatSigned(m_strBuffer, INT32_MIN, 0, 0), "-2147483648");
+	TEST_CHECK_STRING(FormatSigned(m_strBuffer, INT32_MIN, 13, FORMAT_PAD_ZERO), "-002147483648");
+
+	//The width counts the sign, and zeros go after it
+	TEST_CHECK_STRING(FormatSigned(m_strBuffer, -42, 6, 0), "   -42");
+	TEST_CHECK_STRING(FormatSigned(m_strBuffer, -42, 6, FORMAT_PAD_ZERO), "-00042");
+	TEST_CHECK_STRING(FormatSigned(m_strBuffer, -42, 6, FORMAT_LEFT), "-42   ");
+	TEST_CHECK_STRING(FormatSigned(m_strBuffer, 42, 6, FORMAT_PAD_ZERO), "000042");
+}
+
+
+static void TestHex(void)
+{
+	TEST_CHECK_STRING(FormatHex(m_strBuffer, 0, 0, 0), "0");
+	TEST_CHECK_STRING(FormatHex(m_strBuffer, 0xBEEF, 0, 0), "beef");
+	TEST_CHECK_STRING(FormatHex(m_strBuffer, 0xBEEF, 0, FORMAT_UPPER), "BEEF");
+	TEST_CHECK_STRING(FormatHex(m_strBuffer, 0xFFFFFFFFUL, 0, 0), "ffffffff");
+	TEST_CHECK_STRING(FormatHex(m_strBuffer, 0x80000000UL, 0, 0), "80000000");
+	TEST_CHECK_STRING(FormatHex(m_strBuffer, 0x0F, 2, FORMAT_PAD_ZERO | FORMAT_UPPER), "0F");
+	TEST_CHECK_STRING(FormatHex(m_strBuffer, 0x0100, 0, 0), "100");
+	TEST_CHECK_STRING(FormatHex(m_strBuffer, 0x1, 4, 0), "   1");
+	TEST_CHECK_STRING(FormatHex(m_strBuffer, 0x1, 4, FORMAT_LEFT), "1   ");
+}
+
+
+static void TestFixed(void)
+{
+	TEST_CHECK_STRING(FormatFixed(m_strBuffer, 4987, 3, 0, 0), "4.987");
+	TEST_CHECK_STRING(FormatFixed(m_strBuffer, 1000, 3, 0, 0), "1.000");
+	TEST_CHECK_STRING(FormatFixed(m_strBuffer, 1234, 0, 0, 0), "1234");
+
+	//Smaller than the decimals, with zeros between the point and the digits
+	TEST_CHECK_STRING(FormatFixed(m_strBuffer, 5, 3, 0, 0), "0.005");
+	TEST_CHECK_STRING(FormatFixed(m_strBuffer, 50, 3, 0, 0), "0.050");
+	TEST_CHECK_STRING(FormatFixed(m_strBuffer, 0, 2, 0, 0), "0.00");
+	TEST_CHECK_STRING(FormatFixed(m_strBuffer, 123, 3, 0, 0), "0.123");
+
+	//Negative
+	TEST_CHECK_STRING(FormatFixed(m_strBuffer, -5, 3, 0, 0), "-0.005");
+	TEST_CHECK_STRING(FormatFixed(m_strBuffer, -1234, 2, 0, 0), "-12.34");
+	TEST_CHECK_STRING(FormatFixed(m_strBuffer, -1234, 0, 0, 0), "-1234");
+	TEST_CHECK_STRING(FormatFixed(m_strBuffer, INT32_MIN, 9, 0, 0), "-2.147483648");
+	TEST_CHECK_STRING(FormatFixed(m_strBuffer, INT32_MIN, 3, 0, 0), "-2147483.648");
+
+	//The width counts the sign and the point
+	TEST_CHECK_STRING(FormatFixed(m_strBuffer, 12, 2, 7, 0), "   0.12");
+	TEST_CHECK_STRING(FormatFixed(m_strBuffer, 12, 2, 7, FORMAT_PAD_ZERO), "0000.12");
+	TEST_CHECK_STRING(FormatFixed(m_strBuffer, -12, 2, 7, FORMAT_PAD_ZERO), "-000.12");
+	TEST_CHECK_STRING(FormatFixed(m_strBuffer, -12, 2, 7, FORMAT_LEFT), "-0.12  ");
+
+	//More than 9 decimals is 9
+	TEST_CHECK_STRING(FormatFixed(m_strBuffer, 5, 12, 0, 0), "0.000000005");
+}
+
+
+static void TestString(void)
+{
+	//Variables
+	char small[8];
+
+	TEST_CHECK_STRING(FormatString(m_strBuffer, sizeof(m_strBuffer), "plain"), "plain");
+	TEST_CHECK_STRING(FormatString(m_strBuffer, sizeof(m_strBuffer), "%d %i %u", -123, 45, 678), "-123 45 678");
+	TEST_CHECK_STRING(FormatString(m_strBuffer, sizeof(m_strBuffer), "%ld %lu", (int32_t)INT32_MIN, (uint32_t)4294967295UL), "-2147483648 4294967295");
+	TEST_CHECK_STRING(FormatString(m_strBuffer, sizeof(m_strBuffer), "%x %X %04x %lx", 0xab, 0xab, 0xab, (uint32_t)0xDEADBEEFUL), "ab AB 00ab deadbeef");
+	TEST_CHECK_STRING(FormatString(m_strBuffer, sizeof(m_strBuffer), "%c%s%%", 'A', "bc"), "Abc%");
+
+	//Flags and widths
+	TEST_CHECK_STRING(FormatString(m_strBuffer, sizeof(m_strBuffer), "%5u|%-5u|%05u", 42, 42, 42), "   42|42   |00042");
+	TEST_CHECK_STRING(FormatString(m_strBuffer, sizeof(m_strBuffer), "%6d|%-6d|%06d", -42, -42, -42), "   -42|-42   |-00042");
+	TEST_CHECK_STRING(FormatString(m_strBuffer, sizeof(m_strBuffer), "%6s|%-6s|%1s", "ab", "ab", "abc"), "    ab|ab    |abc");
+	TEST_CHECK_STRING(FormatString(m_strBuffer, sizeof(m_strBuffer), "%-05u|", 7), "7    |");
+
+	//Fixed point, with the precision as the decimals
+	TEST_CHECK_STRING(FormatString(m_strBuffer, sizeof(m_strBuffer), "%.3q", 5), "0.005");
+	TEST_CHECK_STRING(FormatString(m_strBuffer, sizeof(m_strBuffer), "%.2q", -1234), "-12.34");
+	TEST_CHECK_STRING(FormatString(m_strBuffer, sizeof(m_strBuffer), "%q", 42), "42");
+	TEST_CHECK_STRING(FormatString(m_strBuffer, sizeof(m_strBuffer), "%08.3lq", (int32_t)123456), "0123.456");
+	TEST_CHECK_STRING(FormatString(m_strBuffer, sizeof(m_strBuffer), "%-8.1qV", 123), "12.3    V");
+	TEST_CHECK_STRING(FormatString(m_strBuffer, sizeof(m_strBuffer), "%3u%% %.3qV", 87, 4987), " 87% 4.987V");
+
+	//Widths past what the value buffer takes are cut to 29
+	TEST_CHECK_STRING(FormatString(m_strBuffer, sizeof(m_strBuffer), "%40u", 1), "                            1");
+
+	//Unknown types are output as they are, and a format ending mid specifier stops there
+	TEST_CHECK_STRING(FormatString(m_strBuffer, sizeof(m_strBuffer), "%y"), "y");
+	TEST_CHECK_STRING(FormatString(m_strBuffer, sizeof(m_strBuffer), "ab%"), "ab");
+
+	//Cut short, it's still terminated and the length is what the full string would have been
+	HOST_CHECK_EQUAL(FormatString(small, sizeof(small), "%s", "abcdefghij"), 10);
+	HOST_CHECK(strcmp(small, "abcdefg") == 0);
+	HOST_CHECK_EQUAL(FormatString(small, sizeof(small), "%u", 1234567UL), 7);
+	HOST_CHECK(strcmp(small, "1234567") == 0);
+	HOST_CHECK_EQUAL(FormatString(small, sizeof(small), "%lu", (uint32_t)12345678UL), 8);
+	HOST_CHECK(strcmp(small, "1234567") == 0);
+	HOST_CHECK_EQUAL(FormatString(small, 1, "%d", 5), 1);
+	HOST_CHECK_EQUAL(small[0], '\0');
+
+	//A buffer of no size isn't written at all
+	small[0] = 'x';
+	HOST_CHECK_EQUAL(FormatString(small, 0, "%d", 5), 1);
+	HOST_CHECK_EQUAL(small[0], 'x');
+
+	//FormatStringV, as from a wrapper
+	HOST_CHECK_EQUAL(Format(m_strBuffer, sizeof(m_strBuffer), "%s=%.2q", "v", 314), 6);
+	HOST_CHECK(strcmp(m_strBuffer, "v=3.14") == 0);
+	HOST_CHECK_EQUAL(Format(small, 4, "%s=%.2q", "v", 314), 6);
+	HOST_CHECK(strcmp(small, "v=3") == 0);
+}
+
+
+static void TestPrint(void)
+{
+	m_uchrPrinted = 0;
+	memset(m_strPrinted, 0, sizeof(m_strPrinted));
+
+	FormatPrint(Sink, "%3u%% %.3qV %-4s|", 87, -4987, "ok");
+	HOST_CHECK(strcmp(m_strPrinted, " 87% -4.987V ok  |") == 0);
+}
+
+
+int main(void)
+{
+	TestUnsigned();
+	TestSigned();
+	TestHex();
+	TestFixed();
+	TestString();
+	TestPrint();
+
+	return HostTestResult("format");
+}
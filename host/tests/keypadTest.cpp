@@ -0,0 +1,307 @@
+/**
+ * \file keypadTest.cpp
+ * \author Tim Robbins
+ * \brief Runs the interrupt driven keypad scanning on a simulated 4x3 matrix, its columns on PORTC and its rows on PORTB. \n
+ * The row pins are set through the simulator from the keys held and the columns driven low, so a press while parked raises \n
+ * the pin change interrupt. Checks a press wakes the scanning, the down, repeat and up events come after their scans with \n
+ * the key values, that held keys roll over with the repeat following the most recent one, and that it parks again once released. \n
+ */
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <string.h>
+#include "hostSim.h"
+#include "hostTest.h"
+#include "ckeypadMatrix.h"
+
+
+///The ticks of a full scan
+#define TEST_SCAN_TICKS				KP_COLUMNS
+
+
+///The column pins on PORTC and the row pins on PORTB, spread out so the pin positions are used rather than the indexes
+static const unsigned char m_uchrColumnPins[KP_COLUMNS] = { 0, 2, 5 };
+static const unsigned char m_uchrRowPins[KP_ROWS] = { 1, 3, 4, 6 };
+
+///The key values
+static const unsigned char m_uchrValues[KP_ROWS][KP_COLUMNS] =
+{
+	{ '1', '2', '3' },
+	{ '4', '5', '6' },
+	{ '7', '8', '9' },
+	{ '*', '0', '#' }
+};
+
+///The keys held
+static bool m_bHeld[KP_ROWS][KP_COLUMNS];
+
+
+///Sets the row pins from the keys held, a row reading low when a held key joins it to a column driven low
+static void UpdateRows(void)
+{
+	//Variables
+	bool low = false;
+
+	for(uint8_t row = 0; row < KP_ROWS; row++)
+	{
+		low = false;
+
+		for(uint8_t column = 0; column < KP_COLUMNS; column++)
+		{
+			if(m_bHeld[row][column] && (DDRC & (1 << m_uchrColumnPins[column])) && !(PORTC & (1 << m_uchrColumnPins[column])))
+			{
+				low = true;
+			}
+		}
+
+		HostGpioSetPin(&PINB, m_uchrRowPins[row], !low);
+	}
+}
+
+
+static void Press(uint8_t row, uint8_t column)
+{
+	m_bHeld[row][column] = true;
+	UpdateRows();
+}
+
+
+static void Release(uint8_t row, uint8_t column)
+{
+	m_bHeld[row][column] = false;
+	UpdateRows();
+}
+
+
+///Runs some ticks, the rows settling to the column driven before each
+static void Tick(uint16_t ticks)
+{
+	for(uint16_t i = 0; i < ticks; i++)
+	{
+		UpdateRows();
+		kp_Tick();
+	}
+}
+
+
+///Runs full scans until there's an event, up to some scans, returning the scans it took or 0 if there was none
+static uint16_t ScansToEvent(kp_event_t* keyEvent, uint16_t limit)
+{
+	for(uint16_t scans = 1; scans <= limit; scans++)
+	{
+		Tick(TEST_SCAN_TICKS);
+
+		if(kp_GetEvent(keyEvent))
+		{
+			return scans;
+		}
+	}
+
+	return 0;
+}
+
+
+///Checks an event
+static bool IsEvent(const kp_event_t* keyEvent, uint8_t key, uint8_t type)
+{
+	return (keyEvent->key == key && keyEvent->type == type);
+}
+
+
+///The bit of a key in the keymap
+static kp_keymap_t KeyBit(uint8_t row, uint8_t column)
+{
+	return ((kp_keymap_t)1 << (row * KP_COLUMNS + column));
+}
+
+
+static void TestParked(void)
+{
+	//Variables
+	kp_event_t keyEvent;
+
+	//Parked with every column low, so any key can wake it, and the rows pulled up
+	HOST_CHECK(kp_IsIdle());
+	HOST_CHECK_EQUAL(DDRC & 0x25, 0x25);
+	HOST_CHECK_EQUAL(PORTC & 0x25, 0);
+	HOST_CHECK_EQUAL(DDRB & 0x5A, 0);
+	HOST_CHECK_EQUAL(PORTB & 0x5A, 0x5A);
+	HOST_CHECK_EQUAL(PCMSK0 & 0x5A, 0x5A);
+	HOST_CHECK(PCICR & (1 << PCIE0));
+
+	//Nothing happens while parked
+	Tick(10 * TEST_SCAN_TICKS);
+	HOST_CHECK(kp_IsIdle());
+	HOST_CHECK(!kp_GetEvent(&keyEvent));
+}
+
+
+static void TestPressAndRelease(void)
+{
+	//Variables
+	kp_event_t keyEvent;
+
+	//The press wakes it through the pin change interrupt, which turns itself off while scanning
+	Press(1, 1);
+	HOST_CHECK(!kp_IsIdle());
+	HOST_CHECK_EQUAL(PCICR & (1 << PCIE0), 0);
+
+	//Down once it has read the same for the debounce scans
+	HOST_CHECK_EQUAL(ScansToEvent(&keyEvent, 10), KP_DEBOUNCE_SCANS);
+	HOST_CHECK(IsEvent(&keyEvent, '5', KP_EVENT_DOWN));
+	HOST_CHECK_EQUAL(kp_GetKeymap(), KeyBit(1, 1));
+
+	//Repeats after the delay, counted from the scan it went down on, then at the rate
+	HOST_CHECK_EQUAL(ScansToEvent(&keyEvent, 100), KP_REPEAT_DELAY_SCANS - 1);
+	HOST_CHECK(IsEvent(&keyEvent, '5', KP_EVENT_REPEAT));
+
+	for(uint8_t i = 0; i < 3; i++)
+	{
+		HOST_CHECK_EQUAL(ScansToEvent(&keyEvent, 100), KP_REPEAT_RATE_SCANS);
+		HOST_CHECK(IsEvent(&keyEvent, '5', KP_EVENT_REPEAT));
+	}
+
+	//Up once released for the debounce scans, parking again on the same scan
+	Release(1, 1);
+	HOST_CHECK_EQUAL(ScansToEvent(&keyEvent, 10), KP_DEBOUNCE_SCANS);
+	HOST_CHECK(IsEvent(&keyEvent, '5', KP_EVENT_UP));
+	HOST_CHECK_EQUAL(kp_GetKeymap(), 0);
+	HOST_CHECK(kp_IsIdle());
+	HOST_CHECK(PCICR & (1 << PCIE0));
+	HOST_CHECK_EQUAL(DDRC & 0x25, 0x25);
+	HOST_CHECK_EQUAL(PORTC & 0x25, 0);
+
+	Tick(100 * TEST_SCAN_TICKS);
+	HOST_CHECK(!kp_GetEvent(&keyEvent));
+}
+
+
+static void TestBounce(void)
+{
+	//Variables
+	kp_event_t keyEvent;
+
+	//A press shorter than the debounce wakes it but gives no events, and it parks again
+	Press(3, 2);
+	Tick(TEST_SCAN_TICKS);
+	Release(3, 2);
+	HOST_CHECK_EQUAL(ScansToEvent(&keyEvent, 10), 0);
+	HOST_CHECK(kp_IsIdle());
+	HOST_CHECK_EQUAL(kp_GetKeymap(), 0);
+}
+
+
+static void TestRollover(void)
+{
+	//Variables
+	kp_event_t keyEvent;
+
+	//Three keys held together, none on a rectangle's corners so none ghost, each going down in turn
+	Press(0, 0);
+	HOST_CHECK_EQUAL(ScansToEvent(&keyEvent, 10), KP_DEBOUNCE_SCANS);
+	HOST_CHECK(IsEvent(&keyEvent, '1', KP_EVENT_DOWN));
+
+	Press(2, 2);
+	HOST_CHECK_EQUAL(ScansToEvent(&keyEvent, 10), KP_DEBOUNCE_SCANS);
+	HOST_CHECK(IsEvent(&keyEvent, '9', KP_EVENT_DOWN));
+
+	Press(3, 1);
+	HOST_CHECK_EQUAL(ScansToEvent(&keyEvent, 10), KP_DEBOUNCE_SCANS);
+	HOST_CHECK(IsEvent(&keyEvent, '0', KP_EVENT_DOWN));
+	HOST_CHECK_EQUAL(kp_GetKeymap(), KeyBit(0, 0) | KeyBit(2, 2) | KeyBit(3, 1));
+
+	//Only the most recent key repeats
+	HOST_CHECK_EQUAL(ScansToEvent(&keyEvent, 100), KP_REPEAT_DELAY_SCANS - 1);
+	HOST_CHECK(IsEvent(&keyEvent, '0', KP_EVENT_REPEAT));
+
+	//Releasing it stops the repeats, while the others stay down
+	Release(3, 1);
+	HOST_CHECK_EQUAL(ScansToEvent(&keyEvent, 10), KP_DEBOUNCE_SCANS);
+	HOST_CHECK(IsEvent(&keyEvent, '0', KP_EVENT_UP));
+	HOST_CHECK_EQUAL(ScansToEvent(&keyEvent, 2 * KP_REPEAT_DELAY_SCANS), 0);
+	HOST_CHECK_EQUAL(kp_GetKeymap(), KeyBit(0, 0) | KeyBit(2, 2));
+	HOST_CHECK(!kp_IsIdle());
+
+	//Two going down on the same scan are queued lowest key first, and the repeat takes the last of them
+	Press(1, 0);
+	Press(3, 2);
+	HOST_CHECK_EQUAL(ScansToEvent(&keyEvent, 10), KP_DEBOUNCE_SCANS);
+	HOST_CHECK(IsEvent(&keyEvent, '4', KP_EVENT_DOWN));
+	HOST_CHECK(kp_GetEvent(&keyEvent));
+	HOST_CHECK(IsEvent(&keyEvent, '#', KP_EVENT_DOWN));
+	HOST_CHECK_EQUAL(ScansToEvent(&keyEvent, 100), KP_REPEAT_DELAY_SCANS - 1);
+	HOST_CHECK(IsEvent(&keyEvent, '#', KP_EVENT_REPEAT));
+
+	//All released together
+	memset(m_bHeld, 0, sizeof(m_bHeld));
+	UpdateRows();
+	HOST_CHECK_EQUAL(ScansToEvent(&keyEvent, 10), KP_DEBOUNCE_SCANS);
+	HOST_CHECK(IsEvent(&keyEvent, '1', KP_EVENT_UP));
+
+	for(uint8_t i = 0; i < 3; i++)
+	{
+		HOST_CHECK(kp_GetEvent(&keyEvent));
+		HOST_CHECK_EQUAL(keyEvent.type, KP_EVENT_UP);
+	}
+
+	HOST_CHECK(!kp_GetEvent(&keyEvent));
+	HOST_CHECK(kp_IsIdle());
+}
+
+
+static void TestQueueFull(void)
+{
+	//Variables
+	kp_event_t keyEvent;
+	uint8_t events = 0;
+
+	//Left unread, the queue keeps the oldest events and drops the rest
+	Press(2, 0);
+	Tick((KP_DEBOUNCE_SCANS + KP_REPEAT_DELAY_SCANS + KP_REPEAT_RATE_SCANS * KP_EVENT_QUEUE_SIZE) * TEST_SCAN_TICKS);
+	Release(2, 0);
+	Tick(KP_DEBOUNCE_SCANS * TEST_SCAN_TICKS);
+	HOST_CHECK(kp_IsIdle());
+
+	HOST_CHECK(kp_GetEvent(&keyEvent));
+	HOST_CHECK(IsEvent(&keyEvent, '7', KP_EVENT_DOWN));
+	events++;
+
+	while(kp_GetEvent(&keyEvent))
+	{
+		HOST_CHECK(IsEvent(&keyEvent, '7', KP_EVENT_REPEAT));
+		events++;
+	}
+
+	HOST_CHECK_EQUAL(events, KP_EVENT_QUEUE_SIZE - 1);
+
+	//With room again, the next press is taken
+	Press(0, 2);
+	HOST_CHECK_EQUAL(ScansToEvent(&keyEvent, 10), KP_DEBOUNCE_SCANS);
+	HOST_CHECK(IsEvent(&keyEvent, '3', KP_EVENT_DOWN));
+	Release(0, 2);
+	HOST_CHECK_EQUAL(ScansToEvent(&keyEvent, 10), KP_DEBOUNCE_SCANS);
+	HOST_CHECK(IsEvent(&keyEvent, '3', KP_EVENT_UP));
+	HOST_CHECK(kp_IsIdle());
+}
+
+
+int main(void)
+{
+	HostSimReset();
+	memset(m_bHeld, 0, sizeof(m_bHeld));
+
+	//Rows pulled up with nothing held
+	for(uint8_t row = 0; row < KP_ROWS; row++) HostGpioSetPin(&PINB, m_uchrRowPins[row], true);
+
+	kp_InterruptInit(m_uchrColumnPins, m_uchrRowPins, m_uchrValues);
+	sei();
+
+	TestParked();
+	TestPressAndRelease();
+	TestBounce();
+	TestRollover();
+	TestQueueFull();
+
+	HOST_CHECK_EQUAL(HostSimUnhandledInterrupts(), 0);
+
+	return HostTestResult("keypad");
+}
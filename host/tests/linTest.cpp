@@ -0,0 +1,176 @@
+/**
+ * \file linTest.cpp
+ * \author Tim Robbins
+ * \brief Runs avrLin against the simulated LIN/UART, as the master with a schedule table and as a slave. \n
+ * Checks the headers go out in the schedule's order and timing, a schedule change waits for the end of the slot, \n
+ * published frames send their buffer, subscribed ones fill theirs, unanswered headers count as misses, \n
+ * and the bit timing and baud rate tolerance for each end. \n
+ */
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <string.h>
+#include "hostSim.h"
+#include "hostTest.h"
+#include "avrLin.h"
+
+
+///The most headers kept by the hook
+#define TEST_MAX_HEADERS			32
+
+
+///The frames of the test, one published and two subscribed, the last never answered
+static LinFrame_t m_frames[] =
+{
+	{ 0x10, 2, LIN_FRAME_PUBLISH },
+	{ 0x20, 4, 0 },
+	{ 0x21, 2, 0 },
+};
+
+///The master's schedule
+static const LinSlot_t m_scheduleA[] = { { &m_frames[0], 10 }, { &m_frames[1], 10 }, { &m_frames[2], 5 } };
+
+///The schedule changed to
+static const LinSlot_t m_scheduleB[] = { { &m_frames[1], 5 } };
+
+///The ids of the headers the master sent
+static uint8_t m_uchrHeaders[TEST_MAX_HEADERS];
+static uint8_t m_uchrHeaderCount = 0;
+
+///The response the slave played by the test answers 0x20 with
+static const uint8_t m_uchrSlaveResponse[4] = { 1, 2, 3, 4 };
+
+
+static void OnHeader(uint8_t protectedId)
+{
+	if(m_uchrHeaderCount < TEST_MAX_HEADERS) m_uchrHeaders[m_uchrHeaderCount++] = protectedId & 0x3F;
+	if((protectedId & 0x3F) == 0x20) HostLinInjectResponse(m_uchrSlaveResponse, sizeof(m_uchrSlaveResponse));
+}
+
+
+/**
+ * \brief Runs the bus for some milliseconds, calling LinTick at the start of each as the tick interrupt would
+ */
+static void Tick(uint8_t milliseconds)
+{
+	for(uint8_t i = 0; i < milliseconds; i++)
+	{
+		cli();
+		LinTick();
+		sei();
+		HostSimRunMilliseconds(1);
+	}
+}
+
+
+static void TestMaster(void)
+{
+	//Variables
+	const uint8_t published[2] = { 0x12, 0x34 };
+	const uint8_t expected[6] = { 0x10, 0x20, 0x21, 0x10, 0x20, 0x21 };
+	uint8_t data[8];
+	uint8_t sent[8];
+
+	//The master's clock has to be within 0.5%, and its bit timing isn't resynchronised
+	HOST_CHECK(LinInit(106000, true, m_frames, 3) == false);
+	HOST_CHECK(LinInit(19200, true, m_frames, 3));
+	HOST_CHECK(LINBTR & (1 << LDISR));
+	HOST_CHECK_EQUAL(LINBTR & 0x3F, 25);
+
+	LinFrameWrite(&m_frames[0], published);
+	HOST_CHECK(LinScheduleSet(m_scheduleA, 3));
+	LinScheduleStart();
+
+	//Slots of 10, 10 and 5ms send a header at 0, 10, 20, 25, 35 and 45ms, each on the bus for under 2ms
+	Tick(47);
+	HOST_CHECK_EQUAL(m_uchrHeaderCount, 6);
+	for(uint8_t i = 0; i < 6; i++) HOST_CHECK_EQUAL(m_uchrHeaders[i], expected[i]);
+
+	//The published frame's buffer went out after both of its headers
+	HOST_CHECK_EQUAL(HostUartTake(HOST_UART_LIN, sent, sizeof(sent)), 4);
+	HOST_CHECK_EQUAL(sent[0], 0x12);
+	HOST_CHECK_EQUAL(sent[3], 0x34);
+
+	//The answered frame was filled, once per response
+	HOST_CHECK(LinFrameRead(&m_frames[1], data));
+	HOST_CHECK(memcmp(data, m_uchrSlaveResponse, 4) == 0);
+	HOST_CHECK(LinFrameRead(&m_frames[1], data) == false);
+	HOST_CHECK_EQUAL(m_frames[1].misses, 0);
+	HOST_CHECK_EQUAL(m_frames[1].errors, 0);
+
+	//The unanswered one counted a miss when its first slot ended, the second is still going
+	HOST_CHECK_EQUAL(m_frames[2].misses, 1);
+	HOST_CHECK(LinFrameRead(&m_frames[2], data) == false);
+
+	//A new table starts once the slot going ends, at 50ms
+	HOST_CHECK(LinScheduleSet(m_scheduleB, 1));
+	m_uchrHeaderCount = 0;
+	Tick(3);
+	HOST_CHECK_EQUAL(m_uchrHeaderCount, 0);
+	Tick(12);
+	HOST_CHECK_EQUAL(m_uchrHeaderCount, 3);
+	for(uint8_t i = 0; i < m_uchrHeaderCount; i++) HOST_CHECK_EQUAL(m_uchrHeaders[i], 0x20);
+	HOST_CHECK_EQUAL(m_frames[2].misses, 2);
+
+	//Stopped, nothing more is sent
+	LinScheduleStop();
+	HostSimRunMilliseconds(5);
+	m_uchrHeaderCount = 0;
+	Tick(20);
+	HOST_CHECK_EQUAL(m_uchrHeaderCount, 0);
+	HostUartTake(HOST_UART_LIN, sent, sizeof(sent));
+}
+
+
+static void TestSlave(void)
+{
+	//Variables
+	const uint8_t published[2] = { 0x56, 0x78 };
+	const uint8_t response[4] = { 9, 8, 7, 6 };
+	uint8_t data[8];
+	uint8_t sent[8];
+
+	//A slave only has to be within its own tolerance, and resynchronises to the master
+	HOST_CHECK(LinInit(381000, false, m_frames, 3) == false);
+	HOST_CHECK(LinInit(106000, false, m_frames, 3));
+	HOST_CHECK(LinInit(19200, false, m_frames, 3));
+	HOST_CHECK((LINBTR & (1 << LDISR)) == 0);
+	HOST_CHECK_EQUAL(LINBTR & 0x3F, 25);
+	HOST_CHECK(LinScheduleSet(m_scheduleA, 3) == false);
+
+	//A header for a published frame is answered with its buffer
+	LinFrameWrite(&m_frames[0], published);
+	HostLinInjectHeader(0x10);
+	HostSimRunMilliseconds(5);
+	HOST_CHECK_EQUAL(HostUartTake(HOST_UART_LIN, sent, sizeof(sent)), 2);
+	HOST_CHECK_EQUAL(sent[0], 0x56);
+	HOST_CHECK_EQUAL(sent[1], 0x78);
+
+	//A header for a subscribed frame takes the response after it
+	HostLinInjectHeader(0x20);
+	HostLinInjectResponse(response, sizeof(response));
+	HostSimRunMilliseconds(5);
+	HOST_CHECK(LinFrameRead(&m_frames[1], data));
+	HOST_CHECK(memcmp(data, response, 4) == 0);
+
+	//A header for a frame the node doesn't take part in is ignored
+	HostLinInjectHeader(0x33);
+	HostSimRunMilliseconds(5);
+	HOST_CHECK_EQUAL(HostUartTake(HOST_UART_LIN, sent, sizeof(sent)), 0);
+	HOST_CHECK(LinFrameRead(&m_frames[1], data) == false);
+	HOST_CHECK(LinFrameRead(&m_frames[2], data) == false);
+}
+
+
+int main(void)
+{
+	HostSimReset();
+	HostLinSetHeaderHook(OnHeader);
+	sei();
+
+	TestMaster();
+	TestSlave();
+
+	HOST_CHECK_EQUAL(HostSimUnhandledInterrupts(), 0);
+
+	return HostTestResult("lin");
+}
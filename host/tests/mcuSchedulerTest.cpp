@@ -0,0 +1,238 @@
+/**
+ * \file mcuSchedulerTest.cpp
+ * \author Tim Robbins
+ * \brief Runs mcuScheduler with its events posted from the USART0 receive interrupt, fed bytes by the simulator. \n
+ * Each byte received is an event, its high nibble the priority posted to and its low nibble the signal. \n
+ * Checks events are dispatched highest priority first and in order within a priority, including ones posted by handlers, \n
+ * that a full queue drops and counts the events past it, and that only events left waiting past their task's deadline count as misses. \n
+ */
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <string.h>
+#include "hostSim.h"
+#include "hostTest.h"
+#include "avrTimers.h"
+#include "mcuScheduler.h"
+
+
+///The most events kept in the log
+#define TEST_MAX_LOG				16
+
+///The signal the lowest priority task answers by posting to the highest
+#define TEST_SIGNAL_ESCALATE		0x0F
+
+
+typedef struct
+{
+	uint8_t priority;
+	uint8_t signal;
+	uint16_t param;
+}
+Dispatched_t;
+
+
+///The events dispatched, in order
+static Dispatched_t m_log[TEST_MAX_LOG];
+static uint8_t m_uchrLogged = 0;
+
+///The events the interrupt posted, which is the param of each, and the ones SchedulerPost turned down
+static uint16_t m_uintPosted = 0;
+static uint8_t m_uchrRefused = 0;
+
+///The system milliseconds the last event was posted at
+static uint32_t m_ulPostedAt = 0;
+
+
+ISR(USART0_RX_vect)
+{
+	//Variables
+	uint8_t data = UDR0;
+
+	m_ulPostedAt = SystemMillis();
+	if(!SchedulerPost(data >> 4, data & 0x0F, m_uintPosted++)) m_uchrRefused++;
+}
+
+
+static void Log(uint8_t priority, const SchedulerEvent_t* event)
+{
+	if(m_uchrLogged < TEST_MAX_LOG)
+	{
+		m_log[m_uchrLogged].priority = priority;
+		m_log[m_uchrLogged].signal = event->signal;
+		m_log[m_uchrLogged].param = event->param;
+		m_uchrLogged++;
+	}
+}
+
+
+static void HandleTop(const SchedulerEvent_t* event)
+{
+	Log(0, event);
+}
+
+
+static void HandleMiddle(const SchedulerEvent_t* event)
+{
+	Log(1, event);
+}
+
+
+static void HandleBottom(const SchedulerEvent_t* event)
+{
+	Log(3, event);
+
+	if(event->signal == TEST_SIGNAL_ESCALATE) SchedulerPost(0, TEST_SIGNAL_ESCALATE, 0xFFFF);
+}
+
+
+///Receives bytes on USART0, each posting an event from the interrupt, without dispatching any
+static void Receive(const uint8_t* data, uint8_t length)
+{
+	HostUartInject(0, data, length);
+	HostSimRunMicroseconds(100UL * length + 100);
+}
+
+
+///Dispatches every event waiting, logging them from the start
+static void DispatchAll(void)
+{
+	m_uchrLogged = 0;
+	while(SchedulerDispatch());
+}
+
+
+///Checks a logged event
+static bool Logged(uint8_t index, uint8_t priority, uint8_t signal, uint16_t param)
+{
+	return (m_log[index].priority == priority && m_log[index].signal == signal && m_log[index].param == param);
+}
+
+
+static void TestOrder(void)
+{
+	//Variables
+	const uint8_t mixed[] = { 0x31, 0x32, 0x11, 0x01, 0x02 };
+	const uint8_t escalate[] = { 0x30 | TEST_SIGNAL_ESCALATE, 0x33 };
+	uint16_t first = m_uintPosted;
+
+	HOST_CHECK(!SchedulerDispatch());
+
+	//Highest priority first, oldest first within one
+	Receive(mixed, sizeof(mixed));
+	DispatchAll();
+	HOST_CHECK_EQUAL(m_uchrLogged, 5);
+	HOST_CHECK(Logged(0, 0, 1, first + 3));
+	HOST_CHECK(Logged(1, 0, 2, first + 4));
+	HOST_CHECK(Logged(2, 1, 1, first + 2));
+	HOST_CHECK(Logged(3, 3, 1, first));
+	HOST_CHECK(Logged(4, 3, 2, first + 1));
+	HOST_CHECK(!SchedulerDispatch());
+
+	//An event a handler posts at a higher priority goes ahead of the ones already waiting
+	first = m_uintPosted;
+	Receive(escalate, sizeof(escalate));
+	DispatchAll();
+	HOST_CHECK_EQUAL(m_uchrLogged, 3);
+	HOST_CHECK(Logged(0, 3, TEST_SIGNAL_ESCALATE, first));
+	HOST_CHECK(Logged(1, 0, TEST_SIGNAL_ESCALATE, 0xFFFF));
+	HOST_CHECK(Logged(2, 3, 3, first + 1));
+	HOST_CHECK_EQUAL(m_uchrRefused, 0);
+}
+
+
+static void TestQueueFull(void)
+{
+	//Variables
+	const uint8_t flood[] = { 0x11, 0x12, 0x13, 0x14, 0x15, 0x01 };
+	const uint8_t noTask[] = { 0x21, 0x81 };
+	uint16_t first = m_uintPosted;
+
+	//The queue holds one less than its size, the rest are dropped and counted, leaving other tasks' queues alone
+	Receive(flood, sizeof(flood));
+	HOST_CHECK_EQUAL(m_uchrRefused, 5 - (MCU_SCHEDULER_QUEUE_SIZE - 1));
+	HOST_CHECK_EQUAL(SchedulerDropped(1), 5 - (MCU_SCHEDULER_QUEUE_SIZE - 1));
+	HOST_CHECK_EQUAL(SchedulerDropped(0), 0);
+
+	DispatchAll();
+	HOST_CHECK_EQUAL(m_uchrLogged, MCU_SCHEDULER_QUEUE_SIZE);
+	HOST_CHECK(Logged(0, 0, 1, first + 5));
+
+	for(uint8_t i = 0; i < MCU_SCHEDULER_QUEUE_SIZE - 1; i++) HOST_CHECK(Logged(i + 1, 1, i + 1, first + i));
+
+	//Room again once dispatched
+	Receive(flood, 1);
+	DispatchAll();
+	HOST_CHECK_EQUAL(m_uchrLogged, 1);
+	HOST_CHECK_EQUAL(SchedulerDropped(1), 5 - (MCU_SCHEDULER_QUEUE_SIZE - 1));
+
+	//A priority with no task, or past the last, is turned down without counting a drop
+	m_uchrRefused = 0;
+	Receive(noTask, sizeof(noTask));
+	HOST_CHECK_EQUAL(m_uchrRefused, 2);
+	HOST_CHECK_EQUAL(SchedulerDropped(2), 0);
+	HOST_CHECK(!SchedulerDispatch());
+	m_uchrRefused = 0;
+}
+
+
+///Posts one event from the interrupt and dispatches it when it has waited the milliseconds given
+static void WaitAndDispatch(uint8_t data, uint32_t waitMs)
+{
+	Receive(&data, 1);
+	while(SystemMillis() - m_ulPostedAt < waitMs) HostSimRunMicroseconds(50);
+	DispatchAll();
+	HOST_CHECK_EQUAL(m_uchrLogged, 1);
+}
+
+
+static void TestDeadlines(void)
+{
+	//Up to the deadline is in time, a millisecond past it is a miss
+	WaitAndDispatch(0x01, 0);
+	WaitAndDispatch(0x01, 2);
+	HOST_CHECK_EQUAL(SchedulerDeadlineMisses(0), 0);
+	WaitAndDispatch(0x01, 3);
+	HOST_CHECK_EQUAL(SchedulerDeadlineMisses(0), 1);
+
+	WaitAndDispatch(0x31, 5);
+	HOST_CHECK_EQUAL(SchedulerDeadlineMisses(3), 0);
+	WaitAndDispatch(0x31, 6);
+	HOST_CHECK_EQUAL(SchedulerDeadlineMisses(3), 1);
+
+	//A task with no deadline never misses, and the others' counts are their own
+	WaitAndDispatch(0x11, 50);
+	HOST_CHECK_EQUAL(SchedulerDeadlineMisses(1), 0);
+	HOST_CHECK_EQUAL(SchedulerDeadlineMisses(0), 1);
+	HOST_CHECK_EQUAL(SchedulerDeadlineMisses(3), 1);
+}
+
+
+int main(void)
+{
+	HostSimReset();
+	SystemTickInit();
+	SchedulerInit();
+
+	//A priority takes one task, with a handler
+	HOST_CHECK(SchedulerAddTask(0, HandleTop, 2));
+	HOST_CHECK(SchedulerAddTask(1, HandleMiddle, 0));
+	HOST_CHECK(SchedulerAddTask(3, HandleBottom, 5));
+	HOST_CHECK(!SchedulerAddTask(3, HandleTop, 0));
+	HOST_CHECK(!SchedulerAddTask(MCU_SCHEDULER_MAX_TASKS, HandleTop, 0));
+	HOST_CHECK(!SchedulerAddTask(2, 0, 0));
+
+	//USART0 receiving at 125k baud, each byte raising the interrupt
+	UBRR0 = (F_CPU / 16 / 125000UL) - 1;
+	UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
+	UCSR0B = (1 << RXEN0) | (1 << RXCIE0);
+	sei();
+	HostSimRunMilliseconds(2);
+
+	TestOrder();
+	TestQueueFull();
+	TestDeadlines();
+
+	HOST_CHECK_EQUAL(HostSimUnhandledInterrupts(), 0);
+
+	return HostTestResult("mcuScheduler");
+}
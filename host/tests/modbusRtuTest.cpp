@@ -0,0 +1,344 @@
+/**
+ * \file modbusRtuTest.cpp
+ * \author Tim Robbins
+ * \brief Runs modbusRtu as a slave and then as a master, on Timer 1 as it would be on the M1, with the test on the other end of USART0. \n
+ * As a slave, checks every function code against the map, the exceptions, that other slaves' frames are left alone, \n
+ * that a broadcast is written without an answer, and that a bad CRC or a gap of more than t1.5 inside a frame drops it. \n
+ * As a master, checks a read, an exception, a timeout and a broadcast. \n
+ */
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <string.h>
+#include "hostSim.h"
+#include "hostTest.h"
+#include "modbusRtu.h"
+
+
+///The slave address used
+#define TEST_SLAVE			17
+
+///The microseconds of a character at 19200 baud in the simulator, which sends 10 bits
+#define TEST_CHAR_US		521
+
+///Bytes sent by the driver since the last Send
+static uint8_t m_uchrSent[300];
+static uint16_t m_uintSentCount = 0;
+
+///What the slave played by the test answers the master with, 0 for nothing
+static uint8_t m_uchrAnswer = 0;
+
+///The milliseconds the master has run
+static uint16_t m_uintNow = 0;
+
+///The slave's map
+static uint16_t m_uintHolding[10] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+static uint16_t m_uintInput[4] = { 0x1111, 0x2222, 0x3333, 0x4444 };
+static uint8_t m_uchrCoils[2] = { 0xA5, 0x3C };
+static uint8_t m_uchrDiscrete[1] = { 0x0F };
+
+///The last write the written callback was called with
+static uint8_t m_uchrWrittenFunction = 0;
+static uint16_t m_uintWrittenAddress = 0;
+static uint16_t m_uintWrittenCount = 0;
+static uint8_t m_uchrWrites = 0;
+
+
+static void OnWritten(uint8_t function, uint16_t address, uint16_t count)
+{
+	m_uchrWrittenFunction = function;
+	m_uintWrittenAddress = address;
+	m_uintWrittenCount = count;
+	m_uchrWrites++;
+}
+
+static const ModbusMap_t m_map =
+{
+	m_uintHolding, 100, 10,
+	m_uintInput, 0, 4,
+	m_uchrCoils, 0, 16,
+	m_uchrDiscrete, 0, 8,
+	OnWritten
+};
+
+
+///The CRC worked out the long way, to check the driver's against
+static uint16_t Crc(const uint8_t* bytes, uint16_t length)
+{
+	//Variables
+	uint16_t crc = 0xFFFF;
+
+	while(length--)
+	{
+		crc ^= *bytes++;
+		for(uint8_t i = 0; i < 8; i++) crc = (crc & 1) ? ((crc >> 1) ^ 0xA001) : (crc >> 1);
+	}
+
+	return crc;
+}
+
+
+///Adds the CRC to a frame, returning its length with it
+static uint16_t AddCrc(uint8_t* frame, uint16_t length)
+{
+	//Variables
+	uint16_t crc = Crc(frame, length);
+
+	frame[length] = (uint8_t)crc;
+	frame[length + 1] = (uint8_t)(crc >> 8);
+	return length + 2;
+}
+
+
+///Answers the master's request, once all 8 bytes of it are in
+static void OnSlaveSent(uint8_t uart, uint8_t data)
+{
+	//Variables
+	static uint8_t answer[16];
+	uint16_t length = 0;
+
+	if(uart != 0) return;
+	m_uchrSent[m_uintSentCount++] = data;
+
+	if(m_uintSentCount == 8 && m_uchrAnswer != 0)
+	{
+		if(m_uchrAnswer == 1)
+		{
+			const uint8_t values[] = { TEST_SLAVE, MODBUS_READ_HOLDING, 8, 0, 1, 0, 2, 0, 3, 0xAB, 0xCD };
+			memcpy(answer, values, sizeof(values));
+			length = sizeof(values);
+		}
+		else
+		{
+			const uint8_t exception[] = { TEST_SLAVE, MODBUS_READ_HOLDING | 0x80, MODBUS_ILLEGAL_ADDRESS };
+			memcpy(answer, exception, sizeof(exception));
+			length = sizeof(exception);
+		}
+
+		HostUartInject(0, answer, AddCrc(answer, length));
+	}
+}
+
+
+///Sends a request to the slave and waits long enough for its answer to be sent
+static void Send(const uint8_t* request, uint16_t length)
+{
+	//Variables
+	uint8_t frame[300];
+
+	memcpy(frame, request, length);
+	m_uintSentCount = 0;
+	HostUartInject(0, frame, AddCrc(frame, length));
+	HostSimRunMilliseconds(20);
+}
+
+
+///Checks the slave's answer is the bytes given followed by a good CRC
+static void CheckAnswer(const uint8_t* expected, uint16_t length)
+{
+	HOST_CHECK_EQUAL(m_uintSentCount, length + 2);
+	if(m_uintSentCount != length + 2) return;
+	HOST_CHECK(memcmp(m_uchrSent, expected, length) == 0);
+	HOST_CHECK_EQUAL(Crc(m_uchrSent, m_uintSentCount), 0);
+}
+
+
+static void TestSlave(void)
+{
+	//Variables
+	const uint8_t readHolding[] = { TEST_SLAVE, MODBUS_READ_HOLDING, 0, 100, 0, 3 };
+	const uint8_t holdingAnswer[] = { TEST_SLAVE, MODBUS_READ_HOLDING, 6, 0, 1, 0, 2, 0, 3 };
+	const uint8_t readCoils[] = { TEST_SLAVE, MODBUS_READ_COILS, 0, 2, 0, 10 };
+	const uint8_t coilsAnswer[] = { TEST_SLAVE, MODBUS_READ_COILS, 2, 0x29, 0x03 };
+	const uint8_t readDiscrete[] = { TEST_SLAVE, MODBUS_READ_DISCRETE, 0, 1, 0, 4 };
+	const uint8_t discreteAnswer[] = { TEST_SLAVE, MODBUS_READ_DISCRETE, 1, 0x07 };
+	const uint8_t readInput[] = { TEST_SLAVE, MODBUS_READ_INPUT, 0, 1, 0, 2 };
+	const uint8_t inputAnswer[] = { TEST_SLAVE, MODBUS_READ_INPUT, 4, 0x22, 0x22, 0x33, 0x33 };
+	const uint8_t writeRegister[] = { TEST_SLAVE, MODBUS_WRITE_REGISTER, 0, 105, 0x12, 0x34 };
+	const uint8_t writeCoil[] = { TEST_SLAVE, MODBUS_WRITE_COIL, 0, 0, 0, 0 };
+	const uint8_t writeRegisters[] = { TEST_SLAVE, MODBUS_WRITE_REGISTERS, 0, 100, 0, 2, 4, 0xAA, 0xBB, 0xCC, 0xDD };
+	const uint8_t writeCoils[] = { TEST_SLAVE, MODBUS_WRITE_COILS, 0, 4, 0, 8, 1, 0xFF };
+	const uint8_t badAddress[] = { TEST_SLAVE, MODBUS_READ_HOLDING, 0, 0, 0, 1 };
+	const uint8_t badAddressAnswer[] = { TEST_SLAVE, MODBUS_READ_HOLDING | 0x80, MODBUS_ILLEGAL_ADDRESS };
+	const uint8_t badFunction[] = { TEST_SLAVE, 0x07, 0, 0, 0, 1 };
+	const uint8_t badFunctionAnswer[] = { TEST_SLAVE, 0x87, MODBUS_ILLEGAL_FUNCTION };
+	const uint8_t otherSlave[] = { TEST_SLAVE + 1, MODBUS_WRITE_REGISTER, 0, 100, 0, 0x55 };
+	const uint8_t broadcast[] = { 0, MODBUS_WRITE_REGISTER, 0, 100, 0, 0x77 };
+	const uint8_t afterBroadcast[] = { TEST_SLAVE, MODBUS_READ_HOLDING, 6, 0, 0x77, 0xCC, 0xDD, 0, 3 };
+	uint8_t frame[16];
+	uint16_t length = 0;
+	ModbusStats_t stats;
+
+	HostSimReset();
+	HostUartSetTxHook(OnSlaveSent);
+	HOST_CHECK(ModbusInit(19200, TEST_SLAVE, &m_map));
+	sei();
+	HostSimRunMilliseconds(5);
+
+	//No parity is sent with two stop bits, keeping the 11 bit character
+	HOST_CHECK_EQUAL(UCSR0C & ((1 << UPM01) | (1 << USBS0)), (1 << USBS0));
+
+	//Reads
+	Send(readHolding, sizeof(readHolding));
+	CheckAnswer(holdingAnswer, sizeof(holdingAnswer));
+	Send(readCoils, sizeof(readCoils));
+	CheckAnswer(coilsAnswer, sizeof(coilsAnswer));
+	Send(readDiscrete, sizeof(readDiscrete));
+	CheckAnswer(discreteAnswer, sizeof(discreteAnswer));
+	Send(readInput, sizeof(readInput));
+	CheckAnswer(inputAnswer, sizeof(inputAnswer));
+
+	//Writes echo the request, or its first 6 bytes for the multiple writes, and call back with what changed
+	Send(writeRegister, sizeof(writeRegister));
+	CheckAnswer(writeRegister, sizeof(writeRegister));
+	HOST_CHECK_EQUAL(m_uintHolding[5], 0x1234);
+	HOST_CHECK_EQUAL(m_uchrWrittenFunction, MODBUS_WRITE_REGISTER);
+	HOST_CHECK_EQUAL(m_uintWrittenAddress, 105);
+	HOST_CHECK_EQUAL(m_uintWrittenCount, 1);
+
+	Send(writeCoil, sizeof(writeCoil));
+	CheckAnswer(writeCoil, sizeof(writeCoil));
+	HOST_CHECK_EQUAL(m_uchrCoils[0], 0xA4);
+
+	Send(writeRegisters, sizeof(writeRegisters));
+	CheckAnswer(writeRegisters, 6);
+	HOST_CHECK_EQUAL(m_uintHolding[0], 0xAABB);
+	HOST_CHECK_EQUAL(m_uintHolding[1], 0xCCDD);
+	HOST_CHECK_EQUAL(m_uintWrittenCount, 2);
+
+	Send(writeCoils, sizeof(writeCoils));
+	CheckAnswer(writeCoils, 6);
+	HOST_CHECK_EQUAL(m_uchrCoils[0], 0xF4);
+	HOST_CHECK_EQUAL(m_uchrCoils[1], 0x3F);
+	HOST_CHECK_EQUAL(m_uchrWrittenFunction, MODBUS_WRITE_COILS);
+	HOST_CHECK_EQUAL(m_uintWrittenAddress, 4);
+	HOST_CHECK_EQUAL(m_uintWrittenCount, 8);
+
+	//Exceptions
+	Send(badAddress, sizeof(badAddress));
+	CheckAnswer(badAddressAnswer, sizeof(badAddressAnswer));
+	Send(badFunction, sizeof(badFunction));
+	CheckAnswer(badFunctionAnswer, sizeof(badFunctionAnswer));
+
+	//Another slave's request is left alone, a broadcast is written but not answered
+	Send(otherSlave, sizeof(otherSlave));
+	HOST_CHECK_EQUAL(m_uintSentCount, 0);
+	HOST_CHECK_EQUAL(m_uintHolding[0], 0xAABB);
+	Send(broadcast, sizeof(broadcast));
+	HOST_CHECK_EQUAL(m_uintSentCount, 0);
+	HOST_CHECK_EQUAL(m_uintHolding[0], 0x77);
+	HOST_CHECK_EQUAL(m_uchrWrites, 5);
+
+	//A bad CRC isn't answered
+	memcpy(frame, readHolding, sizeof(readHolding));
+	length = AddCrc(frame, sizeof(readHolding));
+	frame[length - 1] ^= 1;
+	m_uintSentCount = 0;
+	HostUartInject(0, frame, length);
+	HostSimRunMilliseconds(20);
+	HOST_CHECK_EQUAL(m_uintSentCount, 0);
+
+	//Nor is one with a gap of more than t1.5, 859us at 19200, in the middle
+	frame[length - 1] ^= 1;
+	m_uintSentCount = 0;
+	HostUartInject(0, frame, 4);
+	HostSimRunMicroseconds(4 * TEST_CHAR_US + 1200);
+	HostUartInject(0, frame + 4, length - 4);
+	HostSimRunMilliseconds(20);
+	HOST_CHECK_EQUAL(m_uintSentCount, 0);
+
+	//But a shorter gap is fine
+	HostUartInject(0, frame, 4);
+	HostSimRunMicroseconds(4 * TEST_CHAR_US + 500);
+	HostUartInject(0, frame + 4, length - 4);
+	HostSimRunMilliseconds(20);
+	CheckAnswer(afterBroadcast, sizeof(afterBroadcast));
+
+	ModbusGetStats(&stats);
+	HOST_CHECK_EQUAL(stats.frames, 13);
+	HOST_CHECK_EQUAL(stats.crcErrors, 1);
+	HOST_CHECK_EQUAL(stats.charErrors, 1);
+	HOST_CHECK_EQUAL(stats.exceptions, 2);
+	HOST_CHECK_EQUAL(HostSimUnhandledInterrupts(), 0);
+}
+
+
+///Runs the master for some milliseconds, polling as the main loop would
+static void Run(uint16_t milliseconds)
+{
+	for(uint16_t i = 0; i < milliseconds; i++)
+	{
+		HostSimRunMilliseconds(1);
+		ModbusPoll(++m_uintNow);
+	}
+}
+
+
+static void TestMaster(void)
+{
+	//Variables
+	const uint8_t request[] = { TEST_SLAVE, MODBUS_READ_HOLDING, 0, 0, 0, 4 };
+	const uint8_t broadcast[] = { 0, MODBUS_WRITE_REGISTERS, 0, 10, 0, 2, 4, 0x12, 0x34, 0x56, 0x78 };
+	uint16_t values[4] = { 0, 0, 0, 0 };
+	uint16_t written[2] = { 0x1234, 0x5678 };
+	uint8_t exception = 0;
+
+	HostSimReset();
+	HostUartSetTxHook(OnSlaveSent);
+	HOST_CHECK(ModbusInit(115200, MODBUS_MASTER, 0));
+	sei();
+	Run(5);
+	HOST_CHECK_EQUAL(ModbusMasterResult(&exception), MODBUS_MASTER_IDLE);
+
+	//A read, with a second request refused while it's going
+	m_uchrAnswer = 1;
+	m_uintSentCount = 0;
+	HOST_CHECK(ModbusMasterRequest(TEST_SLAVE, MODBUS_READ_HOLDING, 0, 4, values));
+	HOST_CHECK(!ModbusMasterRequest(TEST_SLAVE, MODBUS_READ_HOLDING, 0, 4, values));
+	HOST_CHECK_EQUAL(ModbusMasterResult(&exception), MODBUS_MASTER_BUSY);
+	Run(10);
+	HOST_CHECK_EQUAL(ModbusMasterResult(&exception), MODBUS_MASTER_DONE);
+	HOST_CHECK_EQUAL(m_uintSentCount, 8);
+	HOST_CHECK(memcmp(m_uchrSent, request, sizeof(request)) == 0);
+	HOST_CHECK_EQUAL(Crc(m_uchrSent, 8), 0);
+	HOST_CHECK_EQUAL(values[0], 0x0001);
+	HOST_CHECK_EQUAL(values[1], 0x0002);
+	HOST_CHECK_EQUAL(values[2], 0x0003);
+	HOST_CHECK_EQUAL(values[3], 0xABCD);
+
+	//An exception
+	m_uchrAnswer = 2;
+	m_uintSentCount = 0;
+	HOST_CHECK(ModbusMasterRequest(TEST_SLAVE, MODBUS_READ_HOLDING, 0, 4, values));
+	Run(10);
+	HOST_CHECK_EQUAL(ModbusMasterResult(&exception), MODBUS_MASTER_EXCEPTION);
+	HOST_CHECK_EQUAL(exception, MODBUS_ILLEGAL_ADDRESS);
+
+	//No answer times out, and not before the timeout
+	m_uchrAnswer = 0;
+	m_uintSentCount = 0;
+	HOST_CHECK(ModbusMasterRequest(TEST_SLAVE, MODBUS_READ_HOLDING, 0, 4, values));
+	Run(MODBUS_RESPONSE_TIMEOUT_MS / 2);
+	HOST_CHECK_EQUAL(ModbusMasterResult(&exception), MODBUS_MASTER_BUSY);
+	Run(MODBUS_RESPONSE_TIMEOUT_MS / 2 + 10);
+	HOST_CHECK_EQUAL(ModbusMasterResult(&exception), MODBUS_MASTER_TIMEOUT);
+
+	//A broadcast is done once it's sent
+	m_uintSentCount = 0;
+	HOST_CHECK(ModbusMasterRequest(0, MODBUS_WRITE_REGISTERS, 10, 2, written));
+	Run(5);
+	HOST_CHECK_EQUAL(ModbusMasterResult(&exception), MODBUS_MASTER_DONE);
+	HOST_CHECK_EQUAL(m_uintSentCount, sizeof(broadcast) + 2);
+	HOST_CHECK(memcmp(m_uchrSent, broadcast, sizeof(broadcast)) == 0);
+	HOST_CHECK_EQUAL(Crc(m_uchrSent, m_uintSentCount), 0);
+
+	HOST_CHECK_EQUAL(HostSimUnhandledInterrupts(), 0);
+}
+
+
+int main(void)
+{
+	TestSlave();
+	TestMaster();
+
+	return HostTestResult("modbusRtu");
+}
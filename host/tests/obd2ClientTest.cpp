@@ -0,0 +1,149 @@
+/**
+ * \file obd2ClientTest.cpp
+ * \author Tim Robbins
+ * \brief Runs obd2Client against ECUs played by the test on the simulated CAN bus. \n
+ * Checks positive responses fill the cache, and negative ones complete the oldest request in flight: \n
+ * busy queues it again, response pending waits another timeout, and any other code is read back as rejected \n
+ * and holds the PID off until a later positive response clears it. \n
+ */
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <string.h>
+#include "hostSim.h"
+#include "hostTest.h"
+#include "avrCanUtilities.h"
+#include "obd2Client.h"
+
+
+///The requests sent for each PID
+static uint8_t m_uchrRequests[256];
+
+///The milliseconds the test has run
+static uint16_t m_uintNow = 0;
+
+
+static void OnSend(const HostCanFrame_t* frame)
+{
+	if(frame->id == OBD2_FUNCTIONAL_ID && frame->data[1] == OBD2_MODE_CURRENT_DATA) m_uchrRequests[frame->data[2]]++;
+}
+
+
+static int8_t OnFrame(CAN_FRAME& frame)
+{
+	Obd2Receive(frame);
+	return 0;
+}
+
+
+///Runs for some milliseconds, taking frames and polling as the main loop would
+static void Run(uint16_t milliseconds)
+{
+	for(uint16_t i = 0; i < milliseconds; i++)
+	{
+		HostSimRunMilliseconds(1);
+		while(CAN_process_frame(OnFrame) >= 0);
+		Obd2Poll(++m_uintNow);
+	}
+}
+
+
+///Answers from the first ECU with a single frame of the bytes given
+static void Answer(const uint8_t* bytes, uint8_t length)
+{
+	//Variables
+	HostCanFrame_t frame;
+
+	memset(&frame, 0, sizeof(frame));
+	frame.id = OBD2_RESPONSE_ID;
+	frame.length = 8;
+	frame.data[0] = length;
+	memcpy(&frame.data[1], bytes, length);
+	HOST_CHECK(HostCanInject(&frame));
+	Run(2);
+}
+
+
+int main(void)
+{
+	//Variables
+	const uint8_t rpm[] = { 0x41, 0x0C, 0x1A, 0xF8 };
+	const uint8_t speed[] = { 0x41, 0x0D, 0x32 };
+	const uint8_t outOfRange[] = { OBD2_NEGATIVE_RESPONSE, OBD2_MODE_CURRENT_DATA, 0x31 };
+	const uint8_t pending[] = { OBD2_NEGATIVE_RESPONSE, OBD2_MODE_CURRENT_DATA, OBD2_NRC_RESPONSE_PENDING };
+	const uint8_t busy[] = { OBD2_NEGATIVE_RESPONSE, OBD2_MODE_CURRENT_DATA, OBD2_NRC_BUSY };
+	const uint8_t otherMode[] = { OBD2_NEGATIVE_RESPONSE, 0x22, 0x31 };
+	const uint8_t supported[] = { 0x41, 0x7A, 0x01 };
+	Obd2Value_t value;
+	Obd2Stats_t stats;
+	uint16_t sentAt = 0;
+
+	HostSimReset();
+	HostCanSetTxHook(OnSend);
+	CAN_init_tx(CAN_BPS_500K, false, 1);
+	Can0.watchFor();
+	Obd2Init(OBD2_FUNCTIONAL_ID);
+	sei();
+
+	//Two requests in flight, the first answered
+	HOST_CHECK(Obd2AddPid(0x0C, 1000));
+	HOST_CHECK(Obd2AddPid(0x7A, 1000));
+	Run(2);
+	sentAt = m_uintNow;
+	HOST_CHECK_EQUAL(Obd2Outstanding(), 2);
+	Answer(rpm, sizeof(rpm));
+	HOST_CHECK_EQUAL(Obd2Read(0x0C, &value), OBD2_READ_FRESH);
+	HOST_CHECK_EQUAL(value.data[0], 0x1A);
+	HOST_CHECK_EQUAL(value.nrc, 0);
+
+	//A negative response to another mode isn't ours
+	Answer(otherMode, sizeof(otherMode));
+	HOST_CHECK_EQUAL(Obd2Outstanding(), 1);
+
+	//A negative response completes the one left with the error, and it's held off rather than timing out or being sent again
+	Answer(outOfRange, sizeof(outOfRange));
+	HOST_CHECK_EQUAL(Obd2Outstanding(), 0);
+	HOST_CHECK_EQUAL(Obd2Read(0x7A, &value), OBD2_READ_REJECTED);
+	HOST_CHECK_EQUAL(value.nrc, 0x31);
+	Run(500);
+	HOST_CHECK_EQUAL(Obd2Read(0x7A, &value), OBD2_READ_REJECTED);
+	HOST_CHECK_EQUAL(m_uchrRequests[0x7A], 1);
+	Obd2GetStats(&stats);
+	HOST_CHECK_EQUAL(stats.rejects, 1);
+	HOST_CHECK_EQUAL(stats.timeouts, 0);
+
+	//Response pending gives the request another timeout
+	HOST_CHECK(Obd2AddPid(0x0D, 1000));
+	Run(2);
+	Run(OBD2_TIMEOUT_MS - 20);
+	Answer(pending, sizeof(pending));
+	Run(OBD2_TIMEOUT_MS - 20);
+	HOST_CHECK_EQUAL(Obd2Outstanding(), 1);
+	Answer(speed, sizeof(speed));
+	HOST_CHECK_EQUAL(Obd2Read(0x0D, &value), OBD2_READ_FRESH);
+	HOST_CHECK_EQUAL(value.data[0], 0x32);
+
+	//Busy sends it again straight away, without counting it as rejected
+	Obd2AddPid(0x0D, 1000);
+	Run(2);
+	HOST_CHECK_EQUAL(m_uchrRequests[0x0D], 2);
+	Answer(busy, sizeof(busy));
+	HOST_CHECK_EQUAL(m_uchrRequests[0x0D], 3);
+	HOST_CHECK_EQUAL(Obd2Outstanding(), 1);
+	Answer(speed, sizeof(speed));
+	HOST_CHECK_EQUAL(Obd2Outstanding(), 0);
+
+	//Once the hold off is over it's asked again, and a positive response clears the error
+	while(m_uchrRequests[0x7A] < 2 && (uint16_t)(m_uintNow - sentAt) < OBD2_MISS_HOLDOFF_MS + 10) Run(1);
+	HOST_CHECK_EQUAL(m_uchrRequests[0x7A], 2);
+	HOST_CHECK((uint16_t)(m_uintNow - sentAt) >= OBD2_MISS_HOLDOFF_MS - 2);
+	Answer(supported, sizeof(supported));
+	HOST_CHECK_EQUAL(Obd2Read(0x7A, &value), OBD2_READ_FRESH);
+	HOST_CHECK_EQUAL(value.nrc, 0);
+
+	Obd2GetStats(&stats);
+	HOST_CHECK_EQUAL(stats.rejects, 1);
+	HOST_CHECK_EQUAL(stats.timeouts, 0);
+	HOST_CHECK_EQUAL(HostSimUnhandledInterrupts(), 0);
+
+	return HostTestResult("obd2Client");
+}
@@ -0,0 +1,96 @@
+/**
+ * \file smokeTest.cpp
+ * \author Tim Robbins
+ * \brief Runs the plain drivers against the simulated registers: the system tick, SPI, USART0, TWI and the ADC. \n
+ * It checks the drivers build for the host and that each peripheral model answers them the way the part would. \n
+ */
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <string.h>
+#include "hostSim.h"
+#include "hostTest.h"
+#include "avrTimers.h"
+#include "mcuDelays.h"
+#include "avrSerial.h"
+#include "spi.h"
+#include "i2c.h"
+#include "mcuAdc.h"
+
+
+static uint8_t m_uchrTwiData[8];
+static uint8_t m_uchrTwiCount = 0;
+
+static uint8_t InvertResponder(uint8_t dataIn)
+{
+	return (uint8_t)~dataIn;
+}
+
+static bool TwiWrite(uint8_t data)
+{
+	if(m_uchrTwiCount < sizeof(m_uchrTwiData)) {
+		m_uchrTwiData[m_uchrTwiCount++] = data;
+	}
+
+	return true;
+}
+
+
+int main()
+{
+	//Variables
+	uint8_t buffer[16];										//Bytes taken from the simulated USART
+	uint16_t length = 0;									//Amount taken
+	uint8_t message[] = "OK";								//String written to the USART
+	uint8_t twiBytes[] = { 0x40, 0xA5, 0x5A, 0 };			//Bytes sent over TWI, ending with 0
+	const HostTwiDevice_t device = { 0x3C, 0, TwiWrite, 0, 0 };
+
+	HostSimReset();
+
+	//A delay before the tick is started spins through it rather than sleeping with nothing to wake it
+	sei();
+	delayForMilliseconds(5);
+	HOST_CHECK(HostSimCycles() >= 5 * (F_CPU / 1000UL));
+	cli();
+
+	//The tick counts milliseconds from Timer0's compare interrupt
+	SystemTickInit();
+	sei();
+	HostSimRunMilliseconds(25);
+	HOST_CHECK(SystemMillis() >= 24 && SystemMillis() <= 25);
+	HOST_CHECK_EQUAL(HostSimUnhandledInterrupts(), 0);
+
+	//Once it's running, a delay sleeps until the tick has counted it out
+	delayForMilliseconds(10);
+	HOST_CHECK(SystemMillis() >= 34 && SystemMillis() <= 36);
+
+	//SPI shifts in what the responder gives back
+	HostSpiSetResponder(InvertResponder);
+	SpiInitParent(0, true, false);
+	HOST_CHECK_EQUAL(SpiExchangeByte(0x5A), 0xA5);
+
+	//USART0 sends a string out and reads injected bytes back
+	UCSR0B = (1 << TXEN0) | (1 << RXEN0);
+	USART0_write_string(message);
+	HostSimRunMilliseconds(30);
+	length = HostUartTake(0, buffer, sizeof(buffer));
+	HOST_CHECK(length >= 2);
+	HOST_CHECK(memcmp(buffer, "OK", 2) == 0);
+	HostUartInject(0, (const uint8_t*)"hi", 2);
+	HOST_CHECK_EQUAL(USART0_read_byte(), 'h');
+	HOST_CHECK_EQUAL(USART0_read_byte(), 'i');
+
+	//TWI writes reach the device at the address, the bytes and not the pointer to them
+	HostTwiAttach(&device);
+	I2CInit();
+	HOST_CHECK_EQUAL(I2CSendBytes(0x3C << 1, twiBytes), 0);
+	HOST_CHECK_EQUAL(m_uchrTwiCount, 3);
+	HOST_CHECK(memcmp(m_uchrTwiData, twiBytes, 3) == 0);
+
+	//The ADC converts the input set for the channel
+	HostAdcSetInput(3, 777);
+	ADC_enable();
+	HOST_CHECK_EQUAL(AdcGet((adc_channel_t)3), 777);
+	HOST_CHECK_EQUAL(AdcSample((adc_channel_t)3, 4), 777);
+
+	return HostTestResult("smokeTest");
+}
@@ -0,0 +1,230 @@
+/**
+ * \file softTimerTest.cpp
+ * \author Tim Robbins
+ * \brief Runs the software timer wheel in avrTimers off the simulated system tick, serviced each millisecond as a main loop would. \n
+ * Checks one shot and periodic timers expire on their millisecond, that restarting a running timer moves it, \n
+ * that a callback can stop its own timer or the next one in the slot being walked, and that a service more than \n
+ * SOFT_TIMER_WHEEL_SIZE milliseconds late fires each expired timer once, leaving the ones for later laps. \n
+ */
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <string.h>
+#include "hostSim.h"
+#include "hostTest.h"
+#include "avrTimers.h"
+
+
+///The most expires kept for a timer
+#define TEST_MAX_FIRES				16
+
+
+typedef struct
+{
+	uint32_t at[TEST_MAX_FIRES];	///The milliseconds it fired at
+	uint8_t count;					///The times it fired
+	SoftTimer_t* stop;				///A timer to stop when it fires, or 0
+	uint8_t stopAfter;				///The fires to stop it after
+}
+Fired_t;
+
+
+static void OnExpire(void* arg)
+{
+	//Variables
+	Fired_t* fired = (Fired_t*)arg;
+
+	if(fired->count < TEST_MAX_FIRES) fired->at[fired->count] = SystemMillis();
+	fired->count++;
+
+	if(fired->stop != 0 && fired->count == fired->stopAfter) SoftTimerStop(fired->stop);
+}
+
+
+///Runs and services the wheel each millisecond until the system time reaches the one given
+static void RunUntil(uint32_t millis)
+{
+	while(!SystemTimeReached(millis))
+	{
+		HostSimRunMilliseconds(1);
+		SoftTimerService();
+	}
+}
+
+
+///If a timer fired on its millisecond, or the next when the service came late by the time the test itself takes
+static bool FiredAt(const Fired_t* fired, uint8_t index, uint32_t expires)
+{
+	return (fired->at[index] - expires) <= 1;
+}
+
+
+static void TestOneShotAndPeriodic(void)
+{
+	//Variables
+	SoftTimer_t oneShot = SOFT_TIMER_INIT;
+	SoftTimer_t periodic;
+	Fired_t oneShotFired;
+	Fired_t periodicFired;
+	uint32_t start = SystemMillis();
+
+	memset(&oneShotFired, 0, sizeof(oneShotFired));
+	memset(&periodicFired, 0, sizeof(periodicFired));
+	memset(&periodic, 0xFF, sizeof(periodic));
+	SoftTimerInit(&periodic);
+	HOST_CHECK(!SoftTimerIsActive(&oneShot));
+	HOST_CHECK(!SoftTimerIsActive(&periodic));
+
+	//Past a lap of the wheel, so it has to be passed over on the first
+	SoftTimerStart(&oneShot, SOFT_TIMER_WHEEL_SIZE + 5, 0, OnExpire, &oneShotFired);
+	SoftTimerStart(&periodic, 3, 7, OnExpire, &periodicFired);
+	HOST_CHECK(SoftTimerIsActive(&oneShot));
+
+	RunUntil(start + 100);
+	HOST_CHECK_EQUAL(oneShotFired.count, 1);
+	HOST_CHECK(FiredAt(&oneShotFired, 0, start + SOFT_TIMER_WHEEL_SIZE + 5));
+	HOST_CHECK(!SoftTimerIsActive(&oneShot));
+
+	//Expires off the first one, not off when it was serviced, so it doesn't drift
+	HOST_CHECK_EQUAL(periodicFired.count, 14);
+	for(uint8_t i = 0; i < 14; i++) HOST_CHECK(FiredAt(&periodicFired, i, start + 3 + 7 * (uint32_t)i));
+	HOST_CHECK(SoftTimerIsActive(&periodic));
+
+	SoftTimerStop(&periodic);
+	HOST_CHECK(!SoftTimerIsActive(&periodic));
+	RunUntil(start + 120);
+	HOST_CHECK_EQUAL(periodicFired.count, 14);
+}
+
+
+static void TestRestart(void)
+{
+	//Variables
+	SoftTimer_t moved = SOFT_TIMER_INIT;
+	SoftTimer_t sharing = SOFT_TIMER_INIT;
+	Fired_t movedFired;
+	Fired_t sharingFired;
+	uint32_t start = SystemMillis();
+
+	memset(&movedFired, 0, sizeof(movedFired));
+	memset(&sharingFired, 0, sizeof(sharingFired));
+
+	//Two in the same slot, the one restarted taken out from under the other
+	SoftTimerStart(&sharing, 10, 0, OnExpire, &sharingFired);
+	SoftTimerStart(&moved, 10, 0, OnExpire, &movedFired);
+	RunUntil(start + 5);
+	SoftTimerStart(&moved, 10, 0, OnExpire, &movedFired);
+	HOST_CHECK(SoftTimerIsActive(&moved));
+
+	RunUntil(start + 30);
+	HOST_CHECK_EQUAL(sharingFired.count, 1);
+	HOST_CHECK(FiredAt(&sharingFired, 0, start + 10));
+	HOST_CHECK_EQUAL(movedFired.count, 1);
+	HOST_CHECK(FiredAt(&movedFired, 0, start + 15));
+
+	//Restarted as periodic, then as one shot again
+	SoftTimerStart(&moved, 2, 2, OnExpire, &movedFired);
+	RunUntil(start + 37);
+	HOST_CHECK_EQUAL(movedFired.count, 4);
+	SoftTimerStart(&moved, 4, 0, OnExpire, &movedFired);
+	RunUntil(start + 60);
+	HOST_CHECK_EQUAL(movedFired.count, 5);
+	HOST_CHECK(!SoftTimerIsActive(&moved));
+}
+
+
+static void TestStopInCallback(void)
+{
+	//Variables
+	SoftTimer_t self = SOFT_TIMER_INIT;
+	SoftTimer_t first = SOFT_TIMER_INIT;
+	SoftTimer_t second = SOFT_TIMER_INIT;
+	Fired_t selfFired;
+	Fired_t firstFired;
+	Fired_t secondFired;
+	uint32_t start = SystemMillis();
+
+	memset(&selfFired, 0, sizeof(selfFired));
+	memset(&firstFired, 0, sizeof(firstFired));
+	memset(&secondFired, 0, sizeof(secondFired));
+
+	//A periodic timer stopping itself, after it was put back in the wheel
+	selfFired.stop = &self;
+	selfFired.stopAfter = 3;
+	SoftTimerStart(&self, 1, SOFT_TIMER_WHEEL_SIZE, OnExpire, &selfFired);
+
+	//Timers are walked from the last one put in a slot, so the first one started is the next one walked after the second
+	secondFired.stop = &first;
+	secondFired.stopAfter = 1;
+	SoftTimerStart(&first, 8, 0, OnExpire, &firstFired);
+	SoftTimerStart(&second, 8, 0, OnExpire, &secondFired);
+
+	RunUntil(start + 100);
+	HOST_CHECK_EQUAL(selfFired.count, 3);
+	HOST_CHECK(!SoftTimerIsActive(&self));
+	HOST_CHECK_EQUAL(secondFired.count, 1);
+	HOST_CHECK_EQUAL(firstFired.count, 0);
+	HOST_CHECK(!SoftTimerIsActive(&first));
+}
+
+
+static void TestLateService(void)
+{
+	//Variables
+	SoftTimer_t oneShot = SOFT_TIMER_INIT;
+	SoftTimer_t periodic = SOFT_TIMER_INIT;
+	SoftTimer_t nextLap = SOFT_TIMER_INIT;
+	Fired_t oneShotFired;
+	Fired_t periodicFired;
+	Fired_t nextLapFired;
+	uint32_t start = SystemMillis();
+	uint32_t serviced = 0;
+
+	memset(&oneShotFired, 0, sizeof(oneShotFired));
+	memset(&periodicFired, 0, sizeof(periodicFired));
+	memset(&nextLapFired, 0, sizeof(nextLapFired));
+
+	SoftTimerStart(&oneShot, 5, 0, OnExpire, &oneShotFired);
+	SoftTimerStart(&periodic, 4, 4, OnExpire, &periodicFired);
+	SoftTimerStart(&nextLap, 3 * SOFT_TIMER_WHEEL_SIZE, 0, OnExpire, &nextLapFired);
+
+	//Well over a lap of the wheel with no service
+	HostSimRunMilliseconds(2 * SOFT_TIMER_WHEEL_SIZE + 8);
+	serviced = SystemMillis();
+	SoftTimerService();
+
+	//Each expired timer fires once, and the periodic one picks up a period from now rather than firing for each it missed
+	HOST_CHECK_EQUAL(oneShotFired.count, 1);
+	HOST_CHECK_EQUAL(periodicFired.count, 1);
+	HOST_CHECK_EQUAL(nextLapFired.count, 0);
+	HOST_CHECK(SoftTimerIsActive(&nextLap));
+
+	RunUntil(serviced + 4);
+	HOST_CHECK_EQUAL(periodicFired.count, 2);
+	HOST_CHECK(FiredAt(&periodicFired, 1, serviced + 4));
+
+	//The timer for the later lap still fires on its millisecond
+	RunUntil(start + 3 * SOFT_TIMER_WHEEL_SIZE + 2);
+	HOST_CHECK_EQUAL(nextLapFired.count, 1);
+	HOST_CHECK(FiredAt(&nextLapFired, 0, start + 3 * SOFT_TIMER_WHEEL_SIZE));
+	HOST_CHECK_EQUAL(oneShotFired.count, 1);
+
+	SoftTimerStop(&periodic);
+}
+
+
+int main(void)
+{
+	HostSimReset();
+	SystemTickInit();
+	sei();
+	HostSimRunMilliseconds(3);
+
+	TestOneShotAndPeriodic();
+	TestRestart();
+	TestStopInCallback();
+	TestLateService();
+
+	HOST_CHECK_EQUAL(HostSimUnhandledInterrupts(), 0);
+
+	return HostTestResult("softTimer");
+}
@@ -0,0 +1,31 @@
+/**
+ * \file atomic.h
+ * \author Tim Robbins
+ * \brief Host stand in for util/atomic.h. The block saves SREG and turns interrupts off, then puts SREG back or turns them on after.
+ */
+#ifndef HOST_UTIL_ATOMIC_H_
+#define HOST_UTIL_ATOMIC_H_ 1
+
+#include "../hostSim.h"
+
+///Puts SREG back to how it was at the start of the block
+#define ATOMIC_RESTORESTATE				0
+
+///Turns interrupts on at the end of the block
+#define ATOMIC_FORCEON					1
+
+///Leaves SREG alone at the end of a non atomic block
+#define NONATOMIC_RESTORESTATE			0
+
+///Turns interrupts off at the end of a non atomic block
+#define NONATOMIC_FORCEOFF				1
+
+///Runs the block with interrupts off
+#define ATOMIC_BLOCK(type)				for(uint8_t __hostSreg = HostSimAtomicEnter(), __hostOnce = 1; __hostOnce; \
+											__hostOnce = 0, HostSimAtomicExit((type) ? (uint8_t)(__hostSreg | 0x80) : __hostSreg))
+
+///Runs the block with interrupts on
+#define NONATOMIC_BLOCK(type)			for(uint8_t __hostSreg = SREG, __hostOnce = (HostSimInterruptsOn(), 1); __hostOnce; \
+											__hostOnce = 0, HostSimAtomicExit((type) ? (uint8_t)(__hostSreg & 0x7F) : __hostSreg))
+
+#endif
@@ -0,0 +1,25 @@
+/**
+ * \file delay.h
+ * \author Tim Robbins
+ * \brief Host stand in for util/delay.h. The delays run the simulation for the same number of cycles.
+ */
+#ifndef HOST_UTIL_DELAY_H_
+#define HOST_UTIL_DELAY_H_ 1
+
+#include "../hostSim.h"
+
+#ifndef F_CPU
+#warning "F_CPU not defined for <util/delay.h>"
+#define F_CPU							1000000UL
+#endif
+
+///Delays for a number of microseconds
+#define _delay_us(us)					HostSimDelayCycles((double)(us) * ((double)F_CPU / 1e6))
+
+///Delays for a number of milliseconds
+#define _delay_ms(ms)					HostSimDelayCycles((double)(ms) * ((double)F_CPU / 1e3))
+
+///Delays for a number of cycles
+#define __builtin_avr_delay_cycles(n)	HostSimDelayCycles((double)(n))
+
+#endif
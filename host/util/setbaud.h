@@ -0,0 +1,36 @@
+/**
+ * \file setbaud.h
+ * \author Tim Robbins
+ * \brief Host stand in for util/setbaud.h. Works out the USART baud rate register values from F_CPU and BAUD.
+ */
+#ifndef HOST_UTIL_SETBAUD_H_
+#define HOST_UTIL_SETBAUD_H_ 1
+
+#ifndef F_CPU
+#error "setbaud.h requires F_CPU to be defined"
+#endif
+
+#ifndef BAUD
+#error "setbaud.h requires BAUD to be defined"
+#endif
+
+#ifndef BAUD_TOL
+#define BAUD_TOL						2
+#endif
+
+#define UBRR_VALUE						(((F_CPU) + 8UL * (BAUD)) / (16UL * (BAUD)) - 1UL)
+
+//Falls back to double speed when the normal rate is out of tolerance
+#if (100 * (F_CPU) > (16 * ((UBRR_VALUE) + 1)) * (100 * (BAUD) + (BAUD) * (BAUD_TOL))) || \
+	(100 * (F_CPU) < (16 * ((UBRR_VALUE) + 1)) * (100 * (BAUD) - (BAUD) * (BAUD_TOL)))
+#undef UBRR_VALUE
+#define UBRR_VALUE						(((F_CPU) + 4UL * (BAUD)) / (8UL * (BAUD)) - 1UL)
+#define USE_2X							1
+#else
+#define USE_2X							0
+#endif
+
+#define UBRRL_VALUE						(UBRR_VALUE & 0xff)
+#define UBRRH_VALUE						(UBRR_VALUE >> 8)
+
+#endif
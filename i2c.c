@@ -98,7 +98,7 @@ uint8_t I2CByte(uint8_t i2c_address, uint8_t byte) {
 
 
 
-uint8_t I2CBytes(uint8_t i2c_address, uint8_t *bytes) {
+uint8_t I2CSendBytes(uint8_t i2c_address, uint8_t *bytes) {
 	uint8_t I2C_status = 0;
 	uint16_t index = 0;
 
@@ -107,9 +107,10 @@ uint8_t I2CBytes(uint8_t i2c_address, uint8_t *bytes) {
 	if(I2C_status == 0) {
 		while (*bytes)
 		{
-			__I2C_LOAD_DATA_REG(bytes++);
+			__I2C_LOAD_DATA_REG(*bytes++);
 			__I2C_START_EN();
 			uint16_t timeout = __I2C_TIMEOUT();
+			index = 0;
 			__I2C_WAIT_TILL_RDY() {
 				index++;
 				if(index >= timeout){
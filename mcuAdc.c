@@ -8,6 +8,11 @@
 
 #include "mcuAdc.h"
 
+#if defined(__AVR) && defined(ADC_USE_SCAN_MODE) && ADC_USE_SCAN_MODE == 1
+#include <avr/interrupt.h>
+#include "mcuIsrStats.h"
+#endif
+
 
 
 /**
@@ -52,7 +57,7 @@ uint16_t AdcGet(adc_channel_t adcChannel)
 uint16_t AdcSample(adc_channel_t adcChannel, uint8_t sampleCount)
 {
     //Variables
-    uint16_t adcResult = 0; //Return value from the ADC
+    uint32_t adcResult = 0; //Accumulated value from the ADC. 32 bits so 255 samples of 16 bit results can't overflow
     
     //If the sample count is greater than 0, avoid divide by 0 errors,...
     if(sampleCount > 0)
@@ -80,11 +85,586 @@ uint16_t AdcSample(adc_channel_t adcChannel, uint8_t sampleCount)
 
     }
     
-    return adcResult;
+    return (uint16_t)adcResult;
+}
+
+
+
+
+
+/**
+ * \brief Sets up a filter to oversample and decimate. 4^extraBits samples are summed and shifted right by extraBits, \n
+ * giving one output with extraBits more bits of resolution for every 4^extraBits samples in. Needs some noise on the signal to work.
+ * \param filter The filter to set up
+ * \param extraBits The amount of extra bits of resolution wanted, 1 to 4
+ */
+void AdcFilterInitOversample(AdcFilter_t* filter, uint8_t extraBits)
+{
+	//Range check
+	if(extraBits < 1)
+	{
+		extraBits = 1;
+	}
+	else if(extraBits > 4)
+	{
+		extraBits = 4;
+	}
+	
+	filter->type = ADC_FILTER_OVERSAMPLE;
+	filter->shift = extraBits;
+	
+	//4^n samples. For n of 4 this wraps to 0, which the sample count also wraps to after 256 samples
+	filter->length = (uint8_t)(1 << (extraBits << 1));
+	AdcFilterReset(filter);
+}
+
+
+
+/**
+ * \brief Sets up a moving average filter over the last 2^windowShift samples, using a running sum
+ * \param filter The filter to set up
+ * \param windowShift log2 of the window size. The window can't be larger than ADC_FILTER_MAX_WINDOW
+ * \return False if the window is too large, leaving the filter as it was
+ */
+bool AdcFilterInitAverage(AdcFilter_t* filter, uint8_t windowShift)
+{
+	//Range check. The shift is checked before it's used, shifting past the width of an int is undefined
+	if(windowShift > 7 || (1 << windowShift) > ADC_FILTER_MAX_WINDOW)
+	{
+		return false;
+	}
+	
+	filter->type = ADC_FILTER_AVERAGE;
+	filter->shift = windowShift;
+	filter->length = (uint8_t)(1 << windowShift);
+	AdcFilterReset(filter);
+	
+	return true;
+}
+
+
+
+/**
+ * \brief Sets up a first order IIR low pass filter, y += (x - y) >> k. A larger k is a lower cutoff
+ * \param filter The filter to set up
+ * \param k The filter shift, 1 to 15
+ */
+void AdcFilterInitIir(AdcFilter_t* filter, uint8_t k)
+{
+	//Range check
+	if(k < 1)
+	{
+		k = 1;
+	}
+	else if(k > 15)
+	{
+		k = 15;
+	}
+	
+	filter->type = ADC_FILTER_IIR;
+	filter->shift = k;
+	filter->length = 1;
+	AdcFilterReset(filter);
+}
+
+
+
+/**
+ * \brief Sets up a median of the last N samples filter, for removing spikes
+ * \param filter The filter to set up
+ * \param length The amount of samples to take the median of. Odd values from 3 to ADC_FILTER_MAX_MEDIAN
+ */
+void AdcFilterInitMedian(AdcFilter_t* filter, uint8_t length)
+{
+	//Range check, keeping it odd so there is a true middle
+	if(length < 3)
+	{
+		length = 3;
+	}
+	else if(length > ADC_FILTER_MAX_MEDIAN)
+	{
+		length = ADC_FILTER_MAX_MEDIAN;
+	}
+	
+	if((length & 0x01) == 0)
+	{
+		length--;
+	}
+	
+	filter->type = ADC_FILTER_MEDIAN;
+	filter->shift = 0;
+	filter->length = length;
+	AdcFilterReset(filter);
+}
+
+
+
+/**
+ * \brief Clears a filters state, keeping its settings
+ * \param filter The filter to reset
+ */
+void AdcFilterReset(AdcFilter_t* filter)
+{
+	filter->count = 0;
+	filter->index = 0;
+	filter->accumulator = 0;
+}
+
+
+
+/**
+ * \brief Runs a sample through a filter. Only shifts, adds and compares are used, no division, so it's fine to call from an ISR
+ * \param filter The filter
+ * \param sample The new sample
+ * \param output Where to load the filtered value, if there is one
+ * \return True if there is an output for this sample, false if the filter is still collecting samples for its next output
+ */
+bool AdcFilterProcess(AdcFilter_t* filter, uint16_t sample, uint16_t* output)
+{
+	//Variables
+	bool hasOutput = true; //If an output was made
+	
+	switch(filter->type)
+	{
+		case ADC_FILTER_OVERSAMPLE:
+			filter->accumulator += sample;
+			filter->count++;
+			
+			//If the decimation count has been reached, output the sum shifted down by the extra bits
+			if(filter->count == filter->length)
+			{
+				*output = (uint16_t)(filter->accumulator >> filter->shift);
+				filter->accumulator = 0;
+				filter->count = 0;
+			}
+			else
+			{
+				hasOutput = false;
+			}
+			break;
+			
+		case ADC_FILTER_AVERAGE:
+			//On the first sample, fill the window with it so the output starts out settled instead of ramping up from 0
+			if(filter->count == 0)
+			{
+				for(uint8_t i = 0; i < filter->length; i++)
+				{
+					filter->history[i] = sample;
+				}
+				
+				filter->accumulator = ((int32_t)sample << filter->shift);
+				filter->count = 1;
+			}
+			
+			//Swap the oldest sample in the running sum for the newest
+			filter->accumulator += (int32_t)sample - filter->history[filter->index];
+			filter->history[filter->index] = sample;
+			filter->index = (filter->index + 1) & (filter->length - 1);
+			*output = (uint16_t)(filter->accumulator >> filter->shift);
+			break;
+			
+		case ADC_FILTER_IIR:
+			//Start the state at the first sample instead of 0
+			if(filter->count == 0)
+			{
+				filter->accumulator = ((int32_t)sample << ADC_FILTER_IIR_FRACTION_BITS);
+				filter->count = 1;
+			}
+			
+			filter->accumulator += ((((int32_t)sample << ADC_FILTER_IIR_FRACTION_BITS) - filter->accumulator) >> filter->shift);
+			
+			//Round to the nearest whole value on the way out
+			*output = (uint16_t)((filter->accumulator + (1 << (ADC_FILTER_IIR_FRACTION_BITS - 1))) >> ADC_FILTER_IIR_FRACTION_BITS);
+			break;
+			
+		case ADC_FILTER_MEDIAN:
+		{
+			//Variables
+			uint16_t sorted[ADC_FILTER_MAX_MEDIAN]; //Sorted copy of the window
+			uint8_t windowCount = 0; //The amount of samples in the window so far
+			
+			filter->history[filter->index] = sample;
+			filter->index++;
+			
+			if(filter->index >= filter->length)
+			{
+				filter->index = 0;
+			}
+			
+			if(filter->count < filter->length)
+			{
+				filter->count++;
+			}
+			
+			windowCount = filter->count;
+			
+			//Insertion sort the small window into the copy
+			for(uint8_t i = 0; i < windowCount; i++)
+			{
+				uint16_t value = filter->history[i];
+				uint8_t j = i;
+				
+				while(j > 0 && sorted[j - 1] > value)
+				{
+					sorted[j] = sorted[j - 1];
+					j--;
+				}
+				
+				sorted[j] = value;
+			}
+			
+			*output = sorted[windowCount >> 1];
+			break;
+		}
+		
+		default:
+			*output = sample;
+			break;
+	};
+	
+	return hasOutput;
 }
 
 
 
+#if defined(__AVR) && defined(ADC_USE_SCAN_MODE) && ADC_USE_SCAN_MODE == 1
+
+
+///The channels being scanned and their result buffers
+static AdcScanChannel_t m_adcScanChannels[ADC_SCAN_MAX_CHANNELS];
+
+///The amount of channels in the scan list
+static uint8_t m_uchrAdcScanCount = 0;
+
+///The scan list index of the conversion in progress
+static volatile uint8_t m_uchrAdcScanIndex = 0;
+
+///The scan list index the multiplexer is set to. Free running, it's one ahead of the conversion in progress
+static volatile uint8_t m_uchrAdcScanSelected = 0;
+
+///The trigger source for the scan
+static uint8_t m_uchrAdcScanTrigger = ADC_SCAN_TRIGGER_CHAINED;
+
+
+
+/**
+ * \brief ADC conversion complete vector. Stores the result for the channel just converted and moves the multiplexer to the next channel in the list
+ *
+ */
+ISR(ADC_vect)
+{
+	ISR_STATS_ENTER(ISR_STATS_ID_ADC);
+	
+	//Variables
+	uint8_t scanIndex = m_uchrAdcScanIndex; //Index of the channel that just finished
+	AdcScanChannel_t* scanChannel = 0; //The channel that just finished
+	uint16_t adcValue = (uint16_t)ADC_get_result(); //The conversion result
+	uint8_t nextHead = 0; //Where the head will be after this write
+	bool hasOutput = true; //If there is a result to store
+	
+	//Range check, in case the list was changed under a conversion
+	if(scanIndex >= m_uchrAdcScanCount)
+	{
+		ISR_STATS_EXIT(ISR_STATS_ID_ADC);
+		return;
+	}
+	
+	scanChannel = &m_adcScanChannels[scanIndex];
+	nextHead = (scanChannel->head + 1) & (ADC_SCAN_BUFFER_SIZE - 1);
+	
+	//Run the filter, if any. Decimating filters only have an output every so many samples
+	if(scanChannel->filter != 0)
+	{
+		hasOutput = AdcFilterProcess(scanChannel->filter, adcValue, &adcValue);
+	}
+	
+	//If nothing to store...
+	if(hasOutput == false)
+	{
+		//Skip it
+	}
+	//Else if the buffer has room, store the result. Else, count the overrun and keep the oldest values
+	else if(nextHead != scanChannel->tail)
+	{
+		scanChannel->buffer[scanChannel->head] = adcValue;
+		scanChannel->head = nextHead;
+	}
+	else if(scanChannel->overruns < 0xFF)
+	{
+		scanChannel->overruns++;
+	}
+	
+	if(hasOutput)
+	{
+		scanChannel->latest = adcValue;
+	}
+	
+	//Move the multiplexer on to the next channel in the list
+	scanIndex = m_uchrAdcScanSelected + 1;
+	if(scanIndex >= m_uchrAdcScanCount)
+	{
+		scanIndex = 0;
+	}
+	
+	//Free running, the conversion now in progress started on the channel already selected. Otherwise the next one is on the new channel
+	if(m_uchrAdcScanTrigger == ADC_SCAN_TRIGGER_FREE_RUNNING)
+	{
+		m_uchrAdcScanIndex = m_uchrAdcScanSelected;
+	}
+	else
+	{
+		m_uchrAdcScanIndex = scanIndex;
+	}
+	
+	m_uchrAdcScanSelected = scanIndex;
+	ADC_select_channel(m_adcScanChannels[scanIndex].channel);
+	
+	//If not being auto triggered, start the next conversion now
+	if(m_uchrAdcScanTrigger == ADC_SCAN_TRIGGER_CHAINED)
+	{
+		ADC_start_conversion();
+	}
+	#if defined(ADC_SCAN_CLEAR_TRIGGER_FLAG)
+	//The trigger source only starts a conversion on a rising edge of its flag, so clear it for the next period
+	else
+	{
+		ADC_SCAN_CLEAR_TRIGGER_FLAG();
+	}
+	#endif
+	
+	ISR_STATS_EXIT(ISR_STATS_ID_ADC);
+}
+
+
+
+/**
+ * \brief Sets up the interrupt driven scan of the channels passed. The ADC must already be configured and enabled. \n
+ * For a fixed sample rate, pass the chips ADTS value for a timer (such as a compare match) as the trigger source. \n
+ * ADC_SCAN_TRIGGER_FREE_RUNNING converts back to back without the interrupt starting each one, and its results are matched to their channel. \n
+ * The trigger sources interrupt flag must be cleared each period for the next trigger to happen, either by its own ISR or by defining ADC_SCAN_CLEAR_TRIGGER_FLAG(). \n
+ * Each channel is sampled at (trigger rate / channelCount). \n
+ * Example use: \n
+ * const adc_channel_t channels[3] = { ADC_0, ADC_2, ADC_5 }; \n
+ * AdcScanInit(channels, 3, ADC_SCAN_TRIGGER_CHAINED); \n
+ * AdcScanStart(); \n
+ * \param adcChannels The channels to scan, in order
+ * \param channelCount The amount of channels to scan
+ * \param triggerSource The ADTS value of the auto trigger source to use, or ADC_SCAN_TRIGGER_CHAINED to convert back to back
+ * \return The amount of channels being scanned
+ */
+uint8_t AdcScanInit(const adc_channel_t adcChannels[], uint8_t channelCount, uint8_t triggerSource)
+{
+	//Make sure we aren't scanning while setting up
+	AdcScanStop();
+	
+	//Range check
+	if(channelCount > ADC_SCAN_MAX_CHANNELS)
+	{
+		channelCount = ADC_SCAN_MAX_CHANNELS;
+	}
+	
+	//Load the channels and reset their buffers
+	for(uint8_t i = 0; i < channelCount; i++)
+	{
+		m_adcScanChannels[i].channel = adcChannels[i];
+		m_adcScanChannels[i].head = 0;
+		m_adcScanChannels[i].tail = 0;
+		m_adcScanChannels[i].overruns = 0;
+		m_adcScanChannels[i].latest = 0;
+		m_adcScanChannels[i].filter = 0;
+	}
+	
+	m_uchrAdcScanCount = channelCount;
+	m_uchrAdcScanTrigger = triggerSource;
+	
+	return channelCount;
+}
+
+
+
+/**
+ * \brief Starts the interrupt driven scan. Global interrupts must be on
+ *
+ */
+void AdcScanStart()
+{
+	//If there's nothing to scan, nothing to start
+	if(m_uchrAdcScanCount == 0)
+	{
+		return;
+	}
+	
+	//Start from the top of the list, dropping any result left from before
+	m_uchrAdcScanIndex = 0;
+	m_uchrAdcScanSelected = 0;
+	ADC_select_channel(m_adcScanChannels[0].channel);
+	ADC_clear_interrupt_flag();
+	ADC_enable_interrupt();
+	
+	if(m_uchrAdcScanTrigger == ADC_SCAN_TRIGGER_CHAINED)
+	{
+		ADC_disable_auto_trigger();
+		ADC_start_conversion();
+	}
+	else
+	{
+		ADC_set_auto_trigger_source(m_uchrAdcScanTrigger);
+		ADC_enable_auto_trigger();
+		
+		//Free running needs the first conversion started, after that each starts the next
+		if(m_uchrAdcScanTrigger == ADC_SCAN_TRIGGER_FREE_RUNNING)
+		{
+			ADC_start_conversion();
+		}
+	}
+}
+
+
+
+/**
+ * \brief Stops the interrupt driven scan and leaves the channel selection cleared for AdcGet and AdcSample
+ *
+ */
+void AdcScanStop()
+{
+	ADC_disable_auto_trigger();
+	ADC_disable_interrupt();
+	
+	//Let any conversion in progress finish
+	while(ADC_get_status());
+	
+	ADC_select_channel(0);
+}
+
+
+
+/**
+ * \brief Gets the amount of results waiting in a scanned channels buffer
+ * \param scanIndex The index of the channel in the scan list
+ * \return The amount of results waiting
+ */
+uint8_t AdcScanAvailable(uint8_t scanIndex)
+{
+	if(scanIndex >= m_uchrAdcScanCount)
+	{
+		return 0;
+	}
+	
+	return (uint8_t)((m_adcScanChannels[scanIndex].head - m_adcScanChannels[scanIndex].tail) & (ADC_SCAN_BUFFER_SIZE - 1));
+}
+
+
+
+/**
+ * \brief Reads the oldest result from a scanned channels buffer without blocking
+ * \param scanIndex The index of the channel in the scan list
+ * \param adcValue Where to load the result
+ * \return True if a result was read, false if the buffer was empty
+ */
+bool AdcScanRead(uint8_t scanIndex, uint16_t* adcValue)
+{
+	//Variables
+	AdcScanChannel_t* scanChannel = 0; //The channel to read from
+	uint8_t tail = 0; //Copy of the read index
+	
+	if(scanIndex >= m_uchrAdcScanCount)
+	{
+		return false;
+	}
+	
+	scanChannel = &m_adcScanChannels[scanIndex];
+	tail = scanChannel->tail;
+	
+	//If empty...
+	if(tail == scanChannel->head)
+	{
+		return false;
+	}
+	
+	//The ISR only writes to the head, so the single byte tail update needs no locking
+	*adcValue = scanChannel->buffer[tail];
+	scanChannel->tail = (tail + 1) & (ADC_SCAN_BUFFER_SIZE - 1);
+	
+	return true;
+}
+
+
+
+/**
+ * \brief Gets the most recent result of a scanned channel without removing anything from its buffer
+ * \param scanIndex The index of the channel in the scan list
+ * \return The most recent result, 0 if nothing has been converted yet
+ */
+uint16_t AdcScanLatest(uint8_t scanIndex)
+{
+	//Variables
+	uint16_t adcValue = 0; //The return value
+	uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+	
+	if(scanIndex >= m_uchrAdcScanCount)
+	{
+		return 0;
+	}
+	
+	//Reading a 16 bit value the ISR may be writing, so do it with interrupts off
+	interruptsOff();
+	adcValue = m_adcScanChannels[scanIndex].latest;
+	SREG = sreg;
+	
+	return adcValue;
+}
+
+
+
+/**
+ * \brief Gets the amount of results dropped from a scanned channel because its buffer was full
+ * \param scanIndex The index of the channel in the scan list
+ * \return The amount of dropped results, saturating at 255
+ */
+uint8_t AdcScanOverruns(uint8_t scanIndex)
+{
+	if(scanIndex >= m_uchrAdcScanCount)
+	{
+		return 0;
+	}
+	
+	return m_adcScanChannels[scanIndex].overruns;
+}
+
+
+
+/**
+ * \brief Attaches a filter to a scanned channel so its results are filtered in the ADC interrupt before being buffered. \n
+ * The filter is reset as it's attached, so nothing it saw before carries over. Pass 0 to remove the filter. The filter must stay in memory while it is attached.
+ * \param scanIndex The index of the channel in the scan list
+ * \param filter The initialized filter to attach
+ */
+void AdcScanSetFilter(uint8_t scanIndex, AdcFilter_t* filter)
+{
+	//Variables
+	uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+	
+	if(scanIndex >= m_uchrAdcScanCount)
+	{
+		return;
+	}
+	
+	//Swap the filter and drop the old results with interrupts off so the ISR never sees a half made change
+	interruptsOff();
+	
+	if(filter != 0)
+	{
+		AdcFilterReset(filter);
+	}
+	
+	m_adcScanChannels[scanIndex].filter = filter;
+	m_adcScanChannels[scanIndex].tail = m_adcScanChannels[scanIndex].head;
+	SREG = sreg;
+}
+
+
+#endif
+
 
 
 #if defined(__DAC_INCLUDED__)
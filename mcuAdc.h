@@ -14,6 +14,7 @@ extern "C" {
 
 #include "config.h"
 #include "mcuUtils.h"
+#include <stdbool.h>
 
 
 #ifdef __AVR
@@ -27,26 +28,35 @@ extern "C" {
 ///Sets the adc results to b right adjusted
 #define ADC_adjust_right()						ADMUX &= ~(1 << ADLAR)
 
+///Sets bits in ADCSRA. ADIF is written as 0, since writing back a 1 read from it would clear a result not yet taken
+#define ADC_CONTROL_SET(bits)					ADCSRA = ((ADCSRA & ~(1 << ADIF)) | (bits))
+
+///Clears bits in ADCSRA, writing ADIF as 0
+#define ADC_CONTROL_CLEAR(bits)					ADCSRA = (ADCSRA & ~((1 << ADIF) | (bits)))
+
 ///Enables the adc
-#define ADC_enable()							ADCSRA |= (1 << ADEN)
+#define ADC_enable()							ADC_CONTROL_SET(1 << ADEN)
 
 ///Disables the ADC
-#define ADC_disable()							ADCSRA &= ~(1 << ADEN)
+#define ADC_disable()							ADC_CONTROL_CLEAR(1 << ADEN)
 
 ///Enables ADC interrupts
-#define ADC_enable_interrupt()					ADCSRA |= (1 << ADIE)
+#define ADC_enable_interrupt()					ADC_CONTROL_SET(1 << ADIE)
 
 ///Disables adc interrupts
-#define ADC_disable_interrupt()					ADCSRA &= ~(1 << ADIE)
+#define ADC_disable_interrupt()					ADC_CONTROL_CLEAR(1 << ADIE)
 
 ///Starts ADC conversion
-#define ADC_start_conversion()					ADCSRA |= (1 << ADSC)
+#define ADC_start_conversion()					ADC_CONTROL_SET(1 << ADSC)
 
 ///Enables the auto trigger
-#define ADC_enable_auto_trigger()				ADCSRA |= (1 << ADATE)
+#define ADC_enable_auto_trigger()				ADC_CONTROL_SET(1 << ADATE)
 
 ///Disables the auto trigger
-#define ADC_disable_auto_trigger()				ADCSRA &= ~(1 << ADATE)
+#define ADC_disable_auto_trigger()				ADC_CONTROL_CLEAR(1 << ADATE)
+
+///Clears the conversion complete flag, dropping a result the interrupt hasn't taken
+#define ADC_clear_interrupt_flag()				ADC_CONTROL_SET(1 << ADIF)
 
 ///Voltage reference mode 1
 #define ADC_REF_MODE_1							(0b00 << REFS0)
@@ -154,6 +164,59 @@ extern void DacSet(uint16_t dacValue);
 
 #define ADC_get_status()		((ADCSRA >> ADSC) & 0x01)
 
+#ifndef ADC_CHANNEL_MASK
+///Mask for the channel select bits in the channel select register
+#define ADC_CHANNEL_MASK		0x1F
+#endif
+
+#ifdef ADTS3
+///Mask for the auto trigger source select bits
+#define ADC_TRIGGER_SOURCE_MASK	((1 << ADTS3) | (1 << ADTS2) | (1 << ADTS1) | (1 << ADTS0))
+#else
+///Mask for the auto trigger source select bits
+#define ADC_TRIGGER_SOURCE_MASK	((1 << ADTS2) | (1 << ADTS1) | (1 << ADTS0))
+#endif
+
+///Sets the auto trigger source select bits. Values are chip specific, see the ADCSRB ADTS bits in the datasheet
+#define ADC_set_auto_trigger_source(v)			ADCSRB = ((ADCSRB & ~ADC_TRIGGER_SOURCE_MASK) | ((v) & ADC_TRIGGER_SOURCE_MASK))
+
+///Selects the channel, leaving the rest of the channel select register alone
+#define ADC_select_channel(ch)					ADC_CHANNEL_REG = ((ADC_CHANNEL_REG & ~ADC_CHANNEL_MASK) | ((ch) & ADC_CHANNEL_MASK))
+
+
+
+#ifndef ADC_USE_SCAN_MODE
+///If the interrupt driven channel scanning should be used. Defines ISR(ADC_vect) if set to 1
+#define ADC_USE_SCAN_MODE		0
+#endif
+
+
+#if ADC_USE_SCAN_MODE == 1
+
+#ifndef ADC_SCAN_MAX_CHANNELS
+///The max amount of channels in the scan list
+#define ADC_SCAN_MAX_CHANNELS	4
+#endif
+
+#ifndef ADC_SCAN_BUFFER_SIZE
+///The size of each channels result ring buffer. Must be a power of 2
+#define ADC_SCAN_BUFFER_SIZE	16
+#endif
+
+#if (ADC_SCAN_BUFFER_SIZE & (ADC_SCAN_BUFFER_SIZE - 1)) != 0 || ADC_SCAN_BUFFER_SIZE > 128
+#error mcuAdc.h: ADC_SCAN_BUFFER_SIZE must be a power of 2, no larger than 128
+#endif
+
+///Trigger value for the scan to start each conversion from the ADC interrupt, back to back, instead of from an auto trigger source
+#define ADC_SCAN_TRIGGER_CHAINED	0xFF
+
+///Trigger value for free running, the ADTS value 0. Each conversion starts as the last ends, before the interrupt can move the multiplexer,
+///so the scan keeps one channel ahead. The interrupt must run within a conversion time
+#define ADC_SCAN_TRIGGER_FREE_RUNNING	0
+
+#endif
+
+
 
 
 #elif defined(__XC)
@@ -243,6 +306,100 @@ extern uint16_t AdcSample(adc_channel_t adcChannel, uint8_t sampleCount);
 
 
 
+///Filter type for a filter that passes samples through untouched
+#define ADC_FILTER_NONE					0
+
+///Filter type for oversampling and decimating, 4^n samples in for 1 sample out with n extra bits
+#define ADC_FILTER_OVERSAMPLE			1
+
+///Filter type for a moving average over a power of 2 window, using a running sum
+#define ADC_FILTER_AVERAGE				2
+
+///Filter type for a first order IIR low pass, y += (x - y) / 2^k
+#define ADC_FILTER_IIR					3
+
+///Filter type for a median of the last N samples, for despiking
+#define ADC_FILTER_MEDIAN				4
+
+
+#ifndef ADC_FILTER_MAX_WINDOW
+///The max amount of samples a moving average or median filter keeps. Must be a power of 2
+#define ADC_FILTER_MAX_WINDOW			16
+#endif
+
+#ifndef ADC_FILTER_MAX_MEDIAN
+///The max amount of samples a median filter can use. Kept small since the sort is done on every sample
+#define ADC_FILTER_MAX_MEDIAN			7
+#endif
+
+#ifndef ADC_FILTER_IIR_FRACTION_BITS
+///The amount of fraction bits the IIR filter keeps its state with
+#define ADC_FILTER_IIR_FRACTION_BITS	8
+#endif
+
+#if (ADC_FILTER_MAX_WINDOW & (ADC_FILTER_MAX_WINDOW - 1)) != 0 || ADC_FILTER_MAX_MEDIAN > ADC_FILTER_MAX_WINDOW
+#error mcuAdc.h: ADC_FILTER_MAX_WINDOW must be a power of 2 and no smaller than ADC_FILTER_MAX_MEDIAN
+#endif
+
+
+typedef struct _ADC_FILTER_
+{
+	uint8_t type;									///The type of filter, ADC_FILTER_X
+	uint8_t shift;									///Oversample: extra bits. Average: log2 of the window. IIR: k
+	uint8_t length;									///The amount of samples per output (oversample) or in the window (average, median)
+	uint8_t count;									///The amount of samples taken so far
+	uint8_t index;									///The next write position in the history
+	int32_t accumulator;							///Oversample: sum. Average: running sum. IIR: state with fraction bits
+	uint16_t history[ADC_FILTER_MAX_WINDOW];		///The last samples for the average and median filters
+
+}
+/**
+* \brief Struct for a fixed point streaming filter. No division is done when processing samples
+*/
+AdcFilter_t;
+
+
+extern void AdcFilterInitOversample(AdcFilter_t* filter, uint8_t extraBits);
+extern bool AdcFilterInitAverage(AdcFilter_t* filter, uint8_t windowShift);
+extern void AdcFilterInitIir(AdcFilter_t* filter, uint8_t k);
+extern void AdcFilterInitMedian(AdcFilter_t* filter, uint8_t length);
+extern void AdcFilterReset(AdcFilter_t* filter);
+extern bool AdcFilterProcess(AdcFilter_t* filter, uint16_t sample, uint16_t* output);
+
+
+#if defined(ADC_USE_SCAN_MODE) && ADC_USE_SCAN_MODE == 1
+
+
+typedef struct _ADC_SCAN_CHANNEL_
+{
+	volatile uint16_t buffer[ADC_SCAN_BUFFER_SIZE];		///Ring buffer of the results for the channel
+	volatile uint8_t head;								///Write index, only moved by the ADC interrupt
+	volatile uint8_t tail;								///Read index, only moved by the application
+	volatile uint8_t overruns;							///Count of results dropped because the buffer was full. Saturates at 255
+	volatile uint16_t latest;							///The most recent result, kept even when the buffer is full
+	AdcFilter_t* filter;								///Optional filter the results are passed through before being buffered
+	adc_channel_t channel;								///The channel to convert
+
+}
+/**
+* \brief Struct for a scanned channel and its result ring buffer
+*/
+AdcScanChannel_t;
+
+
+extern uint8_t AdcScanInit(const adc_channel_t adcChannels[], uint8_t channelCount, uint8_t triggerSource);
+extern void AdcScanStart();
+extern void AdcScanStop();
+extern uint8_t AdcScanAvailable(uint8_t scanIndex);
+extern bool AdcScanRead(uint8_t scanIndex, uint16_t* adcValue);
+extern uint16_t AdcScanLatest(uint8_t scanIndex);
+extern uint8_t AdcScanOverruns(uint8_t scanIndex);
+extern void AdcScanSetFilter(uint8_t scanIndex, AdcFilter_t* filter);
+
+#endif
+
+
+
 
 
 
@@ -0,0 +1,107 @@
+/**
+ * \file mcuCrc.h
+ * \author Tim Robbins
+ * \brief Header file for the CRCs used in framing and image checks. \n
+ * CRC-8 SAE J1850, for LIN and CAN signal protection. CRC-16 Modbus, for Modbus RTU. \n
+ * CRC-16 CCITT, the 0x1021 non reflected one starting at 0xFFFF, for ISO-TP payloads and serial framing. CRC-32, the Ethernet and zip one, for firmware images. \n
+ * Each CRC can be worked out three ways, picked per CRC at build time to trade flash for speed: \n
+ * CRC_METHOD_BITWISE takes no table but shifts 8 times a byte, CRC_METHOD_NIBBLE has a 16 entry table and does two lookups a byte, \n
+ * CRC_METHOD_TABLE has a 256 entry table and does one. The tables are in program memory. \n
+ * Per CRC the tables are 16 and 256 bytes for CRC-8, 32 and 512 for each CRC-16 and 64 and 1024 for CRC-32. \n
+ * All the methods give the same CRC. \n
+ *
+ * The Update and Block functions are the raw CRC. They keep no state, so any number of CRCs can be worked out at once, \n
+ * in interrupts as well, a byte at a time as it arrives. Start from the CRC's INIT value and xor the end with its XOROUT. \n
+ * The plain functions do a whole buffer, start to end. \n
+ *
+ * Example use: \n
+ *
+ * crc = CRC16_MODBUS_INIT; \n
+ * ISR(USART0_RX_vect) { crc = Crc16ModbusUpdate(crc, UDR0); } \n
+ * ... \n
+ * crc = CRC32_INIT; \n
+ * for(page = 0; page < pages; page++) crc = Crc32Block(crc, ReadPage(page), PAGE_SIZE); \n
+ * good = ((crc ^ CRC32_XOROUT) == imageCrc); \n
+ *
+ * The methods are measured against each other by host/bench/crcBench.cpp, built once for each CRC_METHOD by make -C host bench. \n
+ */
+#ifndef MCU_CRC_H_
+#define MCU_CRC_H_ 1
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+
+///Ways of working out a CRC
+#define CRC_METHOD_BITWISE				0	//No table, a shift per bit
+#define CRC_METHOD_NIBBLE				1	//A 16 entry table, a lookup per 4 bits
+#define CRC_METHOD_TABLE				2	//A 256 entry table, a lookup per byte
+
+#ifndef CRC_METHOD
+///The method for every CRC not given its own
+#define CRC_METHOD						CRC_METHOD_TABLE
+#endif
+
+#ifndef CRC8_J1850_METHOD
+///The method for CRC-8 SAE J1850
+#define CRC8_J1850_METHOD				CRC_METHOD
+#endif
+
+#ifndef CRC16_MODBUS_METHOD
+///The method for CRC-16 Modbus
+#define CRC16_MODBUS_METHOD				CRC_METHOD
+#endif
+
+#ifndef CRC16_CCITT_METHOD
+///The method for CRC-16 CCITT
+#define CRC16_CCITT_METHOD				CRC_METHOD
+#endif
+
+#ifndef CRC32_METHOD
+///The method for CRC-32
+#define CRC32_METHOD					CRC_METHOD
+#endif
+
+
+///CRC-8 SAE J1850, polynomial 0x1D, not reflected. The CRC of "123456789" is 0x4B
+#define CRC8_J1850_INIT					0xFF
+#define CRC8_J1850_XOROUT				0xFF
+
+///CRC-16 Modbus, polynomial 0x8005, reflected. The CRC of "123456789" is 0x4B37. Sent low byte first
+#define CRC16_MODBUS_INIT				0xFFFF
+#define CRC16_MODBUS_XOROUT				0x0000
+
+///CRC-16 CCITT, polynomial 0x1021, not reflected. The CRC of "123456789" is 0x29B1. Start from 0 instead for XMODEM
+#define CRC16_CCITT_INIT				0xFFFF
+#define CRC16_CCITT_XOROUT				0x0000
+
+///CRC-32, polynomial 0x04C11DB7, reflected. The CRC of "123456789" is 0xCBF43926
+#define CRC32_INIT						0xFFFFFFFFUL
+#define CRC32_XOROUT					0xFFFFFFFFUL
+
+
+extern uint8_t Crc8J1850Update(uint8_t crc, uint8_t data);
+extern uint8_t Crc8J1850Block(uint8_t crc, const uint8_t* data, uint16_t length);
+extern uint8_t Crc8J1850(const uint8_t* data, uint16_t length);
+
+extern uint16_t Crc16ModbusUpdate(uint16_t crc, uint8_t data);
+extern uint16_t Crc16ModbusBlock(uint16_t crc, const uint8_t* data, uint16_t length);
+extern uint16_t Crc16Modbus(const uint8_t* data, uint16_t length);
+
+extern uint16_t Crc16CcittUpdate(uint16_t crc, uint8_t data);
+extern uint16_t Crc16CcittBlock(uint16_t crc, const uint8_t* data, uint16_t length);
+extern uint16_t Crc16Ccitt(const uint8_t* data, uint16_t length);
+
+extern uint32_t Crc32Update(uint32_t crc, uint8_t data);
+extern uint32_t Crc32Block(uint32_t crc, const uint8_t* data, uint16_t length);
+extern uint32_t Crc32(const uint8_t* data, uint16_t length);
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif /* MCU_CRC_H_ */
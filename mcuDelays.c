@@ -9,6 +9,95 @@
 #include "mcuDelays.h"
 
 
+#if MCU_DELAYS_USE_SYSTEM_TICK == 1 && defined(__AVR)
+
+#include "avrTimers.h"
+#include "mcuUtils.h"
+
+#if AVR_TIMERS_USE_SYSTEM_TICK != 1
+#error mcuDelays.c: MCU_DELAYS_USE_SYSTEM_TICK needs AVR_TIMERS_USE_SYSTEM_TICK as 1 in config.h
+#endif
+
+///If the interrupts are on and the system tick is running, which the sleeping delays need to wake back up. \n
+///Checked each time, so a delay before SystemTickInit or with Timer 0 stopped spins instead of sleeping forever
+#define __DELAYS_CAN_SLEEP()	((SREG & (1 << SREG_I)) && (TIMSK0 & (1 << OCIE0A)) && (TCCR0B & (1 << CS02 | 1 << CS01 | 1 << CS00)))
+
+
+
+/**
+ * \brief Sleeps in idle once, until the next interrupt. Interrupts must be on. \n
+ * Sleep is entered right after interrupts are turned back on, so an interrupt can't slip in between and be slept through.
+ */
+void idleSleep(void)
+{
+	interruptsOff();
+	sleep_set_mode(SLEEP_IDLE_MODE);
+	sleep_enable();
+	interruptsOn();
+	sleep_cpu();
+	sleep_disable();
+}
+
+
+
+/**
+ * \brief Sleeps in idle for x milliseconds. The system tick wakes the core each tick to check the time, \n
+ * and any other interrupts still run while waiting. Interrupts must be on.
+ * \param milliseconds delay time
+ */
+void sleepForMilliseconds(uint32_t milliseconds)
+{
+	//Variables
+	uint32_t start = SystemMicros(); //The time the delay started
+	
+	//Done in chunks of a second so the microsecond difference can't wrap
+	while(milliseconds > 1000)
+	{
+		while((SystemMicros() - start) < 1000000UL)
+		{
+			idleSleep();
+		}
+		
+		start += 1000000UL;
+		milliseconds -= 1000;
+	}
+	
+	while((SystemMicros() - start) < (milliseconds * 1000UL))
+	{
+		idleSleep();
+	}
+}
+
+
+
+/**
+ * \brief Sleeps in idle until a condition is true, checking it after every interrupt, such as a \n
+ * receive complete or the system tick. Interrupts must be on.
+ * \param condition The function returning true once the wait is done
+ * \param timeoutMilliseconds The max time to wait, 0 for forever
+ * \return True if the condition was met, false if it timed out
+ */
+bool waitUntil(DelayCondition_t condition, uint32_t timeoutMilliseconds)
+{
+	//Variables
+	uint32_t deadline = SystemMillis() + timeoutMilliseconds; //When to give up
+	
+	while(condition() == false)
+	{
+		if(timeoutMilliseconds != 0 && SystemTimeReached(deadline))
+		{
+			return false;
+		}
+		
+		idleSleep();
+	}
+	
+	return true;
+}
+
+#endif
+
+
 
 
 /**
@@ -28,6 +117,15 @@ void delayForMicroseconds(uint16_t microseconds) {
  * \param milliseconds delay time
  */
 void delayForMilliseconds(uint16_t milliseconds) {
+	
+	#if MCU_DELAYS_USE_SYSTEM_TICK == 1 && defined(__AVR)
+	//Sleep through it if the tick can wake us back up, spin otherwise
+	if(__DELAYS_CAN_SLEEP()) {
+		sleepForMilliseconds(milliseconds);
+		return;
+	}
+	#endif
+	
 	for(uint16_t i = 0; i < milliseconds; i++) {
 		__DELAYS_MS_DELAY_CALL(1);
 	}
@@ -40,6 +138,15 @@ void delayForMilliseconds(uint16_t milliseconds) {
  * \param tenthSeconds the amount of tenth seconds/100 milliseconds to delay for
  */
 void delayForTenthSeconds(uint16_t tenthSeconds) {
+	
+	#if MCU_DELAYS_USE_SYSTEM_TICK == 1 && defined(__AVR)
+	//Sleep through it if the tick can wake us back up, spin otherwise
+	if(__DELAYS_CAN_SLEEP()) {
+		sleepForMilliseconds((uint32_t)tenthSeconds * 100UL);
+		return;
+	}
+	#endif
+	
 	for(uint16_t i = 0; i < tenthSeconds; i++) {
 		__DELAYS_MS_DELAY_CALL(100);
 	}
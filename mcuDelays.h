@@ -126,6 +126,33 @@ extern void delayForTenthSeconds(uint16_t tenthSeconds);
 
 
 
+#ifndef MCU_DELAYS_USE_SYSTEM_TICK
+///Set as 1 to sleep in idle through millisecond delays using the avrTimers system tick, instead of spinning. \n
+///A delay still spins while interrupts are off or before SystemTickInit has started the tick
+#define MCU_DELAYS_USE_SYSTEM_TICK	0
+#endif
+
+
+#if MCU_DELAYS_USE_SYSTEM_TICK == 1 && defined(__AVR)
+
+#include <stdbool.h>
+
+///Function pointer type for the conditions waited on by waitUntil
+typedef bool (*DelayCondition_t)(void);
+
+//Sleeps in idle once, until the next interrupt
+extern void idleSleep(void);
+
+//Sleeps in idle for x milliseconds, waking on each tick
+extern void sleepForMilliseconds(uint32_t milliseconds);
+
+//Sleeps in idle until a condition is true or a timeout
+extern bool waitUntil(DelayCondition_t condition, uint32_t timeoutMilliseconds);
+
+#endif
+
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,550 @@
+/**
+ * \file mcuFormat.c
+ * \author Tim Robbins
+ * \brief Source file for integer and fixed point formatting
+ */
+#include "mcuFormat.h"
+
+#ifndef MCU_FORMAT_C_
+#define MCU_FORMAT_C_ 1
+
+#include <stdbool.h>
+
+
+///Powers of 10 for the 16 bit conversion, largest first
+static const uint16_t m_uintFormatPowers16[4] = { 10000, 1000, 100, 10 };
+
+///Powers of 10 for the 32 bit conversion, largest first
+static const uint32_t m_ulFormatPowers32[9] = { 1000000000UL, 100000000UL, 10000000UL, 1000000UL, 100000UL, 10000UL, 1000UL, 100UL, 10UL };
+
+///Hexadecimal characters, lower case
+static const char m_chrFormatHexLower[16] = { '0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f' };
+
+///Hexadecimal characters, upper case
+static const char m_chrFormatHexUpper[16] = { '0','1','2','3','4','5','6','7','8','9','A','B','C','D','E','F' };
+
+
+typedef struct _FORMAT_OUTPUT_
+{
+	FormatSink_t sink;		///The sink to send characters to, or 0 to write into the buffer
+	char* buffer;			///The buffer to write into
+	uint16_t size;			///The size of the buffer, including the terminator
+	uint16_t length;		///The amount of characters output so far
+
+}
+/**
+* \brief Struct for where the printf subset is sending its output
+*/
+FormatOutput_t;
+
+
+
+/**
+ * \brief Converts a value to decimal digits without dividing, by counting how many times each power of 10 can be subtracted. \n
+ * Values that fit in 16 bits use 16 bit math, which is the common case and much cheaper on 8 bit parts.
+ * \param digits Where to load the digits, not terminated. Needs room for 10
+ * \param value The value to convert
+ * \return The amount of digits
+ */
+static uint8_t FormatDecimalDigits(char digits[10], uint32_t value)
+{
+	//Variables
+	uint8_t length = 0; //The amount of digits so far
+	char digit = 0; //The digit being counted
+	
+	if(value > 0xFFFF)
+	{
+		for(uint8_t i = 0; i < 9; i++)
+		{
+			digit = '0';
+			
+			while(value >= m_ulFormatPowers32[i])
+			{
+				value -= m_ulFormatPowers32[i];
+				digit++;
+			}
+			
+			//Skip the leading zeros
+			if(length > 0 || digit != '0')
+			{
+				digits[length++] = digit;
+			}
+		}
+	}
+	else
+	{
+		uint16_t shortValue = (uint16_t)value; //16 bit copy of the value
+		
+		for(uint8_t i = 0; i < 4; i++)
+		{
+			digit = '0';
+			
+			while(shortValue >= m_uintFormatPowers16[i])
+			{
+				shortValue -= m_uintFormatPowers16[i];
+				digit++;
+			}
+			
+			if(length > 0 || digit != '0')
+			{
+				digits[length++] = digit;
+			}
+		}
+		
+		value = shortValue;
+	}
+	
+	//Always at least the ones digit
+	digits[length++] = (char)('0' + value);
+	
+	return length;
+}
+
+
+
+/**
+ * \brief Writes a sign and digits into the buffer, padded out to the width
+ * \param buffer The buffer, needs room for the larger of the width or the value plus the terminator
+ * \param sign The sign character, or 0 for none
+ * \param digits The digits
+ * \param length The amount of digits
+ * \param width The min width
+ * \param flags FORMAT_X flags
+ * \return The amount of characters written, not counting the terminator
+ */
+static uint8_t FormatPad(char* buffer, char sign, const char* digits, uint8_t length, uint8_t width, uint8_t flags)
+{
+	//Variables
+	uint8_t total = length + (sign != 0 ? 1 : 0); //The length of the value with its sign
+	uint8_t padding = (width > total) ? (width - total) : 0; //The amount of padding needed
+	uint8_t index = 0; //Index in the buffer
+	
+	//Spaces before the sign when right justifying
+	if((flags & (FORMAT_LEFT | FORMAT_PAD_ZERO)) == 0)
+	{
+		while(padding > 0)
+		{
+			buffer[index++] = ' ';
+			padding--;
+		}
+	}
+	
+	if(sign != 0)
+	{
+		buffer[index++] = sign;
+	}
+	
+	//Zeros after the sign
+	if((flags & FORMAT_LEFT) == 0)
+	{
+		while(padding > 0)
+		{
+			buffer[index++] = '0';
+			padding--;
+		}
+	}
+	
+	for(uint8_t i = 0; i < length; i++)
+	{
+		buffer[index++] = digits[i];
+	}
+	
+	//Spaces after when left justifying
+	while(padding > 0)
+	{
+		buffer[index++] = ' ';
+		padding--;
+	}
+	
+	buffer[index] = '\0';
+	
+	return index;
+}
+
+
+
+/**
+ * \brief Formats an unsigned value as decimal
+ * \param buffer Where to write the terminated string. FORMAT_BUFFER_SIZE, or the width plus 1 if larger
+ * \param value The value
+ * \param width The min width, padded with spaces or zeros
+ * \param flags FORMAT_PAD_ZERO, FORMAT_LEFT
+ * \return The length of the string
+ */
+uint8_t FormatUnsigned(char* buffer, uint32_t value, uint8_t width, uint8_t flags)
+{
+	//Variables
+	char digits[10]; //The digits of the value
+	uint8_t length = FormatDecimalDigits(digits, value); //The amount of digits
+	
+	return FormatPad(buffer, 0, digits, length, width, flags);
+}
+
+
+
+/**
+ * \brief Formats a signed value as decimal
+ * \param buffer Where to write the terminated string. FORMAT_BUFFER_SIZE, or the width plus 1 if larger
+ * \param value The value
+ * \param width The min width, including the sign, padded with spaces or zeros
+ * \param flags FORMAT_PAD_ZERO, FORMAT_LEFT
+ * \return The length of the string
+ */
+uint8_t FormatSigned(char* buffer, int32_t value, uint8_t width, uint8_t flags)
+{
+	//Variables
+	char digits[10]; //The digits of the value
+	uint32_t magnitude = (value < 0) ? (0UL - (uint32_t)value) : (uint32_t)value; //The value without its sign
+	uint8_t length = FormatDecimalDigits(digits, magnitude); //The amount of digits
+	
+	return FormatPad(buffer, (value < 0) ? '-' : 0, digits, length, width, flags);
+}
+
+
+
+/**
+ * \brief Formats a value as hexadecimal, without a prefix
+ * \param buffer Where to write the terminated string. FORMAT_BUFFER_SIZE, or the width plus 1 if larger
+ * \param value The value
+ * \param width The min width. Use FORMAT_PAD_ZERO for a fixed amount of digits, such as 2 for a byte
+ * \param flags FORMAT_PAD_ZERO, FORMAT_LEFT, FORMAT_UPPER
+ * \return The length of the string
+ */
+uint8_t FormatHex(char* buffer, uint32_t value, uint8_t width, uint8_t flags)
+{
+	//Variables
+	char digits[8]; //The digits of the value
+	const char* hexChars = (flags & FORMAT_UPPER) ? m_chrFormatHexUpper : m_chrFormatHexLower; //The characters to use
+	uint8_t length = 0; //The amount of digits
+	
+	//Find the highest nibble with a value, then write them out from there
+	for(int8_t shift = 28; shift >= 0; shift -= 4)
+	{
+		uint8_t nibble = (uint8_t)((value >> shift) & 0x0F);
+		
+		if(length > 0 || nibble != 0 || shift == 0)
+		{
+			digits[length++] = hexChars[nibble];
+		}
+	}
+	
+	return FormatPad(buffer, 0, digits, length, width, flags);
+}
+
+
+
+/**
+ * \brief Formats a fixed point value, being the value scaled up by 10^decimals. \n
+ * A value of 4987 with 3 decimals is "4.987". No division is done, the decimal point is just placed in the digits.
+ * \param buffer Where to write the terminated string. FORMAT_BUFFER_SIZE, or the width plus 1 if larger
+ * \param value The scaled value
+ * \param decimals The amount of decimals, up to 9
+ * \param width The min width, including the sign and decimal point
+ * \param flags FORMAT_PAD_ZERO, FORMAT_LEFT
+ * \return The length of the string
+ */
+uint8_t FormatFixed(char* buffer, int32_t value, uint8_t decimals, uint8_t width, uint8_t flags)
+{
+	//Variables
+	char digits[10]; //The digits of the value
+	char fixed[12]; //The digits with leading zeros and the decimal point
+	uint32_t magnitude = (value < 0) ? (0UL - (uint32_t)value) : (uint32_t)value; //The value without its sign
+	uint8_t length = FormatDecimalDigits(digits, magnitude); //The amount of digits
+	uint8_t index = 0; //Index in the fixed digits
+	
+	if(decimals > 9)
+	{
+		decimals = 9;
+	}
+	
+	if(decimals == 0)
+	{
+		return FormatPad(buffer, (value < 0) ? '-' : 0, digits, length, width, flags);
+	}
+	
+	//Whole part, or a 0 if the value is all decimals
+	if(length > decimals)
+	{
+		for(uint8_t i = 0; i < length - decimals; i++)
+		{
+			fixed[index++] = digits[i];
+		}
+	}
+	else
+	{
+		fixed[index++] = '0';
+	}
+	
+	fixed[index++] = '.';
+	
+	//Zeros between the point and the digits when the value is small. 5 with 3 decimals is 0.005
+	for(uint8_t i = length; i < decimals; i++)
+	{
+		fixed[index++] = '0';
+	}
+	
+	for(uint8_t i = (length > decimals) ? (length - decimals) : 0; i < length; i++)
+	{
+		fixed[index++] = digits[i];
+	}
+	
+	return FormatPad(buffer, (value < 0) ? '-' : 0, fixed, index, width, flags);
+}
+
+
+
+/**
+ * \brief Outputs a character to the sink or the buffer, keeping room for the terminator
+ * \param output The output
+ * \param c The character
+ */
+static void FormatPut(FormatOutput_t* output, char c)
+{
+	if(output->sink != 0)
+	{
+		output->sink(c);
+	}
+	else if(output->length + 1 < output->size)
+	{
+		output->buffer[output->length] = c;
+	}
+	
+	output->length++;
+}
+
+
+
+/**
+ * \brief Outputs a string to the sink or the buffer
+ * \param output The output
+ * \param s The string
+ */
+static void FormatPutString(FormatOutput_t* output, const char* s)
+{
+	while(*s != '\0')
+	{
+		FormatPut(output, *s++);
+	}
+}
+
+
+
+/**
+ * \brief The printf subset core, shared by the buffer and sink versions
+ * \param output Where to send the characters
+ * \param format The format string
+ * \param args The arguments
+ */
+static void FormatCore(FormatOutput_t* output, const char* format, va_list args)
+{
+	//Variables
+	char valueString[FORMAT_BUFFER_SIZE + 16]; //The formatted value, with room for widths up to 29
+	
+	while(*format != '\0')
+	{
+		uint8_t flags = 0; //The flags for the value
+		uint8_t width = 0; //The min width
+		uint8_t precision = 0; //The decimals for fixed point
+		bool isLong = false; //If the value is 32 bit
+		
+		if(*format != '%')
+		{
+			FormatPut(output, *format++);
+			continue;
+		}
+		
+		format++;
+		
+		//Flags
+		while(*format == '-' || *format == '0')
+		{
+			flags |= (*format == '-') ? FORMAT_LEFT : FORMAT_PAD_ZERO;
+			format++;
+		}
+		
+		//Width
+		while(*format >= '0' && *format <= '9')
+		{
+			width = (uint8_t)((width * 10) + (*format - '0'));
+			format++;
+		}
+		
+		if(width > FORMAT_BUFFER_SIZE + 15)
+		{
+			width = FORMAT_BUFFER_SIZE + 15;
+		}
+		
+		//Precision
+		if(*format == '.')
+		{
+			format++;
+			
+			while(*format >= '0' && *format <= '9')
+			{
+				precision = (uint8_t)((precision * 10) + (*format - '0'));
+				format++;
+			}
+		}
+		
+		//Length
+		if(*format == 'l')
+		{
+			isLong = true;
+			format++;
+		}
+		
+		switch(*format)
+		{
+			case 'd':
+			case 'i':
+				FormatSigned(valueString, isLong ? va_arg(args, int32_t) : (int32_t)va_arg(args, int), width, flags);
+				FormatPutString(output, valueString);
+				break;
+				
+			case 'u':
+				FormatUnsigned(valueString, isLong ? va_arg(args, uint32_t) : (uint32_t)va_arg(args, unsigned int), width, flags);
+				FormatPutString(output, valueString);
+				break;
+				
+			case 'X':
+				flags |= FORMAT_UPPER;
+				//Fall through
+			case 'x':
+				FormatHex(valueString, isLong ? va_arg(args, uint32_t) : (uint32_t)va_arg(args, unsigned int), width, flags);
+				FormatPutString(output, valueString);
+				break;
+				
+			case 'q':
+				FormatFixed(valueString, isLong ? va_arg(args, int32_t) : (int32_t)va_arg(args, int), precision, width, flags);
+				FormatPutString(output, valueString);
+				break;
+				
+			case 'c':
+				FormatPut(output, (char)va_arg(args, int));
+				break;
+				
+			case 's':
+			{
+				const char* s = va_arg(args, const char*); //The string
+				uint8_t length = 0; //The length of the string
+				
+				while(s[length] != '\0' && length < 0xFF)
+				{
+					length++;
+				}
+				
+				while((flags & FORMAT_LEFT) == 0 && width > length)
+				{
+					FormatPut(output, ' ');
+					width--;
+				}
+				
+				FormatPutString(output, s);
+				
+				while(width > length)
+				{
+					FormatPut(output, ' ');
+					width--;
+				}
+				break;
+			}
+			
+			case '%':
+				FormatPut(output, '%');
+				break;
+				
+			case '\0':
+				//Format ended in the middle of a specifier
+				return;
+				
+			default:
+				FormatPut(output, *format);
+				break;
+		};
+		
+		format++;
+	}
+}
+
+
+
+/**
+ * \brief Formats into a buffer with the printf subset, always terminating it
+ * \param buffer The buffer
+ * \param bufferSize The size of the buffer
+ * \param format The format string
+ * \param args The arguments
+ * \return The length the full string would have been. If this is bufferSize or more, the string was cut short
+ */
+uint16_t FormatStringV(char* buffer, uint16_t bufferSize, const char* format, va_list args)
+{
+	//Variables
+	FormatOutput_t output = { 0, buffer, bufferSize, 0 }; //The output to the buffer
+	
+	FormatCore(&output, format, args);
+	
+	if(bufferSize > 0)
+	{
+		buffer[(output.length < bufferSize) ? output.length : (bufferSize - 1)] = '\0';
+	}
+	
+	return output.length;
+}
+
+
+
+/**
+ * \brief Formats into a buffer with the printf subset, always terminating it
+ * \param buffer The buffer
+ * \param bufferSize The size of the buffer
+ * \param format The format string
+ * \return The length the full string would have been. If this is bufferSize or more, the string was cut short
+ */
+uint16_t FormatString(char* buffer, uint16_t bufferSize, const char* format, ...)
+{
+	//Variables
+	va_list args; //The arguments
+	uint16_t length = 0; //The formatted length
+	
+	va_start(args, format);
+	length = FormatStringV(buffer, bufferSize, format, args);
+	va_end(args);
+	
+	return length;
+}
+
+
+
+/**
+ * \brief Formats straight into a sink with the printf subset, without needing a buffer for the whole string
+ * \param sink The function to send each character to
+ * \param format The format string
+ * \param args The arguments
+ */
+void FormatPrintV(FormatSink_t sink, const char* format, va_list args)
+{
+	//Variables
+	FormatOutput_t output = { sink, 0, 0, 0 }; //The output to the sink
+	
+	FormatCore(&output, format, args);
+}
+
+
+
+/**
+ * \brief Formats straight into a sink with the printf subset, without needing a buffer for the whole string
+ * \param sink The function to send each character to, such as LcdPrintChar or SSD1306PutChar
+ * \param format The format string
+ */
+void FormatPrint(FormatSink_t sink, const char* format, ...)
+{
+	//Variables
+	va_list args; //The arguments
+	
+	va_start(args, format);
+	FormatPrintV(sink, format, args);
+	va_end(args);
+}
+
+
+#endif
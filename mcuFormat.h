@@ -0,0 +1,61 @@
+/**
+ * \file mcuFormat.h
+ * \author Tim Robbins
+ * \brief Header file for integer and fixed point formatting shared by the displays and serial. \n
+ * Decimal conversion is done by subtracting powers of 10 instead of dividing, which is a lot cheaper on parts without a divider. \n
+ * Everything writes into a caller buffer, or with FormatPrint, straight into a sink function such as LcdPrintChar or SSD1306PutChar. \n
+ *
+ * Printf subset supported by FormatString and FormatPrint: \n
+ * %d %i %u %x %X %c %s %% \n
+ * Flags '-' for left justify and '0' for zero padding, then a width. An 'l' before the type for 32 bit values. \n
+ * %q for fixed point, with the precision as the amount of decimals. "%.2q" of 1234 is "12.34". \n
+ *
+ * Example use: \n
+ *
+ * char strBuffer[FORMAT_BUFFER_SIZE]; \n
+ * FormatUnsigned(strBuffer, adcValue, 4, FORMAT_PAD_ZERO); \n
+ * FormatPrint(LcdPrintChar, "%3u%% %.3qV", percentage, millivolts); \n
+ */
+#ifndef MCU_FORMAT_H_
+#define MCU_FORMAT_H_ 1
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdarg.h>
+
+
+///The buffer size that fits any single formatted value, being a sign, 10 digits, a decimal point and the terminator
+#define FORMAT_BUFFER_SIZE			14
+
+///Flag for padding with zeros instead of spaces. Zeros go after the sign
+#define FORMAT_PAD_ZERO				0x01
+
+///Flag for left justifying, padding with spaces after the value
+#define FORMAT_LEFT					0x02
+
+///Flag for upper case hexadecimal
+#define FORMAT_UPPER				0x04
+
+
+///Function pointer type for a function that takes formatted characters one at a time
+typedef void (*FormatSink_t)(char c);
+
+
+extern uint8_t FormatUnsigned(char* buffer, uint32_t value, uint8_t width, uint8_t flags);
+extern uint8_t FormatSigned(char* buffer, int32_t value, uint8_t width, uint8_t flags);
+extern uint8_t FormatHex(char* buffer, uint32_t value, uint8_t width, uint8_t flags);
+extern uint8_t FormatFixed(char* buffer, int32_t value, uint8_t decimals, uint8_t width, uint8_t flags);
+extern uint16_t FormatString(char* buffer, uint16_t bufferSize, const char* format, ...);
+extern uint16_t FormatStringV(char* buffer, uint16_t bufferSize, const char* format, va_list args);
+extern void FormatPrint(FormatSink_t sink, const char* format, ...);
+extern void FormatPrintV(FormatSink_t sink, const char* format, va_list args);
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif /* MCU_FORMAT_H_ */
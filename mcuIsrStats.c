@@ -0,0 +1,223 @@
+/**
+ * \file mcuIsrStats.c
+ * \author Tim Robbins
+ * \brief Source file for the optional interrupt duration and critical section instrumentation
+ */
+#include "mcuIsrStats.h"
+
+#if !defined(MCU_ISR_STATS_C_) && defined(__AVR) && MCU_USE_ISR_STATS == 1
+#define MCU_ISR_STATS_C_ 1
+
+#include "mcuUtils.h"
+
+
+///The stats for each id
+static IsrStats_t m_isrStats[ISR_STATS_MAX_VECTORS];
+
+
+
+/**
+ * \brief Clears the stats and starts the time source
+ */
+void IsrStatsInit(void)
+{
+	//Variables
+	uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+	
+	interruptsOff();
+	MCU_TIMEBASE_INIT();
+	SREG = sreg;
+	
+	IsrStatsReset();
+}
+
+
+
+/**
+ * \brief Records one duration. Called by the macros with interrupts off, either from an ISR or the end of a critical section
+ * \param id The id to record under
+ * \param ticks The duration in ticks of the time source
+ */
+void IsrStatsRecord(uint8_t id, uint16_t ticks)
+{
+	//Variables
+	IsrStats_t* stats = 0; //The stats being updated
+	uint16_t binLimit = ISR_STATS_HISTOGRAM_FIRST; //The upper limit of the bin being checked
+	uint8_t bin = 0; //The histogram bin for the duration
+	
+	if(id >= ISR_STATS_MAX_VECTORS)
+	{
+		return;
+	}
+	
+	stats = &m_isrStats[id];
+	
+	if(stats->count == 0xFFFF)
+	{
+		//Saturated, so leave the average and histogram as they were and only keep the extremes going
+		if(ticks > stats->max)
+		{
+			stats->max = ticks;
+		}
+		
+		return;
+	}
+	
+	if(stats->count == 0 || ticks < stats->min)
+	{
+		stats->min = ticks;
+	}
+	
+	if(ticks > stats->max)
+	{
+		stats->max = ticks;
+	}
+	
+	stats->count++;
+	stats->total += ticks;
+	
+	//Find the bin by doubling the limit instead of dividing
+	while(bin < (ISR_STATS_HISTOGRAM_BINS - 1) && ticks >= binLimit)
+	{
+		binLimit <<= 1;
+		bin++;
+		
+		//Past the 16 bit range, so everything left goes here
+		if(binLimit == 0)
+		{
+			break;
+		}
+	}
+	
+	stats->histogram[bin]++;
+}
+
+
+
+/**
+ * \brief Clears the stats for all the ids
+ */
+void IsrStatsReset(void)
+{
+	//Variables
+	uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+	uint8_t* bytes = (uint8_t*)m_isrStats; //The stats as bytes, for clearing
+	uint16_t i = 0; //Loop index
+	
+	interruptsOff();
+	
+	for(i = 0; i < sizeof(m_isrStats); i++)
+	{
+		bytes[i] = 0;
+	}
+	
+	SREG = sreg;
+}
+
+
+
+/**
+ * \brief Copies the stats for an id, with interrupts off so an ISR can't change them part way through
+ * \param id The id to get
+ * \param stats Where to copy them
+ * \return True if the id is valid and has samples
+ */
+bool IsrStatsGet(uint8_t id, IsrStats_t* stats)
+{
+	//Variables
+	uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+	
+	if(id >= ISR_STATS_MAX_VECTORS)
+	{
+		return false;
+	}
+	
+	interruptsOff();
+	*stats = m_isrStats[id];
+	SREG = sreg;
+	
+	return (stats->count != 0);
+}
+
+
+
+/**
+ * \brief Packs the stats for an id into a CAN payload. Little endian count, min, max and average, each 16 bits
+ * \param id The id to pack
+ * \param data The 8 byte payload to fill
+ * \return The payload length, being 8, or 0 if the id has no samples
+ */
+uint8_t IsrStatsPack(uint8_t id, uint8_t data[8])
+{
+	//Variables
+	IsrStats_t stats; //Copy of the stats
+	uint16_t average = 0; //The average duration
+	
+	if(IsrStatsGet(id, &stats) == false)
+	{
+		return 0;
+	}
+	
+	average = (uint16_t)(stats.total / stats.count);
+	
+	data[0] = (uint8_t)(stats.count);
+	data[1] = (uint8_t)(stats.count >> 8);
+	data[2] = (uint8_t)(stats.min);
+	data[3] = (uint8_t)(stats.min >> 8);
+	data[4] = (uint8_t)(stats.max);
+	data[5] = (uint8_t)(stats.max >> 8);
+	data[6] = (uint8_t)(average);
+	data[7] = (uint8_t)(average >> 8);
+	
+	return 8;
+}
+
+
+
+/**
+ * \brief Prints a line for each id with samples, then the worst case blocking, through a sink such as a serial put char. \n
+ * Each line is the id, count, min, max, average and the histogram bins, all in ticks
+ * \param sink The function to print through
+ */
+void IsrStatsReport(FormatSink_t sink)
+{
+	//Variables
+	IsrStats_t stats; //Copy of the stats being printed
+	uint16_t worstIsr = 0; //The longest ISR of all
+	uint16_t worstCritical = 0; //The longest critical section
+	uint8_t id = 0; //Loop index
+	uint8_t bin = 0; //Loop index
+	
+	FormatPrint(sink, "id count min max avg hist\r\n");
+	
+	for(id = 0; id < ISR_STATS_MAX_VECTORS; id++)
+	{
+		if(IsrStatsGet(id, &stats) == false)
+		{
+			continue;
+		}
+		
+		if(id == ISR_STATS_ID_CRITICAL)
+		{
+			worstCritical = stats.max;
+		}
+		else if(stats.max > worstIsr)
+		{
+			worstIsr = stats.max;
+		}
+		
+		FormatPrint(sink, "%2u %5u %5u %5u %5lu", id, stats.count, stats.min, stats.max, stats.total / stats.count);
+		
+		for(bin = 0; bin < ISR_STATS_HISTOGRAM_BINS; bin++)
+		{
+			FormatPrint(sink, " %u", stats.histogram[bin]);
+		}
+		
+		FormatPrint(sink, "\r\n");
+	}
+	
+	FormatPrint(sink, "blocking max %lu\r\n", (uint32_t)worstIsr + worstCritical);
+}
+
+
+#endif
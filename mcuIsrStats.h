@@ -0,0 +1,162 @@
+/**
+ * \file mcuIsrStats.h
+ * \author Tim Robbins
+ * \brief Header file for optional interrupt duration and critical section instrumentation. \n
+ * Each instrumented ISR time stamps its entry and exit with a free running timer and keeps the count, min, max, total and a \n
+ * histogram of its durations. Critical sections are tracked the same way under ISR_STATS_ID_CRITICAL. \n
+ * The worst latency any interrupt can see is about the longest critical section plus the longest of the other ISRs, \n
+ * so when one ISR is starving the others, it shows up as the max of another id. \n
+ * With MCU_USE_ISR_STATS at 0 the macros are empty and nothing is compiled in. \n
+ * Durations are in ticks of the time source shared with mcuTrace in mcuTimebase.h, by default Timer 1 at the CPU clock, so ticks are cycles. \n
+ * Code that can run both in the main code and from an ISR, such as SchedulerPost, ends its critical section with \n
+ * ISR_STATS_CRITICAL_END_SREG, so the time is only counted when interrupts were on before it, and not added to the ISR's own. \n
+ *
+ * Example use: \n
+ *
+ * #define ISR_STATS_ID_MY_TIMER	ISR_STATS_ID_USER \n
+ *
+ * IsrStatsInit(); \n
+ * ... \n
+ * ISR(TIMER2_COMPA_vect) { ISR_STATS_ENTER(ISR_STATS_ID_MY_TIMER); ... ISR_STATS_EXIT(ISR_STATS_ID_MY_TIMER); } \n
+ * ... \n
+ * interruptsOff(); ISR_STATS_CRITICAL_BEGIN(); ... ISR_STATS_CRITICAL_END(); SREG = sreg; \n
+ * ... \n
+ * IsrStatsReport(USART0_write_byte); \n
+ */
+#ifndef MCU_ISR_STATS_H_
+#define MCU_ISR_STATS_H_ 1
+
+#include "config.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+
+#ifndef MCU_USE_ISR_STATS
+///If ISR instrumentation is compiled in. 0 makes all the macros empty
+#define MCU_USE_ISR_STATS					0
+#endif
+
+
+#ifdef __AVR
+
+#include <avr/io.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "mcuFormat.h"
+#include "mcuTimebase.h"
+
+
+///Id for critical sections, meaning time with interrupts turned off in the main code
+#define ISR_STATS_ID_CRITICAL				0
+
+///Id for the system tick in avrTimers.c
+#define ISR_STATS_ID_SYSTEM_TICK			1
+
+///Id for the ADC scan in mcuAdc.c
+#define ISR_STATS_ID_ADC					2
+
+///Id for the keypad pin change in ckeypadMatrix.c
+#define ISR_STATS_ID_KEYPAD					3
+
+///Id for the CAN general interrupt in avr_can.cpp
+#define ISR_STATS_ID_CAN					4
+
+///Id for the CAN timer overflow in avr_can.cpp
+#define ISR_STATS_ID_CAN_TIMER				5
+
+///Id for the USART0 receive in avrSerial.c
+#define ISR_STATS_ID_USART0_RX				6
+
+///Id for the USART1 receive in avrSerial.c
+#define ISR_STATS_ID_USART1_RX				7
+
+///The first id free for the application's own ISRs
+#define ISR_STATS_ID_USER					8
+
+
+#ifndef ISR_STATS_MAX_VECTORS
+///The amount of ids kept, including the library's
+#define ISR_STATS_MAX_VECTORS				10
+#endif
+
+#ifndef ISR_STATS_HISTOGRAM_BINS
+///The amount of histogram bins. Bin 0 is under ISR_STATS_HISTOGRAM_FIRST ticks, each next bin is double the last, and the last holds everything above
+#define ISR_STATS_HISTOGRAM_BINS			8
+#endif
+
+#ifndef ISR_STATS_HISTOGRAM_FIRST
+///The upper limit of histogram bin 0 in ticks. Must be a power of 2
+#define ISR_STATS_HISTOGRAM_FIRST			16
+#endif
+
+///Reads the free running time source. Must only be read with interrupts off
+#define ISR_STATS_NOW()						MCU_TIMEBASE_NOW()
+
+#if ISR_STATS_MAX_VECTORS <= ISR_STATS_ID_USART1_RX
+#error mcuIsrStats.h: ISR_STATS_MAX_VECTORS must leave room for the library ids
+#endif
+
+#if (ISR_STATS_HISTOGRAM_FIRST & (ISR_STATS_HISTOGRAM_FIRST - 1)) != 0
+#error mcuIsrStats.h: ISR_STATS_HISTOGRAM_FIRST must be a power of 2
+#endif
+
+
+typedef struct _ISR_STATS_
+{
+	uint16_t count;								///The amount of samples, saturating at 0xFFFF
+	uint16_t min;								///The shortest duration in ticks
+	uint16_t max;								///The longest duration in ticks
+	uint32_t total;								///The sum of the durations, for the average
+	uint16_t histogram[ISR_STATS_HISTOGRAM_BINS];	///The amount of samples in each bin, saturating at 0xFFFF
+
+}
+/**
+* \brief Struct for the durations recorded for one ISR or for the critical sections
+*/
+IsrStats_t;
+
+
+#if MCU_USE_ISR_STATS == 1
+
+///Stamps the entry of an ISR. Must be the first statement of the ISR body, and every return must be preceded by ISR_STATS_EXIT
+#define ISR_STATS_ENTER(id)					uint16_t _isrStatsStart_ = ISR_STATS_NOW()
+
+///Records the duration of an ISR since its ISR_STATS_ENTER
+#define ISR_STATS_EXIT(id)					IsrStatsRecord((id), (uint16_t)(ISR_STATS_NOW() - _isrStatsStart_))
+
+///Stamps the start of a critical section. Goes right after interrupts are turned off
+#define ISR_STATS_CRITICAL_BEGIN()			uint16_t _isrStatsCritical_ = ISR_STATS_NOW()
+
+///Records the length of a critical section. Goes right before interrupts are restored
+#define ISR_STATS_CRITICAL_END()			IsrStatsRecord(ISR_STATS_ID_CRITICAL, (uint16_t)(ISR_STATS_NOW() - _isrStatsCritical_))
+
+///Records the length of a critical section only if interrupts were on in the saved status register, for code that may run in an ISR
+#define ISR_STATS_CRITICAL_END_SREG(sreg)	do { if((sreg) & (1 << SREG_I)) { ISR_STATS_CRITICAL_END(); } } while(0)
+
+extern void IsrStatsInit(void);
+extern void IsrStatsRecord(uint8_t id, uint16_t ticks);
+extern void IsrStatsReset(void);
+extern bool IsrStatsGet(uint8_t id, IsrStats_t* stats);
+extern uint8_t IsrStatsPack(uint8_t id, uint8_t data[8]);
+extern void IsrStatsReport(FormatSink_t sink);
+
+#else
+
+#define ISR_STATS_ENTER(id)
+#define ISR_STATS_EXIT(id)
+#define ISR_STATS_CRITICAL_BEGIN()
+#define ISR_STATS_CRITICAL_END()
+#define ISR_STATS_CRITICAL_END_SREG(sreg)
+
+#endif
+
+#endif
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif /* MCU_ISR_STATS_H_ */
@@ -877,7 +877,7 @@
 #define __PIN_UTIL_TOKENIZE_REG_NAME(reg, t)	_TOKENIZE(reg, t)
 
 ///Helper for tokenizing 
-#define __PIN_UTIL_TOKENIZE_INT_NAME(inttype, n) __PIN_UTIL_TOKENIZE_REG_NAME(_TOKENIZE(inttype, n), __PIN_UTIL_INT_VECT_POSTFIX)
+#define __PIN_UTIL_TOKENIZE_INT_NAME(inttype, n) __PIN_UTIL_TOKENIZE_REG_NAME(inttype, __PIN_UTIL_TOKENIZE_REG_NAME(n, __PIN_UTIL_INT_VECT_POSTFIX))
 
 ///Helper for getting the pin change interrupt related to the pin change interrupt passed
 #define _GET_PCINT_VECT(n)   __PIN_UTIL_TOKENIZE_INT_NAME(__PIN_UTIL_PIN_CHANGE_INT_PREFIX, n)
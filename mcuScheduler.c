@@ -0,0 +1,268 @@
+/**
+ * \file mcuScheduler.c
+ * \author Tim Robbins
+ * \brief Source file for the run to completion priority task scheduler
+ */
+#include "mcuScheduler.h"
+
+#if !defined(MCU_SCHEDULER_C_) && defined(__AVR)
+#define MCU_SCHEDULER_C_ 1
+
+#include "avrTimers.h"
+#include "mcuUtils.h"
+#include "mcuIsrStats.h"
+
+
+typedef struct _SCHEDULER_TASK_
+{
+	SchedulerHandler_t handler;									///The handler for the task, 0 if the priority isn't used
+	volatile SchedulerEvent_t queue[MCU_SCHEDULER_QUEUE_SIZE];	///The events waiting
+	volatile uint8_t head;										///The write index of the queue
+	volatile uint8_t tail;										///The read index of the queue
+	volatile uint8_t dropped;									///The amount of events dropped for a full queue, saturating at 255
+	uint8_t deadlineMisses;										///The amount of events dispatched later than the deadline, saturating at 255
+	uint16_t deadlineMs;										///The max milliseconds from post to dispatch, 0 for none
+
+}
+/**
+* \brief Struct for a scheduler task and its event queue
+*/
+SchedulerTask_t;
+
+
+///The tasks, indexed by priority
+static SchedulerTask_t m_schedulerTasks[MCU_SCHEDULER_MAX_TASKS];
+
+///Bitmap of the tasks with events waiting, bit 0 being the highest priority
+static volatile uint8_t m_uchrSchedulerReady = 0;
+
+
+
+/**
+ * \brief Gets the time stamp for posting events
+ * \return The low 16 bits of the milliseconds, or 0 without the system tick
+ */
+static inline uint16_t SchedulerNow(void)
+{
+	#if AVR_TIMERS_USE_SYSTEM_TICK == 1
+	return (uint16_t)SystemMillis();
+	#else
+	return 0;
+	#endif
+}
+
+
+
+/**
+ * \brief Clears all the tasks
+ */
+void SchedulerInit(void)
+{
+	//Variables
+	uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+	
+	interruptsOff();
+	
+	for(uint8_t i = 0; i < MCU_SCHEDULER_MAX_TASKS; i++)
+	{
+		m_schedulerTasks[i].handler = 0;
+		m_schedulerTasks[i].head = 0;
+		m_schedulerTasks[i].tail = 0;
+		m_schedulerTasks[i].dropped = 0;
+		m_schedulerTasks[i].deadlineMisses = 0;
+		m_schedulerTasks[i].deadlineMs = 0;
+	}
+	
+	m_uchrSchedulerReady = 0;
+	SREG = sreg;
+}
+
+
+
+/**
+ * \brief Adds a task at a priority
+ * \param priority The priority of the task, 0 being the highest. Each priority has one task
+ * \param handler The function to call for each event posted to the task
+ * \param deadlineMs The max milliseconds an event should wait before being dispatched, 0 for none. Needs the system tick
+ * \return True if added, false if the priority is out of range or taken
+ */
+bool SchedulerAddTask(uint8_t priority, SchedulerHandler_t handler, uint16_t deadlineMs)
+{
+	if(priority >= MCU_SCHEDULER_MAX_TASKS || m_schedulerTasks[priority].handler != 0 || handler == 0)
+	{
+		return false;
+	}
+	
+	m_schedulerTasks[priority].deadlineMs = deadlineMs;
+	m_schedulerTasks[priority].handler = handler;
+	
+	return true;
+}
+
+
+
+/**
+ * \brief Posts an event to a task. Safe to call from interrupts and from handlers
+ * \param priority The priority of the task to post to
+ * \param signal What happened
+ * \param param Data for the event
+ * \return True if queued, false if the queue was full or there is no task at the priority
+ */
+bool SchedulerPost(uint8_t priority, uint8_t signal, uint16_t param)
+{
+	//Variables
+	uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+	SchedulerTask_t* task = 0; //The task being posted to
+	uint8_t nextHead = 0; //Where the head will be after this write
+	bool posted = false; //If the event was queued
+	
+	if(priority >= MCU_SCHEDULER_MAX_TASKS || m_schedulerTasks[priority].handler == 0)
+	{
+		return false;
+	}
+	
+	task = &m_schedulerTasks[priority];
+	
+	interruptsOff();
+	ISR_STATS_CRITICAL_BEGIN();
+	
+	nextHead = (task->head + 1) & (MCU_SCHEDULER_QUEUE_SIZE - 1);
+	
+	if(nextHead != task->tail)
+	{
+		task->queue[task->head].signal = signal;
+		task->queue[task->head].param = param;
+		task->queue[task->head].postedAt = SchedulerNow();
+		task->head = nextHead;
+		m_uchrSchedulerReady |= (1 << priority);
+		posted = true;
+	}
+	else if(task->dropped < 0xFF)
+	{
+		task->dropped++;
+	}
+	
+	ISR_STATS_CRITICAL_END_SREG(sreg);
+	SREG = sreg;
+	
+	return posted;
+}
+
+
+
+/**
+ * \brief Runs the handler for the oldest event of the highest priority task with events waiting
+ * \return True if an event was dispatched, false if there was nothing to do
+ */
+bool SchedulerDispatch(void)
+{
+	//Variables
+	uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+	uint8_t ready = m_uchrSchedulerReady; //The tasks with events waiting
+	uint8_t priority = 0; //The priority of the task being dispatched
+	SchedulerTask_t* task = 0; //The task being dispatched
+	SchedulerEvent_t event; //Copy of the event, so the slot can be reused while the handler runs
+	
+	if(ready == 0)
+	{
+		return false;
+	}
+	
+	//Find the highest priority, being the lowest set bit
+	while((ready & 0x01) == 0)
+	{
+		ready >>= 1;
+		priority++;
+	}
+	
+	task = &m_schedulerTasks[priority];
+	
+	event.signal = task->queue[task->tail].signal;
+	event.param = task->queue[task->tail].param;
+	event.postedAt = task->queue[task->tail].postedAt;
+	
+	//Pop the event, clearing the ready bit if it was the last
+	interruptsOff();
+	ISR_STATS_CRITICAL_BEGIN();
+	task->tail = (task->tail + 1) & (MCU_SCHEDULER_QUEUE_SIZE - 1);
+	
+	if(task->tail == task->head)
+	{
+		m_uchrSchedulerReady &= ~(1 << priority);
+	}
+	
+	ISR_STATS_CRITICAL_END_SREG(sreg);
+	SREG = sreg;
+	
+	if(task->deadlineMs != 0 && (uint16_t)(SchedulerNow() - event.postedAt) > task->deadlineMs && task->deadlineMisses < 0xFF)
+	{
+		task->deadlineMisses++;
+	}
+	
+	task->handler(&event);
+	
+	return true;
+}
+
+
+
+/**
+ * \brief Runs the scheduler forever, calling MCU_SCHEDULER_IDLE_HOOK with interrupts off when there is nothing to do. Interrupts are turned on
+ */
+void SchedulerRun(void)
+{
+	interruptsOn();
+	
+	forever
+	{
+		//Check for work with interrupts off so an event posted right after the check isn't slept through.
+		//The hook turns them back on right before sleeping, so the interrupt posting the next event wakes it
+		interruptsOff();
+		
+		if(m_uchrSchedulerReady == 0)
+		{
+			MCU_SCHEDULER_IDLE_HOOK();
+		}
+		
+		interruptsOn();
+		
+		while(SchedulerDispatch());
+	}
+}
+
+
+
+/**
+ * \brief Gets the amount of events dispatched later than the task's deadline
+ * \param priority The priority of the task
+ * \return The amount of misses, saturating at 255
+ */
+uint8_t SchedulerDeadlineMisses(uint8_t priority)
+{
+	if(priority >= MCU_SCHEDULER_MAX_TASKS)
+	{
+		return 0;
+	}
+	
+	return m_schedulerTasks[priority].deadlineMisses;
+}
+
+
+
+/**
+ * \brief Gets the amount of events dropped because the task's queue was full
+ * \param priority The priority of the task
+ * \return The amount dropped, saturating at 255
+ */
+uint8_t SchedulerDropped(uint8_t priority)
+{
+	if(priority >= MCU_SCHEDULER_MAX_TASKS)
+	{
+		return 0;
+	}
+	
+	return m_schedulerTasks[priority].dropped;
+}
+
+
+#endif
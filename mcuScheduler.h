@@ -0,0 +1,96 @@
+/**
+ * \file mcuScheduler.h
+ * \author Tim Robbins
+ * \brief Header file for a run to completion priority task scheduler for the main loop. \n
+ * Interrupts post events to a task's queue and the scheduler runs the handler of the highest priority task with an event waiting. \n
+ * Each handler runs to completion, so a slow low priority task only delays urgent work by the length of one of its events. \n
+ * If AVR_TIMERS_USE_SYSTEM_TICK is 1, the time from post to dispatch is checked against each task's deadline and misses are counted. \n
+ *
+ * Example use: \n
+ *
+ * #define TASK_CAN		0 \n
+ * #define TASK_DISPLAY	3 \n
+ *
+ * SchedulerAddTask(TASK_CAN, CanTaskHandler, 2); \n
+ * SchedulerAddTask(TASK_DISPLAY, DisplayTaskHandler, 0); \n
+ * ... \n
+ * ISR(CAN_INT_vect) { SchedulerPost(TASK_CAN, CAN_EVENT_RX, mobIndex); } \n
+ * ... \n
+ * SchedulerRun(); \n
+ */
+#ifndef MCU_SCHEDULER_H_
+#define MCU_SCHEDULER_H_ 1
+
+#include "config.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+
+#ifdef __AVR
+
+#include <avr/io.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+
+#ifndef MCU_SCHEDULER_MAX_TASKS
+///The amount of tasks, which is also the amount of priorities. 0 is the highest. Up to 8
+#define MCU_SCHEDULER_MAX_TASKS				8
+#endif
+
+#ifndef MCU_SCHEDULER_QUEUE_SIZE
+///The amount of events each task can have waiting. Must be a power of 2
+#define MCU_SCHEDULER_QUEUE_SIZE			4
+#endif
+
+#ifndef MCU_SCHEDULER_IDLE_HOOK
+///Optional function like macro SchedulerRun calls when there is nothing to do, such as going to sleep until the next interrupt. \n
+///It's called with interrupts off and must turn them back on itself, right before sleep_cpu() as in sei(); sleep_cpu();, \n
+///so an event posted after the check still wakes it. mcuDelays' idleSleep does this, with MCU_DELAYS_USE_SYSTEM_TICK as 1
+#define MCU_SCHEDULER_IDLE_HOOK()
+#endif
+
+#if MCU_SCHEDULER_MAX_TASKS > 8
+#error mcuScheduler.h: MCU_SCHEDULER_MAX_TASKS must be 8 or less
+#endif
+
+#if (MCU_SCHEDULER_QUEUE_SIZE & (MCU_SCHEDULER_QUEUE_SIZE - 1)) != 0
+#error mcuScheduler.h: MCU_SCHEDULER_QUEUE_SIZE must be a power of 2
+#endif
+
+
+typedef struct _SCHEDULER_EVENT_
+{
+	uint8_t signal;			///What happened, defined by the application
+	uint16_t param;			///Data for the event, such as a MOb index or received byte
+	uint16_t postedAt;		///The low 16 bits of the millisecond the event was posted, for deadline checks
+
+}
+/**
+* \brief Struct for an event posted to a task
+*/
+SchedulerEvent_t;
+
+
+///Function pointer type for task handlers. Each call handles one event and must return without blocking
+typedef void (*SchedulerHandler_t)(const SchedulerEvent_t* event);
+
+
+extern void SchedulerInit(void);
+extern bool SchedulerAddTask(uint8_t priority, SchedulerHandler_t handler, uint16_t deadlineMs);
+extern bool SchedulerPost(uint8_t priority, uint8_t signal, uint16_t param);
+extern bool SchedulerDispatch(void);
+extern void SchedulerRun(void);
+extern uint8_t SchedulerDeadlineMisses(uint8_t priority);
+extern uint8_t SchedulerDropped(uint8_t priority);
+
+#endif
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif /* MCU_SCHEDULER_H_ */
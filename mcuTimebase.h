@@ -0,0 +1,57 @@
+/**
+ * \file mcuTimebase.h
+ * \author Tim Robbins
+ * \brief Header file for the free running timer shared as a time source by mcuIsrStats and mcuTrace. \n
+ * Both read the same 16 bit counter, so they have to agree on its clock, which is set once here with MCU_TIMEBASE_CS. \n
+ * The default is Timer 1 at the CPU clock, so ticks are cycles. At 12MHz it wraps every 5.4ms, so with mcuTrace call TraceSync \n
+ * at least that often, or set MCU_TIMEBASE_CS as (1 << CS11) for ticks of 8 cycles. \n
+ * Anything else that reprograms Timer 1 can't be used with them, such as modbusRtu with MODBUS_TIMER as 1, which is an error. \n
+ * On parts with more 16 bit timers, MCU_TIMEBASE_NOW and MCU_TIMEBASE_INIT can be defined to use another one. \n
+ */
+#ifndef MCU_TIMEBASE_H_
+#define MCU_TIMEBASE_H_ 1
+
+#include "config.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+
+#ifdef __AVR
+
+#include <avr/io.h>
+#include <stdint.h>
+
+
+#ifndef MCU_TIMEBASE_CS
+///The clock select bits of Timer 1 as the time source. (1 << CS10) counts cycles, (1 << CS11) counts 8 cycles
+#define MCU_TIMEBASE_CS						(1 << CS10)
+#endif
+
+#ifndef MCU_TIMEBASE_NOW
+///Reads the time source. Must only be read with interrupts off, since the 16 bit read shares the timer's temp register
+#define MCU_TIMEBASE_NOW()					((uint16_t)TCNT1)
+#endif
+
+#ifndef MCU_TIMEBASE_INIT
+///Starts the time source. Timer 1 in normal mode at MCU_TIMEBASE_CS. Harmless to run again with the same settings
+#define MCU_TIMEBASE_INIT()					TCCR1A = 0; TCCR1B = MCU_TIMEBASE_CS
+#endif
+
+#if MCU_TIMEBASE_CS == 0
+#error mcuTimebase.h: MCU_TIMEBASE_CS of 0 leaves the timer stopped
+#endif
+
+#if defined(ISR_STATS_TIMER_INIT) || defined(TRACE_TIMER_INIT)
+#error mcuTimebase.h: mcuIsrStats and mcuTrace share the time source now, set MCU_TIMEBASE_CS or MCU_TIMEBASE_INIT instead
+#endif
+
+#endif
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif /* MCU_TIMEBASE_H_ */
@@ -0,0 +1,247 @@
+/**
+ * \file mcuTrace.c
+ * \author Tim Robbins
+ * \brief Source file for the binary event trace
+ */
+#include "mcuTrace.h"
+
+#if !defined(MCU_TRACE_C_) && defined(__AVR) && MCU_USE_TRACE == 1
+#define MCU_TRACE_C_ 1
+
+#include "mcuUtils.h"
+
+
+///The ring of records
+static TraceRecord_t m_traceBuffer[TRACE_BUFFER_RECORDS];
+
+///The write index of the ring
+static volatile uint8_t m_uchrTraceHead = 0;
+
+///The read index of the ring
+static volatile uint8_t m_uchrTraceTail = 0;
+
+///The sequence number for the next event
+static volatile uint8_t m_uchrTraceSeq = 0;
+
+///The amount of events dropped for a full ring, saturating at 255
+static volatile uint8_t m_uchrTraceDropped = 0;
+
+#if defined(TRACE_SERIAL_WRITE)
+
+///The serial packet being sent
+static uint8_t m_uchrTracePacket[TRACE_SERIAL_PACKET_SIZE];
+
+///The index of the next packet byte to send, TRACE_SERIAL_PACKET_SIZE when there is no packet in progress
+static uint8_t m_uchrTracePacketIndex = TRACE_SERIAL_PACKET_SIZE;
+
+#endif
+
+
+
+/**
+ * \brief Clears the ring and starts the time source
+ */
+void TraceInit(void)
+{
+	//Variables
+	uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+	
+	interruptsOff();
+	MCU_TIMEBASE_INIT();
+	SREG = sreg;
+	
+	TraceClear();
+}
+
+
+
+/**
+ * \brief Writes a record. Safe to call from ISRs. If the ring is full the event is dropped, leaving a gap in the sequence numbers
+ * \param id What happened
+ * \param a First argument
+ * \param b Second argument
+ */
+void TraceEvent(uint8_t id, uint16_t a, uint16_t b)
+{
+	//Variables
+	uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+	uint8_t head = 0; //The write index
+	uint8_t nextHead = 0; //Where the head will be after this write
+	TraceRecord_t* record = 0; //The record being written
+	
+	interruptsOff();
+	
+	head = m_uchrTraceHead;
+	nextHead = (head + 1) & (TRACE_BUFFER_RECORDS - 1);
+	
+	if(nextHead != m_uchrTraceTail)
+	{
+		record = &m_traceBuffer[head];
+		record->time = TRACE_NOW();
+		record->id = id;
+		record->seq = m_uchrTraceSeq;
+		record->a = a;
+		record->b = b;
+		m_uchrTraceHead = nextHead;
+	}
+	else if(m_uchrTraceDropped < 0xFF)
+	{
+		m_uchrTraceDropped++;
+	}
+	
+	m_uchrTraceSeq++;
+	
+	SREG = sreg;
+}
+
+
+
+/**
+ * \brief Writes a sync record pairing the time source with an absolute time, for the decoder to unwrap the time stamps against
+ * \param millis The milliseconds, such as from SystemMillis
+ */
+void TraceSync(uint32_t millis)
+{
+	TraceEvent(TRACE_ID_SYNC, (uint16_t)millis, (uint16_t)(millis >> 16));
+}
+
+
+
+/**
+ * \brief Copies the oldest record without removing it, so a transport that fails to send it can try again
+ * \param record Where to copy it
+ * \return True if there was a record
+ */
+bool TracePeek(TraceRecord_t* record)
+{
+	//Variables
+	uint8_t tail = m_uchrTraceTail; //The read index, only changed by the reader
+	
+	if(tail == m_uchrTraceHead)
+	{
+		return false;
+	}
+	
+	*record = m_traceBuffer[tail];
+	
+	return true;
+}
+
+
+
+/**
+ * \brief Removes the oldest record, after it has been sent
+ */
+void TraceRelease(void)
+{
+	if(m_uchrTraceTail != m_uchrTraceHead)
+	{
+		m_uchrTraceTail = (m_uchrTraceTail + 1) & (TRACE_BUFFER_RECORDS - 1);
+	}
+}
+
+
+
+/**
+ * \brief Packs a record into its 8 byte little endian wire layout
+ * \param record The record
+ * \param data The bytes to fill
+ */
+void TracePack(const TraceRecord_t* record, uint8_t data[8])
+{
+	data[0] = (uint8_t)(record->time);
+	data[1] = (uint8_t)(record->time >> 8);
+	data[2] = record->id;
+	data[3] = record->seq;
+	data[4] = (uint8_t)(record->a);
+	data[5] = (uint8_t)(record->a >> 8);
+	data[6] = (uint8_t)(record->b);
+	data[7] = (uint8_t)(record->b >> 8);
+}
+
+
+
+/**
+ * \brief Gets the amount of records waiting to be sent
+ * \return The amount of records
+ */
+uint8_t TracePending(void)
+{
+	return (m_uchrTraceHead - m_uchrTraceTail) & (TRACE_BUFFER_RECORDS - 1);
+}
+
+
+
+/**
+ * \brief Gets the amount of events dropped for a full ring
+ * \return The amount, saturating at 255
+ */
+uint8_t TraceDropped(void)
+{
+	return m_uchrTraceDropped;
+}
+
+
+
+/**
+ * \brief Empties the ring and clears the dropped count
+ */
+void TraceClear(void)
+{
+	//Variables
+	uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+	
+	interruptsOff();
+	m_uchrTraceHead = 0;
+	m_uchrTraceTail = 0;
+	m_uchrTraceDropped = 0;
+	SREG = sreg;
+}
+
+
+
+#if defined(TRACE_SERIAL_WRITE)
+
+/**
+ * \brief Sends what it can of the trace over the serial port without waiting. Call it from the main loop as often as possible
+ */
+void TracePollSerial(void)
+{
+	//Variables
+	TraceRecord_t record; //The record being packed
+	uint8_t checksum = 0; //Sum of the record bytes
+	uint8_t i = 0; //Loop index
+	
+	while(TRACE_SERIAL_READY())
+	{
+		//If no packet is in progress, start the next one
+		if(m_uchrTracePacketIndex >= TRACE_SERIAL_PACKET_SIZE)
+		{
+			if(TracePeek(&record) == false)
+			{
+				return;
+			}
+			
+			TraceRelease();
+			
+			m_uchrTracePacket[0] = TRACE_SERIAL_SYNC;
+			TracePack(&record, &m_uchrTracePacket[1]);
+			
+			for(i = 1; i < TRACE_SERIAL_PACKET_SIZE - 1; i++)
+			{
+				checksum += m_uchrTracePacket[i];
+			}
+			
+			m_uchrTracePacket[TRACE_SERIAL_PACKET_SIZE - 1] = checksum;
+			m_uchrTracePacketIndex = 0;
+		}
+		
+		TRACE_SERIAL_WRITE(m_uchrTracePacket[m_uchrTracePacketIndex]);
+		m_uchrTracePacketIndex++;
+	}
+}
+
+#endif
+
+
+#endif
@@ -0,0 +1,127 @@
+/**
+ * \file mcuTrace.h
+ * \author Tim Robbins
+ * \brief Header file for a binary event trace. \n
+ * TRACE writes a fixed 8 byte record of a time stamp, an event id, a sequence number and two arguments into a RAM ring, \n
+ * taking a few dozen cycles with interrupts briefly off, so it can be used in ISRs without distorting the timing being looked at. \n
+ * The records are streamed in the background, either a byte at a time over the serial port with TracePollSerial, \n
+ * or a record per frame over CAN with CAN_send_trace from avrCanUtilities. tools/traceDecode.py renders them as a timeline. \n
+ * The time stamp is 16 bits of the free running timer shared with mcuIsrStats in mcuTimebase.h, so TraceSync should be called every so often, such as once a millisecond, \n
+ * to give the decoder an absolute time to unwrap it against. A gap in the sequence numbers means records were dropped. \n
+ * With MCU_USE_TRACE at 0 the TRACE macro is empty. \n
+ *
+ * Record layout, little endian, as sent over CAN and inside each serial packet: \n
+ * byte 0-1 time, byte 2 id, byte 3 sequence, byte 4-5 a, byte 6-7 b \n
+ * Serial packet: TRACE_SERIAL_SYNC, the 8 record bytes, then the 8 bit sum of the record bytes \n
+ *
+ * Example use: \n
+ *
+ * #define TRACE_ID_CAN_RX		1 \n
+ *
+ * TraceInit(); \n
+ * ... \n
+ * ISR(CAN_INT_vect) { TRACE(TRACE_ID_CAN_RX, CANPAGE, CANSTMOB); ... } \n
+ * ... \n
+ * while(1) { TracePollSerial(); ... } \n
+ */
+#ifndef MCU_TRACE_H_
+#define MCU_TRACE_H_ 1
+
+#include "config.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+
+#ifndef MCU_USE_TRACE
+///If tracing is compiled in. 0 makes TRACE empty
+#define MCU_USE_TRACE						0
+#endif
+
+
+#ifdef __AVR
+
+#include <avr/io.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "mcuTimebase.h"
+
+
+#ifndef TRACE_BUFFER_RECORDS
+///The amount of records the ring holds. Must be a power of 2, and 8 bytes of RAM each
+#define TRACE_BUFFER_RECORDS				32
+#endif
+
+///Reads the free running time source for the time stamps. Read with interrupts off
+#define TRACE_NOW()							MCU_TIMEBASE_NOW()
+
+#if !defined(TRACE_SERIAL_READY) && defined(UDR0)
+///Checks if the serial port can take a byte without waiting
+#define TRACE_SERIAL_READY()				(UCSR0A & (1 << UDRE0))
+///Writes a byte to the serial port
+#define TRACE_SERIAL_WRITE(b)				UDR0 = (b)
+#endif
+
+///The byte that starts each serial packet
+#define TRACE_SERIAL_SYNC					0xA5
+
+///The size of a serial packet, being the sync byte, the record and the checksum
+#define TRACE_SERIAL_PACKET_SIZE			10
+
+///Event id of the records written by TraceSync, with the milliseconds in a and b. Application ids go below it
+#define TRACE_ID_SYNC						0xFF
+
+#if (TRACE_BUFFER_RECORDS & (TRACE_BUFFER_RECORDS - 1)) != 0 || TRACE_BUFFER_RECORDS > 128
+#error mcuTrace.h: TRACE_BUFFER_RECORDS must be a power of 2 of 128 or less
+#endif
+
+
+typedef struct _TRACE_RECORD_
+{
+	uint16_t time;			///The time source when the event was written
+	uint8_t id;				///What happened, defined by the application
+	uint8_t seq;			///Counts up for every event, including the dropped ones
+	uint16_t a;				///First argument
+	uint16_t b;				///Second argument
+
+}
+/**
+* \brief Struct for a trace record
+*/
+TraceRecord_t;
+
+
+#if MCU_USE_TRACE == 1
+
+///Writes a trace record
+#define TRACE(id, a, b)						TraceEvent((id), (uint16_t)(a), (uint16_t)(b))
+
+extern void TraceInit(void);
+extern void TraceEvent(uint8_t id, uint16_t a, uint16_t b);
+extern void TraceSync(uint32_t millis);
+extern bool TracePeek(TraceRecord_t* record);
+extern void TraceRelease(void);
+extern void TracePack(const TraceRecord_t* record, uint8_t data[8]);
+extern uint8_t TracePending(void);
+extern uint8_t TraceDropped(void);
+extern void TraceClear(void);
+
+#if defined(TRACE_SERIAL_WRITE)
+extern void TracePollSerial(void);
+#endif
+
+#else
+
+#define TRACE(id, a, b)
+
+#endif
+
+#endif
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif /* MCU_TRACE_H_ */
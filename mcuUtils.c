@@ -5,6 +5,7 @@
  */ 
 
 #include "mcuUtils.h"
+#include "mcuFormat.h"
 
 #ifndef MCUUTILS_C_
 #define MCUUTILS_C_ 1
@@ -42,70 +43,9 @@ uint32_t CalculateFrequencyTop(uint64_t cpuSpeed, uint16_t prescaler, uint16_t h
 */
 void ShortToCharArray(char valueAsCharArray[6], uint16_t numVal, uint8_t ignoreInitialEmpties)
 {
-	//Variables
-	uint8_t firstValue =  (numVal / 10000);
-	uint8_t secondValue = ((numVal / 1000) % 10);
-	uint8_t thirdValue =  ((numVal % 1000)/100);
-	uint8_t fourthValue = ((numVal % 100) / 10);
-	uint8_t fifthValue =  ((numVal % 10));
-	
-	for(uint8_t i = 0; i < 6; i++)
-	{
-		valueAsCharArray[i] = ' ';
-	}
-	
-	//Always form the last value, 0 or not
-	fifthValue += 0x30;
-	valueAsCharArray[4] = (char)fifthValue;
-	
-	if(ignoreInitialEmpties == 0)
-	{
-		firstValue += (0x30);
-		secondValue += (0x30);
-		thirdValue += (0x30);
-		fourthValue += (0x30);
-		valueAsCharArray[0] = (char)firstValue;
-		valueAsCharArray[1] = (char)secondValue;
-		valueAsCharArray[2] = (char)thirdValue;
-		valueAsCharArray[3] = (char)fourthValue;
-	}
-	else
-	{
-		//Form the characters
-		if(firstValue > 0)
-		{
-			firstValue += (0x30);
-			secondValue += (0x30);
-			thirdValue += 0x30;
-			fourthValue += 0x30;
-			valueAsCharArray[0] = (char)firstValue;
-			valueAsCharArray[1] = (char)secondValue;
-			valueAsCharArray[2] = (char)thirdValue;
-			valueAsCharArray[3] = (char)fourthValue;
-		}
-		else if (secondValue > 0)
-		{
-			secondValue += (0x30);
-			thirdValue += 0x30;
-			fourthValue += 0x30;
-			valueAsCharArray[1] = (char)secondValue;
-			valueAsCharArray[2] = (char)thirdValue;
-			valueAsCharArray[3] = (char)fourthValue;
-		}
-		else if (thirdValue > 0)
-		{
-			thirdValue += 0x30;
-			fourthValue += 0x30;
-			valueAsCharArray[2] = (char)thirdValue;
-			valueAsCharArray[3] = (char)fourthValue;
-		}
-		else if(fourthValue > 0)
-		{
-			fourthValue += 0x30;
-			valueAsCharArray[3] = (char)fourthValue;
-		}
-	}
-
+	//Five digits with the terminator landing in the last spot, which is then cleared back to a space as before
+	FormatUnsigned(valueAsCharArray, numVal, 5, (ignoreInitialEmpties == 0) ? FORMAT_PAD_ZERO : 0);
+	valueAsCharArray[5] = ' ';
 }
 
 
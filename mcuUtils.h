@@ -20,6 +20,7 @@
 extern "C" {
 #endif /* __cplusplus */
 
+#include <stdbool.h>
 
 
 #ifdef __AVR
@@ -39,11 +40,15 @@ extern "C" {
 ///Value for an 8 bit port being set to Input.
 #define FULL_INPUT		    0x00
 
+#ifndef interruptsOn
 ///Enables global interrupts
 #define interruptsOn()    __asm__ __volatile__ ("sei" ::: "memory")
+#endif
 
+#ifndef interruptsOff
 ///Disables global interrupts
 #define interruptsOff()   __asm__ __volatile__ ("cli" ::: "memory")
+#endif
 
 ///The no process function
 #define noP()	__asm__ __volatile__("nop")
@@ -549,6 +554,22 @@ inline char crolL(char byte)
 
 
 
+#if defined(__AVR) && defined(SMCR)
+
+///The sleep mode bits for idle, where the clocks for the peripherals and their interrupts keep running
+#define SLEEP_IDLE_MODE		0x00
+
+#ifndef sleep_cpu
+/**
+ * \brief Puts the core to sleep in the mode set with sleep_set_mode, until an interrupt. Sleep must be enabled first
+ */
+#define sleep_cpu()			__asm__ __volatile__ ("sleep" ::: "memory")
+#endif
+
+#endif
+
+
+
 
 
 
@@ -802,6 +823,20 @@ typedef union _NIBBLE_SPLIT_UNION_
 }NibbleSplit_t;
 
 
+/**
+ * \brief Checks if a 16 bit millisecond deadline has been reached, allowing for the count wrapping. \n
+ * SystemTimeReached does the same for the system tick's 32 bit count. This is for the uint16_t milliseconds the polled modules are passed, \n
+ * so a deadline can be no more than 32767 milliseconds out
+ * \param now The milliseconds now
+ * \param deadline The deadline
+ * \return True if reached
+ */
+static inline bool TimeReached16(uint16_t now, uint16_t deadline)
+{
+	return ((int16_t)(now - deadline) >= 0);
+}
+
+
 
 extern uint32_t CalculateFrequencyTop(uint64_t cpuSpeed, uint16_t prescaler, uint16_t hertz);
 extern void ShortToCharArray(char valueAsCharArray[6], uint16_t numVal, uint8_t ignoreInitialEmpties);
@@ -0,0 +1,864 @@
+/**
+ * \file modbusRtu.c
+ * \author Tim Robbins
+ * \brief Source file for the Modbus RTU slave and master
+ */
+#include "modbusRtu.h"
+
+#if !defined(MODBUS_RTU_C_) && defined(__AVR) && defined(UDR0)
+#define MODBUS_RTU_C_ 1
+
+#include <avr/interrupt.h>
+#include "mcuUtils.h"
+#include "mcuCrc.h"
+
+
+///The registers of the gap timer
+#if MODBUS_TIMER == 2
+#define MODBUS_TCCRA					TCCR2A
+#define MODBUS_TCCRB					TCCR2B
+#define MODBUS_TCNT						TCNT2
+#define MODBUS_OCR						OCR2A
+#define MODBUS_TIMSK					TIMSK2
+#define MODBUS_OCIE						OCIE2A
+#define MODBUS_TIFR						TIFR2
+#define MODBUS_OCF						OCF2A
+#define MODBUS_TIMER_vect				TIMER2_COMPA_vect
+#define MODBUS_TIMER_TOP				0xFF
+#else
+#define MODBUS_TCCRA					TCCR1A
+#define MODBUS_TCCRB					TCCR1B
+#define MODBUS_TCNT						TCNT1
+#define MODBUS_OCR						OCR1A
+#define MODBUS_TIMSK					TIMSK1
+#define MODBUS_OCIE						OCIE1A
+#define MODBUS_TIFR						TIFR1
+#define MODBUS_OCF						OCF1A
+#define MODBUS_TIMER_vect				TIMER1_COMPA_vect
+#define MODBUS_TIMER_TOP				0xFFFF
+#endif
+
+///Driver states
+#define MODBUS_STATE_IDLE				0	//Bus quiet, the next character starts a frame
+#define MODBUS_STATE_RECEIVING			1	//Taking in a frame
+#define MODBUS_STATE_DROPPING			2	//Ignoring characters until t3.5 of silence
+#define MODBUS_STATE_SENDING			3	//Sending a response or request
+
+///The bits in a character, start, 8 data, parity or a second stop, and stop
+#define MODBUS_CHAR_BITS				11
+
+///Set on the function code of an exception response
+#define MODBUS_EXCEPTION_FLAG			0x80
+
+
+///The log2 of each prescaler of the gap timer, in the order of its clock select values
+#if MODBUS_TIMER == 2
+static const uint8_t m_uchrModbusPrescaleShifts[] = { 0, 3, 5, 6, 7, 8, 10 };
+#else
+static const uint8_t m_uchrModbusPrescaleShifts[] = { 0, 3, 6, 8, 10 };
+#endif
+
+///The frame being received or sent, responses are built over their request
+static uint8_t m_uchrModbusBuffer[MODBUS_BUFFER_SIZE];
+
+///The bytes in the buffer
+static volatile uint16_t m_uintModbusLength = 0;
+
+///The next byte to send
+static volatile uint16_t m_uintModbusTxIndex = 0;
+
+///The CRC of the bytes received so far, 0 once a good frame's CRC is in
+static uint16_t m_uintModbusCrc = CRC16_MODBUS_INIT;
+
+///The state, one of MODBUS_STATE_
+static volatile uint8_t m_uchrModbusState = MODBUS_STATE_IDLE;
+
+///Timer ticks of t3.5
+static uint16_t m_uintModbusT35Ticks = 0;
+
+///Timer ticks between the ends of two characters past which a frame is broken, a character plus t1.5
+static uint16_t m_uintModbusGapTicks = 0;
+
+///This slave's address, MODBUS_MASTER for the master
+static uint8_t m_uchrModbusAddress = MODBUS_MASTER;
+
+///The slave's data
+static const ModbusMap_t* m_modbusMap = 0;
+
+///The master's request
+static uint8_t m_uchrModbusReqSlave = 0;
+static uint8_t m_uchrModbusReqFunction = 0;
+static uint16_t m_uintModbusReqCount = 0;
+static void* m_modbusReqData = 0;
+
+///The result of the master's request, one of MODBUS_MASTER_
+static volatile uint8_t m_uchrModbusResult = MODBUS_MASTER_IDLE;
+
+///The exception code of the last exception response
+static volatile uint8_t m_uchrModbusException = 0;
+
+///Set when the request has been sent, the response timeout starts at the next poll
+static volatile bool m_bModbusSent = false;
+
+///If the master is waiting for the response
+static bool m_bModbusWaiting = false;
+
+///When the response timeout runs out
+static uint16_t m_uintModbusDeadline = 0;
+
+///The counters
+static volatile ModbusStats_t m_modbusStats;
+
+
+
+/**
+ * \brief Checks a range of addresses is in one of the map's tables
+ * \param address The first address asked for
+ * \param count The amount asked for
+ * \param start The address of the table's first entry
+ * \param total The entries in the table
+ * \return True if it's all there
+ */
+static inline bool ModbusInRange(uint16_t address, uint16_t count, uint16_t start, uint16_t total)
+{
+	return (address >= start && count <= total && address - start <= total - count);
+}
+
+
+
+/**
+ * \brief Appends the CRC to the frame in the buffer and starts sending it from the UDRE interrupt
+ * \param length The bytes before the CRC
+ */
+static void ModbusSend(uint16_t length)
+{
+	//Variables
+	uint16_t crc = Crc16Modbus(m_uchrModbusBuffer, length); //The frame's CRC
+
+	m_uchrModbusBuffer[length] = (uint8_t)crc;
+	m_uchrModbusBuffer[length + 1] = (uint8_t)(crc >> 8);
+	m_uintModbusLength = length + 2;
+	m_uintModbusTxIndex = 0;
+	m_uchrModbusState = MODBUS_STATE_SENDING;
+
+	#ifdef MODBUS_DE_PORT
+	MODBUS_DE_PORT |= (1 << MODBUS_DE_PIN);
+	#endif
+
+	//The receiver is off while sending, so a half duplex bus doesn't hear its own echo
+	UCSR0B = (UCSR0B & ~((1 << RXEN0) | (1 << RXCIE0) | (1 << TXCIE0))) | (1 << UDRIE0);
+}
+
+
+
+/**
+ * \brief Reads bits from one of the map's bit tables into a response, a bit per coil, first in the low bit
+ * \param response Where the bits go, cleared first
+ * \param bits The table
+ * \param offset The bit in the table to start at
+ * \param count The amount of bits
+ */
+static void ModbusReadBits(uint8_t* response, const uint8_t* bits, uint16_t offset, uint16_t count)
+{
+	for(uint16_t i = 0; i < (count + 7) / 8; i++)
+	{
+		response[i] = 0;
+	}
+
+	for(uint16_t i = 0; i < count; i++, offset++)
+	{
+		if(bits[offset >> 3] & (1 << (offset & 7)))
+		{
+			response[i >> 3] |= (1 << (i & 7));
+		}
+	}
+}
+
+
+
+/**
+ * \brief Handles a request to this slave, building the response over it in the buffer. \n
+ * Reads come straight out of the map's tables and writes go straight into them
+ * \param length The bytes in the request, less the CRC
+ * \return The bytes in the response less the CRC, 0 for none
+ */
+static uint16_t ModbusSlave(uint16_t length)
+{
+	//Variables
+	uint8_t* frame = m_uchrModbusBuffer; //The request, then the response
+	const ModbusMap_t* map = m_modbusMap; //The slave's data
+	uint8_t function = frame[1]; //The function code
+	uint16_t address = ((uint16_t)frame[2] << 8) | frame[3]; //The first address
+	uint16_t count = ((uint16_t)frame[4] << 8) | frame[5]; //The amount, or the value of a single write
+	uint8_t exception = 0; //The exception to answer with, 0 for none
+	uint16_t response = 0; //The bytes in the response
+	const uint8_t* bits = 0; //The bit table read or written
+	const uint16_t* registers = 0; //The register table read
+	uint16_t start = 0; //The address of the table's first entry
+	uint16_t total = 0; //The entries in the table
+	uint16_t offset = 0; //The entry asked for first
+
+	if(frame[0] != m_uchrModbusAddress && frame[0] != 0)
+	{
+		return 0;
+	}
+
+	//Every supported function has an address and a count or value
+	if(length < 6)
+	{
+		exception = MODBUS_ILLEGAL_VALUE;
+	}
+	else switch(function)
+	{
+		case MODBUS_READ_COILS:
+		case MODBUS_READ_DISCRETE:
+			bits = (function == MODBUS_READ_COILS) ? map->coils : map->discrete;
+			start = (function == MODBUS_READ_COILS) ? map->coilStart : map->discreteStart;
+			total = (function == MODBUS_READ_COILS) ? map->coilCount : map->discreteCount;
+
+			if(count == 0 || count > 2000 || (count + 7) / 8 + 5 > MODBUS_BUFFER_SIZE)
+			{
+				exception = MODBUS_ILLEGAL_VALUE;
+			}
+			else if(bits == 0 || ModbusInRange(address, count, start, total) == false)
+			{
+				exception = MODBUS_ILLEGAL_ADDRESS;
+			}
+			else
+			{
+				frame[2] = (count + 7) / 8;
+				ModbusReadBits(&frame[3], bits, address - start, count);
+				response = 3 + frame[2];
+			}
+		break;
+
+		case MODBUS_READ_HOLDING:
+		case MODBUS_READ_INPUT:
+			registers = (function == MODBUS_READ_HOLDING) ? map->holding : map->input;
+			start = (function == MODBUS_READ_HOLDING) ? map->holdingStart : map->inputStart;
+			total = (function == MODBUS_READ_HOLDING) ? map->holdingCount : map->inputCount;
+
+			if(count == 0 || count > 125 || count * 2 + 5 > MODBUS_BUFFER_SIZE)
+			{
+				exception = MODBUS_ILLEGAL_VALUE;
+			}
+			else if(registers == 0 || ModbusInRange(address, count, start, total) == false)
+			{
+				exception = MODBUS_ILLEGAL_ADDRESS;
+			}
+			else
+			{
+				registers += address - start;
+				frame[2] = count * 2;
+
+				for(uint16_t i = 0; i < count; i++)
+				{
+					frame[3 + i * 2] = (uint8_t)(registers[i] >> 8);
+					frame[4 + i * 2] = (uint8_t)registers[i];
+				}
+
+				response = 3 + frame[2];
+			}
+		break;
+
+		case MODBUS_WRITE_COIL:
+			if(count != 0xFF00 && count != 0x0000)
+			{
+				exception = MODBUS_ILLEGAL_VALUE;
+			}
+			else if(map->coils == 0 || ModbusInRange(address, 1, map->coilStart, map->coilCount) == false)
+			{
+				exception = MODBUS_ILLEGAL_ADDRESS;
+			}
+			else
+			{
+				offset = address - map->coilStart;
+
+				if(count != 0)
+				{
+					map->coils[offset >> 3] |= (1 << (offset & 7));
+				}
+				else
+				{
+					map->coils[offset >> 3] &= ~(1 << (offset & 7));
+				}
+
+				count = 1;
+				response = 6;
+			}
+		break;
+
+		case MODBUS_WRITE_REGISTER:
+			if(map->holding == 0 || ModbusInRange(address, 1, map->holdingStart, map->holdingCount) == false)
+			{
+				exception = MODBUS_ILLEGAL_ADDRESS;
+			}
+			else
+			{
+				map->holding[address - map->holdingStart] = count;
+				count = 1;
+				response = 6;
+			}
+		break;
+
+		case MODBUS_WRITE_COILS:
+			if(count == 0 || count > 1968 || length < 7 || frame[6] != (count + 7) / 8 || length != 7 + frame[6])
+			{
+				exception = MODBUS_ILLEGAL_VALUE;
+			}
+			else if(map->coils == 0 || ModbusInRange(address, count, map->coilStart, map->coilCount) == false)
+			{
+				exception = MODBUS_ILLEGAL_ADDRESS;
+			}
+			else
+			{
+				offset = address - map->coilStart;
+
+				for(uint16_t i = 0; i < count; i++, offset++)
+				{
+					if(frame[7 + (i >> 3)] & (1 << (i & 7)))
+					{
+						map->coils[offset >> 3] |= (1 << (offset & 7));
+					}
+					else
+					{
+						map->coils[offset >> 3] &= ~(1 << (offset & 7));
+					}
+				}
+
+				response = 6;
+			}
+		break;
+
+		case MODBUS_WRITE_REGISTERS:
+			if(count == 0 || count > 123 || length < 7 || frame[6] != count * 2 || length != 7 + frame[6])
+			{
+				exception = MODBUS_ILLEGAL_VALUE;
+			}
+			else if(map->holding == 0 || ModbusInRange(address, count, map->holdingStart, map->holdingCount) == false)
+			{
+				exception = MODBUS_ILLEGAL_ADDRESS;
+			}
+			else
+			{
+				offset = address - map->holdingStart;
+
+				for(uint16_t i = 0; i < count; i++)
+				{
+					map->holding[offset + i] = ((uint16_t)frame[7 + i * 2] << 8) | frame[8 + i * 2];
+				}
+
+				response = 6;
+			}
+		break;
+
+		default:
+			exception = MODBUS_ILLEGAL_FUNCTION;
+		break;
+	}
+
+	if(exception != 0)
+	{
+		frame[1] = function | MODBUS_EXCEPTION_FLAG;
+		frame[2] = exception;
+		response = 3;
+		m_modbusStats.exceptions++;
+	}
+	else if(function >= MODBUS_WRITE_COIL && map->written != 0)
+	{
+		map->written(function, address, count);
+	}
+
+	//Broadcasts are never answered
+	return (frame[0] == 0) ? 0 : response;
+}
+
+
+
+/**
+ * \brief Matches a response to the master's request, putting what was read in the request's array
+ * \param length The bytes in the response, less the CRC
+ */
+static void ModbusMaster(uint16_t length)
+{
+	//Variables
+	const uint8_t* frame = m_uchrModbusBuffer; //The response
+	uint16_t bytes = 0; //The data bytes a read should have
+	uint8_t* bits = (uint8_t*)m_modbusReqData; //Where read bits go
+	uint16_t* registers = (uint16_t*)m_modbusReqData; //Where read registers go
+
+	//The receiver is off while the request goes out, so anything heard while busy comes after it
+	if(m_uchrModbusResult != MODBUS_MASTER_BUSY || frame[0] != m_uchrModbusReqSlave)
+	{
+		return;
+	}
+
+	if(frame[1] == (m_uchrModbusReqFunction | MODBUS_EXCEPTION_FLAG) && length == 3)
+	{
+		m_uchrModbusException = frame[2];
+		m_uchrModbusResult = MODBUS_MASTER_EXCEPTION;
+		m_bModbusSent = false;
+		m_bModbusWaiting = false;
+		return;
+	}
+
+	if(frame[1] != m_uchrModbusReqFunction)
+	{
+		return;
+	}
+
+	switch(m_uchrModbusReqFunction)
+	{
+		case MODBUS_READ_COILS:
+		case MODBUS_READ_DISCRETE:
+			bytes = (m_uintModbusReqCount + 7) / 8;
+
+			if(frame[2] != bytes || length != 3 + bytes)
+			{
+				return;
+			}
+
+			for(uint16_t i = 0; i < bytes; i++)
+			{
+				bits[i] = frame[3 + i];
+			}
+		break;
+
+		case MODBUS_READ_HOLDING:
+		case MODBUS_READ_INPUT:
+			bytes = m_uintModbusReqCount * 2;
+
+			if(frame[2] != bytes || length != 3 + bytes)
+			{
+				return;
+			}
+
+			for(uint16_t i = 0; i < m_uintModbusReqCount; i++)
+			{
+				registers[i] = ((uint16_t)frame[3 + i * 2] << 8) | frame[4 + i * 2];
+			}
+		break;
+
+		default:
+			//Writes echo the address and the value or count
+			if(length != 6)
+			{
+				return;
+			}
+		break;
+	}
+
+	m_uchrModbusResult = MODBUS_MASTER_DONE;
+	m_bModbusSent = false;
+	m_bModbusWaiting = false;
+}
+
+
+
+/**
+ * \brief Sets up USART0 and the gap timer, 8 data bits, even parity unless MODBUS_PARITY_EVEN is 0, and 1 stop bit. \n
+ * Frames are only taken once the bus has been quiet for t3.5
+ * \param baud The baud rate
+ * \param address This slave's address, 1 to 247, or MODBUS_MASTER
+ * \param map The slave's data, kept not copied. 0 for the master
+ * \return False if the address or map are bad or t3.5 can't be timed at this baud rate
+ */
+bool ModbusInit(uint32_t baud, uint8_t address, const ModbusMap_t* map)
+{
+	//Variables
+	uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+	uint32_t charUs = 0; //Microseconds a character takes
+	uint32_t t15Us = 0; //Microseconds of t1.5
+	uint32_t t35Us = 0; //Microseconds of t3.5
+	uint32_t t35Cycles = 0; //CPU cycles of t3.5
+	uint8_t select = 0; //The prescaler's index
+	uint8_t shift = 0; //Its log2
+
+	if(baud == 0 || address > 247 || (address != MODBUS_MASTER && map == 0))
+	{
+		return false;
+	}
+
+	charUs = (MODBUS_CHAR_BITS * 1000000UL + baud / 2) / baud;
+
+	//The spec fixes the timeouts above 19200 baud, since they'd be too short to time reliably
+	if(baud > 19200)
+	{
+		t15Us = 750;
+		t35Us = 1750;
+	}
+	else
+	{
+		t15Us = charUs * 3 / 2;
+		t35Us = charUs * 7 / 2;
+	}
+
+	//Smallest prescaler that fits t3.5, for the finest gap timing
+	t35Cycles = (F_CPU / 1000UL) * t35Us / 1000UL;
+
+	while(select < sizeof(m_uchrModbusPrescaleShifts) && (t35Cycles >> m_uchrModbusPrescaleShifts[select]) > MODBUS_TIMER_TOP)
+	{
+		select++;
+	}
+
+	if(select == sizeof(m_uchrModbusPrescaleShifts))
+	{
+		return false;
+	}
+
+	shift = m_uchrModbusPrescaleShifts[select];
+
+	interruptsOff();
+
+	m_uintModbusT35Ticks = (uint16_t)(t35Cycles >> shift);
+	m_uintModbusGapTicks = (uint16_t)((((F_CPU / 1000UL) * (charUs + t15Us) / 1000UL) >> shift));
+	m_uchrModbusAddress = address;
+	m_modbusMap = map;
+	m_uchrModbusResult = MODBUS_MASTER_IDLE;
+	m_bModbusSent = false;
+	m_bModbusWaiting = false;
+
+	m_modbusStats.frames = 0;
+	m_modbusStats.crcErrors = 0;
+	m_modbusStats.charErrors = 0;
+	m_modbusStats.exceptions = 0;
+
+	#ifdef MODBUS_DE_PORT
+	MODBUS_DE_PORT &= ~(1 << MODBUS_DE_PIN);
+	MODBUS_DE_DIR |= (1 << MODBUS_DE_PIN);
+	#endif
+
+	UCSR0B = 0;
+	UCSR0A = (1 << U2X0);
+	UBRR0 = (uint16_t)((F_CPU + baud * 4) / (baud * 8) - 1);
+	UCSR0C = ((MODBUS_PARITY_EVEN) ? (1 << UPM01) : (1 << USBS0)) | (1 << UCSZ01) | (1 << UCSZ00);
+	UCSR0B = (1 << RXEN0) | (1 << TXEN0) | (1 << RXCIE0);
+
+	//Wait out t3.5 before taking the first frame, in case one is already going
+	MODBUS_TCCRA = 0;
+	MODBUS_TCCRB = select + 1;
+	MODBUS_TCNT = 0;
+	MODBUS_OCR = m_uintModbusT35Ticks;
+	MODBUS_TIFR = (1 << MODBUS_OCF);
+	MODBUS_TIMSK |= (1 << MODBUS_OCIE);
+	m_uchrModbusState = MODBUS_STATE_DROPPING;
+
+	SREG = sreg;
+
+	return true;
+}
+
+
+
+/**
+ * \brief Sends a request as the master. The result is got with ModbusMasterResult
+ * \param slave The slave's address, 0 to broadcast a write
+ * \param function One of the function codes
+ * \param address The first address
+ * \param count The amount to read or write, 1 for MODBUS_WRITE_COIL and MODBUS_WRITE_REGISTER
+ * \param data For registers a uint16_t array, for coils and discrete inputs a uint8_t array of bits, first in the low bit. \n
+ * Reads are put in it when the response comes, so it has to stay around until then
+ * \return False if a request is still going, the bus is busy or the request doesn't fit the buffer
+ */
+bool ModbusMasterRequest(uint8_t slave, uint8_t function, uint16_t address, uint16_t count, void* data)
+{
+	//Variables
+	uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+	uint8_t* frame = m_uchrModbusBuffer; //The request
+	const uint8_t* bits = (const uint8_t*)data; //The bits to write
+	const uint16_t* registers = (const uint16_t*)data; //The registers to write
+	uint16_t length = 6; //The bytes in the request less the CRC
+	uint16_t bytes = 0; //The data bytes of a multiple write
+
+	if(m_uchrModbusAddress != MODBUS_MASTER || m_uchrModbusResult == MODBUS_MASTER_BUSY || count == 0)
+	{
+		return false;
+	}
+
+	if(function == MODBUS_WRITE_COILS)
+	{
+		bytes = (count + 7) / 8;
+	}
+	else if(function == MODBUS_WRITE_REGISTERS)
+	{
+		bytes = count * 2;
+	}
+
+	if((bytes != 0 && bytes + 9 > MODBUS_BUFFER_SIZE) || (bytes == 0 && count * 2 + 5 > MODBUS_BUFFER_SIZE))
+	{
+		return false;
+	}
+
+	interruptsOff();
+
+	if(m_uchrModbusState != MODBUS_STATE_IDLE)
+	{
+		SREG = sreg;
+		return false;
+	}
+
+	frame[0] = slave;
+	frame[1] = function;
+	frame[2] = (uint8_t)(address >> 8);
+	frame[3] = (uint8_t)address;
+	frame[4] = (uint8_t)(count >> 8);
+	frame[5] = (uint8_t)count;
+
+	if(function == MODBUS_WRITE_COIL)
+	{
+		frame[4] = (bits[0] & 0x01) ? 0xFF : 0x00;
+		frame[5] = 0;
+	}
+	else if(function == MODBUS_WRITE_REGISTER)
+	{
+		frame[4] = (uint8_t)(registers[0] >> 8);
+		frame[5] = (uint8_t)registers[0];
+	}
+	else if(function == MODBUS_WRITE_COILS)
+	{
+		frame[6] = bytes;
+
+		for(uint16_t i = 0; i < bytes; i++)
+		{
+			frame[7 + i] = bits[i];
+		}
+
+		length = 7 + bytes;
+	}
+	else if(function == MODBUS_WRITE_REGISTERS)
+	{
+		frame[6] = bytes;
+
+		for(uint16_t i = 0; i < count; i++)
+		{
+			frame[7 + i * 2] = (uint8_t)(registers[i] >> 8);
+			frame[8 + i * 2] = (uint8_t)registers[i];
+		}
+
+		length = 7 + bytes;
+	}
+
+	m_uchrModbusReqSlave = slave;
+	m_uchrModbusReqFunction = function;
+	m_uintModbusReqCount = count;
+	m_modbusReqData = data;
+	m_uchrModbusResult = MODBUS_MASTER_BUSY;
+	m_bModbusSent = false;
+	m_bModbusWaiting = false;
+
+	ModbusSend(length);
+
+	SREG = sreg;
+
+	return true;
+}
+
+
+
+/**
+ * \brief Gets the result of the master's request
+ * \param exception Where to put the exception code for MODBUS_MASTER_EXCEPTION, or 0
+ * \return One of MODBUS_MASTER_
+ */
+uint8_t ModbusMasterResult(uint8_t* exception)
+{
+	if(exception != 0)
+	{
+		*exception = m_uchrModbusException;
+	}
+
+	return m_uchrModbusResult;
+}
+
+
+
+/**
+ * \brief Times out the master's request. Not needed by a slave
+ * \param nowMs The milliseconds now
+ */
+void ModbusPoll(uint16_t nowMs)
+{
+	//Variables
+	uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+
+	interruptsOff();
+
+	if(m_bModbusSent)
+	{
+		m_bModbusSent = false;
+		m_bModbusWaiting = true;
+		m_uintModbusDeadline = nowMs + MODBUS_RESPONSE_TIMEOUT_MS;
+	}
+	else if(m_bModbusWaiting && TimeReached16(nowMs, m_uintModbusDeadline))
+	{
+		m_bModbusWaiting = false;
+		m_uchrModbusResult = MODBUS_MASTER_TIMEOUT;
+	}
+
+	SREG = sreg;
+}
+
+
+
+/**
+ * \brief Gets the driver's counters
+ * \param stats Where to put them
+ */
+void ModbusGetStats(ModbusStats_t* stats)
+{
+	//Variables
+	uint8_t sreg = SREG; //Saved status register, for restoring the interrupt state
+
+	interruptsOff();
+	stats->frames = m_modbusStats.frames;
+	stats->crcErrors = m_modbusStats.crcErrors;
+	stats->charErrors = m_modbusStats.charErrors;
+	stats->exceptions = m_modbusStats.exceptions;
+	SREG = sreg;
+}
+
+
+
+/**
+ * \brief USART0 receive interrupt. Restarts the gap timer, checks the gap since the last character and adds the byte to the frame
+ */
+ISR(USART0_RX_vect)
+{
+	//Variables
+	uint8_t status = UCSR0A; //The errors, read before the data
+	uint8_t data = UDR0; //The character
+	uint16_t elapsed = MODBUS_TCNT; //Timer ticks since the last character
+
+	MODBUS_TCNT = 0;
+	MODBUS_OCR = m_uintModbusT35Ticks;
+	MODBUS_TIFR = (1 << MODBUS_OCF);
+	MODBUS_TIMSK |= (1 << MODBUS_OCIE);
+
+	if(m_uchrModbusState == MODBUS_STATE_IDLE)
+	{
+		m_uchrModbusState = MODBUS_STATE_RECEIVING;
+		m_uintModbusLength = 0;
+		m_uintModbusCrc = CRC16_MODBUS_INIT;
+	}
+	//More than t1.5 of silence inside a frame
+	else if(m_uchrModbusState == MODBUS_STATE_RECEIVING && elapsed > m_uintModbusGapTicks)
+	{
+		m_uchrModbusState = MODBUS_STATE_DROPPING;
+		m_modbusStats.charErrors++;
+	}
+
+	if(m_uchrModbusState != MODBUS_STATE_RECEIVING)
+	{
+		return;
+	}
+
+	if((status & ((1 << FE0) | (1 << DOR0) | (1 << UPE0))) || m_uintModbusLength >= MODBUS_BUFFER_SIZE)
+	{
+		m_uchrModbusState = MODBUS_STATE_DROPPING;
+		m_modbusStats.charErrors++;
+		return;
+	}
+
+	m_uchrModbusBuffer[m_uintModbusLength++] = data;
+	m_uintModbusCrc = Crc16ModbusUpdate(m_uintModbusCrc, data);
+}
+
+
+
+/**
+ * \brief Gap timer interrupt, t3.5 of silence has ended the frame. A good one is handled here, and a slave's response started
+ */
+ISR(MODBUS_TIMER_vect)
+{
+	//Variables
+	uint16_t length = m_uintModbusLength; //The bytes in the frame
+	uint16_t response = 0; //The bytes in a slave's response
+
+	MODBUS_TIMSK &= ~(1 << MODBUS_OCIE);
+
+	if(m_uchrModbusState == MODBUS_STATE_RECEIVING)
+	{
+		//Address, function, at least one byte and the CRC, which leaves the running CRC at 0 when it's right
+		if(length < 4)
+		{
+			m_modbusStats.charErrors++;
+		}
+		else if(m_uintModbusCrc != 0)
+		{
+			m_modbusStats.crcErrors++;
+		}
+		else
+		{
+			m_modbusStats.frames++;
+			m_uchrModbusState = MODBUS_STATE_IDLE;
+
+			if(m_uchrModbusAddress == MODBUS_MASTER)
+			{
+				ModbusMaster(length - 2);
+			}
+			else
+			{
+				response = ModbusSlave(length - 2);
+
+				if(response != 0)
+				{
+					ModbusSend(response);
+					return;
+				}
+			}
+		}
+	}
+
+	if(m_uchrModbusState != MODBUS_STATE_SENDING)
+	{
+		m_uchrModbusState = MODBUS_STATE_IDLE;
+	}
+}
+
+
+
+/**
+ * \brief USART0 data register empty interrupt, sends the next byte of the frame
+ */
+ISR(USART0_UDRE_vect)
+{
+	UDR0 = m_uchrModbusBuffer[m_uintModbusTxIndex++];
+
+	if(m_uintModbusTxIndex >= m_uintModbusLength)
+	{
+		//Wait for the last byte to leave the shift register before letting go of the bus
+		UCSR0A = (UCSR0A & (1 << U2X0)) | (1 << TXC0);
+		UCSR0B = (UCSR0B & ~(1 << UDRIE0)) | (1 << TXCIE0);
+	}
+}
+
+
+
+/**
+ * \brief USART0 transmit complete interrupt, the frame is out so the bus is let go and the receiver turned back on
+ */
+ISR(USART0_TX_vect)
+{
+	#ifdef MODBUS_DE_PORT
+	MODBUS_DE_PORT &= ~(1 << MODBUS_DE_PIN);
+	#endif
+
+	UCSR0B = (UCSR0B & ~(1 << TXCIE0)) | (1 << RXEN0) | (1 << RXCIE0);
+	m_uchrModbusState = MODBUS_STATE_IDLE;
+
+	if(m_uchrModbusAddress == MODBUS_MASTER && m_uchrModbusResult == MODBUS_MASTER_BUSY)
+	{
+		//Nobody answers a broadcast
+		if(m_uchrModbusReqSlave == 0)
+		{
+			m_uchrModbusResult = MODBUS_MASTER_DONE;
+		}
+		else
+		{
+			m_bModbusSent = true;
+		}
+	}
+}
+
+
+#endif
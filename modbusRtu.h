@@ -0,0 +1,167 @@
+/**
+ * \file modbusRtu.h
+ * \author Tim Robbins
+ * \brief Header file for a Modbus RTU slave and master on USART0, with the framing done in interrupts. \n
+ * Each received character restarts a timer. A gap of more than t1.5 inside a frame marks it bad, and t3.5 of silence ends it, \n
+ * so the frame is handled in the timer interrupt the moment the bus goes quiet, without the main loop polling for it. \n
+ * The CRC is worked out a byte at a time as the characters come in, with mcuCrc, so a frame ends already checked. mcuCrc.c has to be built too. \n
+ * A slave answers from the timer interrupt. Requests are served straight out of the application's register and coil arrays \n
+ * given in the map, and the response is built over the request in the same buffer and sent from the UDRE interrupt. \n
+ * Above 19200 baud t1.5 and t3.5 are the fixed 750us and 1750us of the spec. \n
+ * Timer 2 is used where there is one, otherwise Timer 1, set with MODBUS_TIMER. Timer 1 is also the time source of \n
+ * mcuIsrStats and mcuTrace, so neither can be used with it. The driver owns USART0's interrupts, \n
+ * so _SERIAL_USE_INT has to stay 0. For RS-485, define MODBUS_DE_PORT, MODBUS_DE_DIR and MODBUS_DE_PIN for the driver enable, held high while sending. \n
+ * Writes from the master land in the map's arrays from the interrupt, the written callback is called from there as well. \n
+ *
+ * Example use, as a slave: \n
+ *
+ * uint16_t holding[10]; \n
+ * uint8_t coils[2]; \n
+ * static const ModbusMap_t map = { holding, 0, 10, 0, 0, 0, coils, 0, 16, 0, 0, 0, 0 }; \n
+ * ModbusInit(19200, 17, &map); \n
+ * sei(); \n
+ *
+ * And as a master: \n
+ *
+ * uint16_t values[4]; \n
+ * ModbusInit(19200, MODBUS_MASTER, 0); \n
+ * ModbusMasterRequest(17, MODBUS_READ_HOLDING, 0, 4, values); \n
+ * ... \n
+ * while(1) { ModbusPoll((uint16_t)SystemMillis()); if(ModbusMasterResult(&exception) == MODBUS_MASTER_DONE) { ... } } \n
+ */
+#ifndef MODBUS_RTU_H_
+#define MODBUS_RTU_H_ 1
+
+#include "config.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+
+#ifdef __AVR
+
+#include <avr/io.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef UDR0
+
+
+#ifndef MODBUS_TIMER
+#ifdef TCCR2A
+///The timer timing the gaps between characters, 1 or 2. Its compare A interrupt is taken
+#define MODBUS_TIMER						2
+#else
+#define MODBUS_TIMER						1
+#endif
+#endif
+
+#if MODBUS_TIMER == 1 && (MCU_USE_ISR_STATS == 1 || MCU_USE_TRACE == 1)
+#error modbusRtu.h: Timer 1 is the time source of mcuIsrStats and mcuTrace, so modbusRtu needs MODBUS_TIMER as 2 with them
+#endif
+
+#ifndef MODBUS_BUFFER_SIZE
+///The bytes in the frame buffer. 256 holds any RTU frame, less limits the registers per request
+#define MODBUS_BUFFER_SIZE					256
+#endif
+
+#ifndef MODBUS_RESPONSE_TIMEOUT_MS
+///The milliseconds a master waits for a response
+#define MODBUS_RESPONSE_TIMEOUT_MS			100
+#endif
+
+#ifndef MODBUS_PARITY_EVEN
+///1 for 8E1, the Modbus default, 0 for 8N2, the second stop bit keeping the 11 bit character RTU asks for
+#define MODBUS_PARITY_EVEN					1
+#endif
+
+
+///Slave address passed to ModbusInit to be the master
+#define MODBUS_MASTER						0
+
+///Function codes
+#define MODBUS_READ_COILS					0x01
+#define MODBUS_READ_DISCRETE				0x02
+#define MODBUS_READ_HOLDING					0x03
+#define MODBUS_READ_INPUT					0x04
+#define MODBUS_WRITE_COIL					0x05
+#define MODBUS_WRITE_REGISTER				0x06
+#define MODBUS_WRITE_COILS					0x0F
+#define MODBUS_WRITE_REGISTERS				0x10
+
+///Exception codes
+#define MODBUS_ILLEGAL_FUNCTION				0x01
+#define MODBUS_ILLEGAL_ADDRESS				0x02
+#define MODBUS_ILLEGAL_VALUE				0x03
+
+///Results of a master request
+#define MODBUS_MASTER_IDLE					0	//No request made
+#define MODBUS_MASTER_BUSY					1	//Sending or waiting for the response
+#define MODBUS_MASTER_DONE					2	//Answered, read values are in the request's array
+#define MODBUS_MASTER_EXCEPTION				3	//The slave answered with an exception
+#define MODBUS_MASTER_TIMEOUT				4	//No answer in MODBUS_RESPONSE_TIMEOUT_MS
+
+
+/**
+ * \brief Called after the master writes to the map, from the interrupt
+ * \param function The write function
+ * \param address The first address written
+ * \param count The amount written
+ */
+typedef void (*ModbusWritten_t)(uint8_t function, uint16_t address, uint16_t count);
+
+
+typedef struct _MODBUS_MAP_
+{
+	uint16_t* holding;				///Holding registers, read and written by the master
+	uint16_t holdingStart;			///The address of the first
+	uint16_t holdingCount;			///The amount
+	const uint16_t* input;			///Input registers, read only
+	uint16_t inputStart;			///The address of the first
+	uint16_t inputCount;			///The amount
+	uint8_t* coils;					///Coils, a bit each, read and written by the master
+	uint16_t coilStart;				///The address of the first
+	uint16_t coilCount;				///The amount
+	const uint8_t* discrete;		///Discrete inputs, a bit each, read only
+	uint16_t discreteStart;			///The address of the first
+	uint16_t discreteCount;			///The amount
+	ModbusWritten_t written;		///Called after a write, or 0
+
+}
+/**
+* \brief Struct for a slave's data, used in place
+*/
+ModbusMap_t;
+
+
+typedef struct _MODBUS_STATS_
+{
+	uint16_t frames;				///Frames received with a good CRC
+	uint16_t crcErrors;				///Frames with a bad CRC
+	uint16_t charErrors;			///Frames dropped for a framing, parity or overrun error, a gap over t1.5 or being too long
+	uint16_t exceptions;			///Exception responses sent
+
+}
+/**
+* \brief Struct for the driver's counters
+*/
+ModbusStats_t;
+
+
+extern bool ModbusInit(uint32_t baud, uint8_t address, const ModbusMap_t* map);
+extern bool ModbusMasterRequest(uint8_t slave, uint8_t function, uint16_t address, uint16_t count, void* data);
+extern uint8_t ModbusMasterResult(uint8_t* exception);
+extern void ModbusPoll(uint16_t nowMs);
+extern void ModbusGetStats(ModbusStats_t* stats);
+
+#endif
+
+#endif
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif /* MODBUS_RTU_H_ */
@@ -0,0 +1,465 @@
+/**
+ * \file obd2Client.cpp
+ * \author Timothy Robbins
+ * \brief OBD-II mode 01 client
+ */
+#if defined(__cplusplus) && defined(__AVR)
+#if defined(__AVR_ATmega32C1__) || defined(__AVR_ATmega64C1__) || defined(__AVR_ATmega16M1__) || defined(__AVR_ATmega32M1__) || defined(__AVR_ATmega64M1__)
+
+#ifndef __OBD2_CLIENT_CPP__
+#define __OBD2_CLIENT_CPP__
+
+
+#include "obd2Client.h"
+#include "mcuUtils.h"
+
+
+///The amount of ECU response ids
+#define OBD2_ECU_QUANTITY               8
+
+
+typedef struct _OBD2_ENTRY_
+{
+    uint8_t pid;                    ///The PID
+    bool used;                      ///If the entry has a PID
+    bool valid;                     ///If a value has been received
+    bool fresh;                     ///If the value is younger than the max age, kept by Obd2Poll
+    bool queued;                    ///If a request is waiting to be sent
+    bool pending;                   ///If a request is in flight
+    uint8_t length;                 ///The data bytes of the value
+    uint8_t data[4];                ///The value
+    uint8_t ecu;                    ///The ECU that answered
+    uint8_t misses;                 ///The timeouts in a row
+    uint8_t nrc;                    ///The negative response code to the last request, 0 if it was answered
+    uint16_t maxAgeMs;              ///The max age of the value
+    uint16_t receivedMs;            ///When the value was received
+    uint16_t sentMs;                ///When the last request was sent
+
+}
+/**
+* \brief Struct for a cached PID
+*/
+Obd2Entry_t;
+
+
+///The cached PIDs
+static Obd2Entry_t m_obd2Entries[OBD2_PIDS_MAX];
+
+///The id requests are sent to
+static uint16_t m_uintObd2RequestId = OBD2_FUNCTIONAL_ID;
+
+///The requests in flight
+static uint8_t m_uchrObd2Outstanding = 0;
+
+///The entry to look at first for the next request
+static uint8_t m_uchrObd2Next = 0;
+
+///The milliseconds at the last poll
+static uint16_t m_uintObd2Now = 0;
+
+///The counters
+static Obd2Stats_t m_obd2Stats;
+
+
+
+/**
+ * \brief Finds a PID's entry
+ * \param pid The PID
+ * \return The entry or 0
+ */
+static Obd2Entry_t* Obd2Find(uint8_t pid)
+{
+    //Variables
+    uint8_t i = 0; //Loop index
+
+    for(i = 0; i < OBD2_PIDS_MAX; i++)
+    {
+        if(m_obd2Entries[i].used && m_obd2Entries[i].pid == pid)
+        {
+            return &m_obd2Entries[i];
+        }
+    }
+
+    return 0;
+}
+
+
+
+/**
+ * \brief Sends a mode 01 request for a PID
+ * \param pid The PID
+ * \return False if the CAN tx queue is full
+ */
+static bool Obd2SendRequest(uint8_t pid)
+{
+    //Variables
+    CAN_FRAME frame; //The request
+    uint8_t i = 0; //Loop index
+
+    frame.id = m_uintObd2RequestId;
+    frame.extended = 0;
+    frame.rtr = 0;
+    frame.priority = 0;
+    frame.length = 8;
+    frame.data.bytes[0] = 2;
+    frame.data.bytes[1] = OBD2_MODE_CURRENT_DATA;
+    frame.data.bytes[2] = pid;
+
+    for(i = 3; i < 8; i++)
+    {
+        frame.data.bytes[i] = OBD2_PAD_BYTE;
+    }
+
+    return Can0.sendFrame(frame);
+}
+
+
+
+/**
+ * \brief Completes the oldest request in flight with a negative response code, since the response doesn't say which PID it's for
+ * \param nrc The negative response code
+ */
+static void Obd2Reject(uint8_t nrc)
+{
+    //Variables
+    Obd2Entry_t* entry = 0; //The oldest request in flight
+    uint8_t i = 0; //Loop index
+
+    for(i = 0; i < OBD2_PIDS_MAX; i++)
+    {
+        if(m_obd2Entries[i].used && m_obd2Entries[i].pending && (entry == 0 || (int16_t)(m_obd2Entries[i].sentMs - entry->sentMs) < 0))
+        {
+            entry = &m_obd2Entries[i];
+        }
+    }
+
+    if(entry == 0)
+    {
+        return;
+    }
+
+    //Still being worked on, so wait another timeout
+    if(nrc == OBD2_NRC_RESPONSE_PENDING)
+    {
+        entry->sentMs = m_uintObd2Now;
+        return;
+    }
+
+    entry->pending = false;
+    entry->queued = true;
+    m_uchrObd2Outstanding--;
+
+    if(nrc == OBD2_NRC_BUSY)
+    {
+        return;
+    }
+
+    //Held off like a PID that keeps timing out, the hold off counts from when the request was sent
+    entry->nrc = nrc;
+    entry->misses = OBD2_MAX_MISSES;
+    m_obd2Stats.rejects++;
+}
+
+
+
+/**
+ * \brief Sets up the client and clears the cache
+ * \param requestId OBD2_FUNCTIONAL_ID to ask every ECU, or OBD2_PHYSICAL_ID plus the ECU number to ask just one
+ */
+void Obd2Init(uint16_t requestId)
+{
+    //Variables
+    uint8_t i = 0; //Loop index
+
+    for(i = 0; i < OBD2_PIDS_MAX; i++)
+    {
+        m_obd2Entries[i].used = false;
+    }
+
+    m_uintObd2RequestId = requestId;
+    m_uchrObd2Outstanding = 0;
+    m_uchrObd2Next = 0;
+
+    m_obd2Stats.requests = 0;
+    m_obd2Stats.responses = 0;
+    m_obd2Stats.cacheHits = 0;
+    m_obd2Stats.timeouts = 0;
+    m_obd2Stats.rejects = 0;
+}
+
+
+
+/**
+ * \brief Adds a PID to the cache, or changes its max age, and queues a request for it
+ * \param pid The PID
+ * \param maxAgeMs The milliseconds a value is served from the cache for, under 32768
+ * \return False if the cache is full
+ */
+bool Obd2AddPid(uint8_t pid, uint16_t maxAgeMs)
+{
+    //Variables
+    Obd2Entry_t* entry = Obd2Find(pid); //The PID's entry
+    uint8_t i = 0; //Loop index
+
+    if(entry == 0)
+    {
+        for(i = 0; i < OBD2_PIDS_MAX && m_obd2Entries[i].used; i++);
+
+        if(i == OBD2_PIDS_MAX)
+        {
+            return false;
+        }
+
+        entry = &m_obd2Entries[i];
+        entry->pid = pid;
+        entry->used = true;
+        entry->valid = false;
+        entry->fresh = false;
+        entry->pending = false;
+        entry->misses = 0;
+        entry->nrc = 0;
+    }
+
+    entry->maxAgeMs = maxAgeMs;
+
+    if(entry->pending == false)
+    {
+        entry->queued = true;
+    }
+
+    return true;
+}
+
+
+
+/**
+ * \brief Times out the requests not answered, ages the cache, and sends the queued requests while there's room in the pipeline
+ * \param nowMs The milliseconds now
+ */
+void Obd2Poll(uint16_t nowMs)
+{
+    //Variables
+    Obd2Entry_t* entry = 0; //The entry being looked at
+    uint8_t i = 0; //Loop index
+    uint8_t index = 0; //The entry's index
+
+    m_uintObd2Now = nowMs;
+
+    for(i = 0; i < OBD2_PIDS_MAX; i++)
+    {
+        entry = &m_obd2Entries[i];
+
+        if(entry->used == false)
+        {
+            continue;
+        }
+
+        if(entry->pending && TimeReached16(nowMs, entry->sentMs + OBD2_TIMEOUT_MS))
+        {
+            entry->pending = false;
+            entry->queued = true;
+            m_uchrObd2Outstanding--;
+            m_obd2Stats.timeouts++;
+
+            if(entry->misses != 0xFF)
+            {
+                entry->misses++;
+            }
+        }
+
+        //Checked here as well as in Obd2Read so a value can't come back fresh when the milliseconds wrap
+        if(entry->fresh && (uint16_t)(nowMs - entry->receivedMs) > entry->maxAgeMs)
+        {
+            entry->fresh = false;
+        }
+    }
+
+    //Send in turn from after the last one sent
+    for(i = 0; i < OBD2_PIDS_MAX && m_uchrObd2Outstanding < OBD2_PIPELINE_DEPTH; i++)
+    {
+        index = (m_uchrObd2Next + i) % OBD2_PIDS_MAX;
+        entry = &m_obd2Entries[index];
+
+        if(entry->used == false || entry->queued == false || entry->pending)
+        {
+            continue;
+        }
+
+        if(entry->misses >= OBD2_MAX_MISSES && TimeReached16(nowMs, entry->sentMs + OBD2_MISS_HOLDOFF_MS) == false)
+        {
+            continue;
+        }
+
+        if(Obd2SendRequest(entry->pid) == false)
+        {
+            break;
+        }
+
+        entry->queued = false;
+        entry->pending = true;
+        entry->sentMs = nowMs;
+        m_uchrObd2Outstanding++;
+        m_obd2Stats.requests++;
+        m_uchrObd2Next = (index + 1) % OBD2_PIDS_MAX;
+    }
+}
+
+
+
+/**
+ * \brief Takes a received frame, storing it if it's a mode 01 response or completing a request with it if it's a negative response to one
+ * \param frame The frame
+ * \return True if the frame was from an ECU, so it's been dealt with
+ */
+bool Obd2Receive(CAN_FRAME& frame)
+{
+    //Variables
+    Obd2Entry_t* entry = 0; //The PID's entry
+    uint8_t ecu = (uint8_t)(frame.id - OBD2_RESPONSE_ID); //The ECU that sent it
+    uint8_t length = frame.data.bytes[0]; //The single frame length
+    uint8_t i = 0; //Loop index
+
+    if(frame.extended || frame.id < OBD2_RESPONSE_ID || ecu >= OBD2_ECU_QUANTITY)
+    {
+        return false;
+    }
+
+    //Asked one ECU, so the others aren't ours
+    if(m_uintObd2RequestId != OBD2_FUNCTIONAL_ID && ecu != (uint8_t)(m_uintObd2RequestId - OBD2_PHYSICAL_ID))
+    {
+        return false;
+    }
+
+    if(length == 3 && frame.length > 3 && frame.data.bytes[1] == OBD2_NEGATIVE_RESPONSE && frame.data.bytes[2] == OBD2_MODE_CURRENT_DATA)
+    {
+        Obd2Reject(frame.data.bytes[3]);
+        return true;
+    }
+
+    //Only single frames, with the mode and PID, are answers to a mode 01 request
+    if(length < 2 || length > 7 || length >= frame.length || frame.data.bytes[1] != (OBD2_MODE_RESPONSE | OBD2_MODE_CURRENT_DATA))
+    {
+        return true;
+    }
+
+    entry = Obd2Find(frame.data.bytes[2]);
+
+    if(entry == 0)
+    {
+        return true;
+    }
+
+    if(entry->pending)
+    {
+        entry->pending = false;
+        m_uchrObd2Outstanding--;
+        m_obd2Stats.responses++;
+    }
+    //A second ECU answering a functional request. The lowest ECU, the engine on most cars, is kept
+    else if(entry->fresh && ecu > entry->ecu)
+    {
+        return true;
+    }
+
+    entry->length = (length - 2 > 4) ? 4 : length - 2;
+
+    for(i = 0; i < entry->length; i++)
+    {
+        entry->data[i] = frame.data.bytes[3 + i];
+    }
+
+    entry->ecu = ecu;
+    entry->receivedMs = m_uintObd2Now;
+    entry->valid = true;
+    entry->fresh = true;
+    entry->queued = false;
+    entry->misses = 0;
+    entry->nrc = 0;
+
+    return true;
+}
+
+
+
+/**
+ * \brief Reads a PID, from the cache if the value is young enough. Otherwise a request is queued for the next Obd2Poll \n
+ * A PID not added yet is added with OBD2_DEFAULT_MAX_AGE_MS
+ * \param pid The PID
+ * \param value Where to put the value, set for OBD2_READ_FRESH and OBD2_READ_STALE. Only the code is set for OBD2_READ_REJECTED
+ * \return OBD2_READ_FRESH, OBD2_READ_STALE, OBD2_READ_REJECTED or OBD2_READ_NONE
+ */
+uint8_t Obd2Read(uint8_t pid, Obd2Value_t* value)
+{
+    //Variables
+    Obd2Entry_t* entry = Obd2Find(pid); //The PID's entry
+    uint16_t age = 0; //The age of the value
+    uint8_t i = 0; //Loop index
+
+    if(entry == 0)
+    {
+        Obd2AddPid(pid, OBD2_DEFAULT_MAX_AGE_MS);
+        return OBD2_READ_NONE;
+    }
+
+    if(entry->pending == false && (entry->fresh == false || (uint16_t)(m_uintObd2Now - entry->receivedMs) > entry->maxAgeMs))
+    {
+        entry->queued = true;
+    }
+
+    if(entry->nrc != 0)
+    {
+        value->nrc = entry->nrc;
+        return OBD2_READ_REJECTED;
+    }
+
+    if(entry->valid == false)
+    {
+        return OBD2_READ_NONE;
+    }
+
+    age = m_uintObd2Now - entry->receivedMs;
+
+    value->length = entry->length;
+    value->nrc = 0;
+    value->ecu = entry->ecu;
+    value->ageMs = age;
+
+    for(i = 0; i < entry->length; i++)
+    {
+        value->data[i] = entry->data[i];
+    }
+
+    if(entry->fresh && age <= entry->maxAgeMs)
+    {
+        m_obd2Stats.cacheHits++;
+        return OBD2_READ_FRESH;
+    }
+
+    return OBD2_READ_STALE;
+}
+
+
+
+/**
+ * \brief Gets the amount of requests in flight
+ * \return The requests
+ */
+uint8_t Obd2Outstanding(void)
+{
+    return m_uchrObd2Outstanding;
+}
+
+
+
+/**
+ * \brief Gets the client's counters
+ * \param stats Where to put them
+ */
+void Obd2GetStats(Obd2Stats_t* stats)
+{
+    *stats = m_obd2Stats;
+}
+
+#endif /* __OBD2_CLIENT_CPP__ */
+#endif
+#endif
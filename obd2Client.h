@@ -0,0 +1,145 @@
+/**
+ * \file obd2Client.h
+ * \author Timothy Robbins
+ * \brief OBD-II mode 01 client for the OBD2 relay node, over ISO 15765-4 CAN with 11 bit ids. \n
+ * Up to OBD2_PIPELINE_DEPTH single PID requests are kept in flight at once instead of waiting out each round trip, \n
+ * and responses are matched back to their request by the PID they carry. \n
+ * Every PID read has a cache entry with a max age. Obd2Read answers from the cache while the value is younger than that, \n
+ * and only queues a request for it once it's older, so a display reading the same PIDs each pass costs no bus traffic \n
+ * until they need refreshing. Queued PIDs are sent in turn, so one slow PID can't starve the rest. \n
+ * A request not answered within OBD2_TIMEOUT_MS is dropped and queued again. A PID missing OBD2_MAX_MISSES answers in a row \n
+ * is most likely not supported, since ECUs ignore those in functional requests, so it's left alone for OBD2_MISS_HOLDOFF_MS. \n
+ * A negative response, 0x7F then the mode then the code, carries no PID, so it's matched to the oldest request in flight. \n
+ * OBD2_NRC_RESPONSE_PENDING restarts that request's timeout and OBD2_NRC_BUSY queues it again. Any other code completes \n
+ * the request with the error, which Obd2Read returns as OBD2_READ_REJECTED, and the PID is left alone for OBD2_MISS_HOLDOFF_MS. \n
+ * Times are milliseconds, taken from the last Obd2Poll. \n
+ *
+ * Example use: \n
+ *
+ * CAN_init_tx(CAN_BPS_500K, false, 1); \n
+ * Obd2Init(OBD2_FUNCTIONAL_ID); \n
+ * Obd2AddPid(0x0C, 100); \n
+ * Obd2AddPid(0x05, 2000); \n
+ * int8_t OnFrame(CAN_FRAME& frame) { if(Obd2Receive(frame)) return 0; ... } \n
+ * ... \n
+ * while(1) \n
+ * { \n
+ *     CAN_process_frame(OnFrame); \n
+ *     Obd2Poll((uint16_t)SystemMillis()); \n
+ *     if(Obd2Read(0x0C, &value) != OBD2_READ_NONE) rpm = ((value.data[0] << 8) | value.data[1]) / 4; \n
+ * } \n
+ */
+
+#if defined(__cplusplus) && defined(__AVR)
+#if defined(__AVR_ATmega32C1__) || defined(__AVR_ATmega64C1__) || defined(__AVR_ATmega16M1__) || defined(__AVR_ATmega32M1__) || defined(__AVR_ATmega64M1__)
+
+#ifndef __OBD2_CLIENT_H__
+#define __OBD2_CLIENT_H__
+
+#include <avr/io.h>
+#include "config.h"
+#include "avr_can.h"
+
+
+#ifndef OBD2_PIDS_MAX
+///The amount of PIDs that can be cached, 20 bytes of RAM each
+#define OBD2_PIDS_MAX                   16
+#endif
+
+#ifndef OBD2_PIPELINE_DEPTH
+///The most requests in flight at once
+#define OBD2_PIPELINE_DEPTH             4
+#endif
+
+#ifndef OBD2_TIMEOUT_MS
+///The milliseconds to wait for a response, P2 max of ISO 15765-4 with some margin
+#define OBD2_TIMEOUT_MS                 100
+#endif
+
+#ifndef OBD2_DEFAULT_MAX_AGE_MS
+///The max age of a PID first seen by Obd2Read
+#define OBD2_DEFAULT_MAX_AGE_MS         500
+#endif
+
+#ifndef OBD2_MAX_MISSES
+///The timeouts in a row before a PID is held off
+#define OBD2_MAX_MISSES                 3
+#endif
+
+#ifndef OBD2_MISS_HOLDOFF_MS
+///The milliseconds a PID that keeps timing out is left alone for
+#define OBD2_MISS_HOLDOFF_MS            5000
+#endif
+
+#ifndef OBD2_PAD_BYTE
+///The byte the unused data of a request is padded with, requests are always 8 bytes long
+#define OBD2_PAD_BYTE                   0x00
+#endif
+
+
+///Request ids
+#define OBD2_FUNCTIONAL_ID              0x7DF   //To every ECU
+#define OBD2_PHYSICAL_ID                0x7E0   //Plus the ECU number, 0 to 7, to just that ECU
+
+///The response id of the first ECU, the rest follow on
+#define OBD2_RESPONSE_ID                0x7E8
+
+///The service for current data, and the response to it
+#define OBD2_MODE_CURRENT_DATA          0x01
+#define OBD2_MODE_RESPONSE              0x40
+
+///The first byte of a negative response, followed by the mode and the code
+#define OBD2_NEGATIVE_RESPONSE          0x7F
+
+///Negative response codes handled apart from the rest
+#define OBD2_NRC_BUSY                   0x21    //Busy, repeat the request
+#define OBD2_NRC_RESPONSE_PENDING       0x78    //The answer is coming, keep waiting
+
+///Results of Obd2Read
+#define OBD2_READ_NONE                  0   //No value yet, a request is queued
+#define OBD2_READ_FRESH                 1   //The value is younger than the PID's max age
+#define OBD2_READ_STALE                 2   //The value is older than the max age, a request is queued
+#define OBD2_READ_REJECTED              3   //The last request got a negative response, only the code is set
+
+
+typedef struct _OBD2_VALUE_
+{
+    uint8_t length;                 ///The data bytes, A to D
+    uint8_t data[4];                ///The data, A first
+    uint8_t ecu;                    ///The ECU that answered, 0 for the one at OBD2_RESPONSE_ID
+    uint16_t ageMs;                 ///The milliseconds since it was received
+    uint8_t nrc;                    ///The negative response code for OBD2_READ_REJECTED, otherwise 0
+
+}
+/**
+* \brief Struct for a PID's value
+*/
+Obd2Value_t;
+
+
+typedef struct _OBD2_STATS_
+{
+    uint32_t requests;              ///Requests sent
+    uint32_t responses;             ///Responses matched to a request
+    uint32_t cacheHits;             ///Reads answered from the cache with a fresh value
+    uint16_t timeouts;              ///Requests not answered in time
+    uint16_t rejects;               ///Requests completed by a negative response
+
+}
+/**
+* \brief Struct for the client's counters
+*/
+Obd2Stats_t;
+
+
+void Obd2Init(uint16_t requestId);
+bool Obd2AddPid(uint8_t pid, uint16_t maxAgeMs);
+void Obd2Poll(uint16_t nowMs);
+bool Obd2Receive(CAN_FRAME& frame);
+uint8_t Obd2Read(uint8_t pid, Obd2Value_t* value);
+uint8_t Obd2Outstanding(void);
+void Obd2GetStats(Obd2Stats_t* stats);
+
+#endif /* __OBD2_CLIENT_H__ */
+#endif
+#endif
@@ -84,17 +84,8 @@ void SSD1306Initialize(bool displayOn, uint8_t currentDisplaySelection)
 	#if !defined(SSD1306_DRAW_IMMEDIATE) || SSD1306_DRAW_IMMEDIATE < 1
 	//SSD1306ClearBuffer();
 	
-	//Make sure buffer is cleared and initialized
-	for(uint8_t y = 0, x = 0; y < SSD1306_HEIGHT; x++)
-	{
-		
-		if(x >= SSD1306_WIDTH)
-		{
-			x = 0;
-			y++;
-		}
-		SSD1306DisplayBuffer[y][x] = 0;
-	}
+	//Make sure buffer is cleared and initialized. The buffer is a byte per 8 rows, so only SSD1306_HEIGHT/8 rows of it
+	memset(SSD1306DisplayBuffer, 0x00, sizeof(SSD1306DisplayBuffer));
 	
 	#endif
     
@@ -712,7 +703,7 @@ void SSD1306PutP(PGM_P progmemS) {
 		 	currentFontChar[i] = fontSheet[fontLocation+i];
 	 	}
 	 	
-	 	SSD1306PutFontChar(c,currentFontChar,fontSheetCharacterLength);
+	 	SSD1306PutFontChar(c,(const char*)currentFontChar,fontSheetCharacterLength);
  	}
  	
  }
@@ -756,7 +747,7 @@ void SSD1306PutP(PGM_P progmemS) {
 				
 		}
 		 
-		 SSD1306PutFontChar(c,currentFontChar,fontSheetCharacterLength);
+		 SSD1306PutFontChar(c,(const char*)currentFontChar,fontSheetCharacterLength);
 	 }
 	 
 	 
@@ -806,7 +797,7 @@ void SSD1306PutP(PGM_P progmemS) {
 		{
 			currentFontChar[j] = fontSheet[j+i*fontSheetCharacterWidth];
 		}
-		SSD1306WriteFontLine(currentFontChar,fontSheetCharacterWidth);	 
+		SSD1306WriteFontLine((const char*)currentFontChar,fontSheetCharacterWidth);	 
 		SSD1306GoToPosition(x,y+1,fontSheetCharacterWidth);
 	}
 	 
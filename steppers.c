@@ -10,6 +10,106 @@
 #ifndef STEPPERS_C
 #define	STEPPERS_C 1
 
+#include "mcuUtils.h"
+
+
+
+///The phase patterns for each stepping mode, bit 0 being phase line 0. Indexed by STEPPER_MODE_X
+static const uint8_t m_uchrStepperPhasePatterns[3][STEPPER_MAX_SEQUENCE_LENGTH] =
+{
+    { 0x01, 0x02, 0x04, 0x08 },
+    { 0x09, 0x03, 0x06, 0x0C },
+    { 0x09, 0x01, 0x03, 0x02, 0x06, 0x04, 0x0C, 0x08 }
+};
+
+///Where each step of each mode sits in the 8 step half step cycle, for keeping the rotor position across a mode change. Indexed by STEPPER_MODE_X
+static const uint8_t m_uchrStepperHalfStepPositions[3][STEPPER_MAX_SEQUENCE_LENGTH] =
+{
+    { 1, 3, 5, 7 },
+    { 0, 2, 4, 6 },
+    { 0, 1, 2, 3, 4, 5, 6, 7 }
+};
+
+
+
+/**
+ * \brief Initializes a stepper object, precomputing the port values for every step so stepping is a table lookup. \n
+ * Example use: \n
+ * StepperInit(&stepperX, &STEPPER_PORT_OUT_REGISTER, auchrPinPositions, STEPPER_MODE_FULL); \n
+ * \author Tim Robbins
+ * \param stepper The stepper object to initialize
+ * \param stepperOutputRegister The output register the stepper motors phase lines are connected to
+ * \param phaseLinePinPositions The positions of the phase line pins
+ * \param stepMode The stepping mode, STEPPER_MODE_WAVE, STEPPER_MODE_FULL, or STEPPER_MODE_HALF
+ */
+void StepperInit(Stepper_t* stepper, volatile uint8_t* stepperOutputRegister, const uint8_t phaseLinePinPositions[4], uint8_t stepMode)
+{
+    stepper->outputRegister = stepperOutputRegister;
+    stepper->sequenceIndex = 0;
+    stepper->sequenceLength = 0;
+    StepperSetMode(stepper, phaseLinePinPositions, stepMode);
+}
+
+
+
+/**
+ * \brief Rebuilds the stepper objects sequence table for a new stepping mode. \n
+ * The current step is mapped to the step of the new mode with the same phase on, or the nearest one sharing a phase with it, so the rotor position is kept.
+ * \author Tim Robbins
+ * \param stepper The stepper object
+ * \param phaseLinePinPositions The positions of the phase line pins
+ * \param stepMode The stepping mode, STEPPER_MODE_WAVE, STEPPER_MODE_FULL, or STEPPER_MODE_HALF
+ */
+void StepperSetMode(Stepper_t* stepper, const uint8_t phaseLinePinPositions[4], uint8_t stepMode)
+{
+    //Variables
+    uint8_t i = 0; //Sequence index
+    uint8_t j = 0; //Phase line index
+    uint8_t newLength = 0; //The length of the new sequence
+    uint8_t position = 0; //The current step's place in the half step cycle
+    
+    //Range check
+    if(stepMode > STEPPER_MODE_HALF)
+    {
+        stepMode = STEPPER_MODE_FULL;
+    }
+    
+    newLength = (stepMode == STEPPER_MODE_HALF) ? 8 : 4;
+    
+    //Keep the position by finding the current step in the half step cycle. Wave and full steps are every other half step,
+    //so a step between two of the new mode's goes to the one before it, which shares its phase
+    if(stepper->sequenceLength != 0 && stepper->stepMode <= STEPPER_MODE_HALF)
+    {
+        position = m_uchrStepperHalfStepPositions[stepper->stepMode][stepper->sequenceIndex & (stepper->sequenceLength - 1)];
+        stepper->sequenceIndex = (stepMode == STEPPER_MODE_HALF) ? position : (uint8_t)(position >> 1);
+    }
+    
+    stepper->sequenceIndex &= (newLength - 1);
+    stepper->sequenceLength = newLength;
+    stepper->stepMode = stepMode;
+    stepper->phaseMask = 0;
+    
+    //Create the mask for the phase lines
+    for(j = 0; j < 4; j++)
+    {
+        stepper->phaseMask |= (uint8_t)(1 << phaseLinePinPositions[j]);
+    }
+    
+    //Loop through and convert each phase pattern to its port value
+    for(i = 0; i < newLength; i++)
+    {
+        stepper->sequence[i] = 0;
+        
+        for(j = 0; j < 4; j++)
+        {
+            if(readBit(m_uchrStepperPhasePatterns[stepMode][i], j))
+            {
+                stepper->sequence[i] |= (uint8_t)(1 << phaseLinePinPositions[j]);
+            }
+        }
+    }
+}
+
 
 
 /**
@@ -36,8 +36,117 @@ extern "C" {
     
     
 #include <stdbool.h>
+#include <stdint.h>
 
+
+
+///Sequence selection for a precomputed stepper object, one phase on at a time
+#define STEPPER_MODE_WAVE           0
+
+///Sequence selection for a precomputed stepper object, two phases on at a time
+#define STEPPER_MODE_FULL           1
+
+///Sequence selection for a precomputed stepper object, alternating one and two phases on
+#define STEPPER_MODE_HALF           2
+
+///Max amount of entries in a stepper objects sequence table
+#define STEPPER_MAX_SEQUENCE_LENGTH 8
+
+
+///Helper for turning a 4 bit phase pattern into a port value for the passed phase line pin positions
+#define _STEPPER_PATTERN_TO_PORT(pattern, p0, p1, p2, p3)   ((uint8_t)( (((pattern) & 0x01) ? (1 << (p0)) : 0) | (((pattern) & 0x02) ? (1 << (p1)) : 0) \
+                                                            | (((pattern) & 0x04) ? (1 << (p2)) : 0) | (((pattern) & 0x08) ? (1 << (p3)) : 0) ))
+
+///Compile time wave step table for the phase line pin positions passed
+#define STEPPER_WAVE_SEQUENCE(p0, p1, p2, p3)   { _STEPPER_PATTERN_TO_PORT(0x01, p0, p1, p2, p3), _STEPPER_PATTERN_TO_PORT(0x02, p0, p1, p2, p3), \
+                                                  _STEPPER_PATTERN_TO_PORT(0x04, p0, p1, p2, p3), _STEPPER_PATTERN_TO_PORT(0x08, p0, p1, p2, p3) }
+
+///Compile time full step table for the phase line pin positions passed
+#define STEPPER_FULL_SEQUENCE(p0, p1, p2, p3)   { _STEPPER_PATTERN_TO_PORT(0x09, p0, p1, p2, p3), _STEPPER_PATTERN_TO_PORT(0x03, p0, p1, p2, p3), \
+                                                  _STEPPER_PATTERN_TO_PORT(0x06, p0, p1, p2, p3), _STEPPER_PATTERN_TO_PORT(0x0C, p0, p1, p2, p3) }
+
+///Compile time half step table for the phase line pin positions passed
+#define STEPPER_HALF_SEQUENCE(p0, p1, p2, p3)   { _STEPPER_PATTERN_TO_PORT(0x09, p0, p1, p2, p3), _STEPPER_PATTERN_TO_PORT(0x01, p0, p1, p2, p3), \
+                                                  _STEPPER_PATTERN_TO_PORT(0x03, p0, p1, p2, p3), _STEPPER_PATTERN_TO_PORT(0x02, p0, p1, p2, p3), \
+                                                  _STEPPER_PATTERN_TO_PORT(0x06, p0, p1, p2, p3), _STEPPER_PATTERN_TO_PORT(0x04, p0, p1, p2, p3), \
+                                                  _STEPPER_PATTERN_TO_PORT(0x0C, p0, p1, p2, p3), _STEPPER_PATTERN_TO_PORT(0x08, p0, p1, p2, p3) }
+
+///Mask of the phase line pin positions passed
+#define STEPPER_PHASE_MASK(p0, p1, p2, p3)      ((uint8_t)((1 << (p0)) | (1 << (p1)) | (1 << (p2)) | (1 << (p3))))
+
+
+/**
+ * \brief Compile time initializer for a wave stepping object when the pins are fixed. \n
+ * Example use: \n
+ * Stepper_t stepperX = STEPPER_INIT_WAVE(PORTB, 0, 1, 2, 3); \n
+ */
+#define STEPPER_INIT_WAVE(outputReg, p0, p1, p2, p3)    { &(outputReg), STEPPER_PHASE_MASK(p0, p1, p2, p3), 4, 0, STEPPER_MODE_WAVE, STEPPER_WAVE_SEQUENCE(p0, p1, p2, p3) }
+
+///Compile time initializer for a full stepping object when the pins are fixed
+#define STEPPER_INIT_FULL(outputReg, p0, p1, p2, p3)    { &(outputReg), STEPPER_PHASE_MASK(p0, p1, p2, p3), 4, 0, STEPPER_MODE_FULL, STEPPER_FULL_SEQUENCE(p0, p1, p2, p3) }
+
+///Compile time initializer for a half stepping object when the pins are fixed
+#define STEPPER_INIT_HALF(outputReg, p0, p1, p2, p3)    { &(outputReg), STEPPER_PHASE_MASK(p0, p1, p2, p3), 8, 0, STEPPER_MODE_HALF, STEPPER_HALF_SEQUENCE(p0, p1, p2, p3) }
+
+
+
+typedef struct _STEPPER_OBJECT_
+{
+    volatile uint8_t* outputRegister;                   ///The output register the phase lines are connected to
+    uint8_t phaseMask;                                  ///Mask of the phase line pins on the output register
+    uint8_t sequenceLength;                             ///The amount of entries in the sequence table, 4 or 8
+    uint8_t sequenceIndex;                              ///The index for the current step position
+    uint8_t stepMode;                                   ///The stepping mode the sequence table is for, STEPPER_MODE_X
+    uint8_t sequence[STEPPER_MAX_SEQUENCE_LENGTH];      ///The precomputed phase line values for each step
+
+}
+/**
+* \brief Struct for a stepper with its step sequence precomputed as port values
+*/
+Stepper_t;
+
+
+
+/**
+ * \brief Has the stepper objects motor take a step. Only a table lookup and a masked port write, safe for use in an ISR. \n
+ * Example use: \n
+ * StepperInit(&stepperX, &PORTB, auchrPinPositions, STEPPER_MODE_HALF); \n
+ * StepperStep(&stepperX, blnIsCounterClockwise); \n
+ * \param stepper The stepper object
+ * \param isCounterClockwise If taking a counter clockwise step
+ */
+static inline void StepperStep(Stepper_t* stepper, bool isCounterClockwise)
+{
+    //Variables
+    uint8_t stepSequenceIndex = stepper->sequenceIndex; //Copy of the step sequence index
     
+    //Clear the phase lines and set the current steps value, leaving the rest of the port alone
+    *stepper->outputRegister = (uint8_t)((*stepper->outputRegister & ~stepper->phaseMask) | stepper->sequence[stepSequenceIndex]);
+    
+    //Adjust the step index based on direction. The sequence lengths are powers of 2, so masking handles the roll over
+    stepSequenceIndex = (isCounterClockwise) ? stepSequenceIndex - 1 : stepSequenceIndex + 1;
+    stepper->sequenceIndex = stepSequenceIndex & (stepper->sequenceLength - 1);
+}
+
+
+
+/**
+ * \brief Turns off all the phase lines of the stepper objects motor
+ * \param stepper The stepper object
+ */
+static inline void StepperRelease(Stepper_t* stepper)
+{
+    *stepper->outputRegister &= ~stepper->phaseMask;
+}
+
+
+
+extern void StepperInit(Stepper_t* stepper, volatile uint8_t* stepperOutputRegister, const uint8_t phaseLinePinPositions[4], uint8_t stepMode);
+extern void StepperSetMode(Stepper_t* stepper, const uint8_t phaseLinePinPositions[4], uint8_t stepMode);
+
+
+
+
 //These are using arrays for the values. Is probably better?
     
 extern void StepperWaveStep(volatile uint8_t* stepperPhasePortValue, uint8_t phaseLinePinPositions[4], uint8_t* stepSequenceIndex, bool isCounterClockwise);
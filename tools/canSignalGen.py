@@ -0,0 +1,291 @@
+#!/usr/bin/env python3
+"""
+Generates inline CAN_FRAME pack and unpack functions from a DBC-like signal description.
+
+Each message becomes a struct of raw signal values, a pack function that fills a CAN_FRAME
+and an unpack function that reads one. The bit layout is worked out here, so the generated
+code is straight line shifts and masks on data.bytes, or a plain load and store through
+data.s0..s3 and data.low/high when a little endian signal lines up with them. Scale and offset
+go into defines and inline float conversions that are only compiled in if used.
+
+The description is the message and signal lines of a DBC file:
+
+    BO_ <id> <Name>: <length> <sender>
+     SG_ <Name> : <start bit>|<bit length>@<1 little endian, 0 big endian><+ unsigned, - signed> (<scale>,<offset>) [<min>|<max>] "<unit>" <receivers>
+
+An id with bit 31 set is extended, as in DBC files. Comments start with //, and other DBC
+lines are ignored. Example use:
+
+    tools/canSignalGen.py tools/canSignals.example.dbc -o canSignals.h
+"""
+import argparse
+import os
+import re
+import sys
+
+MESSAGE_LINE = re.compile(r"^\s*BO_\s+(\d+)\s+(\w+)\s*:\s*(\d+)")
+SIGNAL_LINE = re.compile(
+    r"^\s*SG_\s+(\w+)\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*"
+    r"\(\s*([-+0-9.eE]+)\s*,\s*([-+0-9.eE]+)\s*\)"
+    r"(?:\s*\[\s*([-+0-9.eE]+)\s*\|\s*([-+0-9.eE]+)\s*\])?"
+    r"(?:\s*\"([^\"]*)\")?")
+
+EXTENDED_FLAG = 0x80000000
+
+
+class Signal:
+    def __init__(self, name, start, length, little, signed, scale, offset, minimum, maximum, unit):
+        self.name = name
+        self.start = start
+        self.length = length
+        self.little = little
+        self.signed = signed
+        self.scale = scale
+        self.offset = offset
+        self.minimum = minimum
+        self.maximum = maximum
+        self.unit = unit
+
+    def bit_positions(self):
+        """Frame bit (byte * 8 + bit in byte) of each signal bit, least significant first"""
+        if self.little:
+            return [self.start + i for i in range(self.length)]
+        # Motorola: the start bit is the most significant, and the bits run down through
+        # each byte then on to bit 7 of the next byte
+        positions = []
+        position = self.start
+        for _ in range(self.length):
+            positions.append(position)
+            if position % 8 == 0:
+                position += 15
+            else:
+                position -= 1
+        positions.reverse()
+        return positions
+
+    def chunks(self):
+        """Runs of bits that share a byte: (byte, bit in byte, bit in signal, count)"""
+        runs = []
+        for signal_bit, position in enumerate(self.bit_positions()):
+            byte, bit = divmod(position, 8)
+            if runs and runs[-1][0] == byte and runs[-1][1] + runs[-1][3] == bit \
+                    and runs[-1][2] + runs[-1][3] == signal_bit:
+                runs[-1][3] += 1
+            else:
+                runs.append([byte, bit, signal_bit, 1])
+        return runs
+
+    def c_type(self):
+        for size in (8, 16, 32, 64):
+            if self.length <= size:
+                return ("int%u_t" if self.signed else "uint%u_t") % size
+        raise ValueError("signal %s is longer than 64 bits" % self.name)
+
+    def union_field(self):
+        """The CAN_FRAME data union field that holds exactly this signal, or None"""
+        if not self.little or self.start % self.length != 0:
+            return None
+        index = self.start // self.length
+        if self.length == 8:
+            return "bytes[%u]" % index
+        if self.length == 16:
+            return "s%u" % index
+        if self.length == 32:
+            return ("low", "high")[index]
+        if self.length == 64:
+            return "value"
+        return None
+
+
+class Message:
+    def __init__(self, frame_id, name, length):
+        self.extended = (frame_id & EXTENDED_FLAG) != 0
+        self.id = frame_id & ~EXTENDED_FLAG
+        self.name = name
+        self.length = length
+        self.signals = []
+
+
+def parse(lines, source):
+    messages = []
+    for number, line in enumerate(lines, 1):
+        line = line.split("//")[0]
+        message = MESSAGE_LINE.match(line)
+        if message:
+            messages.append(Message(int(message.group(1)), message.group(2), int(message.group(3))))
+            continue
+        signal = SIGNAL_LINE.match(line)
+        if signal is None:
+            if line.strip().startswith("SG_"):
+                raise SystemExit("%s:%u: can't read the signal" % (source, number))
+            continue
+        if not messages:
+            raise SystemExit("%s:%u: signal before any message" % (source, number))
+        name, start, length, order, sign, scale, offset, minimum, maximum, unit = signal.groups()
+        item = Signal(name, int(start), int(length), order == "1", sign == "-", float(scale), float(offset),
+                      float(minimum) if minimum else None, float(maximum) if maximum else None, unit or "")
+        last_bit = max(item.bit_positions()) if item.length else 0
+        if item.length == 0 or item.length > 64 or min(item.bit_positions()) < 0 or last_bit >= messages[-1].length * 8:
+            raise SystemExit("%s:%u: signal %s doesn't fit the message" % (source, number, name))
+        messages[-1].signals.append(item)
+    return messages
+
+
+def number(value):
+    text = repr(float(value))
+    return text if "e" in text or "." in text else text + ".0"
+
+
+def emit_pack(signal, out):
+    field = signal.union_field()
+    value = "(uint%u_t)msg->%s" % (max(8, 1 << (signal.length - 1).bit_length()), signal.name)
+    if field is not None:
+        out.append("    frame.data.%s = %s;" % (field, value))
+        return
+    wide = "uint64_t" if signal.length > 32 else "uint32_t" if signal.length > 16 else "uint16_t" if signal.length > 8 else "uint8_t"
+    out.append("    raw = (%s)msg->%s;" % (wide, signal.name))
+    for byte, bit, signal_bit, count in signal.chunks():
+        mask = (1 << count) - 1
+        part = "(raw >> %u)" % signal_bit if signal_bit else "raw"
+        # Bits past the run are cut off by the uint8_t cast when the run reaches the top of the byte
+        part = "(uint8_t)(%s & 0x%02X)" % (part, mask) if bit + count < 8 else "(uint8_t)%s" % part
+        if bit:
+            part = "(uint8_t)(%s << %u)" % (part, bit)
+        out.append("    frame.data.bytes[%u] |= %s;" % (byte, part))
+
+
+def emit_unpack(signal, out):
+    field = signal.union_field()
+    c_type = signal.c_type()
+    if field is not None:
+        out.append("    msg->%s = (%s)frame.data.%s;" % (signal.name, c_type, field))
+        return
+    wide = "uint64_t" if signal.length > 32 else "uint32_t" if signal.length > 16 else "uint16_t" if signal.length > 8 else "uint8_t"
+    terms = []
+    for byte, bit, signal_bit, count in signal.chunks():
+        mask = (1 << count) - 1
+        part = "frame.data.bytes[%u]" % byte
+        if bit:
+            part = "(%s >> %u)" % (part, bit)
+        if bit + count < 8:
+            part = "(%s & 0x%02X)" % (part, mask)
+        part = "((%s)%s)" % (wide, part)
+        if signal_bit:
+            part = "(%s << %u)" % (part, signal_bit)
+        terms.append(part)
+    out.append("    raw = %s;" % ("\n          | ".join(terms)))
+    if signal.signed and signal.length < int(c_type[3:-2] if c_type.startswith("int") else c_type[4:-2]):
+        sign_bit = 1 << (signal.length - 1)
+        out.append("    if (raw & 0x%XULL) raw |= ~(%s)0x%XULL;" % (sign_bit, wide, (sign_bit << 1) - 1))
+    out.append("    msg->%s = (%s)raw;" % (signal.name, c_type))
+
+
+def generate(messages, name, guard, source):
+    out = []
+    out.append("/**")
+    out.append(" * \\file %s" % name)
+    out.append(" * \\brief CAN signal pack and unpack functions generated by tools/canSignalGen.py from %s. Do not edit" % os.path.basename(source))
+    out.append(" */")
+    out.append("#ifndef %s" % guard)
+    out.append("#define %s" % guard)
+    out.append("")
+    out.append("#include \"avr_can.h\"")
+    out.append("")
+    out.append("#if defined(_CAN_LIBRARY_)")
+    for message in messages:
+        upper = message.name.upper()
+        out.append("")
+        out.append("")
+        out.append("///The id of %s" % message.name)
+        out.append("#define %s_ID%s0x%X" % (upper, " " * max(1, 32 - len(upper) - 3), message.id))
+        out.append("///If %s has an extended id" % message.name)
+        out.append("#define %s_EXTENDED%s%u" % (upper, " " * max(1, 32 - len(upper) - 9), message.extended))
+        out.append("///The data length of %s" % message.name)
+        out.append("#define %s_LENGTH%s%u" % (upper, " " * max(1, 32 - len(upper) - 7), message.length))
+        for signal in message.signals:
+            name = "%s_%s" % (upper, signal.name.upper())
+            out.append("#define %s_FACTOR%s%s" % (name, " " * max(1, 32 - len(name) - 7), number(signal.scale)))
+            out.append("#define %s_OFFSET%s%s" % (name, " " * max(1, 32 - len(name) - 7), number(signal.offset)))
+        out.append("")
+        out.append("typedef struct _%s_" % upper)
+        out.append("{")
+        for signal in message.signals:
+            unit = " %s" % signal.unit if signal.unit else ""
+            limits = ""
+            if signal.minimum is not None and signal.maximum is not None:
+                limits = ", %g to %g%s" % (signal.minimum, signal.maximum, unit)
+            out.append("    %-10s %s;%s///Raw value, times %g plus %g for%s%s" % (
+                signal.c_type(), signal.name, " " * max(1, 20 - len(signal.name)), signal.scale, signal.offset,
+                unit if unit else " the value", limits))
+        out.append("")
+        out.append("}")
+        out.append("/**")
+        out.append("* \\brief Struct for the raw signal values of %s" % message.name)
+        out.append("*/")
+        out.append("%s_t;" % message.name)
+        out.append("")
+        out.append("")
+        out.append("/**")
+        out.append(" * \\brief Packs %s into a frame, setting the id and length" % message.name)
+        out.append(" */")
+        out.append("static inline void %s_pack(CAN_FRAME& frame, const %s_t* msg)" % (message.name, message.name))
+        out.append("{")
+        needs_raw = [s for s in message.signals if s.union_field() is None]
+        if needs_raw:
+            out.append("    uint%u_t raw;" % max(8, max(1 << (s.length - 1).bit_length() for s in needs_raw)))
+            out.append("")
+        out.append("    frame.id = %s_ID;" % upper)
+        out.append("    frame.extended = %s_EXTENDED;" % upper)
+        out.append("    frame.rtr = 0;")
+        out.append("    frame.length = %s_LENGTH;" % upper)
+        out.append("    frame.data.value = 0;")
+        for signal in message.signals:
+            emit_pack(signal, out)
+        out.append("}")
+        out.append("")
+        out.append("/**")
+        out.append(" * \\brief Unpacks %s from a frame. The id isn't checked" % message.name)
+        out.append(" */")
+        out.append("static inline void %s_unpack(const CAN_FRAME& frame, %s_t* msg)" % (message.name, message.name))
+        out.append("{")
+        if needs_raw:
+            out.append("    uint%u_t raw;" % max(8, max(1 << (s.length - 1).bit_length() for s in needs_raw)))
+            out.append("")
+        for signal in message.signals:
+            emit_unpack(signal, out)
+        out.append("}")
+        for signal in message.signals:
+            name = "%s_%s" % (upper, signal.name.upper())
+            out.append("")
+            out.append("///Converts the raw %s of %s to its value" % (signal.name, message.name))
+            out.append("static inline float %s_%s_value(const %s_t* msg) { return (float)msg->%s * %s_FACTOR + %s_OFFSET; }" % (
+                message.name, signal.name, message.name, signal.name, name, name))
+    out.append("")
+    out.append("#endif")
+    out.append("#endif /* %s */" % guard)
+    out.append("")
+    return "\n".join(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generates CAN_FRAME pack and unpack functions from a DBC-like description")
+    parser.add_argument("input", help="the signal description")
+    parser.add_argument("-o", "--output", help="the header to write, stdout if not given")
+    args = parser.parse_args()
+
+    with open(args.input) as description:
+        messages = parse(description, args.input)
+
+    name = os.path.basename(args.output) if args.output else "canSignals.h"
+    guard = re.sub(r"\W", "_", name).upper() + "_"
+    text = generate(messages, name, guard, args.input)
+
+    if args.output:
+        with open(args.output, "w") as header:
+            header.write(text)
+    else:
+        sys.stdout.write(text)
+
+
+if __name__ == "__main__":
+    main()
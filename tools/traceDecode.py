@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""
+Decodes the binary event trace from mcuTrace and prints it as a timeline.
+
+Reads either the raw serial stream sent by TracePollSerial, or a candump log of the
+frames sent by CAN_send_trace. Each line is the time since the first record, the time
+since the previous record, the event and its two arguments. Gaps in the sequence numbers
+are printed as dropped records.
+
+Example use:
+
+    cat /dev/ttyUSB0 | tools/traceDecode.py --tick-us 0.0625 --names events.txt
+    candump can0 | tools/traceDecode.py --can 7F0 --tick-us 0.0625
+
+The names file has a line per event id, "1 CAN_RX", ids in decimal or 0x hex.
+"""
+import argparse
+import re
+import sys
+
+SERIAL_SYNC = 0xA5
+PACKET_SIZE = 10
+ID_SYNC = 0xFF
+WRAP = 0x10000
+
+
+def serial_records(stream):
+    """Yields the 8 record bytes of each good packet in a raw serial stream"""
+    pending = b""
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            return
+        pending += chunk
+        while len(pending) >= PACKET_SIZE:
+            if pending[0] != SERIAL_SYNC or (sum(pending[1:9]) & 0xFF) != pending[9]:
+                # Not lined up on a packet, so slide a byte and look again
+                pending = pending[1:]
+                continue
+            yield pending[1:9]
+            pending = pending[PACKET_SIZE:]
+
+
+CANDUMP_LINE = re.compile(
+    r"(?:\s(?P<id1>[0-9A-Fa-f]{3,8})#(?P<data1>[0-9A-Fa-f]*))"
+    r"|(?:\s(?P<id2>[0-9A-Fa-f]{3,8})\s+\[\d\]\s+(?P<data2>(?:[0-9A-Fa-f]{2}\s*)+))")
+
+
+def can_records(stream, can_id):
+    """Yields the data of each 8 byte frame with the trace id in a candump log"""
+    for line in stream:
+        match = CANDUMP_LINE.search(line)
+        if match is None:
+            continue
+        frame_id = match.group("id1") or match.group("id2")
+        data = match.group("data1") if match.group("id1") else match.group("data2")
+        data = bytes.fromhex(data.replace(" ", "").strip())
+        if int(frame_id, 16) == can_id and len(data) == 8:
+            yield data
+
+
+def load_names(path):
+    names = {}
+    if path is not None:
+        with open(path) as names_file:
+            for line in names_file:
+                fields = line.split()
+                if len(fields) >= 2 and not fields[0].startswith("#"):
+                    names[int(fields[0], 0)] = fields[1]
+    names.setdefault(ID_SYNC, "SYNC")
+    return names
+
+
+def decode(records, tick_us, names, out):
+    ticks = None        # Unwrapped time of the last record in ticks
+    last_time = 0       # Raw 16 bit time of the last record
+    last_seq = None
+    sync_base = None    # (ticks, millis) of the first sync record
+
+    for data in records:
+        time = data[0] | (data[1] << 8)
+        event = data[2]
+        seq = data[3]
+        arg_a = data[4] | (data[5] << 8)
+        arg_b = data[6] | (data[7] << 8)
+
+        if last_seq is not None and seq != ((last_seq + 1) & 0xFF):
+            out.write("%12s %11s  -- dropped %u\n" % ("", "", (seq - last_seq - 1) & 0xFF))
+        last_seq = seq
+
+        previous = ticks
+        if ticks is None:
+            ticks = 0
+        else:
+            ticks += (time - last_time) & (WRAP - 1)
+        last_time = time
+
+        if event == ID_SYNC:
+            millis = arg_a | (arg_b << 16)
+            if sync_base is None:
+                sync_base = (ticks, millis)
+            else:
+                # The 16 bit stamps can't see whole wraps, so correct against the absolute time
+                expected = sync_base[0] + (millis - sync_base[1]) * 1000.0 / tick_us
+                ticks += int(round((expected - ticks) / WRAP)) * WRAP
+
+        delta = 0 if previous is None else ticks - previous
+        name = names.get(event, "%u" % event)
+        out.write("%12.1f %+11.1f  %-16s a=%-5u (0x%04X) b=%-5u (0x%04X)\n" % (
+            ticks * tick_us, delta * tick_us, name, arg_a, arg_a, arg_b, arg_b))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decodes the mcuTrace binary event trace into a timeline")
+    parser.add_argument("input", nargs="?", help="file to read, stdin if not given")
+    parser.add_argument("--can", metavar="ID", help="read a candump log, keeping frames with this hex id")
+    parser.add_argument("--tick-us", type=float, default=0.0625,
+                        help="microseconds per time stamp tick, 0.0625 for the default mcuTimebase, timer 1 undivided, at 16MHz")
+    parser.add_argument("--names", help="file of event id and name pairs")
+    args = parser.parse_args()
+
+    if args.can is not None:
+        stream = open(args.input) if args.input else sys.stdin
+        records = can_records(stream, int(args.can, 16))
+    else:
+        stream = open(args.input, "rb") if args.input else sys.stdin.buffer
+        records = serial_records(stream)
+
+    decode(records, args.tick_us, load_names(args.names), sys.stdout)
+
+
+if __name__ == "__main__":
+    main()